@@ -4,11 +4,36 @@
 // Testbench
 
 #include "phvk_engine.h"
+#include "phvk_benchmark.h"
 
-int main()
+int main(int argc, char* argv[])
 {
 	phVkEngine engine;
 
+	// Benchmark mode (see phvk_benchmark.h for options)
+	BenchmarkSettings benchmark;
+	std::string error;
+	if (ParseBenchmarkArgs(argc, argv, benchmark, error))
+	{
+		engine.headless = benchmark.offscreen;
+		engine.load_default_scene = false;
+		engine.frame_overlap = benchmark.frames_in_flight;
+		engine.present_mode = benchmark.present_mode;
+
+		engine.init();
+
+		bool success = RunBenchmark(&engine, benchmark);
+
+		engine.cleanup();
+
+		return success ? 0 : 1;
+	}
+	else if (!error.empty())
+	{
+		fmt::println("{}", error);
+		return 1;
+	}
+
 	engine.init();
 
 	engine.run();
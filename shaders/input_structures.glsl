@@ -10,11 +10,27 @@ layout(set = 0, binding = 0) uniform  SceneData{
 } sceneData;
 
 #ifdef USE_BINDLESS
-layout(set = 0, binding = 1) uniform sampler2D allTextures[];
+// One global set for every material (set 0 holds a dynamic uniform buffer, which
+// can't share a layout with update-after-bind bindings)
+struct MaterialData {
+
+	vec4 colorFactors;
+	vec4 metal_rough_factors;
+	int colorTexID;
+	int metalRoughTexID;
+	int pad0;
+	int pad1;
+};
+
+layout(set = 1, binding = 0) readonly buffer MaterialBuffer{   
+
+	MaterialData materials[];
+};
+
+layout(set = 1, binding = 1) uniform sampler2D allTextures[];
 #else
 layout(set = 1, binding = 1) uniform sampler2D colorTex;
 layout(set = 1, binding = 2) uniform sampler2D metalRoughTex;
-#endif
 
 layout(set = 1, binding = 0) uniform GLTFMaterialData{   
 
@@ -23,4 +39,5 @@ layout(set = 1, binding = 0) uniform GLTFMaterialData{
 	int colorTexID;
 	int metalRoughTexID;
 } materialData;
+#endif
 
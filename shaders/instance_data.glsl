@@ -0,0 +1,9 @@
+// Per-instance data for instanced draws, must match GPUInstanceData in phvk_types.h
+struct InstanceData {
+
+	mat4 transform;
+};
+
+layout(buffer_reference, std430) readonly buffer InstanceBuffer{ 
+	InstanceData instances[];
+};
@@ -0,0 +1,48 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_buffer_reference : require
+
+#include "input_structures.glsl"
+#include "instance_data.glsl"
+
+// Instanced variant of mesh.vert, transforms are read from the instance buffer
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+layout (location = 2) out vec2 outUV;
+
+struct Vertex {
+
+	vec3 position;
+	float uv_x;
+	vec3 normal;
+	float uv_y;
+	vec4 color;
+}; 
+
+layout(buffer_reference, std430) readonly buffer VertexBuffer{ 
+	Vertex vertices[];
+};
+
+//push constants block (GPUInstancedDrawPushConstants, material index and bounds unused)
+layout( push_constant ) uniform constants
+{
+	InstanceBuffer instanceBuffer;
+	VertexBuffer vertexBuffer;
+} PushConstants;
+
+void main() 
+{
+	Vertex v = PushConstants.vertexBuffer.vertices[gl_VertexIndex];
+	mat4 render_matrix = PushConstants.instanceBuffer.instances[gl_InstanceIndex].transform;
+	
+	vec4 position = vec4(v.position, 1.0f);
+
+	gl_Position =  sceneData.viewproj * render_matrix *position;	
+
+	outNormal = (render_matrix * vec4(v.normal, 0.f)).xyz;
+	outColor = v.color.xyz * materialData.colorFactors.xyz;	
+	outUV.x = v.uv_x;
+	outUV.y = v.uv_y;
+}
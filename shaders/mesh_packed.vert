@@ -0,0 +1,39 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_buffer_reference : require
+
+#include "input_structures.glsl"
+#include "packed_vertex.glsl"
+
+// Variant of mesh.vert for meshes stored as PackedVertex
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+layout (location = 2) out vec2 outUV;
+
+//push constants block
+layout( push_constant ) uniform constants
+{
+	mat4 render_matrix;
+	PackedVertexBuffer vertexBuffer;
+	uint pad0;
+	uint pad1;
+	vec4 boundsOrigin;
+	vec4 boundsExtents;
+} PushConstants;
+
+void main() 
+{
+	Vertex v = unpackVertex(PushConstants.vertexBuffer.vertices[gl_VertexIndex],
+		PushConstants.boundsOrigin.xyz, PushConstants.boundsExtents.xyz);
+	
+	vec4 position = vec4(v.position, 1.0f);
+
+	gl_Position =  sceneData.viewproj * PushConstants.render_matrix *position;	
+
+	outNormal = (PushConstants.render_matrix * vec4(v.normal, 0.f)).xyz;
+	outColor = v.color.xyz * materialData.colorFactors.xyz;	
+	outUV.x = v.uv_x;
+	outUV.y = v.uv_y;
+}
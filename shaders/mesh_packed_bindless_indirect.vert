@@ -0,0 +1,55 @@
+#version 460
+
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_buffer_reference : require
+
+#define USE_BINDLESS
+#include "input_structures.glsl"
+#include "packed_vertex.glsl"
+
+// Bindless variant of mesh_packed_indirect.vert
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+layout (location = 2) out vec2 outUV;
+layout (location = 3) flat out uint outMaterialIndex;
+
+struct ObjectData {
+
+	mat4 transform;
+	vec4 sphere;
+	vec4 extents;
+	PackedVertexBuffer vertexBuffer;
+	uint firstIndex;
+	uint indexCount;
+	uint batchIndex;
+	uint firstCommand;
+	uint materialIndex;
+	uint pad;
+};
+
+layout(buffer_reference, std430) readonly buffer ObjectBuffer{ 
+	ObjectData objects[];
+};
+
+//push constants block
+layout( push_constant ) uniform constants
+{
+	ObjectBuffer objectBuffer;
+} PushConstants;
+
+void main() 
+{
+	ObjectData obj = PushConstants.objectBuffer.objects[gl_InstanceIndex];
+	Vertex v = unpackVertex(obj.vertexBuffer.vertices[gl_VertexIndex], obj.sphere.xyz, obj.extents.xyz);
+	
+	vec4 position = vec4(v.position, 1.0f);
+
+	gl_Position =  sceneData.viewproj * obj.transform * position;	
+
+	outNormal = (obj.transform * vec4(v.normal, 0.f)).xyz;
+	outColor = v.color.xyz * materials[obj.materialIndex].colorFactors.xyz;	
+	outUV.x = v.uv_x;
+	outUV.y = v.uv_y;
+	outMaterialIndex = obj.materialIndex;
+}
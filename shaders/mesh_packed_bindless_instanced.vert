@@ -0,0 +1,46 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_buffer_reference : require
+
+#define USE_BINDLESS
+#include "input_structures.glsl"
+#include "packed_vertex.glsl"
+#include "instance_data.glsl"
+
+// Instanced variant of mesh_packed_bindless.vert
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+layout (location = 2) out vec2 outUV;
+layout (location = 3) flat out uint outMaterialIndex;
+
+//push constants block (GPUInstancedDrawPushConstants)
+layout( push_constant ) uniform constants
+{
+	InstanceBuffer instanceBuffer;
+	PackedVertexBuffer vertexBuffer;
+	uint materialIndex;
+	uint pad0;
+	uint pad1;
+	uint pad2;
+	vec4 boundsOrigin;
+	vec4 boundsExtents;
+} PushConstants;
+
+void main() 
+{
+	Vertex v = unpackVertex(PushConstants.vertexBuffer.vertices[gl_VertexIndex],
+		PushConstants.boundsOrigin.xyz, PushConstants.boundsExtents.xyz);
+	mat4 render_matrix = PushConstants.instanceBuffer.instances[gl_InstanceIndex].transform;
+	
+	vec4 position = vec4(v.position, 1.0f);
+
+	gl_Position =  sceneData.viewproj * render_matrix *position;	
+
+	outNormal = (render_matrix * vec4(v.normal, 0.f)).xyz;
+	outColor = v.color.xyz * materials[PushConstants.materialIndex].colorFactors.xyz;	
+	outUV.x = v.uv_x;
+	outUV.y = v.uv_y;
+	outMaterialIndex = PushConstants.materialIndex;
+}
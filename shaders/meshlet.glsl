@@ -0,0 +1,68 @@
+// Meshlet layout and push constants shared by meshlet.task and the meshlet*.mesh variants
+// Requires GL_EXT_buffer_reference, define PACKED_VERTICES before including for PackedVertex meshes
+// (after packed_vertex.glsl)
+
+// Must match MESHLET_* in phvk_meshlet.h
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+#define MESHLET_TASK_GROUP_SIZE 32
+
+// Must match GPUMeshlet in phvk_meshlet.h
+struct Meshlet {
+
+	vec3 center;
+	float radius;
+	vec3 coneAxis;
+	float coneCutoff;
+	uint vertexOffset;
+	uint triangleOffset;
+	uint vertexCount;
+	uint triangleCount;
+};
+
+layout(buffer_reference, std430) readonly buffer MeshletBuffer{ 
+	Meshlet meshlets[];
+};
+
+// Vertex indices and packed triangles (3 x 8-bit local indices per word)
+layout(buffer_reference, std430) readonly buffer MeshletDataBuffer{ 
+	uint data[];
+};
+
+#ifndef PACKED_VERTICES
+struct Vertex {
+
+	vec3 position;
+	float uv_x;
+	vec3 normal;
+	float uv_y;
+	vec4 color;
+}; 
+
+layout(buffer_reference, std430) readonly buffer VertexBuffer{ 
+	Vertex vertices[];
+};
+#endif
+
+// Surviving meshlets of one task workgroup, one mesh workgroup each
+struct TaskPayload {
+
+	uint meshletIndices[MESHLET_TASK_GROUP_SIZE];
+};
+
+//push constants block (GPUMeshletDrawPushConstants)
+layout( push_constant ) uniform constants
+{
+	mat4 render_matrix;
+#ifdef PACKED_VERTICES
+	PackedVertexBuffer vertexBuffer;
+#else
+	VertexBuffer vertexBuffer;
+#endif
+	MeshletBuffer meshletBuffer;		// First meshlet of the surface
+	MeshletDataBuffer meshletData;
+	uint meshletCount;
+	uint materialIndex;
+	vec4 boundsOrigin;					// Dequantization (packed meshes)
+	vec4 boundsExtents;
+} PushConstants;
@@ -0,0 +1,54 @@
+
+// Packed vertex layout (16 bytes), must match PackedVertex in phvk_types.h
+//   word 0: position.x | position.y << 16        (unorm16, relative to the surface bounds)
+//   word 1: position.z | normal.xy << 16         (unorm16, octahedral snorm8 x2)
+//   word 2: uv                                   (half2)
+//   word 3: color                                (rgba8 unorm)
+struct PackedVertex {
+
+	uint positionXY;
+	uint positionZNormal;
+	uint uv;
+	uint color;
+};
+
+layout(buffer_reference, std430) readonly buffer PackedVertexBuffer{ 
+	PackedVertex vertices[];
+};
+
+struct Vertex {
+
+	vec3 position;
+	float uv_x;
+	vec3 normal;
+	float uv_y;
+	vec4 color;
+};
+
+vec3 decodeOctahedral(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
+// Bounds: position = origin + (q * 2 - 1) * extents
+Vertex unpackVertex(PackedVertex p, vec3 boundsOrigin, vec3 boundsExtents)
+{
+	Vertex v;
+
+	vec3 q = vec3(unpackUnorm2x16(p.positionXY), float(p.positionZNormal & 0xffffu) / 65535.0);
+	v.position = boundsOrigin + (q * 2.0 - 1.0) * boundsExtents;
+
+	v.normal = decodeOctahedral(unpackSnorm4x8(p.positionZNormal).zw);
+
+	vec2 uv = unpackHalf2x16(p.uv);
+	v.uv_x = uv.x;
+	v.uv_y = uv.y;
+
+	v.color = unpackUnorm4x8(p.color);
+
+	return v;
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Per-frame CPU linear arena and heap allocation counter
+
+#include "phvk_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// *** Frame Arena ***
+
+void FrameArena::init(size_t size)
+{
+    head = 0;
+    frame_usage = 0;
+
+    blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(size));
+    block_sizes.push_back(size);
+}
+
+void FrameArena::reset()
+{
+    if (blocks.size() > 1)
+    {
+        // Overflowed last time: replace everything with one block that fits the whole frame
+        size_t new_size = std::max(frame_usage, block_sizes[0]) * 2;
+
+        blocks.clear();
+        block_sizes.clear();
+        blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(new_size));
+        block_sizes.push_back(new_size);
+    }
+
+    head = 0;
+    frame_usage = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    size_t offset = (head + alignment - 1) & ~(alignment - 1);
+    size_t padding = offset - head;
+
+    if (offset + size > block_sizes.back())
+    {
+        // Out of space: chain an overflow block for the rest of the frame
+        // (new[] blocks are aligned for any fundamental type)
+        size_t block_size = std::max(block_sizes.back(), size);
+        blocks.push_back(std::make_unique_for_overwrite<std::byte[]>(block_size));
+        block_sizes.push_back(block_size);
+        offset = 0;
+        padding = 0;
+    }
+
+    frame_usage += padding + size;
+    head = offset + size;
+
+    return blocks.back().get() + offset;
+}
+
+// *** Heap Allocation Counter ***
+// Replaces the global allocation functions (the array and nothrow forms forward to these)
+
+static std::atomic<uint64_t> heap_allocation_count { 0 };
+
+uint64_t HeapAllocationCount()
+{
+    return heap_allocation_count.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size)
+{
+    heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+    const size_t a = (size_t)alignment;
+    const size_t rounded = ((size ? size : 1) + a - 1) & ~(a - 1);
+#ifdef _MSC_VER
+    void* p = _aligned_malloc(rounded, a);
+#else
+    void* p = std::aligned_alloc(a, rounded);
+#endif
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(p, alignment);
+}
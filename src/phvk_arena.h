@@ -0,0 +1,47 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Per-frame CPU linear arena and heap allocation counter
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+// Bump allocator for transient CPU data of one frame (culling output, scratch lists, etc.)
+// One per FrameData, reset at the start of the frame. Memory is never freed individually
+// and no destructors run, so only trivially destructible types are allowed.
+// Main thread only: allocate spans up front, jobs may then fill them in parallel
+struct FrameArena
+{
+    // blocks[0] is the primary block, additional blocks are overflow for the current frame
+    // and get merged on reset (no allocation once the primary block fits a whole frame)
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    std::vector<size_t> block_sizes;
+    size_t head { 0 };              // Offset into the last block
+    size_t frame_usage { 0 };       // Total bytes allocated this frame (incl. alignment)
+
+    void init(size_t size);
+
+    void reset();
+
+    void* allocate(size_t size, size_t alignment);
+
+    // Uninitialized storage for count elements
+    template <typename T>
+    std::span<T> allocate(size_t count)
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "FrameArena never runs destructors");
+        return { (T*)allocate(count * sizeof(T), alignof(T)), count };
+    }
+
+    size_t capacity() const { return block_sizes.empty() ? 0 : block_sizes[0]; }
+};
+
+// Global operator new calls since startup (all threads)
+// The engine reports the per-frame difference, a steady-state frame should add none
+uint64_t HeapAllocationCount();
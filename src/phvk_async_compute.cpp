@@ -0,0 +1,220 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Async compute scheduling (compute queue passes, timeline semaphore, queue ownership transfers)
+
+#include "phvk_async_compute.h"
+
+#include "phvk_engine.h"
+#include "phvk_initializers.h"
+
+#include <algorithm>
+
+void AsyncCompute::init(phVkEngine* engine, VkQueue compute_queue, uint32_t compute_family)
+{
+    this->engine = engine;
+    device = engine->device;
+    graphics_family = engine->graphics_queue_family;
+
+    queue = compute_queue;
+    queue_family = compute_family;
+
+    if (!isAvailable())
+    {
+        fmt::println("Compute passes inline (no separate compute queue family)");
+        return;
+    }
+
+    // One command buffer per frame slot, reset with its pool when the slot comes around again
+    VkCommandPoolCreateInfo pool_info = vkinit::command_pool_create_info(queue_family,
+        VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
+    command_pools.resize(MAX_FRAME_OVERLAP);
+    command_buffers.resize(MAX_FRAME_OVERLAP);
+    for (uint32_t i = 0; i < MAX_FRAME_OVERLAP; i++)
+    {
+        VK_CHECK(vkCreateCommandPool(device, &pool_info, nullptr, &command_pools[i]));
+
+        VkCommandBufferAllocateInfo alloc_info = vkinit::command_buffer_allocate_info(command_pools[i], 1);
+        VK_CHECK(vkAllocateCommandBuffers(device, &alloc_info, &command_buffers[i]));
+    }
+
+    // Timeline semaphore, value N is signaled once the Nth submit has finished
+    VkSemaphoreTypeCreateInfo type_info { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphore_info = vkinit::semaphore_create_info();
+    semaphore_info.pNext = &type_info;
+    VK_CHECK(vkCreateSemaphore(device, &semaphore_info, nullptr, &timeline));
+
+    fmt::println("Async compute queue family {}", queue_family);
+}
+
+void AsyncCompute::destroy()
+{
+    // Device must be idle, destroying a pool frees its command buffers
+    for (VkCommandPool pool : command_pools)
+    {
+        vkDestroyCommandPool(device, pool, nullptr);
+    }
+    command_pools.clear();
+    command_buffers.clear();
+
+    if (timeline != VK_NULL_HANDLE)
+    {
+        vkDestroySemaphore(device, timeline, nullptr);
+        timeline = VK_NULL_HANDLE;
+    }
+
+    for (uint32_t i = 0; i < pass_count; i++)
+    {
+        passes[i].record = nullptr;
+    }
+    pass_count = 0;
+}
+
+void AsyncCompute::addPass(const char* name, std::span<const ComputeImageUse> images, RecordFunction&& record)
+{
+    assert(pass_count < MAX_PASSES && images.size() <= MAX_PASS_IMAGES);
+
+    Pass& pass = passes[pass_count++];
+    pass.name = name;
+    pass.image_count = (uint32_t)images.size();
+    std::copy(images.begin(), images.end(), pass.images.begin());
+    pass.record = std::move(record);
+}
+
+void AsyncCompute::submit(uint32_t frame_index)
+{
+    frame_async = isAsync() && pass_count > 0;
+    passes_submitted = 0;
+    acquires.count = 0;
+    wait_stages = VK_PIPELINE_STAGE_2_NONE;
+
+    if (!frame_async)
+    {
+        return;
+    }
+
+    // Slot's previous submit has completed (the graphics work waiting on it has)
+    VK_CHECK(vkResetCommandPool(device, command_pools[frame_index], 0));
+
+    VkCommandBuffer cmd = command_buffers[frame_index];
+    VkCommandBufferBeginInfo begin_info =
+        vkinit::command_buffer_begin_info(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    VK_CHECK(vkBeginCommandBuffer(cmd, &begin_info));
+
+    ImageBarriers releases;
+    for (uint32_t i = 0; i < pass_count; i++)
+    {
+        Pass& pass = passes[i];
+
+        recordPassStart(cmd, pass);
+        pass.record(cmd);
+
+        // Release to graphics with the final layout, the acquire is recorded by recordGraphics()
+        // (only needs to happen once: the next use discards the contents, so ownership is not returned)
+        for (uint32_t j = 0; j < pass.image_count; j++)
+        {
+            const ComputeImageUse& use = pass.images[j];
+
+            VkImageMemoryBarrier2 release { .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+            release.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+            release.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+            release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+            release.dstAccessMask = VK_ACCESS_2_NONE;
+            release.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            release.newLayout = use.final_layout;
+            release.srcQueueFamilyIndex = queue_family;
+            release.dstQueueFamilyIndex = graphics_family;
+            release.image = use.image;
+            release.subresourceRange = vkinit::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT);
+            releases.add(release);
+
+            VkImageMemoryBarrier2 acquire = release;
+            acquire.srcStageMask = use.graphics_stages;     // Chains with the timeline wait
+            acquire.srcAccessMask = VK_ACCESS_2_NONE;
+            acquire.dstStageMask = use.graphics_stages;
+            acquire.dstAccessMask = use.graphics_access;
+            acquires.add(acquire);
+
+            wait_stages |= use.graphics_stages;
+        }
+
+        pass.record = nullptr;
+    }
+    releases.record(cmd);
+
+    VK_CHECK(vkEndCommandBuffer(cmd));
+
+    VkCommandBufferSubmitInfo cmd_info = vkinit::command_buffer_submit_info(cmd);
+    VkSemaphoreSubmitInfo signal_info = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, timeline);
+    signal_info.value = next_value;
+
+    VkSubmitInfo2 submit = vkinit::submit_info(&cmd_info, &signal_info, nullptr);
+
+    // The compute family may be the one the uploads use
+    {
+        std::scoped_lock queue_lock(engine->upload_manager.queue_mutex);
+        VK_CHECK(vkQueueSubmit2(queue, 1, &submit, VK_NULL_HANDLE));
+    }
+
+    submitted_value = next_value++;
+    passes_submitted = pass_count;
+    pass_count = 0;
+}
+
+uint64_t AsyncCompute::recordGraphics(VkCommandBuffer cmd)
+{
+    if (frame_async)
+    {
+        acquires.record(cmd);
+        return submitted_value;
+    }
+
+    // Inline: same passes on the graphics queue, the render graph pass around this call
+    // transitions the images
+    for (uint32_t i = 0; i < pass_count; i++)
+    {
+        passes[i].record(cmd);
+        passes[i].record = nullptr;
+    }
+    pass_count = 0;
+
+    return 0;
+}
+
+void AsyncCompute::recordPassStart(VkCommandBuffer cmd, const Pass& pass) const
+{
+    ImageBarriers starts;
+    for (uint32_t j = 0; j < pass.image_count; j++)
+    {
+        VkImageMemoryBarrier2 barrier { .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_NONE;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = pass.images[j].image;
+        barrier.subresourceRange = vkinit::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT);
+        starts.add(barrier);
+    }
+    starts.record(cmd);
+}
+
+void AsyncCompute::ImageBarriers::record(VkCommandBuffer cmd)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    VkDependencyInfo dep_info { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep_info.imageMemoryBarrierCount = count;
+    dep_info.pImageMemoryBarriers = barriers.data();
+    vkCmdPipelineBarrier2(cmd, &dep_info);
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Async compute scheduling (compute queue passes, timeline semaphore, queue ownership transfers)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <array>
+#include <functional>
+#include <span>
+#include <vector>
+
+class phVkEngine;
+
+// Image written by a compute pass and read by the graphics frame afterwards
+// Contents are discarded when the pass starts (GENERAL layout while the pass runs)
+// Final layout / graphics scope describe the ownership acquire (async only)
+struct ComputeImageUse
+{
+    VkImage image { VK_NULL_HANDLE };
+    VkImageLayout final_layout { VK_IMAGE_LAYOUT_GENERAL };    // Layout the graphics work expects
+    VkPipelineStageFlags2 graphics_stages { VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT };  // First graphics use
+    VkAccessFlags2 graphics_access { VK_ACCESS_2_MEMORY_READ_BIT };
+};
+
+// Independent compute passes (no pass reads another's output, nothing from the graphics work of
+// the same frame), scheduled per frame:
+//   addPass()          - pass recorded later by its callback, declares the images it writes
+//   submit()           - async: passes recorded on the frame's compute command buffer, images
+//                        released to the graphics family, submission signals the timeline
+//   recordGraphics()   - async: ownership acquires on the graphics command buffer
+//                        inline: passes recorded right there (called from a render graph pass that
+//                        declares the images, so the graph transitions them)
+// The graphics submit waits on the returned timeline value, so a frame's compute work overlaps
+// with the previous frame's graphics work on the GPU.
+// Devices without a separate compute family (or with async disabled) run every pass inline,
+// callers see the same interface either way.
+// Not thread-safe, driven by the render loop
+class AsyncCompute
+{
+public:
+    static constexpr uint32_t MAX_PASSES = 8;
+    static constexpr uint32_t MAX_PASS_IMAGES = 4;
+
+    using RecordFunction = std::function<void(VkCommandBuffer)>;
+
+    VkSemaphore timeline { VK_NULL_HANDLE };
+
+    // Switched by the UI, takes effect on the next frame (queue must be available)
+    bool enabled { true };
+
+    // Queue family differs from graphics (otherwise every pass runs inline)
+    void init(phVkEngine* engine, VkQueue compute_queue, uint32_t compute_family);
+    void destroy();
+
+    bool isAvailable() const { return queue_family != graphics_family; }
+    bool isAsync() const { return enabled && isAvailable(); }
+    bool frameAsync() const { return frame_async; }      // Current frame's passes went to the compute queue
+    uint32_t queueFamily() const { return queue_family; }
+
+    // Pass for this frame (captures should stay small, they are stored inline)
+    void addPass(const char* name, std::span<const ComputeImageUse> images, RecordFunction&& record);
+
+    // Submit the frame's passes to the compute queue (nothing to do when inline)
+    // Frame slot's previous graphics work must have completed (render fence waited)
+    void submit(uint32_t frame_index);
+
+    // Acquires (async) or inline passes on the graphics command buffer, clears the pass list
+    // Returns the timeline value the graphics submit must wait on (0 = no wait, see waitValue)
+    uint64_t recordGraphics(VkCommandBuffer cmd);
+    uint64_t waitValue() const { return frame_async ? submitted_value : 0; }
+
+    // Pipeline stages waiting on the timeline (first graphics use of the pass images)
+    VkPipelineStageFlags2 waitStages() const { return wait_stages; }
+
+    // Stats
+    uint32_t passes_submitted { 0 };        // Async passes last frame
+
+private:
+    struct Pass
+    {
+        const char* name { nullptr };
+        std::array<ComputeImageUse, MAX_PASS_IMAGES> images {};
+        uint32_t image_count { 0 };
+        RecordFunction record;
+    };
+
+    // Image barriers of one pass boundary
+    struct ImageBarriers
+    {
+        std::array<VkImageMemoryBarrier2, MAX_PASSES * MAX_PASS_IMAGES> barriers;
+        uint32_t count { 0 };
+
+        void add(const VkImageMemoryBarrier2& barrier) { barriers[count++] = barrier; }
+        void record(VkCommandBuffer cmd);
+    };
+
+    // UNDEFINED -> GENERAL before the pass writes the images (compute queue)
+    void recordPassStart(VkCommandBuffer cmd, const Pass& pass) const;
+
+    phVkEngine* engine { nullptr };
+    VkDevice device { VK_NULL_HANDLE };
+    VkQueue queue { VK_NULL_HANDLE };
+    uint32_t queue_family { 0 };
+    uint32_t graphics_family { 0 };
+
+    // One per frame slot, on the compute family
+    std::vector<VkCommandPool> command_pools;
+    std::vector<VkCommandBuffer> command_buffers;
+
+    std::array<Pass, MAX_PASSES> passes;
+    uint32_t pass_count { 0 };
+
+    // Acquire side of the ownership transfers of the last submit
+    ImageBarriers acquires;
+    VkPipelineStageFlags2 wait_stages { VK_PIPELINE_STAGE_2_NONE };
+
+    bool frame_async { false };             // Decided by submit() for the current frame
+    uint64_t next_value { 1 };
+    uint64_t submitted_value { 0 };         // Waited on by the next recordGraphics (0 = nothing submitted)
+};
@@ -0,0 +1,555 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Benchmark mode (deterministic camera path, JSON report)
+
+#include "phvk_benchmark.h"
+
+#include "phvk_engine.h"
+
+#include <SDL.h>
+
+#include "imgui.h"
+#include "imgui_impl_sdl2.h"
+#include "imgui_impl_vulkan.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+// *** Helpers ***
+
+static bool ParseCount(const char* text, uint32_t& value)
+{
+    const char* end = text + strlen(text);
+    auto [ptr, ec] = std::from_chars(text, end, value);
+    return ec == std::errc() && ptr == end;
+}
+
+static bool ParseMilliseconds(const char* text, float& value)
+{
+    const char* end = text + strlen(text);
+    auto [ptr, ec] = std::from_chars(text, end, value);
+    return ec == std::errc() && ptr == end && value > 0.f;
+}
+
+// Summary of one metric's samples (nearest-rank percentiles)
+struct SampleSummary
+{
+    float min { 0.f };
+    float avg { 0.f };
+    float p50 { 0.f };
+    float p90 { 0.f };
+    float p95 { 0.f };
+    float p99 { 0.f };
+    float max { 0.f };
+};
+
+static SampleSummary Summarize(std::vector<float> samples)
+{
+    SampleSummary s;
+    if (samples.empty())
+    {
+        return s;
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    auto percentile = [&](float p)
+        {
+            size_t rank = (size_t)std::ceil(p * samples.size());
+            return samples[std::clamp(rank, (size_t)1, samples.size()) - 1];
+        };
+
+    double sum = 0.0;
+    for (float v : samples)
+    {
+        sum += v;
+    }
+
+    s.min = samples.front();
+    s.max = samples.back();
+    s.avg = (float)(sum / samples.size());
+    s.p50 = percentile(0.50f);
+    s.p90 = percentile(0.90f);
+    s.p95 = percentile(0.95f);
+    s.p99 = percentile(0.99f);
+    return s;
+}
+
+static std::string SummaryJSON(const SampleSummary& s)
+{
+    return fmt::format("{{ \"min\": {:.4f}, \"avg\": {:.4f}, \"p50\": {:.4f}, \"p90\": {:.4f}, "
+        "\"p95\": {:.4f}, \"p99\": {:.4f}, \"max\": {:.4f} }}", s.min, s.avg, s.p50, s.p90, s.p95, s.p99, s.max);
+}
+
+// Minimal escaping for paths and device names
+static std::string EscapeJSON(std::string_view text)
+{
+    std::string out;
+    out.reserve(text.size());
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+
+// *** Arguments ***
+
+bool ParseBenchmarkArgs(int argc, char* argv[], BenchmarkSettings& settings, std::string& error)
+{
+    bool requested = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+        if (arg == "--benchmark" && value)
+        {
+            settings.scene_path = value;
+            requested = true;
+            i++;
+        }
+        else if (arg == "--frames" && value)
+        {
+            if (!ParseCount(value, settings.frames) || settings.frames == 0)
+            {
+                error = fmt::format("Invalid frame count: {}", value);
+            }
+            i++;
+        }
+        else if (arg == "--warmup" && value)
+        {
+            if (!ParseCount(value, settings.warmup_frames))
+            {
+                error = fmt::format("Invalid warmup frame count: {}", value);
+            }
+            i++;
+        }
+        else if (arg == "--output" && value)
+        {
+            settings.output_path = value;
+            i++;
+        }
+        else if (arg == "--vertex-format" && value)
+        {
+            std::string_view format = value;
+            if (format == "standard")
+            {
+                settings.vertex_format = VertexFormat::standard;
+            }
+            else if (format == "packed")
+            {
+                settings.vertex_format = VertexFormat::packed;
+            }
+            else
+            {
+                error = fmt::format("Unknown vertex format: {}", value);
+            }
+            i++;
+        }
+        else if (arg == "--frames-in-flight" && value)
+        {
+            if (!ParseCount(value, settings.frames_in_flight) || 
+                settings.frames_in_flight == 0 || settings.frames_in_flight > MAX_FRAME_OVERLAP)
+            {
+                error = fmt::format("Invalid frames in flight (1 - {}): {}", MAX_FRAME_OVERLAP, value);
+            }
+            i++;
+        }
+        else if (arg == "--target-gpu-ms" && value)
+        {
+            if (!ParseMilliseconds(value, settings.target_gpu_time))
+            {
+                error = fmt::format("Invalid target GPU time (ms): {}", value);
+            }
+            i++;
+        }
+        else if (arg == "--present-mode" && value)
+        {
+            std::string_view mode = value;
+            if (mode == "fifo")
+            {
+                settings.present_mode = VK_PRESENT_MODE_FIFO_KHR;
+            }
+            else if (mode == "mailbox")
+            {
+                settings.present_mode = VK_PRESENT_MODE_MAILBOX_KHR;
+            }
+            else if (mode == "immediate")
+            {
+                settings.present_mode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+            }
+            else
+            {
+                error = fmt::format("Unknown present mode: {}", value);
+            }
+            i++;
+        }
+        else if (arg == "--offscreen")
+        {
+            settings.offscreen = true;
+        }
+        else if (arg == "--cpu-culling")
+        {
+            settings.gpu_culling = false;
+        }
+        else if (arg == "--serial-recording")
+        {
+            settings.parallel_recording = false;
+        }
+        else if (arg == "--inline-compute")
+        {
+            settings.async_compute = false;
+        }
+        else
+        {
+            error = fmt::format("Unknown or incomplete argument: {}", arg);
+        }
+    }
+
+    if (!requested)
+    {
+        if (error.empty() && argc > 1)
+        {
+            error = "Benchmark options require --benchmark <scene.glb>";
+        }
+        return false;
+    }
+
+    // Fall back to the assets directory used by the interactive mode
+    if (!std::filesystem::exists(settings.scene_path))
+    {
+        std::filesystem::path asset_path = std::filesystem::path("../../../../assets") / settings.scene_path;
+        if (std::filesystem::exists(asset_path))
+        {
+            settings.scene_path = asset_path.string();
+        }
+    }
+
+    return error.empty();
+}
+
+
+// *** BenchmarkCameraPath ***
+
+void BenchmarkCameraPath::fitBounds(const Vec3f& min, const Vec3f& max)
+{
+    center = Vec3f((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+
+    float dx = max.x - min.x;
+    float dy = max.y - min.y;
+    float dz = max.z - min.z;
+    radius = std::max(0.5f * std::sqrt(dx * dx + dy * dy + dz * dz), 1.f);
+}
+
+void BenchmarkCameraPath::apply(Camera& camera, uint32_t frame, uint32_t frame_count) const
+{
+    // One full orbit over the run, bobbing between two heights
+    const float two_pi = 6.28318531f;
+    float angle = two_pi * (float)frame / (float)std::max(frame_count, 1u);
+    float distance = radius * 1.6f;
+    float height = radius * (0.25f + 0.15f * std::sin(2.f * angle));
+
+    camera.position = Vec3f(
+        center.x + distance * std::sin(angle),
+        center.y + height,
+        center.z + distance * std::cos(angle));
+    camera.velocity = Vec3f();
+
+    // Look at the center (forward is -Z, yaw about -Y, pitch about X)
+    float dx = center.x - camera.position.x;
+    float dy = center.y - camera.position.y;
+    float dz = center.z - camera.position.z;
+
+    camera.yaw = std::atan2(dx, -dz);
+    camera.pitch = std::atan2(dy, std::sqrt(dx * dx + dz * dz));
+}
+
+
+// *** RunBenchmark ***
+
+bool RunBenchmark(phVkEngine* engine, const BenchmarkSettings& settings)
+{
+    const std::string scene_name = "benchmark";
+
+    engine->use_gpu_culling = settings.gpu_culling;
+    engine->use_parallel_recording = settings.parallel_recording;
+    engine->async_compute.enabled = settings.async_compute;
+    engine->dynamic_resolution = settings.target_gpu_time > 0.f;
+    if (engine->dynamic_resolution)
+    {
+        engine->target_gpu_time = settings.target_gpu_time;
+    }
+    engine->gpu_profiler.enabled = true;
+
+    // One frame of the normal loop without input handling (returns false on window close / resize)
+    auto render_frame = [&]()
+        {
+            engine->paceFrame();
+
+            SDL_Event sdl_event;
+            while (SDL_PollEvent(&sdl_event) != 0)
+            {
+                if (sdl_event.type == SDL_QUIT)
+                {
+                    return false;
+                }
+            }
+
+            ImGui_ImplVulkan_NewFrame();
+            ImGui_ImplSDL2_NewFrame();
+            ImGui::NewFrame();
+            ImGui::Render();
+
+            engine->draw();
+
+            // Results are only comparable at a fixed resolution
+            if (engine->resize_requested)
+            {
+                fmt::println("Benchmark: swapchain out of date (window resized)");
+                return false;
+            }
+            return true;
+        };
+
+    // *** Load ***
+    fmt::println("Benchmark: loading {}", settings.scene_path);
+
+    auto load_start = std::chrono::steady_clock::now();
+    engine->loadSceneAsync(scene_name, settings.scene_path, settings.vertex_format);
+
+    while (!engine->pending_loads.empty())
+    {
+        if (!render_frame())
+        {
+            return false;
+        }
+    }
+
+    auto load_it = engine->loaded_scenes.find(scene_name);
+    if (load_it == engine->loaded_scenes.end())
+    {
+        fmt::println("Benchmark: failed to load {}", settings.scene_path);
+        return false;
+    }
+
+    float load_ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+
+    // *** Camera Path ***
+    DrawContext context;
+    load_it->second->draw(Mat4f(), context);
+
+    Vec3f min = { FLT_MAX, FLT_MAX, FLT_MAX };
+    Vec3f max = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    size_t surface_count = 0;
+
+    auto add_bounds = [&](const RenderObject& obj)
+        {
+            for (int c = 0; c < 8; c++)
+            {
+                Vec3f corner = obj.bounds.origin + Vec3f(
+                    (c & 1 ? 1.f : -1.f) * obj.bounds.extents.x,
+                    (c & 2 ? 1.f : -1.f) * obj.bounds.extents.y,
+                    (c & 4 ? 1.f : -1.f) * obj.bounds.extents.z);
+                Vec4f v = obj.transform * Vec4f(corner, 1.f);
+
+                min = Vec3f(std::min(v.x, min.x), std::min(v.y, min.y), std::min(v.z, min.z));
+                max = Vec3f(std::max(v.x, max.x), std::max(v.y, max.y), std::max(v.z, max.z));
+            }
+            surface_count++;
+        };
+
+    for (const RenderObject& obj : context.opaque_surfaces)
+    {
+        add_bounds(obj);
+    }
+    for (const RenderObject& obj : context.transparent_surfaces)
+    {
+        add_bounds(obj);
+    }
+
+    BenchmarkCameraPath path;
+    if (surface_count > 0)
+    {
+        path.fitBounds(min, max);
+    }
+
+    // GPU results resolve frame_overlap frames late, keep the ones from the measured range
+    // Metrics are registered (and their samples reserved) during warmup, so the sink doesn't
+    // allocate inside the measured frames' heap_allocations
+    uint64_t first_frame = UINT64_MAX;
+    std::vector<std::pair<std::string, std::vector<float>>> gpu_samples;
+    gpu_samples.reserve(GPUProfiler::MAX_SCOPES + 1);
+
+    engine->gpu_profiler.on_sample = [&](uint64_t frame_number, const std::string& metric, float ms)
+        {
+            auto it = std::find_if(gpu_samples.begin(), gpu_samples.end(),
+                [&](const auto& entry) { return entry.first == metric; });
+            if (it == gpu_samples.end())
+            {
+                gpu_samples.emplace_back(metric, std::vector<float>());
+                it = gpu_samples.end() - 1;
+                it->second.reserve(settings.frames);
+            }
+
+            if (frame_number >= first_frame && frame_number - first_frame < settings.frames)
+            {
+                it->second.push_back(ms);
+            }
+        };
+
+    // *** Warmup ***
+    // Lets uploads land and pipelines / caches settle before measuring
+    for (uint32_t i = 0; i < settings.warmup_frames; i++)
+    {
+        path.apply(engine->main_camera, 0, settings.frames);
+        if (!render_frame())
+        {
+            engine->gpu_profiler.on_sample = nullptr;
+            return false;
+        }
+    }
+
+    // *** Measured Frames ***
+    std::vector<float> frame_times, draw_times, draw_calls, instances, triangles, heap_allocations, input_latencies,
+        render_scales;
+    frame_times.reserve(settings.frames);
+    draw_times.reserve(settings.frames);
+    draw_calls.reserve(settings.frames);
+    instances.reserve(settings.frames);
+    triangles.reserve(settings.frames);
+    heap_allocations.reserve(settings.frames);
+    input_latencies.reserve(settings.frames);
+    render_scales.reserve(settings.frames);
+
+    first_frame = (uint64_t)engine->frame_number;
+
+    bool completed = true;
+    for (uint32_t i = 0; i < settings.frames && completed; i++)
+    {
+        auto frame_start = std::chrono::steady_clock::now();
+
+        path.apply(engine->main_camera, i, settings.frames);
+        const uint64_t allocations = HeapAllocationCount();
+        completed = render_frame();
+        heap_allocations.push_back((float)(HeapAllocationCount() - allocations));
+
+        frame_times.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - frame_start).count());
+        draw_times.push_back(engine->stats.mesh_draw_time);
+        draw_calls.push_back((float)engine->stats.drawcall_count);
+        instances.push_back((float)engine->stats.instance_count);
+        triangles.push_back((float)engine->stats.triangle_count);
+        input_latencies.push_back(engine->stats.input_latency);
+        render_scales.push_back(engine->render_scale);
+    }
+
+    // Resolve the last measured frames' queries
+    for (uint32_t i = 0; i < engine->frame_overlap && completed; i++)
+    {
+        completed = render_frame();
+    }
+
+    engine->gpu_profiler.on_sample = nullptr;
+
+    if (!completed)
+    {
+        fmt::println("Benchmark: stopped before the run finished");
+        return false;
+    }
+
+    // *** Report ***
+    SampleSummary frame_summary = Summarize(frame_times);
+
+    std::string json = "{\n";
+    json += fmt::format("  \"scene\": \"{}\",\n", EscapeJSON(settings.scene_path));
+    json += fmt::format("  \"device\": \"{}\",\n", EscapeJSON(engine->physical_device_properties.deviceName));
+    json += fmt::format("  \"resolution\": [{}, {}],\n", engine->window_extent.width, engine->window_extent.height);
+    json += fmt::format("  \"frames\": {},\n", settings.frames);
+    json += fmt::format("  \"warmup_frames\": {},\n", settings.warmup_frames);
+    json += fmt::format("  \"offscreen\": {},\n", settings.offscreen);
+    json += fmt::format("  \"gpu_culling\": {},\n", engine->isGPUDriven());
+    json += fmt::format("  \"parallel_recording\": {},\n", settings.parallel_recording);
+    json += fmt::format("  \"instancing\": {},\n", engine->isInstancing());
+    json += fmt::format("  \"bindless\": {},\n", engine->metal_rough_material.isBindless());
+    json += fmt::format("  \"async_compute\": {},\n", engine->async_compute.isAsync());
+    json += fmt::format("  \"frames_in_flight\": {},\n", engine->frame_overlap);
+    json += fmt::format("  \"target_gpu_ms\": {},\n", settings.target_gpu_time);
+    json += fmt::format("  \"present_mode\": {},\n", (int)engine->active_present_mode);
+    json += fmt::format("  \"vertex_format\": \"{}\",\n",
+        settings.vertex_format == VertexFormat::packed ? "packed" : "standard");
+    json += fmt::format("  \"load_ms\": {:.2f},\n", load_ms);
+    json += fmt::format("  \"surfaces\": {},\n", surface_count);
+    json += fmt::format("  \"graph_barriers\": {},\n", engine->stats.graph_barriers);
+    json += fmt::format("  \"graph_barrier_batches\": {},\n", engine->stats.graph_barrier_batches);
+
+    // GPU memory at the end of the run
+    const MemoryManager& memory = engine->memory_manager;
+    auto megabytes = [](VkDeviceSize bytes) { return bytes / (1024.0 * 1024.0); };
+    json += fmt::format("  \"memory_mb\": {{ \"mesh\": {:.2f}, \"texture\": {:.2f}, \"transient\": {:.2f}, \"other\": {:.2f} }},\n",
+        megabytes(memory.categoryBytes(MemoryCategory::mesh)), megabytes(memory.categoryBytes(MemoryCategory::texture)),
+        megabytes(memory.categoryBytes(MemoryCategory::transient)), megabytes(memory.categoryBytes(MemoryCategory::other)));
+    json += "  \"memory_heaps\": [";
+    for (uint32_t i = 0; i < memory.heapCount(); i++)
+    {
+        const MemoryManager::HeapStats& heap = memory.heap(i);
+        json += fmt::format("{}\n    {{ \"device_local\": {}, \"budget_mb\": {:.2f}, \"usage_mb\": {:.2f} }}", 
+            (i > 0) ? "," : "", heap.device_local, megabytes(heap.budget), megabytes(heap.usage));
+    }
+    json += memory.heapCount() == 0 ? "],\n" : "\n  ],\n";
+    json += fmt::format("  \"memory_fragmentation\": {:.4f},\n", memory.fragmentation());
+    json += fmt::format("  \"defrag_moves\": {},\n", memory.defrag_moves);
+    json += fmt::format("  \"defrag_mb\": {:.2f},\n", megabytes(memory.defrag_bytes));
+
+    json += fmt::format("  \"frame_time_ms\": {},\n", SummaryJSON(frame_summary));
+    json += fmt::format("  \"cpu_draw_time_ms\": {},\n", SummaryJSON(Summarize(draw_times)));
+    json += fmt::format("  \"draw_calls\": {},\n", SummaryJSON(Summarize(draw_calls)));
+    json += fmt::format("  \"instances\": {},\n", SummaryJSON(Summarize(instances)));
+    json += fmt::format("  \"triangles\": {},\n", SummaryJSON(Summarize(triangles)));
+    json += fmt::format("  \"heap_allocations\": {},\n", SummaryJSON(Summarize(heap_allocations)));
+    json += fmt::format("  \"input_latency_ms\": {},\n", SummaryJSON(Summarize(input_latencies)));
+    json += fmt::format("  \"render_scale\": {},\n", SummaryJSON(Summarize(render_scales)));
+
+    // Metrics only seen during warmup are left out
+    json += "  \"gpu_ms\": {";
+    size_t gpu_metrics = 0;
+    for (const auto& [metric, samples] : gpu_samples)
+    {
+        if (samples.empty())
+        {
+            continue;
+        }
+
+        json += fmt::format("{}\n    \"{}\": {}", (gpu_metrics > 0) ? "," : "", EscapeJSON(metric),
+            SummaryJSON(Summarize(samples)));
+        gpu_metrics++;
+    }
+    json += (gpu_metrics == 0) ? "}\n" : "\n  }\n";
+    json += "}\n";
+
+    std::ofstream file(settings.output_path, std::ios::trunc);
+    if (!file.is_open())
+    {
+        fmt::println("Benchmark: failed to open {}", settings.output_path);
+        return false;
+    }
+    file << json;
+    file.close();
+
+    fmt::println("Benchmark: {} frames, avg {:.2f} ms, p99 {:.2f} ms, report written to {}",
+        settings.frames, frame_summary.avg, frame_summary.p99, settings.output_path);
+
+    return true;
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Benchmark mode (deterministic camera path, JSON report)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <string>
+
+class phVkEngine;
+class Camera;
+
+// Command line:
+//   acid-vulkan --benchmark <scene.glb> [--frames N] [--warmup N] [--offscreen]
+//       [--output report.json] [--vertex-format standard|packed] [--cpu-culling] [--serial-recording]
+//       [--frames-in-flight N] [--present-mode fifo|mailbox|immediate] [--inline-compute]
+//       [--target-gpu-ms MS]
+// Relative scene paths that don't exist are looked up in assets/
+struct BenchmarkSettings
+{
+    std::string scene_path;
+    uint32_t frames { 1000 };          // Measured frames (one camera orbit)
+    uint32_t warmup_frames { 100 };    // Rendered after loading, not measured
+    bool offscreen { false };          // Hidden window, no acquire / present
+    bool gpu_culling { true };
+    bool parallel_recording { true };
+    bool async_compute { true };       // Background effect on the compute queue (if the device has one)
+    float target_gpu_time { 0.f };     // ms, dynamic resolution target (0 = full resolution)
+    VertexFormat vertex_format { VertexFormat::standard };     // packed is lossy (--vertex-format packed)
+    uint32_t frames_in_flight { 2 };
+    VkPresentModeKHR present_mode { VK_PRESENT_MODE_FIFO_KHR };     // FIFO if unsupported
+    std::string output_path { "benchmark.json" };
+};
+
+// Returns false if benchmark mode wasn't requested or the arguments are invalid
+// (error is set for invalid arguments)
+bool ParseBenchmarkArgs(int argc, char* argv[], BenchmarkSettings& settings, std::string& error);
+
+// Orbit around the scene bounds, a pure function of the frame index
+struct BenchmarkCameraPath
+{
+    Vec3f center;
+    float radius { 1.f };
+
+    void fitBounds(const Vec3f& min, const Vec3f& max);
+    void apply(Camera& camera, uint32_t frame, uint32_t frame_count) const;
+};
+
+// Engine must be initialized with headless / load_default_scene / frame_overlap / present_mode 
+// set from the settings
+// Loads the scene, renders the warmup and measured frames and writes the JSON report
+bool RunBenchmark(phVkEngine* engine, const BenchmarkSettings& settings);
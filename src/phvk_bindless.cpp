@@ -0,0 +1,272 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Bindless materials (global texture array + material buffer)
+
+#include "phvk_bindless.h"
+
+#include "phvk_engine.h"
+
+#include <algorithm>
+
+bool BindlessRegistry::init(phVkEngine* engine)
+{
+    device = engine->device;
+
+    // *** Capacity ***
+    // Combined image samplers count against both the sampled image and sampler limits
+    VkPhysicalDeviceVulkan12Properties props12 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES };
+    VkPhysicalDeviceProperties2 props { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+    props.pNext = &props12;
+    vkGetPhysicalDeviceProperties2(engine->physical_device, &props);
+
+    texture_capacity = std::min({ MAX_TEXTURES,
+        props12.maxDescriptorSetUpdateAfterBindSampledImages,
+        props12.maxDescriptorSetUpdateAfterBindSamplers,
+        props12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+        props12.maxPerStageDescriptorUpdateAfterBindSamplers });
+
+    if (texture_capacity < 256)
+    {
+        fmt::println("Bindless materials disabled: device supports {} update-after-bind textures", texture_capacity);
+        texture_capacity = 0;
+        return false;
+    }
+
+    // *** Layout ***
+    DescriptorLayoutBuilder builder;
+    builder.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    builder.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    builder.bindings[1].descriptorCount = texture_capacity;
+
+    // Material buffer is written once, textures are added while earlier frames are in flight
+    VkDescriptorBindingFlags binding_flags[] = {
+        0,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+        VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flags_info { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO };
+    flags_info.bindingCount = 2;
+    flags_info.pBindingFlags = binding_flags;
+
+    layout = builder.build(engine->resource_cache, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | engine->meshShaderStages(),
+        &flags_info, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+
+    // *** Pool / Set ***
+    VkDescriptorPoolSize pool_sizes[] = {
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, texture_capacity } };
+
+    VkDescriptorPoolCreateInfo pool_info { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+    pool_info.maxSets = 1;
+    pool_info.poolSizeCount = 2;
+    pool_info.pPoolSizes = pool_sizes;
+
+    VK_CHECK(vkCreateDescriptorPool(device, &pool_info, nullptr, &pool));
+
+    VkDescriptorSetVariableDescriptorCountAllocateInfo count_info { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO };
+    count_info.descriptorSetCount = 1;
+    count_info.pDescriptorCounts = &texture_capacity;
+
+    VkDescriptorSetAllocateInfo alloc_info { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    alloc_info.pNext = &count_info;
+    alloc_info.descriptorPool = pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &layout;
+
+    VK_CHECK(vkAllocateDescriptorSets(device, &alloc_info, &set));
+
+    // *** Material Buffer ***
+    material_buffer = engine->createBuffer(MAX_MATERIALS * sizeof(GPUBindlessMaterial),
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    materials = (GPUBindlessMaterial*)material_buffer.info.pMappedData;
+
+    DescriptorWriter writer;
+    writer.writeBuffer(0, material_buffer.buffer, MAX_MATERIALS * sizeof(GPUBindlessMaterial), 0,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    writer.updateSet(device, set);
+
+    textures.reserve(256);
+    material_textures.resize(MAX_MATERIALS);
+
+    return true;
+}
+
+void BindlessRegistry::destroy(phVkEngine* engine)
+{
+    if (pool != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+        engine->destroyBuffer(material_buffer);
+    }
+
+    pool = VK_NULL_HANDLE;
+    layout = VK_NULL_HANDLE;
+    set = VK_NULL_HANDLE;
+    materials = nullptr;
+
+    textures.clear();
+    texture_lookup.clear();
+    free_textures.clear();
+    free_materials.clear();
+    material_textures.clear();
+    next_material = 0;
+    texture_count = 0;
+    material_count = 0;
+}
+
+uint32_t BindlessRegistry::registerTexture(VkImageView view, VkSampler sampler)
+{
+    auto key = std::make_pair(view, sampler);
+
+    auto it = texture_lookup.find(key);
+    if (it != texture_lookup.end())
+    {
+        textures[it->second].refs++;
+        return it->second;
+    }
+
+    uint32_t id;
+    if (!free_textures.empty())
+    {
+        id = free_textures.back();
+        free_textures.pop_back();
+    }
+    else
+    {
+        if (textures.size() >= texture_capacity)
+        {
+            fmt::println("Bindless texture array full ({} textures)", texture_capacity);
+            abort();
+        }
+
+        id = (uint32_t)textures.size();
+        textures.emplace_back();
+    }
+
+    textures[id] = TextureSlot{ view, sampler, 1 };
+    texture_lookup[key] = id;
+    texture_count++;
+
+    VkDescriptorImageInfo image_info {};
+    image_info.sampler = sampler;
+    image_info.imageView = view;
+    image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet write = { .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+    write.dstSet = set;
+    write.dstBinding = 1;
+    write.dstArrayElement = id;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image_info;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+    return id;
+}
+
+void BindlessRegistry::releaseTexture(uint32_t id)
+{
+    TextureSlot& slot = textures[id];
+    assert(slot.refs > 0);
+
+    if (--slot.refs > 0)
+    {
+        return;
+    }
+
+    // Slot stays partially bound until it is reused
+    texture_lookup.erase(std::make_pair(slot.view, slot.sampler));
+    slot = TextureSlot();
+    free_textures.push_back(id);
+    texture_count--;
+}
+
+void BindlessRegistry::replaceView(VkImageView old_view, VkImageView new_view, std::vector<uint32_t>& retired)
+{
+    const size_t first_retired = retired.size();
+    std::vector<uint32_t> replacements;
+
+    // registerTexture may grow textures, index instead of holding references
+    const uint32_t slot_count = (uint32_t)textures.size();
+    for (uint32_t id = 0; id < slot_count; id++)
+    {
+        if (textures[id].refs == 0 || textures[id].view != old_view)
+        {
+            continue;
+        }
+
+        const TextureSlot old_slot = textures[id];
+        uint32_t new_id = registerTexture(new_view, old_slot.sampler);
+        textures[new_id].refs = old_slot.refs;
+
+        // Out of the lookup, only the retired list references it now
+        texture_lookup.erase(std::make_pair(old_slot.view, old_slot.sampler));
+        textures[id].refs = 1;
+
+        retired.push_back(id);
+        replacements.push_back(new_id);
+    }
+
+    if (replacements.empty())
+    {
+        return;
+    }
+
+    // Material texture IDs are single 32-bit writes, frames in flight read either slot
+    for (uint32_t index = 0; index < next_material; index++)
+    {
+        std::pair<uint32_t, uint32_t>& ids = material_textures[index];
+        for (size_t i = 0; i < replacements.size(); i++)
+        {
+            const uint32_t old_id = retired[first_retired + i];
+            if (ids.first == old_id)
+            {
+                ids.first = replacements[i];
+                materials[index].color_tex_id = (int32_t)replacements[i];
+            }
+            if (ids.second == old_id)
+            {
+                ids.second = replacements[i];
+                materials[index].metal_rough_tex_id = (int32_t)replacements[i];
+            }
+        }
+    }
+}
+
+uint32_t BindlessRegistry::allocateMaterial(const GPUBindlessMaterial& material)
+{
+    uint32_t index;
+    if (!free_materials.empty())
+    {
+        index = free_materials.back();
+        free_materials.pop_back();
+    }
+    else
+    {
+        if (next_material >= MAX_MATERIALS)
+        {
+            fmt::println("Bindless material buffer full ({} materials)", MAX_MATERIALS);
+            abort();
+        }
+
+        index = next_material++;
+    }
+
+    materials[index] = material;
+    material_textures[index] = { (uint32_t)material.color_tex_id, (uint32_t)material.metal_rough_tex_id };
+    material_count++;
+
+    return index;
+}
+
+void BindlessRegistry::freeMaterial(uint32_t index)
+{
+    releaseTexture(material_textures[index].first);
+    releaseTexture(material_textures[index].second);
+
+    free_materials.push_back(index);
+    material_count--;
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Bindless materials (global texture array + material buffer)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <map>
+#include <utility>
+
+class phVkEngine;
+
+// Per-material constants in the bindless material buffer
+// Must match MaterialData in input_structures.glsl (USE_BINDLESS, std430, 48 bytes)
+struct GPUBindlessMaterial
+{
+    Vec4f color_factors;
+    Vec4f metal_rough_factors;
+    int32_t color_tex_id;
+    int32_t metal_rough_tex_id;
+    uint32_t pad[2];
+};
+
+// One global descriptor set shared by every material:
+//   binding 0: GPUBindlessMaterial[] storage buffer, indexed by material index
+//   binding 1: combined image sampler array (variable count, partially bound, update-after-bind)
+// Materials only differ by an index, so switching materials needs no descriptor binds and
+// indirect batches can span materials.
+// Not thread-safe, registration happens on the main thread (material writes)
+struct BindlessRegistry
+{
+    static constexpr uint32_t MAX_TEXTURES = 16384;     // Clamped to device limits
+    static constexpr uint32_t MAX_MATERIALS = 16384;
+
+    VkDescriptorSetLayout layout { VK_NULL_HANDLE };
+    VkDescriptorSet set { VK_NULL_HANDLE };
+
+    bool isValid() const { return set != VK_NULL_HANDLE; }
+
+    // Returns false (and stays invalid) if the device limits are too low
+    bool init(phVkEngine* engine);
+    void destroy(phVkEngine* engine);
+
+    // Identical view + sampler pairs share one slot (reference counted)
+    // The descriptor is written immediately, the image must stay alive until released
+    uint32_t registerTexture(VkImageView view, VkSampler sampler);
+    void releaseTexture(uint32_t id);
+
+    // Points every material using old_view at new_view (same samplers, new slots)
+    // The old slots keep one reference each and are appended to retired, release them once
+    // no frame in flight can read them (slots can't be rewritten while in use)
+    void replaceView(VkImageView old_view, VkImageView new_view, std::vector<uint32_t>& retired);
+
+    // Texture IDs in the material are owned by the material slot (released with it)
+    uint32_t allocateMaterial(const GPUBindlessMaterial& material);
+    void freeMaterial(uint32_t index);
+
+    // Stats
+    uint32_t textureCount() const { return texture_count; }
+    uint32_t materialCount() const { return material_count; }
+    uint32_t textureCapacity() const { return texture_capacity; }
+
+private:
+    struct TextureSlot
+    {
+        VkImageView view { VK_NULL_HANDLE };
+        VkSampler sampler { VK_NULL_HANDLE };
+        uint32_t refs { 0 };
+    };
+
+    VkDevice device { VK_NULL_HANDLE };
+    VkDescriptorPool pool { VK_NULL_HANDLE };
+
+    AllocatedBuffer material_buffer {};     // Persistently mapped, written in place
+    GPUBindlessMaterial* materials { nullptr };
+    std::vector<std::pair<uint32_t, uint32_t>> material_textures;    // CPU copy of each slot's texture IDs
+
+    std::vector<TextureSlot> textures;
+    std::map<std::pair<VkImageView, VkSampler>, uint32_t> texture_lookup;
+    std::vector<uint32_t> free_textures;
+    std::vector<uint32_t> free_materials;
+
+    uint32_t texture_capacity { 0 };
+    uint32_t next_material { 0 };
+    uint32_t texture_count { 0 };
+    uint32_t material_count { 0 };
+};
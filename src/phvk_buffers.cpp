@@ -0,0 +1,90 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Per-frame linear upload buffer
+
+#include "phvk_buffers.h"
+
+#include "phvk_engine.h"
+
+#include <algorithm>
+
+void LinearUploadBuffer::init(phVkEngine* engine, VkDeviceSize size, VkDeviceSize min_alignment)
+{
+    alignment = std::max<VkDeviceSize>(min_alignment, 16);
+    head = 0;
+    frame_usage = 0;
+
+    blocks.push_back(createBlock(engine, size));
+}
+
+void LinearUploadBuffer::destroy(phVkEngine* engine)
+{
+    for (Block& b : blocks)
+    {
+        engine->destroyBuffer(b.buffer);
+    }
+    blocks.clear();
+}
+
+bool LinearUploadBuffer::reset(phVkEngine* engine)
+{
+    // Called after the frame's fence has signaled, so all blocks are idle
+    bool recreated = false;
+
+    if (blocks.size() > 1)
+    {
+        // Overflowed last time: replace everything with one block that fits the whole frame
+        VkDeviceSize new_size = std::max(frame_usage, blocks[0].size) * 2;
+
+        destroy(engine);
+        blocks.push_back(createBlock(engine, new_size));
+
+        recreated = true;
+    }
+
+    head = 0;
+    frame_usage = 0;
+
+    return recreated;
+}
+
+UploadAllocation LinearUploadBuffer::allocate(phVkEngine* engine, VkDeviceSize size)
+{
+    VkDeviceSize offset = (head + alignment - 1) & ~(alignment - 1);
+    VkDeviceSize padding = offset - head;
+
+    if (offset + size > blocks.back().size)
+    {
+        // Out of space: chain an overflow block for the rest of the frame
+        blocks.push_back(createBlock(engine, std::max(blocks.back().size, size)));
+        offset = 0;
+        padding = 0;
+    }
+
+    Block& block = blocks.back();
+
+    frame_usage += padding + size;
+    head = offset + size;
+
+    UploadAllocation alloc;
+    alloc.data = (char*)block.buffer.info.pMappedData + offset;
+    alloc.buffer = block.buffer.buffer;
+    alloc.offset = offset;
+    alloc.address = block.address + offset;
+
+    return alloc;
+}
+
+LinearUploadBuffer::Block LinearUploadBuffer::createBlock(phVkEngine* engine, VkDeviceSize size)
+{
+    Block block;
+    block.size = size;
+    block.buffer = engine->createBuffer(size,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_CPU_TO_GPU, MemoryCategory::transient);
+    block.address = engine->getBufferAddress(block.buffer.buffer);
+
+    return block;
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Per-frame linear upload buffer
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <cstring>
+
+class phVkEngine;
+
+// Sub-allocation from a LinearUploadBuffer
+struct UploadAllocation
+{
+    void* data { nullptr };         // Persistently mapped CPU pointer
+    VkBuffer buffer { VK_NULL_HANDLE };
+    VkDeviceSize offset { 0 };      // Offset into buffer (use as dynamic offset)
+    VkDeviceAddress address { 0 };  // Device address of the allocation
+};
+
+// Persistently mapped bump allocator for transient per-frame data
+// (scene uniforms, per-draw data, culling inputs, etc.)
+// One per FrameData, reset once the frame's fence has signaled
+struct LinearUploadBuffer
+{
+    struct Block
+    {
+        AllocatedBuffer buffer;
+        VkDeviceAddress address;
+        VkDeviceSize size;
+    };
+
+    // blocks[0] is the primary block, pre-built descriptor sets point into it
+    // Additional blocks are overflow for the current frame and get merged on reset
+    std::vector<Block> blocks;
+    VkDeviceSize head { 0 };        // Offset into the last block
+    VkDeviceSize alignment { 256 };
+    VkDeviceSize frame_usage { 0 }; // Total bytes allocated this frame (incl. alignment)
+
+    void init(phVkEngine* engine, VkDeviceSize size, VkDeviceSize min_alignment);
+    void destroy(phVkEngine* engine);
+
+    // Returns true if the primary block was recreated (descriptor sets must be rewritten)
+    bool reset(phVkEngine* engine);
+
+    UploadAllocation allocate(phVkEngine* engine, VkDeviceSize size);
+
+    template <typename T>
+    UploadAllocation push(phVkEngine* engine, const T& value)
+    {
+        UploadAllocation alloc = allocate(engine, sizeof(T));
+        memcpy(alloc.data, &value, sizeof(T));
+        return alloc;
+    }
+
+    VkBuffer primaryBuffer() const { return blocks[0].buffer.buffer; }
+
+private:
+    Block createBlock(phVkEngine* engine, VkDeviceSize size);
+};
@@ -0,0 +1,200 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Bounding volume hierarchy (culling, later picking / occlusion queries)
+
+#include "phvk_bvh.h"
+
+#include "phvk_engine.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+static BoundingBox EmptyBox()
+{
+    return { Vec3f(FLT_MAX, FLT_MAX, FLT_MAX), Vec3f(-FLT_MAX, -FLT_MAX, -FLT_MAX) };
+}
+
+static void GrowBox(BoundingBox& box, const BoundingBox& other)
+{
+    box.min = Vec3f(std::min(box.min.x, other.min.x), std::min(box.min.y, other.min.y), std::min(box.min.z, other.min.z));
+    box.max = Vec3f(std::max(box.max.x, other.max.x), std::max(box.max.y, other.max.y), std::max(box.max.z, other.max.z));
+}
+
+BoundingBox WorldBoundingBox(const RenderObject& obj)
+{
+    // Column-major, translation in m[12..14]
+    float m[16];
+    memcpy(m, &obj.transform, sizeof(m));
+
+    const Vec3f& o = obj.bounds.origin;
+    const Vec3f& e = obj.bounds.extents;
+
+    Vec3f center(
+        m[0] * o.x + m[4] * o.y + m[8] * o.z + m[12],
+        m[1] * o.x + m[5] * o.y + m[9] * o.z + m[13],
+        m[2] * o.x + m[6] * o.y + m[10] * o.z + m[14]);
+
+    // Extents of the transformed box: |M| * e
+    Vec3f extents(
+        std::abs(m[0]) * e.x + std::abs(m[4]) * e.y + std::abs(m[8]) * e.z,
+        std::abs(m[1]) * e.x + std::abs(m[5]) * e.y + std::abs(m[9]) * e.z,
+        std::abs(m[2]) * e.x + std::abs(m[6]) * e.y + std::abs(m[10]) * e.z);
+
+    return { Vec3f(center.x - extents.x, center.y - extents.y, center.z - extents.z),
+        Vec3f(center.x + extents.x, center.y + extents.y, center.z + extents.z) };
+}
+
+CullResult ClassifyBox(const BoundingBox& box, const Vec4f planes[6])
+{
+    Vec3f center((box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f);
+    Vec3f extents((box.max.x - box.min.x) * 0.5f, (box.max.y - box.min.y) * 0.5f, (box.max.z - box.min.z) * 0.5f);
+
+    bool inside = true;
+    for (int p = 0; p < 6; p++)
+    {
+        float d = planes[p].x * center.x + planes[p].y * center.y + planes[p].z * center.z + planes[p].w;
+        float r = std::abs(planes[p].x) * extents.x + std::abs(planes[p].y) * extents.y +
+            std::abs(planes[p].z) * extents.z;
+
+        if (d < -r)
+        {
+            return CullResult::outside;
+        }
+        inside = inside && d >= r;
+    }
+    return inside ? CullResult::inside : CullResult::intersecting;
+}
+
+
+// *** BoundsHierarchy ***
+
+void BoundsHierarchy::build(const std::vector<BoundingBox>& boxes)
+{
+    nodes.clear();
+    subtree_items.clear();
+    items.resize(boxes.size());
+    for (uint32_t i = 0; i < (uint32_t)boxes.size(); i++)
+    {
+        items[i] = i;
+    }
+
+    if (boxes.empty())
+    {
+        return;
+    }
+
+    // At most 2n - 1 nodes
+    nodes.reserve(boxes.size() * 2);
+    subtree_items.reserve(boxes.size() * 2);
+
+    nodes.push_back({});
+    subtree_items.push_back({});
+    buildNode(boxes, 0, 0, (uint32_t)boxes.size(), 0);
+}
+
+void BoundsHierarchy::buildNode(const std::vector<BoundingBox>& boxes, uint32_t node, uint32_t first, uint32_t count,
+    uint32_t depth)
+{
+    BoundingBox box = EmptyBox();
+    BoundingBox centroids = EmptyBox();
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        const BoundingBox& b = boxes[items[i]];
+        GrowBox(box, b);
+
+        Vec3f c((b.min.x + b.max.x) * 0.5f, (b.min.y + b.max.y) * 0.5f, (b.min.z + b.max.z) * 0.5f);
+        GrowBox(centroids, { c, c });
+    }
+
+    nodes[node].box = box;
+    subtree_items[node] = { first, count };
+
+    if (count <= MAX_LEAF_ITEMS || depth >= MAX_DEPTH)
+    {
+        nodes[node].first = first;
+        nodes[node].count = count;
+        return;
+    }
+
+    // Longest centroid axis, split at the median
+    Vec3f size(centroids.max.x - centroids.min.x, centroids.max.y - centroids.min.y, centroids.max.z - centroids.min.z);
+    int axis = (size.x >= size.y && size.x >= size.z) ? 0 : (size.y >= size.z ? 1 : 2);
+
+    auto centroid = [&](uint32_t item)
+        {
+            const BoundingBox& b = boxes[item];
+            return axis == 0 ? b.min.x + b.max.x : (axis == 1 ? b.min.y + b.max.y : b.min.z + b.max.z);
+        };
+
+    uint32_t half = count / 2;
+    std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count,
+        [&](uint32_t a, uint32_t b) { return centroid(a) < centroid(b); });
+
+    uint32_t left = (uint32_t)nodes.size();
+    nodes.push_back({});
+    nodes.push_back({});
+    subtree_items.push_back({});
+    subtree_items.push_back({});
+
+    nodes[node].first = left;
+    nodes[node].count = 0;
+
+    buildNode(boxes, left, first, half, depth + 1);
+    buildNode(boxes, left + 1, first + half, count - half, depth + 1);
+}
+
+uint32_t BoundsHierarchy::subtreeRoots(uint32_t depth, uint32_t* roots) const
+{
+    if (nodes.empty())
+    {
+        return 0;
+    }
+
+    uint32_t count = 1;
+    roots[0] = 0;
+
+    // Inner nodes are replaced by their children level by level, leaves stay
+    for (uint32_t level = 0; level < depth; level++)
+    {
+        const uint32_t level_count = count;
+        for (uint32_t i = 0; i < level_count; i++)
+        {
+            const Node& node = nodes[roots[i]];
+            if (node.count == 0)
+            {
+                roots[i] = node.first;
+                roots[count++] = node.first + 1;
+            }
+        }
+    }
+
+    return count;
+}
+
+void BoundsHierarchy::refit(const std::vector<BoundingBox>& boxes)
+{
+    // Children always follow their parent
+    for (size_t n = nodes.size(); n-- > 0;)
+    {
+        Node& node = nodes[n];
+        BoundingBox box = EmptyBox();
+
+        if (node.count > 0)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; i++)
+            {
+                GrowBox(box, boxes[items[i]]);
+            }
+        }
+        else
+        {
+            GrowBox(box, nodes[node.first].box);
+            GrowBox(box, nodes[node.first + 1].box);
+        }
+
+        node.box = box;
+    }
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Bounding volume hierarchy (culling, later picking / occlusion queries)
+
+#pragma once
+
+#include "phvk_types.h"
+#include "phvk_culling.h"
+
+#include <cstdint>
+#include <vector>
+
+struct RenderObject;
+
+// World-space axis aligned box
+struct BoundingBox
+{
+    Vec3f min;
+    Vec3f max;
+};
+
+// Bounds origin / extents of the object transformed to world space
+BoundingBox WorldBoundingBox(const RenderObject& obj);
+
+// Box against planes from ExtractFrustumPlanes
+CullResult ClassifyBox(const BoundingBox& box, const Vec4f planes[6]);
+
+// Binary BVH over item boxes, nodes stored parent before children
+// Leaves own a range of items, inner nodes have two consecutive children
+struct BoundsHierarchy
+{
+    static constexpr uint32_t MAX_LEAF_ITEMS = 4;
+    static constexpr uint32_t MAX_DEPTH = 48;       // Bounds the traversal stack
+
+    struct Node
+    {
+        BoundingBox box;
+        uint32_t first;     // Leaf: first entry in items, inner: left child (right child is first + 1)
+        uint32_t count;     // Leaf: item count, inner: 0
+    };
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> items;    // Item indices, grouped by leaf
+
+    bool empty() const { return nodes.empty(); }
+
+    // Median split on the longest centroid axis
+    void build(const std::vector<BoundingBox>& boxes);
+
+    // Recompute node boxes bottom-up for moved items (same topology)
+    void refit(const std::vector<BoundingBox>& boxes);
+
+    // Nodes depth levels below the root (leaves above it included), their subtrees cover every item once
+    // roots must have room for 1 << depth nodes, returns the number written
+    uint32_t subtreeRoots(uint32_t depth, uint32_t* roots) const;
+
+    // Entries of a node's subtree in items start here (subtrees below one node don't overlap)
+    uint32_t firstItem(uint32_t node) const { return subtree_items[node].first; }
+
+    // Top-down traversal of the subtree at root
+    // classify(box) -> CullResult: outside skips the subtree, inside reports it whole
+    // visit(items, count, inside) is called per intersecting leaf and once per fully inside subtree
+    // Returns the number of nodes visited
+    template<typename Classify, typename Visit>
+    uint32_t traverse(Classify&& classify, Visit&& visit, uint32_t root = 0) const
+    {
+        if (nodes.empty())
+        {
+            return 0;
+        }
+
+        uint32_t visited = 0;
+        uint32_t stack[64];
+        uint32_t stack_size = 0;
+        stack[stack_size++] = root;
+
+        while (stack_size > 0)
+        {
+            const Node& node = nodes[stack[--stack_size]];
+            visited++;
+
+            CullResult result = classify(node.box);
+            if (result == CullResult::outside)
+            {
+                continue;
+            }
+
+            if (result == CullResult::inside)
+            {
+                visitAll(node, visit);
+            }
+            else if (node.count > 0)
+            {
+                visit(&items[node.first], node.count, false);
+            }
+            else
+            {
+                stack[stack_size++] = node.first + 1;
+                stack[stack_size++] = node.first;
+            }
+        }
+
+        return visited;
+    }
+
+private:
+    // Leaves of a subtree are contiguous in items, so a fully inside subtree is one range
+    struct ItemRange
+    {
+        uint32_t first;
+        uint32_t count;
+    };
+    std::vector<ItemRange> subtree_items;
+
+    template<typename Visit>
+    void visitAll(const Node& node, Visit&& visit) const
+    {
+        const ItemRange& range = subtree_items[&node - nodes.data()];
+        visit(&items[range.first], range.count, true);
+    }
+
+    void buildNode(const std::vector<BoundingBox>& boxes, uint32_t node, uint32_t first, uint32_t count,
+        uint32_t depth);
+};
@@ -9,6 +9,9 @@
 #include "quat.hpp"
 #include "mat.hpp"
 
+#include <cmath>
+#include <cstring>
+
 Mat4f Camera::getViewMatrix()
 {
     // To create a correct model view, we need to move the world in opposite
@@ -30,6 +33,26 @@ Mat4f Camera::getRotationMatrix()
     return Mat4f(Mat3f::rot(yaw_rotation)) * Mat4f(Mat3f::rot(pitch_rotation));
 }
 
+Mat4f Camera::getProjectionMatrix(float aspect_ratio)
+{
+    // Right-handed perspective with reversed depth (1 at the near plane, 0 at the far plane)
+    // to match the GREATER_OR_EQUAL depth test used by the mesh pipelines.
+    // Y is flipped to account for Vulkan's downward clip space Y axis.
+    // Built as a column-major float array (same memory layout as GLSL mat4)
+    const float f = 1.f / std::tan(fov_y * 0.5f);
+
+    float m[16] = {};
+    m[0] = f / aspect_ratio;
+    m[5] = -f;
+    m[10] = near_plane / (far_plane - near_plane);
+    m[11] = -1.f;
+    m[14] = (near_plane * far_plane) / (far_plane - near_plane);
+
+    Mat4f proj;
+    memcpy(&proj, m, sizeof(m));
+    return proj;
+}
+
 void Camera::processSDLEvent(SDL_Event& e)
 {
     if (e.type == SDL_KEYDOWN) 
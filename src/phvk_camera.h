@@ -17,8 +17,14 @@ public:
     float pitch{ 0.f };
     float yaw{ 0.f };
 
+    // Projection parameters (vertical field of view in radians)
+    float fov_y{ 1.2217305f };  // 70 degrees
+    float near_plane{ 0.1f };
+    float far_plane{ 10000.f };
+
     Mat4f getViewMatrix();
     Mat4f getRotationMatrix();
+    Mat4f getProjectionMatrix(float aspect_ratio);
 
     void processSDLEvent(SDL_Event& e);
 
@@ -0,0 +1,753 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Culling (GPU-driven frustum culling and indirect draws)
+
+#include "phvk_culling.h"
+
+#include "phvk_engine.h"
+#include "phvk_initializers.h"
+#include "phvk_pipelines.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PHVK_CULL_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHVK_CULL_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PHVK_CULL_NEON
+#endif
+
+// Global memory barrier between two pipeline stages
+static void CullBarrier(VkCommandBuffer cmd,
+    VkPipelineStageFlags2 src_stage, VkAccessFlags2 src_access,
+    VkPipelineStageFlags2 dst_stage, VkAccessFlags2 dst_access)
+{
+    VkMemoryBarrier2 barrier { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    barrier.srcStageMask = src_stage;
+    barrier.srcAccessMask = src_access;
+    barrier.dstStageMask = dst_stage;
+    barrier.dstAccessMask = dst_access;
+
+    VkDependencyInfo dep_info { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep_info.memoryBarrierCount = 1;
+    dep_info.pMemoryBarriers = &barrier;
+
+    vkCmdPipelineBarrier2(cmd, &dep_info);
+}
+
+void ExtractFrustumPlanes(const Mat4f& view_proj, Vec4f planes[6])
+{
+    // Gribb-Hartmann plane extraction
+    // Matrix is column-major, row i = (m[i], m[4 + i], m[8 + i], m[12 + i])
+    float m[16];
+    memcpy(m, &view_proj, sizeof(m));
+
+    auto row = [&](int i) { return Vec4f(m[i], m[4 + i], m[8 + i], m[12 + i]); };
+    Vec4f r0 = row(0);
+    Vec4f r1 = row(1);
+    Vec4f r2 = row(2);
+    Vec4f r3 = row(3);
+
+    planes[0] = Vec4f(r3.x + r0.x, r3.y + r0.y, r3.z + r0.z, r3.w + r0.w);  // Left
+    planes[1] = Vec4f(r3.x - r0.x, r3.y - r0.y, r3.z - r0.z, r3.w - r0.w);  // Right
+    planes[2] = Vec4f(r3.x + r1.x, r3.y + r1.y, r3.z + r1.z, r3.w + r1.w);  // Bottom
+    planes[3] = Vec4f(r3.x - r1.x, r3.y - r1.y, r3.z - r1.z, r3.w - r1.w);  // Top
+    planes[4] = r2;                                                         // z >= 0
+    planes[5] = Vec4f(r3.x - r2.x, r3.y - r2.y, r3.z - r2.z, r3.w - r2.w);  // z <= w
+
+    for (int i = 0; i < 6; i++)
+    {
+        float len = std::sqrt(planes[i].x * planes[i].x +
+            planes[i].y * planes[i].y +
+            planes[i].z * planes[i].z);
+
+        if (len > 0.f)
+        {
+            planes[i] = Vec4f(planes[i].x / len, planes[i].y / len, planes[i].z / len, planes[i].w / len);
+        }
+    }
+}
+
+// *** CPU Culling ***
+
+void CullingSpheres::build(const std::vector<RenderObject>& objects)
+{
+    const size_t count = objects.size();
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    radius.resize(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const RenderObject& r = objects[i];
+
+        // Column-major, translation in m[12..14]
+        float m[16];
+        memcpy(m, &r.transform, sizeof(m));
+
+        const Vec3f& o = r.bounds.origin;
+        x[i] = m[0] * o.x + m[4] * o.y + m[8] * o.z + m[12];
+        y[i] = m[1] * o.x + m[5] * o.y + m[9] * o.z + m[13];
+        z[i] = m[2] * o.x + m[6] * o.y + m[10] * o.z + m[14];
+
+        float scale_x = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+        float scale_y = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+        float scale_z = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+        radius[i] = r.bounds.sphere_radius * std::sqrt(std::max(scale_x, std::max(scale_y, scale_z)));
+    }
+}
+
+static CullResult ClassifySphere(const CullingSpheres& spheres, const Vec4f planes[6], uint32_t i)
+{
+    bool inside = true;
+    for (int p = 0; p < 6; p++)
+    {
+        float d = planes[p].x * spheres.x[i] + planes[p].y * spheres.y[i] + 
+            planes[p].z * spheres.z[i] + planes[p].w;
+
+        if (d < -spheres.radius[i])
+        {
+            return CullResult::outside;
+        }
+        inside = inside && d >= spheres.radius[i];
+    }
+    return inside ? CullResult::inside : CullResult::intersecting;
+}
+
+// Per-lane result from the outside / inside bit masks
+static void WriteCullResults(int outside_mask, int inside_mask, uint32_t lanes, CullResult* results)
+{
+    for (uint32_t l = 0; l < lanes; l++)
+    {
+        if (outside_mask & (1 << l))
+        {
+            results[l] = CullResult::outside;
+        }
+        else if (inside_mask & (1 << l))
+        {
+            results[l] = CullResult::inside;
+        }
+        else
+        {
+            results[l] = CullResult::intersecting;
+        }
+    }
+}
+
+void ClassifySpheres(const CullingSpheres& spheres, const Vec4f planes[6],
+    uint32_t first, uint32_t last, CullResult* results)
+{
+    uint32_t i = first;
+
+#if defined(PHVK_CULL_AVX)
+    __m256 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+    for (int p = 0; p < 6; p++)
+    {
+        plane_x[p] = _mm256_set1_ps(planes[p].x);
+        plane_y[p] = _mm256_set1_ps(planes[p].y);
+        plane_z[p] = _mm256_set1_ps(planes[p].z);
+        plane_w[p] = _mm256_set1_ps(planes[p].w);
+    }
+    const __m256 sign = _mm256_set1_ps(-0.f);
+
+    for (; i + 8 <= last; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(&spheres.x[i]);
+        __m256 y = _mm256_loadu_ps(&spheres.y[i]);
+        __m256 z = _mm256_loadu_ps(&spheres.z[i]);
+        __m256 r = _mm256_loadu_ps(&spheres.radius[i]);
+        __m256 neg_r = _mm256_xor_ps(r, sign);
+
+        __m256 outside = _mm256_setzero_ps();
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(plane_x[p], x), _mm256_mul_ps(plane_y[p], y)),
+                _mm256_add_ps(_mm256_mul_ps(plane_z[p], z), plane_w[p]));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, neg_r, _CMP_LT_OQ));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, r, _CMP_GE_OQ));
+        }
+
+        WriteCullResults(_mm256_movemask_ps(outside), _mm256_movemask_ps(inside), 8, &results[i - first]);
+    }
+#elif defined(PHVK_CULL_SSE)
+    __m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+    for (int p = 0; p < 6; p++)
+    {
+        plane_x[p] = _mm_set1_ps(planes[p].x);
+        plane_y[p] = _mm_set1_ps(planes[p].y);
+        plane_z[p] = _mm_set1_ps(planes[p].z);
+        plane_w[p] = _mm_set1_ps(planes[p].w);
+    }
+    const __m128 sign = _mm_set1_ps(-0.f);
+
+    for (; i + 4 <= last; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&spheres.x[i]);
+        __m128 y = _mm_loadu_ps(&spheres.y[i]);
+        __m128 z = _mm_loadu_ps(&spheres.z[i]);
+        __m128 r = _mm_loadu_ps(&spheres.radius[i]);
+        __m128 neg_r = _mm_xor_ps(r, sign);
+
+        __m128 outside = _mm_setzero_ps();
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[p], x), _mm_mul_ps(plane_y[p], y)),
+                _mm_add_ps(_mm_mul_ps(plane_z[p], z), plane_w[p]));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(d, neg_r));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, r));
+        }
+
+        WriteCullResults(_mm_movemask_ps(outside), _mm_movemask_ps(inside), 4, &results[i - first]);
+    }
+#elif defined(PHVK_CULL_NEON)
+    float32x4_t plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+    for (int p = 0; p < 6; p++)
+    {
+        plane_x[p] = vdupq_n_f32(planes[p].x);
+        plane_y[p] = vdupq_n_f32(planes[p].y);
+        plane_z[p] = vdupq_n_f32(planes[p].z);
+        plane_w[p] = vdupq_n_f32(planes[p].w);
+    }
+
+    for (; i + 4 <= last; i += 4)
+    {
+        float32x4_t x = vld1q_f32(&spheres.x[i]);
+        float32x4_t y = vld1q_f32(&spheres.y[i]);
+        float32x4_t z = vld1q_f32(&spheres.z[i]);
+        float32x4_t r = vld1q_f32(&spheres.radius[i]);
+        float32x4_t neg_r = vnegq_f32(r);
+
+        uint32x4_t outside = vdupq_n_u32(0);
+        uint32x4_t inside = vdupq_n_u32(~0u);
+        for (int p = 0; p < 6; p++)
+        {
+            float32x4_t d = vmlaq_f32(vmlaq_f32(vmlaq_f32(plane_w[p], plane_x[p], x), plane_y[p], y), plane_z[p], z);
+            outside = vorrq_u32(outside, vcltq_f32(d, neg_r));
+            inside = vandq_u32(inside, vcgeq_f32(d, r));
+        }
+
+        uint32_t out_lanes[4], in_lanes[4];
+        vst1q_u32(out_lanes, outside);
+        vst1q_u32(in_lanes, inside);
+        int outside_mask = 0, inside_mask = 0;
+        for (int l = 0; l < 4; l++)
+        {
+            outside_mask |= (out_lanes[l] & 1) << l;
+            inside_mask |= (in_lanes[l] & 1) << l;
+        }
+
+        WriteCullResults(outside_mask, inside_mask, 4, &results[i - first]);
+    }
+#endif
+
+    // Remainder (or everything without SIMD)
+    for (; i < last; i++)
+    {
+        results[i - first] = ClassifySphere(spheres, planes, i);
+    }
+}
+
+
+void GPUCulling::init(phVkEngine* engine)
+{
+    indirect_supported = engine->draw_indirect_count_supported && engine->draw_indirect_first_instance_supported;
+    if (!indirect_supported)
+    {
+        fmt::println("GPU culling disabled: drawIndirectCount / drawIndirectFirstInstance not supported");
+        return;
+    }
+
+    // The indirect draws need the indirect variant of the opaque material pipeline
+    if (engine->metal_rough_material.opaque_pipeline.indirect_pipeline == VK_NULL_HANDLE)
+    {
+        fmt::println("GPU culling disabled: missing indirect mesh pipeline");
+        return;
+    }
+
+    VkShaderModule cull_shader;
+    if (!vkutil::load_shader_module(PHVK_SHADER_DIR "cull.comp.spv", engine->device, &cull_shader))
+    {
+        fmt::println("GPU culling disabled: error when building the cull shader");
+        return;
+    }
+
+    // *** Pipeline Layout ***
+    // All buffers are accessed through buffer device addresses, the only set is the depth pyramid
+    VkPushConstantRange push_constant{};
+    push_constant.offset = 0;
+    push_constant.size = sizeof(GPUCullPushConstants);
+    push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkPipelineLayoutCreateInfo layout_info = vkinit::pipeline_layout_create_info();
+    layout_info.pSetLayouts = &engine->depth_pyramid.sample_layout;
+    layout_info.setLayoutCount = 1;
+    layout_info.pPushConstantRanges = &push_constant;
+    layout_info.pushConstantRangeCount = 1;
+
+    VK_CHECK(vkCreatePipelineLayout(engine->device, &layout_info, nullptr, &layout));
+
+    // *** Pipeline Creation ***
+    VkComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.pNext = nullptr;
+    pipeline_info.layout = layout;
+    pipeline_info.stage = vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_COMPUTE_BIT, cull_shader);
+
+    VK_CHECK(vkCreateComputePipelines(engine->device, engine->pipeline_cache.cache, 1, &pipeline_info, nullptr, &pipeline));
+
+    vkDestroyShaderModule(engine->device, cull_shader, nullptr);
+}
+
+void GPUCulling::clearResources(phVkEngine* engine)
+{
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(engine->device, pipeline, nullptr);
+    }
+    if (layout != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineLayout(engine->device, layout, nullptr);
+    }
+
+    if (visibility_capacity > 0)
+    {
+        engine->destroyBuffer(visibility_buffer);
+        visibility_capacity = 0;
+    }
+    if (object_capacity > 0)
+    {
+        engine->destroyBuffer(object_buffer);
+        object_capacity = 0;
+    }
+
+    pipeline = VK_NULL_HANDLE;
+    layout = VK_NULL_HANDLE;
+}
+
+void GPUCulling::destroyBuffers(phVkEngine* engine, GPUCullingBuffers& buffers)
+{
+    if (buffers.object_capacity > 0)
+    {
+        engine->destroyBuffer(buffers.command_buffer);
+        buffers.object_capacity = 0;
+    }
+    if (buffers.batch_capacity > 0)
+    {
+        engine->destroyBuffer(buffers.count_buffer);
+        buffers.batch_capacity = 0;
+    }
+}
+
+void GPUCulling::reserve(phVkEngine* engine, GPUCullingBuffers& buffers, uint32_t objects, uint32_t batch_count)
+{
+    // Buffers belong to a single frame and the frame fence has been waited on,
+    // so they can be destroyed immediately when growing
+
+    if (objects > buffers.object_capacity)
+    {
+        uint32_t capacity = std::max({ objects, buffers.object_capacity + buffers.object_capacity / 2, 256u });
+
+        if (buffers.object_capacity > 0)
+        {
+            engine->destroyBuffer(buffers.command_buffer);
+        }
+
+        buffers.command_buffer = engine->createBuffer(capacity * sizeof(VkDrawIndexedIndirectCommand),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::transient);
+
+        buffers.command_buffer_address = engine->getBufferAddress(buffers.command_buffer.buffer);
+        buffers.object_capacity = capacity;
+    }
+
+    if (batch_count > buffers.batch_capacity)
+    {
+        uint32_t capacity = std::max({ batch_count, buffers.batch_capacity + buffers.batch_capacity / 2, 64u });
+
+        if (buffers.batch_capacity > 0)
+        {
+            engine->destroyBuffer(buffers.count_buffer);
+        }
+
+        buffers.count_buffer = engine->createBuffer(capacity * sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::transient);
+
+        buffers.count_buffer_address = engine->getBufferAddress(buffers.count_buffer.buffer);
+        buffers.batch_capacity = capacity;
+    }
+}
+
+void GPUCulling::markObjectsChanged(uint32_t first, uint32_t count)
+{
+    // Invalid batches rewrite every object anyway
+    if (!batches_valid || count == 0)
+    {
+        return;
+    }
+
+    if (!changed_objects.empty() && changed_objects.back().first + changed_objects.back().count == first)
+    {
+        changed_objects.back().count += count;
+    }
+    else
+    {
+        changed_objects.push_back({ first, count });
+    }
+}
+
+void GPUCulling::prepare(VkCommandBuffer cmd, phVkEngine* engine, FrameData& frame, const DrawContext& ctx)
+{
+    const std::vector<RenderObject>& objects = ctx.opaque_surfaces;
+
+    if (objects.size() != object_count)
+    {
+        batches_valid = false;
+    }
+    object_count = (uint32_t)objects.size();
+
+    if (object_count == 0)
+    {
+        batches.clear();
+        changed_objects.clear();
+        batches_valid = true;
+        submitted_triangles = 0;
+        return;
+    }
+
+    // Every record holds its batch, so new batches rewrite the whole object buffer
+    bool rewrite_objects = !batches_valid;
+
+    // *** Build Batches ***
+    // One batch per unique pipeline + material set + vertex format + geometry page, objects in a 
+    // batch write their commands into a contiguous range of the command buffer
+    // Only redone when the draw list changes, transforms and LOD ranges don't affect the batches
+    if (!batches_valid)
+    {
+        batches.clear();
+        object_batches.resize(object_count);
+
+        // Batch lookup, open addressing in the frame arena
+        struct LookupSlot
+        {
+            const MaterialPipeline* pipeline;
+            VkDescriptorSet material_set;
+            uint32_t page_format;           // Geometry page, vertex format in the top byte
+            uint32_t batch;
+        };
+        uint32_t table_bits = 1;
+        while (((size_t)1 << table_bits) < (size_t)object_count * 2)
+        {
+            table_bits++;
+        }
+        const size_t table_mask = ((size_t)1 << table_bits) - 1;
+        std::span<LookupSlot> table = frame.arena.allocate<LookupSlot>(table_mask + 1);
+        memset(table.data(), 0xFF, table.size_bytes());
+
+        for (uint32_t i = 0; i < object_count; i++)
+        {
+            const MaterialInstance* material = objects[i].material;
+            const uint32_t page_format = objects[i].geometry_page | ((uint32_t)objects[i].vertex_format << 24);
+
+            uint64_t hash = (uint64_t)(uintptr_t)material->pipeline;
+            hash = (hash ^ (uint64_t)material->material_set) * 0x9E3779B97F4A7C15ull;
+            hash = (hash ^ page_format) * 0x9E3779B97F4A7C15ull;
+
+            size_t slot = (size_t)(hash >> (64 - table_bits));
+            while (table[slot].batch != UINT32_MAX && (table[slot].pipeline != material->pipeline ||
+                table[slot].material_set != material->material_set || table[slot].page_format != page_format))
+            {
+                slot = (slot + 1) & table_mask;
+            }
+            if (table[slot].batch == UINT32_MAX)
+            {
+                table[slot] = { material->pipeline, material->material_set, page_format, (uint32_t)batches.size() };
+                batches.push_back(GPUDrawBatch{ material->pipeline, material->material_set, objects[i].vertex_format, 
+                    objects[i].geometry_page, 0, 0 });
+            }
+
+            batches[table[slot].batch].object_count++;
+            object_batches[i] = table[slot].batch;
+        }
+
+        uint32_t first_command = 0;
+        for (GPUDrawBatch& b : batches)
+        {
+            b.first_command = first_command;
+            first_command += b.object_count;
+        }
+        batches_valid = true;
+    }
+
+    // Early and late pass ranges
+    reserve(engine, frame.culling_buffers, object_count * 2, (uint32_t)batches.size() * 2);
+
+    // Visibility is shared by the frames in flight, so a replaced buffer is released with this frame
+    if (object_count > visibility_capacity)
+    {
+        if (visibility_capacity > 0)
+        {
+            frame.delete_queue.pushBuffer(visibility_buffer);
+        }
+
+        uint32_t capacity = std::max({ object_count, visibility_capacity + visibility_capacity / 2, 256u });
+
+        visibility_buffer = engine->createBuffer(capacity * sizeof(uint32_t),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY);
+
+        visibility_buffer_address = engine->getBufferAddress(visibility_buffer.buffer);
+        visibility_capacity = capacity;
+        visibility_valid = false;
+    }
+
+    // Objects are device-local and shared by the frames in flight like visibility
+    if (object_count > object_capacity)
+    {
+        if (object_capacity > 0)
+        {
+            frame.delete_queue.pushBuffer(object_buffer);
+        }
+
+        uint32_t capacity = std::max({ object_count, object_capacity + object_capacity / 2, 256u });
+
+        object_buffer = engine->createBuffer(capacity * sizeof(GPUObjectData),
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            VMA_MEMORY_USAGE_GPU_ONLY);
+
+        object_buffer_address = engine->getBufferAddress(object_buffer.buffer);
+        object_capacity = capacity;
+        rewrite_objects = true;
+    }
+
+    // Pre-cull total, LOD selection changes index counts without touching the batches
+    submitted_triangles = 0;
+    for (const RenderObject& r : objects)
+    {
+        submitted_triangles += r.index_count / 3;
+    }
+
+    // *** Write Object Data ***
+    // Only the objects the scene graph update or LOD selection changed are copied in,
+    // unless the whole buffer is new
+    if (rewrite_objects)
+    {
+        changed_objects.clear();
+        changed_objects.push_back({ 0, object_count });
+    }
+    if (changed_objects.empty())
+    {
+        return;
+    }
+
+    uint32_t changed_count = 0;
+    for (const ObjectRange& range : changed_objects)
+    {
+        changed_count += range.count;
+    }
+
+    UploadAllocation object_alloc = frame.upload_buffer.allocate(engine, changed_count * sizeof(GPUObjectData));
+    GPUObjectData* object_data = (GPUObjectData*)object_alloc.data;
+
+    object_copies.clear();
+    VkDeviceSize src_offset = object_alloc.offset;
+    for (const ObjectRange& range : changed_objects)
+    {
+        for (uint32_t i = range.first; i < range.first + range.count; i++)
+        {
+            const RenderObject& r = objects[i];
+            const GPUDrawBatch& b = batches[object_batches[i]];
+
+            GPUObjectData& o = *object_data++;
+            o.transform = r.transform;
+            o.sphere = Vec4f(r.bounds.origin, r.bounds.sphere_radius);
+            o.extents = Vec4f(r.bounds.extents, 0.f);
+            o.vertex_buffer_address = r.vertex_buffer_address;
+            o.first_index = r.first_index;
+            o.index_count = r.index_count;
+            o.batch_index = object_batches[i];
+            o.first_command = b.first_command;
+            o.material_index = r.material->material_index;
+            o.pad = 0;
+        }
+
+        object_copies.push_back({ src_offset, range.first * sizeof(GPUObjectData), range.count * sizeof(GPUObjectData) });
+        src_offset += range.count * sizeof(GPUObjectData);
+    }
+    changed_objects.clear();
+
+    // Earlier frames may still be culling or drawing with the old records
+    CullBarrier(cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+    vkCmdCopyBuffer(cmd, object_alloc.buffer, object_buffer.buffer, (uint32_t)object_copies.size(), object_copies.data());
+
+    CullBarrier(cmd,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+}
+
+void GPUCulling::recordCull(VkCommandBuffer cmd, phVkEngine* engine, FrameData& frame, const Mat4f& view_proj,
+    uint32_t phase, VkExtent2D extent)
+{
+    if (object_count == 0)
+    {
+        return;
+    }
+
+    GPUCullingBuffers& buffers = frame.culling_buffers;
+    const uint32_t batch_count = (uint32_t)batches.size();
+    const uint32_t pass = (phase == CULL_PHASE_LATE) ? 1 : 0;
+
+    // Reset the pass's per-batch draw counts
+    vkCmdFillBuffer(cmd, buffers.count_buffer.buffer, pass * batch_count * sizeof(uint32_t),
+        batch_count * sizeof(uint32_t), 0);
+
+    // Unknown history: everything was visible, the early pass draws all frustum visible objects
+    if (phase == CULL_PHASE_EARLY && !visibility_valid)
+    {
+        // Earlier frames' cull dispatches may still read and write the old visibility
+        CullBarrier(cmd,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT);
+
+        vkCmdFillBuffer(cmd, visibility_buffer.buffer, 0, object_count * sizeof(uint32_t), 1);
+        visibility_valid = true;
+    }
+
+    // Also orders the previous late phase's visibility writes before this dispatch
+    CullBarrier(cmd,
+        VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, 
+        VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    // *** View Data ***
+    const DepthPyramid& pyramid = engine->depth_pyramid;
+
+    UploadAllocation view_alloc = frame.upload_buffer.allocate(engine, sizeof(GPUCullView));
+    GPUCullView* view = (GPUCullView*)view_alloc.data;
+    view->view_proj = view_proj;
+    ExtractFrustumPlanes(view_proj, view->frustum_planes);
+    view->pyramid = Vec4f((float)pyramid.extent.width, (float)pyramid.extent.height, (float)pyramid.mip_count, 0.f);
+    view->viewport_scale = Vec4f(
+        std::min(1.f, extent.width / (float)std::max(1u, pyramid.depth_extent.width)),
+        std::min(1.f, extent.height / (float)std::max(1u, pyramid.depth_extent.height)), 0.f, 0.f);
+
+    GPUCullPushConstants push_constants;
+    push_constants.view_address = view_alloc.address;
+    push_constants.object_buffer_address = object_buffer_address;
+    push_constants.command_buffer_address = buffers.command_buffer_address + 
+        pass * object_count * sizeof(VkDrawIndexedIndirectCommand);
+    push_constants.count_buffer_address = buffers.count_buffer_address + pass * batch_count * sizeof(uint32_t);
+    push_constants.visibility_buffer_address = visibility_buffer_address;
+    push_constants.object_count = object_count;
+    push_constants.phase = phase;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &pyramid.sample_set, 0, nullptr);
+    vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GPUCullPushConstants), &push_constants);
+
+    // 64 threads per workgroup, one object per thread
+    vkCmdDispatch(cmd, (object_count + 63) / 64, 1, 1);
+
+    // Commands and counts are consumed by the indirect draws
+    CullBarrier(cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+}
+
+void GPUCulling::recordDraws(VkCommandBuffer cmd, phVkEngine* engine, FrameData& frame,
+    VkDescriptorSet global_descriptor, uint32_t global_offset, VkExtent2D extent, uint32_t pass)
+{
+    GPUCullingBuffers& buffers = frame.culling_buffers;
+    const uint32_t batch_count = (uint32_t)batches.size();
+    const VkDeviceSize command_offset = pass * object_count * sizeof(VkDrawIndexedIndirectCommand);
+    const VkDeviceSize count_offset = pass * batch_count * sizeof(uint32_t);
+
+    VkPipeline last_pipeline = VK_NULL_HANDLE;
+    VkDescriptorSet last_material_set = VK_NULL_HANDLE;
+    uint32_t last_geometry_page = UINT32_MAX;
+
+    GPUIndirectPushConstants push_constants;
+    push_constants.object_buffer_address = object_buffer_address;
+
+    for (uint32_t i = 0; i < (uint32_t)batches.size(); i++)
+    {
+        const GPUDrawBatch& b = batches[i];
+
+        const MaterialPipeline* material_pipeline = b.pipeline;
+        VkPipeline pipeline = material_pipeline->get(b.vertex_format, true);
+
+        if (pipeline != last_pipeline)
+        {
+            last_pipeline = pipeline;
+
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, material_pipeline->layout, 0, 1,
+                &global_descriptor, 1, &global_offset);
+
+            vkCmdPushConstants(cmd, material_pipeline->layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                sizeof(GPUIndirectPushConstants), &push_constants);
+
+            VkViewport viewport = {};
+            viewport.x = 0;
+            viewport.y = 0;
+            viewport.width = (float)extent.width;
+            viewport.height = (float)extent.height;
+            viewport.minDepth = 0.f;
+            viewport.maxDepth = 1.f;
+
+            vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+            VkRect2D scissor = {};
+            scissor.offset.x = 0;
+            scissor.offset.y = 0;
+            scissor.extent.width = extent.width;
+            scissor.extent.height = extent.height;
+
+            vkCmdSetScissor(cmd, 0, 1, &scissor);
+        }
+
+        if (b.material_set != last_material_set)
+        {
+            last_material_set = b.material_set;
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, material_pipeline->layout, 1, 1,
+                &b.material_set, 0, nullptr);
+        }
+
+        if (b.geometry_page != last_geometry_page)
+        {
+            last_geometry_page = b.geometry_page;
+            vkCmdBindIndexBuffer(cmd, engine->geometry_pool.indexBuffer(b.geometry_page), 0, VK_INDEX_TYPE_UINT32);
+        }
+
+        vkCmdDrawIndexedIndirectCount(cmd,
+            buffers.command_buffer.buffer, command_offset + b.first_command * sizeof(VkDrawIndexedIndirectCommand),
+            buffers.count_buffer.buffer, count_offset + i * sizeof(uint32_t),
+            b.object_count, sizeof(VkDrawIndexedIndirectCommand));
+
+        engine->stats.drawcall_count++;
+    }
+
+    // Submitted before culling, counted once per frame
+    if (pass == 0)
+    {
+        engine->stats.triangle_count += submitted_triangles;
+        engine->stats.instance_count += object_count;
+    }
+}
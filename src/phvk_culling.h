@@ -0,0 +1,198 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Culling (GPU-driven frustum culling and indirect draws)
+
+#pragma once
+
+#include "phvk_types.h"
+
+class phVkEngine;
+struct FrameData;
+struct RenderObject;
+
+// Per-object data for the GPU-driven path
+// Must match ObjectData in cull.comp and mesh_indirect.vert (std430, 128 bytes)
+struct GPUObjectData
+{
+    Mat4f transform;
+    Vec4f sphere;                           // xyz: bounds origin (object space), w: sphere radius
+    Vec4f extents;                          // xyz: bounds extents (object space)
+    VkDeviceAddress vertex_buffer_address;
+    uint32_t first_index;
+    uint32_t index_count;
+    uint32_t batch_index;                   // Slot in the count buffer
+    uint32_t first_command;                 // First command of the batch in the command buffer
+    uint32_t material_index;                // Bindless material buffer slot
+    uint32_t pad;
+};
+
+// Cull dispatch modes (see cull.comp)
+// Frustum:  frustum test only (occlusion culling off)
+// Early:    frustum visible objects that were visible last frame (drawn before the depth pyramid is built)
+// Late:     every frustum visible object is tested against the depth pyramid and records its visibility,
+//           visible objects the early pass skipped are drawn
+constexpr uint32_t CULL_PHASE_FRUSTUM = 0;
+constexpr uint32_t CULL_PHASE_EARLY = 1;
+constexpr uint32_t CULL_PHASE_LATE = 2;
+
+// Per-dispatch view data for cull.comp, read through a device address
+// Must match CullView in cull.comp (std430)
+struct GPUCullView
+{
+    Mat4f view_proj;
+    Vec4f frustum_planes[6];
+    Vec4f pyramid;                          // xy: depth pyramid mip 0 size, z: mip count
+    Vec4f viewport_scale;                   // xy: rendered area / depth image size
+};
+
+// Push constants for cull.comp
+struct GPUCullPushConstants
+{
+    VkDeviceAddress view_address;
+    VkDeviceAddress object_buffer_address;
+    VkDeviceAddress command_buffer_address;  // Offset to the phase's command range
+    VkDeviceAddress count_buffer_address;    // Offset to the phase's counts
+    VkDeviceAddress visibility_buffer_address;
+    uint32_t object_count;
+    uint32_t phase;                          // CULL_PHASE_*
+};
+
+// Push constants for mesh_indirect.vert
+struct GPUIndirectPushConstants
+{
+    VkDeviceAddress object_buffer_address;
+};
+
+// Group of objects drawn with a single vkCmdDrawIndexedIndirectCount
+// (all objects share a pipeline, a material set, a vertex format and a geometry pool page;
+// with bindless materials every material shares the set)
+struct GPUDrawBatch
+{
+    MaterialPipeline* pipeline;
+    VkDescriptorSet material_set;
+    VertexFormat vertex_format;
+    uint32_t geometry_page;
+    uint32_t first_command;
+    uint32_t object_count;
+};
+
+// Per-frame GPU buffers for culling (owned by FrameData)
+struct GPUCullingBuffers
+{
+    // Commands and counts have two ranges, one per draw pass (early / late with occlusion culling)
+    AllocatedBuffer command_buffer;         // VkDrawIndexedIndirectCommand[], GPU-written
+    AllocatedBuffer count_buffer;           // uint32_t[] per batch, GPU-written
+
+    VkDeviceAddress command_buffer_address { 0 };
+    VkDeviceAddress count_buffer_address { 0 };
+
+    uint32_t object_capacity { 0 };
+    uint32_t batch_capacity { 0 };
+};
+
+// Extract normalized frustum planes (xyz: normal pointing inside, w: distance) from a
+// view-projection matrix. Assumes [0, 1] clip space depth (either depth direction)
+void ExtractFrustumPlanes(const Mat4f& view_proj, Vec4f planes[6]);
+
+// *** CPU Culling ***
+// World-space bounding spheres in structure-of-arrays form, classified against the frustum
+// planes 8 (AVX) or 4 (SSE / NEON) at a time. Only intersecting objects need the box test
+
+enum class CullResult : uint8_t
+{
+    outside,
+    inside,
+    intersecting
+};
+
+struct CullingSpheres
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> radius;
+
+    uint32_t size() const { return (uint32_t)x.size(); }
+
+    // One sphere per object: bounds origin transformed, radius scaled by the largest axis scale
+    void build(const std::vector<RenderObject>& objects);
+};
+
+// Classify spheres [first, last) against planes from ExtractFrustumPlanes
+void ClassifySpheres(const CullingSpheres& spheres, const Vec4f planes[6],
+    uint32_t first, uint32_t last, CullResult* results);
+
+struct GPUCulling
+{
+    VkPipeline pipeline { VK_NULL_HANDLE };
+    VkPipelineLayout layout { VK_NULL_HANDLE };
+
+    // Batches of the current draw list
+    std::vector<GPUDrawBatch> batches;
+    uint32_t object_count { 0 };
+    uint32_t submitted_triangles { 0 };    // Pre-cull total, culled count is only known on the GPU
+
+    // True when the cull pipeline was created (requires the indirect mesh pipeline variant) and the
+    // device has drawIndirectCount and drawIndirectFirstInstance
+    bool isSupported() const { return pipeline != VK_NULL_HANDLE && indirect_supported; }
+
+    void init(phVkEngine* engine);
+    void clearResources(phVkEngine* engine);
+    void destroyBuffers(phVkEngine* engine, GPUCullingBuffers& buffers);
+
+    // Build batches from the opaque draw list (if invalidated) and copy the changed objects into the
+    // object buffer (must be recorded outside of rendering, before the cull passes)
+    void prepare(VkCommandBuffer cmd, phVkEngine* engine, FrameData& frame, const DrawContext& ctx);
+
+    // Reset counts and dispatch the cull shader for a CULL_PHASE_* (must be recorded outside of rendering)
+    // The early and frustum phases draw from pass 0, the late phase from pass 1
+    void recordCull(VkCommandBuffer cmd, phVkEngine* engine, FrameData& frame, const Mat4f& view_proj,
+        uint32_t phase, VkExtent2D extent);
+
+    // Issue one indirect-count draw per batch for a pass (must be recorded inside rendering)
+    void recordDraws(VkCommandBuffer cmd, phVkEngine* engine, FrameData& frame,
+        VkDescriptorSet global_descriptor, uint32_t global_offset, VkExtent2D extent, uint32_t pass = 0);
+
+    // Last-frame visibility no longer matches the object list (every object counts as visible)
+    void resetVisibility() { visibility_valid = false; }
+
+    // Objects were added, removed or moved to another geometry page, the next prepare rebuilds the batches
+    // and the whole object buffer
+    void invalidateBatches()
+    {
+        batches_valid = false;
+        changed_objects.clear();
+    }
+
+    // Transforms, bounds or the LOD range of opaque objects [first, first + count) changed
+    void markObjectsChanged(uint32_t first, uint32_t count);
+
+private:
+    struct ObjectRange
+    {
+        uint32_t first, count;
+    };
+
+    // Batch of every object, kept while the batches are valid
+    std::vector<uint32_t> object_batches;
+    bool batches_valid { false };
+
+    // GPUObjectData of every opaque object, shared by all frames
+    // Patched by prepare with the ranges marked since the last frame
+    AllocatedBuffer object_buffer;
+    VkDeviceAddress object_buffer_address { 0 };
+    uint32_t object_capacity { 0 };
+    std::vector<ObjectRange> changed_objects;
+    std::vector<VkBufferCopy> object_copies;
+
+    // Visibility of every object in the last late phase (uint32_t per object), shared by all frames
+    AllocatedBuffer visibility_buffer;
+    VkDeviceAddress visibility_buffer_address { 0 };
+    uint32_t visibility_capacity { 0 };
+    bool visibility_valid { false };
+
+    bool indirect_supported { false };
+
+    void reserve(phVkEngine* engine, GPUCullingBuffers& buffers, uint32_t objects, uint32_t batch_count);
+};
@@ -7,6 +7,7 @@
 
 #include "phvk_descriptors.h"
 #include "phvk_initializers.h"
+#include "phvk_resource_cache.h"
 
 //> descriptor_bind
 void DescriptorLayoutBuilder::addBinding(uint32_t binding, VkDescriptorType type)
@@ -44,6 +45,22 @@ VkDescriptorSetLayout DescriptorLayoutBuilder::build(VkDevice device, VkShaderSt
 
     return set;
 }
+
+VkDescriptorSetLayout DescriptorLayoutBuilder::build(ResourceCache& cache, VkShaderStageFlags shader_stages, void* p_next, VkDescriptorSetLayoutCreateFlags flags)
+{
+    for (auto& b : bindings) {
+        b.stageFlags |= shader_stages;
+    }
+
+    VkDescriptorSetLayoutCreateInfo info = {.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    info.pNext = p_next;
+
+    info.pBindings = bindings.data();
+    info.bindingCount = (uint32_t)bindings.size();
+    info.flags = flags;
+
+    return cache.getDescriptorLayout(info);
+}
 //< descriptor_layout
 
 //> descriptor_pool_init
@@ -94,64 +111,106 @@ VkDescriptorSet DescriptorAllocator::allocate(VkDevice device, VkDescriptorSetLa
 //> write_image
 void DescriptorWriter::writeImage(int binding,VkImageView image, VkSampler sampler,  VkImageLayout layout, VkDescriptorType type)
 {
-    VkDescriptorImageInfo& info = image_info.emplace_back(VkDescriptorImageInfo 
+    assert(image_count < MAX_WRITES && write_count < MAX_WRITES);
+
+    VkDescriptorImageInfo& info = image_info[image_count++];
+    info = VkDescriptorImageInfo 
         {
 		    .sampler = sampler,
 		    .imageView = image,
 		    .imageLayout = layout
-	    });
+	    };
 
-	VkWriteDescriptorSet write = { .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	VkWriteDescriptorSet& write = writes[write_count++];
+	write = { .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
 
 	write.dstBinding = binding;
 	write.dstSet = VK_NULL_HANDLE; // Left empty for now until we need to write it
 	write.descriptorCount = 1;
 	write.descriptorType = type;
 	write.pImageInfo = &info;
-
-	writes.push_back(write);
 }
 //< write_image
 // 
 //> write_buffer
 void DescriptorWriter::writeBuffer(int binding, VkBuffer buffer, size_t size, size_t offset, VkDescriptorType type)
 {
-	VkDescriptorBufferInfo& info = buffer_info.emplace_back(VkDescriptorBufferInfo
+    assert(buffer_count < MAX_WRITES && write_count < MAX_WRITES);
+
+	VkDescriptorBufferInfo& info = buffer_info[buffer_count++];
+    info = VkDescriptorBufferInfo
         {
 		    .buffer = buffer,
 		    .offset = offset,
 		    .range = size
-		});
+		};
 
-	VkWriteDescriptorSet write = {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+	VkWriteDescriptorSet& write = writes[write_count++];
+	write = {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
 
 	write.dstBinding = binding;
 	write.dstSet = VK_NULL_HANDLE; // Left empty for now until we need to write it
 	write.descriptorCount = 1;
 	write.descriptorType = type;
 	write.pBufferInfo = &info;
-
-	writes.push_back(write);
 }
 //< write_buffer
 //> writer_end
 void DescriptorWriter::clear()
 {
-    image_info.clear();
-    writes.clear();
-    buffer_info.clear();
+    image_count = 0;
+    write_count = 0;
+    buffer_count = 0;
 }
 
 void DescriptorWriter::updateSet(VkDevice device, VkDescriptorSet set)
 {
-    for (VkWriteDescriptorSet& write : writes) 
+    for (uint32_t i = 0; i < write_count; i++) 
     {
-        write.dstSet = set;
+        writes[i].dstSet = set;
     }
 
-    vkUpdateDescriptorSets(device, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+    vkUpdateDescriptorSets(device, write_count, writes.data(), 0, nullptr);
 }
 //< writer_end
+
+VkDescriptorUpdateTemplateEntry DescriptorUpdateTemplate::entry(uint32_t binding, VkDescriptorType type, size_t offset)
+{
+    VkDescriptorUpdateTemplateEntry entry {};
+    entry.dstBinding = binding;
+    entry.dstArrayElement = 0;
+    entry.descriptorCount = 1;
+    entry.descriptorType = type;
+    entry.offset = offset;
+    entry.stride = 0;   // Single descriptor, stride unused
+
+    return entry;
+}
+
+void DescriptorUpdateTemplate::build(VkDevice device, VkDescriptorSetLayout layout, std::span<const VkDescriptorUpdateTemplateEntry> entries)
+{
+    VkDescriptorUpdateTemplateCreateInfo info = {.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO};
+    info.descriptorUpdateEntryCount = (uint32_t)entries.size();
+    info.pDescriptorUpdateEntries = entries.data();
+    info.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    info.descriptorSetLayout = layout;
+
+    VK_CHECK(vkCreateDescriptorUpdateTemplate(device, &info, nullptr, &update_template));
+}
+
+void DescriptorUpdateTemplate::destroy(VkDevice device)
+{
+    if (update_template != VK_NULL_HANDLE)
+    {
+        vkDestroyDescriptorUpdateTemplate(device, update_template, nullptr);
+        update_template = VK_NULL_HANDLE;
+    }
+}
+
+void DescriptorUpdateTemplate::updateSet(VkDevice device, VkDescriptorSet set, const void* data) const
+{
+    vkUpdateDescriptorSetWithTemplate(device, set, update_template, data);
+}
 //> growpool_2
 void DescriptorAllocatorGrowable::init(VkDevice device, uint32_t max_sets, std::span<PoolSizeRatio> pool_ratios)
 {
@@ -167,6 +226,9 @@ void DescriptorAllocatorGrowable::init(VkDevice device, uint32_t max_sets, std::
     sets_per_pool = max_sets * 1.5; // Grow it next allocation
 
     ready_pools.push_back(new_pool);
+
+    set_count = 0;
+    retry_count = 0;
 }
 
 void DescriptorAllocatorGrowable::clearPools(VkDevice device)
@@ -199,18 +261,13 @@ void DescriptorAllocatorGrowable::destroyPools(VkDevice device)
 //< growpool_2
 
 //> growpool_1
+// Current pool: the last ready one (allocations keep using it until it is full)
 VkDescriptorPool DescriptorAllocatorGrowable::getPool(VkDevice device)
 {       
-    VkDescriptorPool new_pool;
-    if (ready_pools.size() != 0) 
-    {
-        new_pool = ready_pools.back();
-        ready_pools.pop_back();
-    }
-    else 
+    if (ready_pools.empty()) 
     {
 	    //need to create a new pool
-	    new_pool = createPool(device, sets_per_pool, ratios);
+	    ready_pools.push_back(createPool(device, sets_per_pool, ratios));
 
 	    sets_per_pool = sets_per_pool * 1.5;
 	    if (sets_per_pool > 4092) 
@@ -219,7 +276,7 @@ VkDescriptorPool DescriptorAllocatorGrowable::getPool(VkDevice device)
 	    }
     }   
 
-    return new_pool;
+    return ready_pools.back();
 }
 
 VkDescriptorPool DescriptorAllocatorGrowable::createPool(VkDevice device, uint32_t set_count, std::span<PoolSizeRatio> pool_ratios)
@@ -250,31 +307,44 @@ VkDescriptorPool DescriptorAllocatorGrowable::createPool(VkDevice device, uint32
 //> growpool_3
 VkDescriptorSet DescriptorAllocatorGrowable::allocate(VkDevice device, VkDescriptorSetLayout layout, void* p_next)
 {
-    //get or create a pool to allocate from
-    VkDescriptorPool pool_to_use = getPool(device);
-
 	VkDescriptorSetAllocateInfo alloc_info = {};
 	alloc_info.pNext = p_next;
 	alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	alloc_info.descriptorPool = pool_to_use;
+	alloc_info.descriptorPool = getPool(device);
 	alloc_info.descriptorSetCount = 1;
 	alloc_info.pSetLayouts = &layout;
 
 	VkDescriptorSet ds;
 	VkResult result = vkAllocateDescriptorSets(device, &alloc_info, &ds);
 
-    //allocation failed. Try again
+    //allocation failed: retire the current pool and try again in the next one
     if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) 
     {
-        full_pools.push_back(pool_to_use);
-    
-        pool_to_use = getPool(device);
-        alloc_info.descriptorPool = pool_to_use;
+        full_pools.push_back(ready_pools.back());
+        ready_pools.pop_back();
+        retry_count++;
 
+        alloc_info.descriptorPool = getPool(device);
         VK_CHECK(vkAllocateDescriptorSets(device, &alloc_info, &ds));
     }
-  
-    ready_pools.push_back(pool_to_use);
+    else
+    {
+        VK_CHECK(result);
+    }
+
+    set_count++;
     return ds;
 }
+
+DescriptorAllocatorGrowable::Stats DescriptorAllocatorGrowable::takeStats()
+{
+    Stats stats;
+    stats.pools = (uint32_t)(ready_pools.size() + full_pools.size());
+    stats.sets = set_count;
+    stats.retries = retry_count;
+
+    set_count = 0;
+    retry_count = 0;
+    return stats;
+}
 //< growpool_3
\ No newline at end of file
@@ -10,9 +10,11 @@
 
 #include "phvk_types.h"
 
-#include <deque>
+#include <array>
 #include <span>
 
+class ResourceCache;
+
 //> descriptor_layout
 struct DescriptorLayoutBuilder 
 {
@@ -21,15 +23,29 @@ struct DescriptorLayoutBuilder
     void addBinding(uint32_t binding, VkDescriptorType type);
     void clear();
     VkDescriptorSetLayout build(VkDevice device, VkShaderStageFlags shaderStages, void* p_next = nullptr, VkDescriptorSetLayoutCreateFlags flags = 0);
+
+    // Shared through the cache (identical layouts are created once, the cache destroys them)
+    VkDescriptorSetLayout build(ResourceCache& cache, VkShaderStageFlags shaderStages, void* p_next = nullptr, VkDescriptorSetLayoutCreateFlags flags = 0);
 };
 //< descriptor_layout
 // 
 //> writer
+// Fixed capacity (MAX_WRITES per set), no heap allocation: meant to live on the stack
+// Not copyable or movable, writes point into the info arrays
 struct DescriptorWriter 
 {
-    std::deque<VkDescriptorImageInfo> image_info;
-    std::deque<VkDescriptorBufferInfo> buffer_info;
-    std::vector<VkWriteDescriptorSet> writes;
+    static constexpr uint32_t MAX_WRITES = 16;
+
+    std::array<VkDescriptorImageInfo, MAX_WRITES> image_info;
+    std::array<VkDescriptorBufferInfo, MAX_WRITES> buffer_info;
+    std::array<VkWriteDescriptorSet, MAX_WRITES> writes;
+    uint32_t image_count { 0 };
+    uint32_t buffer_count { 0 };
+    uint32_t write_count { 0 };
+
+    DescriptorWriter() = default;
+    DescriptorWriter(const DescriptorWriter&) = delete;
+    DescriptorWriter& operator=(const DescriptorWriter&) = delete;
 
     void writeImage(int binding, VkImageView image, VkSampler sampler, VkImageLayout layout, VkDescriptorType type);
     void writeBuffer(int binding, VkBuffer buffer, size_t size, size_t offset, VkDescriptorType type); 
@@ -39,6 +55,21 @@ struct DescriptorWriter
 };
 //< writer
 // 
+// Descriptor update template: a set's layout written from one struct in a single call
+// (vkUpdateDescriptorSetWithTemplate), for sets rewritten often with the same shape
+struct DescriptorUpdateTemplate
+{
+    VkDescriptorUpdateTemplate update_template { VK_NULL_HANDLE };
+
+    // One descriptor per entry, read from data + offset (a VkDescriptorImageInfo / VkDescriptorBufferInfo)
+    static VkDescriptorUpdateTemplateEntry entry(uint32_t binding, VkDescriptorType type, size_t offset);
+
+    void build(VkDevice device, VkDescriptorSetLayout layout, std::span<const VkDescriptorUpdateTemplateEntry> entries);
+    void destroy(VkDevice device);
+
+    void updateSet(VkDevice device, VkDescriptorSet set, const void* data) const;
+};
+// 
 //> descriptor_allocator
 struct DescriptorAllocator 
 {
@@ -69,11 +100,22 @@ public:
 		float ratio;
 	};
 
+    // Allocation counters (sets / retries since the last takeStats)
+    struct Stats
+    {
+        uint32_t pools { 0 };           // Pools alive
+        uint32_t sets { 0 };
+        uint32_t retries { 0 };         // Allocations that found the current pool full
+    };
+
 	void init(VkDevice device, uint32_t initial_sets, std::span<PoolSizeRatio> pool_ratios);
 	void clearPools(VkDevice device);
 	void destroyPools(VkDevice device);
 
     VkDescriptorSet allocate(VkDevice device, VkDescriptorSetLayout layout, void* p_next = nullptr);
+
+    // Current counters, sets and retries restart from zero
+    Stats takeStats();
 private:
 	VkDescriptorPool getPool(VkDevice device);
 	VkDescriptorPool createPool(VkDevice device, uint32_t set_count, std::span<PoolSizeRatio> pool_ratios);
@@ -83,5 +125,8 @@ private:
 	std::vector<VkDescriptorPool> ready_pools;
 	uint32_t sets_per_pool;
 
+    uint32_t set_count { 0 };
+    uint32_t retry_count { 0 };
+
 };
 //< descriptor_allocator_grow
\ No newline at end of file
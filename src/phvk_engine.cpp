@@ -14,7 +14,11 @@
 
 #include <VkBootstrap.h> 
 
+#include <algorithm>
 #include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 
@@ -38,6 +42,10 @@
 // Singleton instance of the engine
 phVkEngine* loaded_engine = nullptr;
 
+// First use of the swapchain image in a frame (blit from the draw image), the acquire semaphore
+// wait and the image's first barrier both use it
+constexpr VkPipelineStageFlags2 SWAPCHAIN_WAIT_STAGES = VK_PIPELINE_STAGE_2_BLIT_BIT;
+
 phVkEngine& phVkEngine::getLoadedEngine() 
 { 
     return *loaded_engine; 
@@ -102,6 +110,13 @@ bool IsVisible(const RenderObject& obj, const Mat4f& viewproj)
     }
 }
 
+// Distance of the bounds center along the view direction (positive in front of the camera)
+float ViewDepth(const RenderObject& obj, const Mat4f& view)
+{
+    Vec4f center = view * (obj.transform * Vec4f(obj.bounds.origin, 1.f));
+    return -center.z;
+}
+
 
 void phVkEngine::init()
 {
@@ -114,6 +129,11 @@ void phVkEngine::init()
 
     // SDL window flags
     SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+    if (headless)
+    {
+        // Window only provides the surface for device selection, nothing is presented
+        window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN | SDL_WINDOW_HIDDEN);
+    }
 
 	// Create the window
     window = SDL_CreateWindow(
@@ -124,6 +144,8 @@ void phVkEngine::init()
         window_extent.height,
         window_flags);
 
+    jobs.init();
+
     initVulkan();
     initSwapchain();
     initCommands();
@@ -139,23 +161,50 @@ void phVkEngine::init()
     main_camera.pitch = 0.f;
 	main_camera.yaw = 0.f;
 
-    // GLTF Scene
-    std::string structure_path = { "../../../../assets/structure.glb" };
-    auto structure_file = LoadGLTF(this, structure_path);
-    assert(structure_file.has_value());
-    loaded_scenes["structure"] = *structure_file;
+    // GLTF Scene (streams in while the main loop renders)
+    if (load_default_scene)
+    {
+        std::string structure_path = { "../../../../assets/structure.glb" };
+        loadSceneAsync("structure", structure_path);
+    }
 
     is_initialized = true;
 }
 
+static const char* PresentModeName(VkPresentModeKHR mode)
+{
+    switch (mode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR: return "Immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR: return "Mailbox";
+    case VK_PRESENT_MODE_FIFO_KHR: return "FIFO (vsync)";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO Relaxed";
+    default: return "Other";
+    }
+}
+
 void phVkEngine::run()
 {
     SDL_Event sdl_event;
     bool sdl_quit = false;
 
+    auto last_frame_start = std::chrono::steady_clock::now();
+
     // main loop
     while (!sdl_quit) {
 
+        // Low-latency pacing sleeps here, so the input below is as fresh as possible
+        paceFrame();
+
+        // Full loop time (including the fence wait in draw)
+        auto frame_start = std::chrono::steady_clock::now();
+        stats.frame_time = std::chrono::duration<float, std::milli>(frame_start - last_frame_start).count();
+        last_frame_start = frame_start;
+
+        const uint64_t heap_allocations = HeapAllocationCount();
+        stats.heap_allocations = (int)(heap_allocations - last_heap_allocations);
+        last_heap_allocations = heap_allocations;
+
         // Handle queued events
         while (SDL_PollEvent(&sdl_event) != 0)
         {
@@ -206,7 +255,27 @@ void phVkEngine::run()
         // Imgui window for controlling background
         if (ImGui::Begin("background"))
         {
+            ImGui::BeginDisabled(dynamic_resolution);
             ImGui::SliderFloat("Render Scale", &render_scale, 0.3f, 1.f);
+            ImGui::EndDisabled();
+
+            ImGui::BeginDisabled(!gpu_profiler.isSupported());
+            ImGui::Checkbox("Dynamic Resolution", &dynamic_resolution);
+            ImGui::EndDisabled();
+            if (dynamic_resolution)
+            {
+                ImGui::SliderFloat("Target GPU Time (ms)", &target_gpu_time, 2.f, 50.f);
+                ImGui::SliderFloat("Min Render Scale", &min_render_scale, 0.3f, 1.f);
+                ImGui::Text("GPU %.2f ms at %.0f%% scale", gpu_time_estimate, render_scale * 100.f);
+            }
+
+            bool cubic = upscale_filter == VK_FILTER_CUBIC_EXT;
+            ImGui::BeginDisabled(!cubic_blit_supported);
+            if (ImGui::Checkbox("Cubic Upscale", &cubic))
+            {
+                upscale_filter = cubic ? VK_FILTER_CUBIC_EXT : VK_FILTER_LINEAR;
+            }
+            ImGui::EndDisabled();
 
             ComputeEffect& selected = background_effects[current_background_effect];
 
@@ -214,6 +283,15 @@ void phVkEngine::run()
 
             ImGui::SliderInt("Effect Index", &current_background_effect, 0, background_effects.size() - 1);
 
+            if (async_compute.isAvailable())
+            {
+                ImGui::Checkbox("Async Compute", &async_compute.enabled);
+            }
+            else
+            {
+                ImGui::Text("Async compute: no separate queue family (inline)");
+            }
+
             ImGui::InputFloat4("data1", (float*)&selected.data.data1);
             ImGui::InputFloat4("data2", (float*)&selected.data.data2);
             ImGui::InputFloat4("data3", (float*)&selected.data.data3);
@@ -222,6 +300,112 @@ void phVkEngine::run()
             ImGui::End();
         }
 
+        // Imgui window for engine stats and render path toggles
+        if (ImGui::Begin("Stats"))
+        {
+            ImGui::Text("Frame time: %.2f ms (GPU %.2f ms)", stats.frame_time, 
+                gpu_profiler.averageFrameTime());
+            ImGui::Text("Draw time: %f ms", stats.mesh_draw_time);
+            ImGui::Text("Triangles: %i", stats.triangle_count);
+            ImGui::Text("Draws: %i (%i instances)", stats.drawcall_count, stats.instance_count);
+            ImGui::Text("Heap allocations: %i per frame", stats.heap_allocations);
+            ImGui::Text("Latency: %.2f ms input to submit, %.2f ms to present (%.2f ms fence, %.2f ms pacing)",
+                stats.input_latency, stats.present_latency, stats.fence_wait, stats.pacing_wait);
+            if (stats.cull_tested > 0)
+            {
+                ImGui::Text("CPU culling: %i / %i visible (%.1f%% culled, %i box tests, %i BVH nodes)", 
+                    stats.cull_visible, stats.cull_tested, 100.f * (1.f - stats.cull_visible / (float)stats.cull_tested), 
+                    stats.cull_box_tests, stats.cull_bvh_nodes);
+            }
+            ImGui::Text("LODs: %i surfaces reduced", stats.lod_reduced);
+            ImGui::Text("Uploads: %u batches, %.1f MB", upload_manager.batches_submitted, 
+                upload_manager.bytes_uploaded / (1024.0 * 1024.0));
+            ImGui::Text("Loading scenes: %zu", pending_loads.size());
+            ImGui::Text("Vertex memory: %.1f MB (packing saved %.1f MB)", 
+                vertex_memory / (1024.0 * 1024.0), vertex_memory_saved / (1024.0 * 1024.0));
+            if (metal_rough_material.isBindless())
+            {
+                ImGui::Text("Bindless: %u / %u textures, %u materials", bindless_registry.textureCount(),
+                    bindless_registry.textureCapacity(), bindless_registry.materialCount());
+            }
+            ImGui::Text("Geometry pool: %.1f / %.1f MB (%u pages)", 
+                geometry_pool.usedBytes() / (1024.0 * 1024.0), 
+                geometry_pool.capacityBytes() / (1024.0 * 1024.0), geometry_pool.livePageCount());
+            ImGui::Text("Descriptors: %i pools, %i sets (%i retries)", stats.descriptor_pools,
+                stats.descriptor_sets, stats.descriptor_retries);
+            ImGui::Text("Render graph: %i barriers in %i batches, %.1f MB transient",
+                stats.graph_barriers, stats.graph_barrier_batches, 
+                render_graph.transientBytes() / (1024.0 * 1024.0));
+            ImGui::Text("Caches: %zu samplers, %zu layouts (%u hits), %zu shared textures (%u hits)",
+                resource_cache.samplerCount(), resource_cache.layoutCount(), resource_cache.hits(),
+                texture_cache.size(), texture_cache.hits());
+            if (texture_streamer.isEnabled())
+            {
+                ImGui::Text("Streamed textures: %u, %.1f MB resident (%u uploading)", texture_streamer.textureCount(),
+                    texture_streamer.residentBytes() / (1024.0 * 1024.0), texture_streamer.uploadingCount());
+                ImGui::SliderInt("Texture Budget (MB)", &texture_streamer.budget_mb, 32, 4096);
+            }
+
+            ImGui::BeginDisabled(!gpu_culling.isSupported());
+            ImGui::Checkbox("GPU Culling", &use_gpu_culling);
+            ImGui::EndDisabled();
+
+            ImGui::BeginDisabled(!isGPUDriven() || !depth_pyramid.isSupported());
+            ImGui::Checkbox("Occlusion Culling", &use_occlusion_culling);
+            ImGui::EndDisabled();
+
+            ImGui::BeginDisabled(isGPUDriven());
+            ImGui::Checkbox("BVH Culling", &use_bvh_culling);
+            ImGui::EndDisabled();
+
+            ImGui::Checkbox("LODs", &use_lods);
+            ImGui::SliderFloat("LOD Error (px)", &lod_error_pixels, 0.25f, 8.f);
+
+            ImGui::BeginDisabled(isGPUDriven() || jobs.workerCount() == 0);
+            ImGui::Checkbox("Parallel Recording", &use_parallel_recording);
+            ImGui::EndDisabled();
+
+            ImGui::BeginDisabled(isGPUDriven() || !metal_rough_material.supportsInstancing());
+            ImGui::Checkbox("Instancing", &use_instancing);
+            ImGui::EndDisabled();
+
+            ImGui::BeginDisabled(isGPUDriven() || !metal_rough_material.supportsMeshlets());
+            ImGui::Checkbox("Mesh Shading", &use_mesh_shading);
+            ImGui::EndDisabled();
+
+            // Presentation: rebuilding the swapchain applies a new present mode
+            int overlap = (int)frame_overlap;
+            if (ImGui::SliderInt("Frames In Flight", &overlap, 1, (int)MAX_FRAME_OVERLAP))
+            {
+                setFrameOverlap((uint32_t)overlap);
+            }
+
+            ImGui::BeginDisabled(headless);
+            if (ImGui::BeginCombo("Present Mode", PresentModeName(active_present_mode)))
+            {
+                for (VkPresentModeKHR mode : supported_present_modes)
+                {
+                    if (ImGui::Selectable(PresentModeName(mode), mode == active_present_mode) && mode != active_present_mode)
+                    {
+                        present_mode = mode;
+                        resize_requested = true;
+                    }
+                }
+                ImGui::EndCombo();
+            }
+            ImGui::EndDisabled();
+
+            bool low_latency = frame_pacing == FramePacing::low_latency;
+            if (ImGui::Checkbox(present_wait_supported ? "Low-Latency Pacing (present wait)" : "Low-Latency Pacing", &low_latency))
+            {
+                frame_pacing = low_latency ? FramePacing::low_latency : FramePacing::throughput;
+            }
+        }
+        ImGui::End();
+
+        gpu_profiler.drawImGui();
+        memory_manager.drawImGui();
+
         // Calculate internal draw structures for imgui (does not draw to a Vulkan image)
         ImGui::Render();
 
@@ -236,35 +420,62 @@ void phVkEngine::cleanup()
 		// Objects have interdependencies, 
         // Generally should delete in reverse order of creation
 
+        // Finish background loads so every scene is in a consistent state
+        jobs.shutdown();
+        for (auto& request : pending_loads)
+        {
+            FinalizeGLTF(this, *request);
+        }
+        pending_loads.clear();
+
         // Wait for GPU to finish
         vkDeviceWaitIdle(device);
 
-        // GLTF Scenes
+        // Old copies of a defragmentation pass in flight, before their owners go
+        memory_manager.destroy();
+
+        // GLTF Scenes (replaced ones wait in the frame delete queues)
+        for (FrameData& frame : frames)
+        {
+            frame.delete_queue.flush(device, allocator);
+        }
         loaded_scenes.clear();
+        draw_commands.opaque_surfaces.clear();
+        draw_commands.transparent_surfaces.clear();
+        texture_cache.destroy();
+        texture_streamer.destroy();
 
-        for (int i = 0; i < FRAME_OVERLAP; i++) {
+        for (int i = 0; i < MAX_FRAME_OVERLAP; i++) {
             // Note: destroying the command pool also destroys buffers allocated from it
             vkDestroyCommandPool(device, frames[i].command_pool, nullptr);
+            for (uint32_t t = 0; t < MAX_RECORD_THREADS; t++)
+            {
+                vkDestroyCommandPool(device, frames[i].secondary_pools[t], nullptr);
+            }
 
             //destroy sync objects
             vkDestroyFence(device, frames[i].render_fence, nullptr);
             vkDestroySemaphore(device, frames[i].render_semaphore, nullptr);
             vkDestroySemaphore(device, frames[i].swapchain_semaphore, nullptr);
 
-			frames[i].delete_queue.flush();
+			frames[i].delete_queue.flush(device, allocator);
+
+            gpu_culling.destroyBuffers(this, frames[i].culling_buffers);
         }
 
-        // Destroy mesh array buffers
+        // Release mesh geometry, then the pool itself
         for (auto& mesh : test_meshes)
         {
-            destroyBuffer(mesh->mesh_buffers.index_buffer);
-            destroyBuffer(mesh->mesh_buffers.vertex_buffer);
+            freeMesh(mesh->mesh_buffers);
         }
+        geometry_pool.destroy();
 
         metal_rough_material.clearResources(device);
+        gpu_culling.clearResources(this);
+        depth_pyramid.destroy(this);
 
         // Flush the global deletion queue
-        main_delete_queue.flush();
+        main_delete_queue.flush(device, allocator);
 
         destroySwapchain();
 
@@ -281,39 +492,152 @@ void phVkEngine::cleanup()
     loaded_engine = nullptr;
 }
 
-void phVkEngine::drawMain(VkCommandBuffer cmd)
+void phVkEngine::scheduleBackground()
+{
+    FrameData& frame = getCurrentFrame();
+
+    // Written on the compute queue into the frame's own image (the draw image may still be in use
+    // by the previous frame), otherwise straight into the draw image (the render graph's
+    // Background pass declares it)
+    if (async_compute.isAsync())
+    {
+        ComputeImageUse target {};
+        target.image = frame.background_image.image;
+        target.final_layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        target.graphics_stages = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT;
+        target.graphics_access = VK_ACCESS_2_TRANSFER_READ_BIT;
+
+        async_compute.addPass("Background", { &target, 1 }, [this, &frame](VkCommandBuffer cmd)
+            {
+                recordBackground(cmd, frame.background_descriptors);
+            });
+    }
+    else
+    {
+        async_compute.addPass("Background", {}, [this](VkCommandBuffer cmd)
+            {
+                recordBackground(cmd, draw_image_descriptors);
+            });
+    }
+}
+
+void phVkEngine::recordBackground(VkCommandBuffer cmd, VkDescriptorSet target)
 {
     ComputeEffect& effect = background_effects[current_background_effect];
 
     // bind the background compute pipeline
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, effect.pipeline);
 
-    // bind the descriptor set containing the draw image for the compute pipeline
+    // bind the descriptor set containing the target image for the compute pipeline
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, gradient_pipeline_layout, 
-        0, 1, &draw_image_descriptors, 0, nullptr);
+        0, 1, &target, 0, nullptr);
 
     vkCmdPushConstants(cmd, gradient_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, 
         sizeof(ComputePushConstants), &effect.data);
     // execute the compute pipeline dispatch. We are using 16x16 workgroup size so we need to divide by it
-    vkCmdDispatch(cmd, std::ceil(window_extent.width / 16.0), 
-        std::ceil(window_extent.height / 16.0), 1);
+    vkCmdDispatch(cmd, std::ceil(draw_extent.width / 16.0), 
+        std::ceil(draw_extent.height / 16.0), 1);
+}
 
-    //draw the triangle
+void phVkEngine::drawMain(VkCommandBuffer cmd)
+{
+    // Draw counts cover every geometry pass of the frame
+    stats.drawcall_count = 0;
+    stats.triangle_count = 0;
+    stats.instance_count = 0;
+
+    const bool occlusion = isOcclusionCulling();
+    const bool async_background = async_compute.frameAsync();
+
+    // Background: inline into the draw image, or copied in from the async compute queue
+    render_graph.setEnabled(frame_graph.background, !async_background);
+    render_graph.setEnabled(frame_graph.background_copy, async_background);
+    if (async_background)
+    {
+        const AllocatedImage& background = getCurrentFrame().background_image;
+        render_graph.setImported(frame_graph.background_image, background.image, background.view,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT,
+            VK_ACCESS_2_TRANSFER_READ_BIT);
+    }
 
-    vkutil::transition_image(cmd, draw_image.image, VK_IMAGE_LAYOUT_GENERAL, 
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    // GPU-driven culling writes the indirect commands before rendering begins
+    // With occlusion culling this is the early phase (objects visible last frame),
+    // followed by the Hi-Z build and the late phase
+    render_graph.setEnabled(frame_graph.culling, isGPUDriven());
+    render_graph.setEnabled(frame_graph.geometry_early, occlusion);
+    render_graph.setEnabled(frame_graph.hiz, occlusion);
+    render_graph.setEnabled(frame_graph.culling_late, occlusion);
+
+    // Headless frames stop at the draw image
+    render_graph.setEnabled(frame_graph.blit, !headless);
+    render_graph.setEnabled(frame_graph.imgui, !headless);
+
+    // CPU side of the culling passes (batches, object buffer), so passes only record commands
+    // Changes aren't tracked while culling runs on the CPU, everything is rewritten once it's back on
+    if (isGPUDriven())
+    {
+        gpu_culling.prepare(cmd, this, getCurrentFrame(), draw_commands);
+    }
+    else
+    {
+        gpu_culling.invalidateBatches();
+    }
+
+    render_graph.execute(cmd);
+
+    stats.graph_barriers = render_graph.barriers_recorded;
+    stats.graph_barrier_batches = render_graph.batches_recorded;
+}
+
+void phVkEngine::drawGeometryPass(VkCommandBuffer cmd, bool early)
+{
+    const bool occlusion = isOcclusionCulling();
 
     VkRenderingAttachmentInfo colorAttachment = vkinit::attachment_info(draw_image.view, 
         nullptr, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
     VkRenderingAttachmentInfo depthAttachment = vkinit::depth_attachment_info(depth_image.view, 
         VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
 
-    VkRenderingInfo render_info = vkinit::rendering_info(window_extent, 
+    VkRenderingInfo render_info = vkinit::rendering_info(draw_extent, 
         &colorAttachment, &depthAttachment);
 
+    // Early pass: last frame's visible objects lay down the occluder depth
+    if (early)
+    {
+        vkCmdBeginRendering(cmd, &render_info);
+        gpu_culling.recordDraws(cmd, this, getCurrentFrame(), getCurrentFrame().scene_descriptor,
+            getCurrentFrame().scene_data_offset, draw_extent, 0);
+        vkCmdEndRendering(cmd);
+        return;
+    }
+
+    // Rest of the frame draws on top of the early pass, depth isn't needed afterwards
+    if (occlusion)
+    {
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    }
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+    // Large CPU-culled lists are recorded into secondary command buffers on the workers
+    const bool parallel = useParallelRecording();
+
+    // Pipeline statistics (queries span the rendering instance)
+    // Secondaries can only execute inside an active query if they inherit it
+    if (!parallel || inherited_queries_supported)
+    {
+        gpu_profiler.beginStatistics(cmd);
+    }
+
+    if (parallel)
+    {
+        render_info.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+    }
+
     vkCmdBeginRendering(cmd, &render_info);
+
+    // CPU recording time (GPU time is in the profiler)
     auto start = std::chrono::system_clock::now();
-    drawGeometry(cmd);
+    drawGeometry(cmd, parallel);
 
     auto end = std::chrono::system_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
@@ -321,6 +645,8 @@ void phVkEngine::drawMain(VkCommandBuffer cmd)
     stats.mesh_draw_time = elapsed.count() / 1000.f;
 
     vkCmdEndRendering(cmd);
+
+    gpu_profiler.endStatistics(cmd);
 }
 
 void phVkEngine::drawImgui(VkCommandBuffer cmd, VkImageView targetImageView)
@@ -338,27 +664,54 @@ void phVkEngine::drawImgui(VkCommandBuffer cmd, VkImageView targetImageView)
 
 void phVkEngine::draw()
 {
+    updateScene();
+
     //wait until the gpu has finished rendering the last frame. Timeout of 1 second
+    auto fence_start = std::chrono::steady_clock::now();
     VK_CHECK(vkWaitForFences(device, 1, &getCurrentFrame().render_fence, true, 1000000000));
+    stats.fence_wait = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - fence_start).count();
+    getCurrentFrame().input_time = input_time;
+    getCurrentFrame().present_id = 0;
 
-    getCurrentFrame().delete_queue.flush();
+    getCurrentFrame().delete_queue.flush(device, allocator);
+    collectDescriptorStats();
     getCurrentFrame().frame_descriptors.clearPools(device);
-    // request image from the swapchain
-    uint32_t swapchain_image_index;
+    getCurrentFrame().arena.reset();
 
-    VkResult e = vkAcquireNextImageKHR(device, swapchain, 1000000000, 
-        getCurrentFrame().swapchain_semaphore, nullptr, &swapchain_image_index);
-    if (e == VK_ERROR_OUT_OF_DATE_KHR) 
+    // Recycle the frame's upload buffer and write the scene uniforms first
+    // (the pre-built scene descriptor points into the primary block)
+    if (getCurrentFrame().upload_buffer.reset(this))
     {
-        resize_requested = true;
-        return;
+        writeSceneDescriptor(getCurrentFrame());
+    }
+
+    UploadAllocation scene_alloc = getCurrentFrame().upload_buffer.push(this, scene_data);
+    assert(scene_alloc.buffer == getCurrentFrame().upload_buffer.primaryBuffer());
+    getCurrentFrame().scene_data_offset = (uint32_t)scene_alloc.offset;
+    // request image from the swapchain (headless frames only render the draw image)
+    uint32_t swapchain_image_index = 0;
+
+    if (!headless)
+    {
+        VkResult e = vkAcquireNextImageKHR(device, swapchain, 1000000000, 
+            getCurrentFrame().swapchain_semaphore, nullptr, &swapchain_image_index);
+        if (e == VK_ERROR_OUT_OF_DATE_KHR) 
+        {
+            resize_requested = true;
+            return;
+        }
     }
 
+    updateRenderScale();
     draw_extent.height = std::min(swapchain_extent.height, draw_image.extent.height) * render_scale;
     draw_extent.width = std::min(swapchain_extent.width, draw_image.extent.width) * render_scale;
 
     VK_CHECK(vkResetFences(device, 1, &getCurrentFrame().render_fence));
 
+    // Compute passes go out first so they overlap with the previous frame's graphics work
+    scheduleBackground();
+    async_compute.submit(frame_number % frame_overlap);
+
     //now that we are sure that the commands finished executing, we can safely reset the command buffer to begin recording again.
     VK_CHECK(vkResetCommandBuffer(getCurrentFrame().main_command_buffer, 0));
 
@@ -372,40 +725,28 @@ void phVkEngine::draw()
     //> draw_first
     VK_CHECK(vkBeginCommandBuffer(cmd, &cmdBeginInfo));
 
-    // transition our main draw image into general layout so we can write into it
-    // we will overwrite it all so we dont care about what was the older layout
-    vkutil::transition_image(cmd, draw_image.image, 
-        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
-    vkutil::transition_image(cmd, depth_image.image, 
-        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
-
-    drawMain(cmd);
+    // Resolve this frame slot's previous GPU timings and reset its queries
+    gpu_profiler.beginFrame(cmd, getCurrentFrame().profiler_frame, frame_number);
 
-    //transtion the draw image and the swapchain image into their correct transfer layouts
-    vkutil::transition_image(cmd, draw_image.image, 
-        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-    vkutil::transition_image(cmd, swapchain_images[swapchain_image_index], 
-        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    // Take ownership of finished uploads before anything can use them
+    upload_manager.flush();
+    uint64_t upload_wait_value = upload_manager.recordAcquires(cmd);
 
-    VkExtent2D extent;
-    extent.height = window_extent.height;
-    extent.width = window_extent.width;
-    //< draw_first
-    //> imgui_draw
-    // execute a copy from the draw image into the swapchain
-    vkutil::copy_image_to_image(cmd, draw_image.image, 
-        swapchain_images[swapchain_image_index], draw_extent, swapchain_extent);
+    // Memory telemetry, defragmentation copies when no loads or texture transitions are in flight
+    memory_manager.update(cmd, pending_loads.empty() && texture_streamer.uploadingCount() == 0);
 
-    // set swapchain image layout to Attachment Optimal so we can draw it
-    vkutil::transition_image(cmd, swapchain_images[swapchain_image_index], 
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    // Swapchain image of the frame, the first barrier on it chains with the acquire semaphore wait
+    if (!headless)
+    {
+        render_graph.setImported(frame_graph.swapchain_image, swapchain_images[swapchain_image_index], 
+            swapchain_image_views[swapchain_image_index], VK_IMAGE_LAYOUT_UNDEFINED, 
+            SWAPCHAIN_WAIT_STAGES);
+    }
 
-    // draw imgui into the swapchain image
-    drawImgui(cmd, swapchain_image_views[swapchain_image_index]);
+    // Every pass of the frame, the render graph records the layout transitions
+    drawMain(cmd);
 
-    // set swapchain image layout to Present so we can draw it
-    vkutil::transition_image(cmd, swapchain_images[swapchain_image_index], 
-        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    uint64_t compute_wait_value = async_compute.waitValue();
 
     // finalize the command buffer (we can no longer add commands, but it can now be executed)
     VK_CHECK(vkEndCommandBuffer(cmd));
@@ -416,172 +757,1044 @@ void phVkEngine::draw()
 
     VkCommandBufferSubmitInfo cmdinfo = vkinit::command_buffer_submit_info(cmd);
 
-    VkSemaphoreSubmitInfo waitInfo = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, 
+    VkSemaphoreSubmitInfo waitInfo = vkinit::semaphore_submit_info(SWAPCHAIN_WAIT_STAGES, 
         getCurrentFrame().swapchain_semaphore);
     VkSemaphoreSubmitInfo signalInfo = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT, 
         getCurrentFrame().render_semaphore);
 
-    VkSubmitInfo2 submit = vkinit::submit_info(&cmdinfo, &signalInfo, &waitInfo);
+    // Also wait on the upload timeline if acquires were recorded (already signaled, orders the copies)
+    // and on the compute timeline for this frame's async passes (both only at the stages that use them)
+    VkSemaphoreSubmitInfo waitInfos[3] = { waitInfo };
+    uint32_t waitCount = 1;
+    if (upload_wait_value != 0)
+    {
+        waitInfos[waitCount] = vkinit::semaphore_submit_info(upload_manager.waitStages(), 
+            upload_manager.timeline);
+        waitInfos[waitCount].value = upload_wait_value;
+        waitCount++;
+    }
+    if (compute_wait_value != 0)
+    {
+        waitInfos[waitCount] = vkinit::semaphore_submit_info(async_compute.waitStages(), 
+            async_compute.timeline);
+        waitInfos[waitCount].value = compute_wait_value;
+        waitCount++;
+    }
+
+    // Headless frames have no swapchain image to wait on or present
+    VkSemaphoreSubmitInfo* waitStart = headless ? waitInfos + 1 : waitInfos;
+    if (headless)
+    {
+        waitCount--;
+    }
+
+    VkSubmitInfo2 submit = vkinit::submit_info(&cmdinfo, headless ? nullptr : &signalInfo, 
+        waitCount > 0 ? waitStart : nullptr);
+    submit.waitSemaphoreInfoCount = waitCount;
 
     // submit command buffer to the queue and execute it.
     // render_fence will now block until the graphic commands finish execution
-    VK_CHECK(vkQueueSubmit2(graphics_queue, 1, &submit, getCurrentFrame().render_fence));
+    {
+        std::scoped_lock queue_lock(upload_manager.queue_mutex);
+        VK_CHECK(vkQueueSubmit2(graphics_queue, 1, &submit, getCurrentFrame().render_fence));
+    }
 
+    last_submit_time = std::chrono::steady_clock::now();
+    stats.input_latency = std::chrono::duration<float, std::milli>(last_submit_time - input_time).count();
+    cpu_frame_estimate = cpu_frame_estimate > 0.f ? 
+        cpu_frame_estimate * 0.9f + stats.input_latency * 0.1f : stats.input_latency;
 
 
-    // prepare present
-    // this will put the image we just rendered to into the visible window.
-    // we want to wait on the render_semaphore for that, 
-    // as its necessary that drawing commands have finished before the image is displayed to the user
-    VkPresentInfoKHR presentInfo = vkinit::present_info();
 
-    presentInfo.pSwapchains = &swapchain;
-    presentInfo.swapchainCount = 1;
+    if (!headless)
+    {
+        // prepare present
+        // this will put the image we just rendered to into the visible window.
+        // we want to wait on the render_semaphore for that, 
+        // as its necessary that drawing commands have finished before the image is displayed to the user
+        VkPresentInfoKHR presentInfo = vkinit::present_info();
 
-    presentInfo.pWaitSemaphores = &getCurrentFrame().render_semaphore;
-    presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pSwapchains = &swapchain;
+        presentInfo.swapchainCount = 1;
 
-    presentInfo.pImageIndices = &swapchain_image_index;
+        presentInfo.pWaitSemaphores = &getCurrentFrame().render_semaphore;
+        presentInfo.waitSemaphoreCount = 1;
 
-    VkResult presentResult = vkQueuePresentKHR(graphics_queue, &presentInfo);
-    if (e == VK_ERROR_OUT_OF_DATE_KHR) 
-    {
-        resize_requested = true;
-        return;
+        presentInfo.pImageIndices = &swapchain_image_index;
+
+        // Present ID, lets the pacing wait for this frame to reach the display
+        VkPresentIdKHR present_id_info = { .sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR };
+        if (present_wait_supported)
+        {
+            getCurrentFrame().present_id = ++present_id;
+            present_id_info.swapchainCount = 1;
+            present_id_info.pPresentIds = &getCurrentFrame().present_id;
+            presentInfo.pNext = &present_id_info;
+        }
+
+        VkResult presentResult;
+        {
+            std::scoped_lock queue_lock(upload_manager.queue_mutex);
+            presentResult = vkQueuePresentKHR(graphics_queue, &presentInfo);
+        }
+        if (presentResult == VK_ERROR_OUT_OF_DATE_KHR) 
+        {
+            resize_requested = true;
+            return;
+        }
     }
+
     //increase the number of frames drawn
     frame_number++;
 }
 
-void phVkEngine::drawGeometry(VkCommandBuffer cmd)
+void phVkEngine::setFrameOverlap(uint32_t count)
 {
-    std::vector<uint32_t> opaque_draws;
-    opaque_draws.reserve(draw_commands.opaque_surfaces.size());
+    count = std::clamp(count, 1u, MAX_FRAME_OVERLAP);
+    if (count == frame_overlap)
+    {
+        return;
+    }
 
-    for (int i = 0; i < draw_commands.opaque_surfaces.size(); i++) 
+    // Nothing in flight afterwards, so frames can map to different slots
+    vkDeviceWaitIdle(device);
+    for (FrameData& frame : frames)
     {
-        if (IsVisible(draw_commands.opaque_surfaces[i], scene_data.view_proj)) 
-        {
-            opaque_draws.push_back(i);
-        }
+        frame.delete_queue.flush(device, allocator);
     }
 
-    // sort the opaque surfaces by material and mesh
-    std::sort(opaque_draws.begin(), opaque_draws.end(), [&](const auto& iA, const auto& iB) 
+    frame_overlap = count;
+}
+
+void phVkEngine::paceFrame()
+{
+    auto pacing_start = std::chrono::steady_clock::now();
+    stats.present_latency = 0.f;
+
+    if (frame_pacing == FramePacing::low_latency && frame_number > 0)
+    {
+        // Display side: the frame before the last one is on screen, so at most one frame 
+        // is queued for presentation (FIFO would otherwise queue up to frame_overlap)
+        const uint64_t target_id = present_id > 0 ? present_id - 1 : 0;
+        if (wait_for_present && !headless && target_id >= swapchain_first_present_id)
         {
-            const RenderObject& A = draw_commands.opaque_surfaces[iA];
-            const RenderObject& B = draw_commands.opaque_surfaces[iB];
-            if (A.material == B.material) 
+            if (wait_for_present(device, swapchain, target_id, 100000000) == VK_SUCCESS)
             {
-                return A.index_buffer < B.index_buffer;
+                for (const FrameData& frame : frames)
+                {
+                    if (frame.present_id == target_id)
+                    {
+                        stats.present_latency = std::chrono::duration<float, std::milli>(
+                            std::chrono::steady_clock::now() - frame.input_time).count();
+                    }
+                }
             }
-            else 
+        }
+
+        // GPU side: the last frame finishes about one GPU frame time after its submit,
+        // start the CPU work so this frame's submit lands just as the GPU frees up
+        // (no prediction without GPU timings, the fence wait paces instead)
+        const float gpu_ms = gpu_profiler.averageFrameTime();
+        if (gpu_ms > 0.f)
+        {
+            auto wake = last_submit_time + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<float, std::milli>(gpu_ms - cpu_frame_estimate - pacing_margin));
+            if (wake > std::chrono::steady_clock::now())
             {
-                return A.material < B.material;
+                std::this_thread::sleep_until(wake);
             }
-        });
+        }
+    }
 
-    //allocate a new uniform buffer for the scene data
-    AllocatedBuffer gpuSceneDataBuffer = createBuffer(sizeof(GPUSceneData), 
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+    input_time = std::chrono::steady_clock::now();
+    stats.pacing_wait = std::chrono::duration<float, std::milli>(input_time - pacing_start).count();
+}
 
-    //add it to the deletion queue of this frame so it gets deleted once its been used
-    getCurrentFrame().delete_queue.pushFunction([=, this]() 
-        {
-            destroyBuffer(gpuSceneDataBuffer);
-        });
+void phVkEngine::updateRenderScale()
+{
+    if (!dynamic_resolution || !gpu_profiler.enabled || !gpu_profiler.isSupported())
+    {
+        return;
+    }
 
-    //write the buffer
-    GPUSceneData* sceneUniformData = (GPUSceneData*)gpuSceneDataBuffer.allocation->GetMappedData();
-    *sceneUniformData = scene_data;
+    // Timings resolve frame_overlap frames late: only new samples from frames rendered at the
+    // current scale count, older ones would push the scale past the target
+    uint64_t sample_frame;
+    const float gpu_ms = gpu_profiler.latestFrameTime(sample_frame);
+    if (gpu_ms <= 0.f || sample_frame < render_scale_frame || sample_frame == render_scale_sample)
+    {
+        return;
+    }
+    render_scale_sample = sample_frame;
 
-    //create a descriptor set that binds that buffer and update it
-    VkDescriptorSet globalDescriptor = getCurrentFrame().frame_descriptors.allocate(device, 
-        gpu_scene_data_descriptor_layout);
+    // Smoothed, one slow frame doesn't move the resolution
+    gpu_time_estimate = (render_scale_samples == 0) ? gpu_ms : gpu_time_estimate + (gpu_ms - gpu_time_estimate) * 0.2f;
+    if (++render_scale_samples < 4)
+    {
+        return;
+    }
 
-    DescriptorWriter writer;
-    writer.writeBuffer(0, gpuSceneDataBuffer.buffer, sizeof(GPUSceneData), 0, 
-        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-    writer.updateSet(device, globalDescriptor);
+    // Between 85% and 100% of the target the scale is left alone
+    if (gpu_time_estimate <= target_gpu_time && gpu_time_estimate >= target_gpu_time * 0.85f)
+    {
+        return;
+    }
+
+    // Pixel work goes with the area (scale squared), aim for the middle of the band but only move
+    // part of the way there: down quickly when over budget, up slowly to avoid oscillating
+    const float ideal = render_scale * std::sqrt(target_gpu_time * 0.925f / gpu_time_estimate);
+    const float damping = (ideal < render_scale) ? 0.5f : 0.25f;
+    const float scale = std::clamp(render_scale + (ideal - render_scale) * damping, min_render_scale, 1.f);
+    if (std::abs(scale - render_scale) < 0.01f)
+    {
+        return;
+    }
+
+    render_scale = scale;
+    render_scale_frame = (uint64_t)frame_number;
+    render_scale_samples = 0;
+}
+
+VkFilter phVkEngine::blitFilter() const
+{
+    // Same size: a plain copy
+    if (draw_extent.width == swapchain_extent.width && draw_extent.height == swapchain_extent.height)
+    {
+        return VK_FILTER_NEAREST;
+    }
+    if (upscale_filter == VK_FILTER_CUBIC_EXT && !cubic_blit_supported)
+    {
+        return VK_FILTER_LINEAR;
+    }
+    return upscale_filter;
+}
+
+void phVkEngine::drawGeometry(VkCommandBuffer cmd, bool parallel)
+{
+    // Opaque surfaces are culled on the GPU (see drawMain) unless the CPU path is selected
+    const bool gpu_driven = isGPUDriven();
+
+    // Visible surfaces as key / index pairs, radix sorted (see phvk_sort.h for the key layout)
+    std::vector<DrawSortEntry>& opaque_draws = opaque_sort_entries;
+    std::vector<DrawSortEntry>& transparent_draws = transparent_sort_entries;
+    opaque_draws.clear();
+    transparent_draws.clear();
+
+    stats.cull_tested = 0;
+    stats.cull_visible = 0;
+    stats.cull_box_tests = 0;
+    stats.cull_bvh_nodes = 0;
+
+    if (!gpu_driven)
+    {
+        const uint32_t surface_count = (uint32_t)draw_commands.opaque_surfaces.size();
+        opaque_draws.reserve(surface_count);
+
+        Vec4f planes[6];
+        ExtractFrustumPlanes(scene_data.view_proj, planes);
+
+        // Hierarchical: each scene's BVH rejects off-screen subtrees whole and accepts
+        // fully inside ones without per-object tests
+        // Culls the subtree at root of a scene's BVH, returns the number of nodes visited
+        auto cull_subtree = [&](const SceneCullRange& scene, uint32_t root, auto&& emit, int& box_tests)
+            {
+                const std::vector<BoundingBox>& boxes = scene.graph->opaqueBoxes();
+
+                return scene.graph->hierarchy().traverse(
+                    [&](const BoundingBox& box) { return ClassifyBox(box, planes); },
+                    [&](const uint32_t* items, uint32_t count, bool inside)
+                    {
+                        for (uint32_t k = 0; k < count; k++)
+                        {
+                            uint32_t i = scene.first_opaque + items[k];
+                            const RenderObject& r = draw_commands.opaque_surfaces[i];
+
+                            if (!inside)
+                            {
+                                CullResult result = ClassifyBox(boxes[items[k]], planes);
+                                if (result == CullResult::outside)
+                                {
+                                    continue;
+                                }
+                                if (result == CullResult::intersecting)
+                                {
+                                    box_tests++;
+                                    if (!IsVisible(r, scene_data.view_proj))
+                                    {
+                                        continue;
+                                    }
+                                }
+                            }
+
+                            emit(DrawSortEntry{ OpaqueDrawKey(r.state_key, ViewDepth(r, scene_data.view)), i });
+                        }
+                    }, root);
+            };
+
+        auto cull_hierarchy = [&]()
+            {
+                if (!parallel)
+                {
+                    for (const SceneCullRange& scene : scene_cull_ranges)
+                    {
+                        stats.cull_bvh_nodes += cull_subtree(scene, 0, 
+                            [&](const DrawSortEntry& e) { opaque_draws.push_back(e); }, stats.cull_box_tests);
+                    }
+                    return;
+                }
+
+                // Enough subtrees per scene to keep the workers busy with a single scene
+                // The nodes above them aren't tested, only their descendants
+                const uint32_t chunk_count = recordChunkCount();
+                uint32_t split_depth = 0;
+                while ((1u << split_depth) < chunk_count)
+                {
+                    split_depth++;
+                }
+
+                struct SubtreeTask
+                {
+                    const SceneCullRange* scene;
+                    uint32_t root;
+                    uint32_t first;     // Output offset (items of a subtree are contiguous in its BVH)
+                    uint32_t visible_count;
+                    uint32_t nodes_visited;
+                    int box_tests;
+                };
+
+                FrameArena& arena = getCurrentFrame().arena;
+                std::span<SubtreeTask> tasks = arena.allocate<SubtreeTask>(scene_cull_ranges.size() << split_depth);
+                std::span<uint32_t> roots = arena.allocate<uint32_t>((size_t)1 << split_depth);
+                uint32_t task_count = 0;
+
+                for (const SceneCullRange& scene : scene_cull_ranges)
+                {
+                    const BoundsHierarchy& hierarchy = scene.graph->hierarchy();
+                    uint32_t root_count = hierarchy.subtreeRoots(split_depth, roots.data());
+                    for (uint32_t k = 0; k < root_count; k++)
+                    {
+                        tasks[task_count++] = { &scene, roots[k], scene.first_opaque + hierarchy.firstItem(roots[k]), 0, 0, 0 };
+                    }
+                }
+
+                // Subtrees of a scene cover disjoint item ranges, so each task writes its own part of the span
+                std::span<DrawSortEntry> visible = arena.allocate<DrawSortEntry>(surface_count);
+
+                auto cull_task = [&](uint32_t t)
+                    {
+                        SubtreeTask& task = tasks[t];
+                        DrawSortEntry* out = visible.data() + task.first;
+                        task.nodes_visited = cull_subtree(*task.scene, task.root,
+                            [&](const DrawSortEntry& e) { out[task.visible_count++] = e; }, task.box_tests);
+                    };
+
+                JobCounter counter;
+                for (uint32_t t = 0; t < task_count; t++)
+                {
+                    jobs.schedule([&cull_task, t]() { cull_task(t); }, &counter);
+                }
+                jobs.wait(counter);
+
+                for (uint32_t t = 0; t < task_count; t++)
+                {
+                    const SubtreeTask& task = tasks[t];
+                    opaque_draws.insert(opaque_draws.end(), visible.data() + task.first, 
+                        visible.data() + task.first + task.visible_count);
+                    stats.cull_box_tests += task.box_tests;
+                    stats.cull_bvh_nodes += task.nodes_visited;
+                }
+            };
+
+        // World-space spheres only change with the draw list
+        const bool hierarchical = use_bvh_culling && !scene_cull_ranges.empty();
+        if (!hierarchical && (cull_spheres_dirty || cull_spheres.size() != surface_count))
+        {
+            cull_spheres.build(draw_commands.opaque_surfaces);
+            cull_spheres_dirty = false;
+        }
+        cull_results.resize(surface_count);
 
-    MaterialPipeline* lastPipeline = nullptr;
-    MaterialInstance* lastMaterial = nullptr;
-    VkBuffer lastIndexBuffer = VK_NULL_HANDLE;
+        // Culls [first, last) and emits opaque keys (front to back within a state)
+        // Spheres are classified with SIMD, only the ones crossing a plane get the box test
+        auto cull = [&](uint32_t first, uint32_t last, auto&& emit, int& box_tests)
+            {
+                ClassifySpheres(cull_spheres, planes, first, last, cull_results.data() + first);
 
-    auto draw = [&](const RenderObject& r) 
+                for (uint32_t i = first; i < last; i++)
+                {
+                    const RenderObject& r = draw_commands.opaque_surfaces[i];
+
+                    bool visible = cull_results[i] == CullResult::inside;
+                    if (cull_results[i] == CullResult::intersecting)
+                    {
+                        visible = IsVisible(r, scene_data.view_proj);
+                        box_tests++;
+                    }
+
+                    if (visible)
+                    {
+                        emit(DrawSortEntry{ OpaqueDrawKey(r.state_key, ViewDepth(r, scene_data.view)), i });
+                    }
+                }
+            };
+
+        if (hierarchical)
         {
-        if (r.material != lastMaterial) 
+            cull_hierarchy();
+        }
+        else if (parallel)
         {
-            lastMaterial = r.material;
-            if (r.material->pipeline != lastPipeline) {
+            // Cull contiguous ranges on the workers into frame arena spans, then merge in order
+            uint32_t chunk_count = recordChunkCount();
+            uint32_t chunk_size = (surface_count + chunk_count - 1) / chunk_count;
+            std::span<DrawSortEntry> visible = getCurrentFrame().arena.allocate<DrawSortEntry>(surface_count);
+            uint32_t visible_counts[MAX_RECORD_THREADS] = {};
+            int box_tests[MAX_RECORD_THREADS] = {};
+
+            // Jobs capture one reference and the chunk index (small enough for std::function's inline storage)
+            auto cull_chunk = [&](uint32_t c)
+                {
+                    uint32_t first = std::min(c * chunk_size, surface_count);
+                    DrawSortEntry* out = visible.data() + first;
+                    uint32_t& count = visible_counts[c];
+                    cull(first, std::min(first + chunk_size, surface_count), 
+                        [&](const DrawSortEntry& e) { out[count++] = e; }, box_tests[c]);
+                };
+
+            JobCounter counter;
+            for (uint32_t c = 0; c < chunk_count; c++)
+            {
+                jobs.schedule([&cull_chunk, c]() { cull_chunk(c); }, &counter);
+            }
+            jobs.wait(counter);
 
-                lastPipeline = r.material->pipeline;
-                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, r.material->pipeline->pipeline);
-                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, r.material->pipeline->layout, 0, 1,
-                    &globalDescriptor, 0, nullptr);
+            for (uint32_t c = 0; c < chunk_count; c++)
+            {
+                const DrawSortEntry* first = visible.data() + std::min(c * chunk_size, surface_count);
+                opaque_draws.insert(opaque_draws.end(), first, first + visible_counts[c]);
+                stats.cull_box_tests += box_tests[c];
+            }
+        }
+        else
+        {
+            cull(0, surface_count, [&](const DrawSortEntry& e) { opaque_draws.push_back(e); }, stats.cull_box_tests);
+        }
 
-                VkViewport viewport = {};
-                viewport.x = 0;
-                viewport.y = 0;
-                viewport.width = (float)window_extent.width;
-                viewport.height = (float)window_extent.height;
-                viewport.minDepth = 0.f;
-                viewport.maxDepth = 1.f;
+        stats.cull_tested = (int)surface_count;
+        stats.cull_visible = (int)opaque_draws.size();
 
-                vkCmdSetViewport(cmd, 0, 1, &viewport);
+        // Group by pipeline, material and geometry page
+        RadixSortDrawKeys(opaque_draws, sort_scratch, &jobs);
+    }
 
-                VkRect2D scissor = {};
-                scissor.offset.x = 0;
-                scissor.offset.y = 0;
-                scissor.extent.width = window_extent.width;
-                scissor.extent.height = window_extent.height;
+    // Repeated surfaces with the same state become one instanced draw
+    const bool instancing = !gpu_driven && isInstancing();
+    VkDeviceAddress instance_address = instancing ? buildInstanceBatches(opaque_draws) : 0;
 
-                vkCmdSetScissor(cmd, 0, 1, &scissor);
+    // Transparent surfaces blend back to front (both paths)
+    transparent_draws.reserve(draw_commands.transparent_surfaces.size());
+    for (uint32_t i = 0; i < (uint32_t)draw_commands.transparent_surfaces.size(); i++)
+    {
+        const RenderObject& r = draw_commands.transparent_surfaces[i];
+        transparent_draws.push_back({ TransparentDrawKey(r.state_key, ViewDepth(r, scene_data.view)), i });
+    }
+    RadixSortDrawKeys(transparent_draws, sort_scratch, &jobs);
+
+    const bool mesh_shading = isMeshShading();
+
+    // Records opaque items [first, last), instance batches when instancing, sorted entries otherwise
+    const uint32_t opaque_count = (uint32_t)(instancing ? instance_batches.size() : opaque_draws.size());
+    auto record_opaque = [&](VkCommandBuffer target, uint32_t first, uint32_t last, DrawRecordState& state)
+        {
+            for (uint32_t i = first; i < last; i++)
+            {
+                if (instancing)
+                {
+                    // Single instances keep the meshlet path
+                    const InstanceBatch& b = instance_batches[i];
+                    const RenderObject& r = draw_commands.opaque_surfaces[b.object];
+                    bool single_meshlet = b.instance_count == 1 && mesh_shading && usesMeshlets(r);
+                    recordSurface(target, r, state, single_meshlet ? nullptr : &b, instance_address);
+                }
+                else
+                {
+                    recordSurface(target, draw_commands.opaque_surfaces[opaque_draws[i].index], state);
+                }
             }
+        };
+
+    if (parallel)
+    {
+        // Sorted list is split into contiguous ranges, one secondary command buffer each,
+        // transparent surfaces get their own buffer (recorded concurrently, executed last)
+        FrameData& frame = getCurrentFrame();
+
+        uint32_t chunk_count = recordChunkCount();
+        uint32_t chunk_size = (opaque_count + chunk_count - 1) / chunk_count;
+        DrawRecordState states[MAX_RECORD_THREADS];
+
+        VkFormat color_format = draw_image.format;
+        VkCommandBufferInheritanceRenderingInfo inheritance_rendering = 
+            { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO };
+        inheritance_rendering.colorAttachmentCount = 1;
+        inheritance_rendering.pColorAttachmentFormats = &color_format;
+        inheritance_rendering.depthAttachmentFormat = depth_image.format;
+        inheritance_rendering.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        VkCommandBufferInheritanceInfo inheritance = { .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+        inheritance.pNext = &inheritance_rendering;
+        if (gpu_profiler.statisticsActive())
+        {
+            inheritance.pipelineStatistics = GPUProfiler::STATISTIC_FLAGS;
+        }
+
+        VkCommandBufferBeginInfo begin_info = 
+            vkinit::command_buffer_begin_info(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | 
+                VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT);
+        begin_info.pInheritanceInfo = &inheritance;
+
+        // Records opaque chunk c, or the transparent list for c == chunk_count
+        auto record = [&](uint32_t c)
+            {
+                VkCommandBuffer secondary = frame.secondary_buffers[c];
+                VK_CHECK(vkResetCommandPool(device, frame.secondary_pools[c], 0));
+                VK_CHECK(vkBeginCommandBuffer(secondary, &begin_info));
+
+                if (c < chunk_count)
+                {
+                    uint32_t first = std::min(c * chunk_size, opaque_count);
+                    record_opaque(secondary, first, std::min(first + chunk_size, opaque_count), states[c]);
+                }
+                else
+                {
+                    for (const DrawSortEntry& d : transparent_draws)
+                    {
+                        recordSurface(secondary, draw_commands.transparent_surfaces[d.index], states[c]);
+                    }
+                }
+
+                VK_CHECK(vkEndCommandBuffer(secondary));
+            };
 
-            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, r.material->pipeline->layout, 1, 1,
-                &r.material->material_set, 0, nullptr);
+        JobCounter counter;
+        for (uint32_t c = 0; c <= chunk_count; c++)
+        {
+            jobs.schedule([&, c]() { record(c); }, &counter);
+        }
+        jobs.wait(counter);
+
+        vkCmdExecuteCommands(cmd, chunk_count + 1, frame.secondary_buffers);
+
+        for (uint32_t c = 0; c <= chunk_count; c++)
+        {
+            stats.drawcall_count += states[c].drawcall_count;
+            stats.triangle_count += states[c].triangle_count;
+            stats.instance_count += states[c].instance_count;
+        }
+    }
+    else
+    {
+        DrawRecordState state;
+
+        if (gpu_driven)
+        {
+            // Late pass with occlusion culling (the early pass is drawn in drawMain)
+            gpu_culling.recordDraws(cmd, this, getCurrentFrame(), getCurrentFrame().scene_descriptor, 
+                getCurrentFrame().scene_data_offset, draw_extent, isOcclusionCulling() ? 1 : 0);
+        }
+
+        record_opaque(cmd, 0, opaque_count, state);
+
+        for (const DrawSortEntry& d : transparent_draws) 
+        {
+            recordSurface(cmd, draw_commands.transparent_surfaces[d.index], state);
         }
-        if (r.index_buffer != lastIndexBuffer) {
-            lastIndexBuffer = r.index_buffer;
-            vkCmdBindIndexBuffer(cmd, r.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+
+        stats.drawcall_count += state.drawcall_count;
+        stats.triangle_count += state.triangle_count;
+        stats.instance_count += state.instance_count;
+    }
+}
+
+void phVkEngine::recordSurface(VkCommandBuffer cmd, const RenderObject& r, DrawRecordState& state,
+    const InstanceBatch* batch, VkDeviceAddress instance_address)
+{
+    // Scene data was written to the frame's upload buffer in draw(),
+    // the pre-built scene descriptor is bound with its dynamic offset
+    VkDescriptorSet globalDescriptor = getCurrentFrame().scene_descriptor;
+    uint32_t scene_offset = getCurrentFrame().scene_data_offset;
+
+    // Meshlet pipelines have their own layout, sets are rebound whenever the pipeline changes
+    const bool meshlets = !batch && isMeshShading() && usesMeshlets(r);
+    VkPipelineLayout layout = meshlets ? r.material->pipeline->meshlet_layout : r.material->pipeline->layout;
+
+    VkPipeline pipeline = meshlets ? r.material->pipeline->getMeshlet(r.vertex_format) :
+        batch ? r.material->pipeline->getInstanced(r.vertex_format) : 
+        r.material->pipeline->get(r.vertex_format, false);
+    if (r.material->material_set != state.material_set || pipeline != state.pipeline) 
+    {
+        state.material_set = r.material->material_set;
+        if (pipeline != state.pipeline) {
+
+            state.pipeline = pipeline;
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1,
+                &globalDescriptor, 1, &scene_offset);
+
+            VkViewport viewport = {};
+            viewport.x = 0;
+            viewport.y = 0;
+            viewport.width = (float)draw_extent.width;
+            viewport.height = (float)draw_extent.height;
+            viewport.minDepth = 0.f;
+            viewport.maxDepth = 1.f;
+
+            vkCmdSetViewport(cmd, 0, 1, &viewport);
+
+            VkRect2D scissor = {};
+            scissor.offset.x = 0;
+            scissor.offset.y = 0;
+            scissor.extent.width = draw_extent.width;
+            scissor.extent.height = draw_extent.height;
+
+            vkCmdSetScissor(cmd, 0, 1, &scissor);
         }
-        // calculate final mesh matrix
+
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1,
+            &r.material->material_set, 0, nullptr);
+    }
+
+    // One task workgroup per MESHLET_TASK_GROUP_SIZE meshlets, no index buffer
+    if (meshlets)
+    {
+        GPUMeshletDrawPushConstants push_constants;
+        push_constants.world_matrix = r.transform;
+        push_constants.vertex_buffer_address = r.vertex_buffer_address;
+        push_constants.meshlet_address = r.meshlet_address;
+        push_constants.meshlet_data_address = r.meshlet_data_address;
+        push_constants.meshlet_count = r.surface->meshlet_count;
+        push_constants.material_index = r.material->material_index;
+        push_constants.bounds_origin = Vec4f(r.bounds.origin, 0.f);
+        push_constants.bounds_extents = Vec4f(r.bounds.extents, 0.f);
+
+        vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, 
+            0, sizeof(GPUMeshletDrawPushConstants), &push_constants);
+
+        state.drawcall_count++;
+        state.instance_count++;
+        state.triangle_count += r.index_count / 3;
+        cmd_draw_mesh_tasks(cmd, (r.surface->meshlet_count + MESHLET_TASK_GROUP_SIZE - 1) / MESHLET_TASK_GROUP_SIZE, 1, 1);
+        return;
+    }
+
+    if (r.geometry_page != state.geometry_page) {
+        state.geometry_page = r.geometry_page;
+        vkCmdBindIndexBuffer(cmd, geometry_pool.indexBuffer(r.geometry_page), 0, VK_INDEX_TYPE_UINT32);
+    }
+    // Instanced draws read their transforms from the instance buffer (gl_InstanceIndex)
+    if (batch)
+    {
+        GPUInstancedDrawPushConstants push_constants;
+        push_constants.instance_buffer_address = instance_address;
+        push_constants.vertex_buffer_address = r.vertex_buffer_address;
+        push_constants.material_index = r.material->material_index;
+        push_constants.pad[0] = push_constants.pad[1] = push_constants.pad[2] = 0;
+        push_constants.bounds_origin = Vec4f(r.bounds.origin, 0.f);
+        push_constants.bounds_extents = Vec4f(r.bounds.extents, 0.f);
+
+        vkCmdPushConstants(cmd, r.material->pipeline->layout, 
+            VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GPUInstancedDrawPushConstants), &push_constants);
+
+        state.drawcall_count++;
+        state.instance_count += batch->instance_count;
+        state.triangle_count += r.index_count / 3 * batch->instance_count;
+        vkCmdDrawIndexed(cmd, r.index_count, batch->instance_count, r.first_index, 0, batch->first_instance);
+        return;
+    }
+
+    // calculate final mesh matrix
+    // Bindless materials share one set and are selected by the pushed material index
+    if (r.vertex_format == VertexFormat::packed || metal_rough_material.isBindless())
+    {
+        // Packed positions are dequantized with the surface bounds
+        GPUPackedDrawPushConstants push_constants;
+        push_constants.world_matrix = r.transform;
+        push_constants.vertex_buffer_address = r.vertex_buffer_address;
+        push_constants.material_index = r.material->material_index;
+        push_constants.pad = 0;
+        push_constants.bounds_origin = Vec4f(r.bounds.origin, 0.f);
+        push_constants.bounds_extents = Vec4f(r.bounds.extents, 0.f);
+
+        vkCmdPushConstants(cmd, r.material->pipeline->layout, 
+            VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GPUPackedDrawPushConstants), &push_constants);
+    }
+    else
+    {
         GPUDrawPushConstants push_constants;
         push_constants.world_matrix = r.transform;
         push_constants.vertex_buffer_address = r.vertex_buffer_address;
 
-        vkCmdPushConstants(cmd, r.material->pipeline->layout, 
-            VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GPUDrawPushConstants), &push_constants);
+        vkCmdPushConstants(cmd, r.material->pipeline->layout, 
+            VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(GPUDrawPushConstants), &push_constants);
+    }
+
+    state.drawcall_count++;
+    state.instance_count++;
+    state.triangle_count += r.index_count / 3;
+    vkCmdDrawIndexed(cmd, r.index_count, 1, r.first_index, 0, 0);
+}
+
+VkDeviceAddress phVkEngine::buildInstanceBatches(const std::vector<DrawSortEntry>& draws)
+{
+    instance_batches.clear();
+    if (draws.empty())
+    {
+        return 0;
+    }
+
+    // *** Group ***
+    // Within each run of equal state keys, surfaces sharing an index range are one batch
+    // (batches keep the order of their nearest instance)
+    FrameArena& arena = getCurrentFrame().arena;
+    std::span<uint32_t> entry_batches = arena.allocate<uint32_t>(draws.size());
+
+    // Surface -> batch lookup, open addressing in the frame arena
+    // Slots are tagged with their run, so a new run starts with an empty table without clearing it
+    struct LookupSlot
+    {
+        uint64_t surface;
+        uint32_t batch;
+        uint32_t run;
+    };
+    uint32_t table_bits = 1;
+    while (((size_t)1 << table_bits) < draws.size() * 2)
+    {
+        table_bits++;
+    }
+    const size_t table_mask = ((size_t)1 << table_bits) - 1;
+    std::span<LookupSlot> table = arena.allocate<LookupSlot>(table_mask + 1);
+    memset(table.data(), 0xFF, table.size_bytes());
+
+    uint32_t run = 0;
+    size_t run_start = 0;
+    while (run_start < draws.size())
+    {
+        const uint64_t state_key = draws[run_start].key >> 32;
+
+        size_t i = run_start;
+        for (; i < draws.size() && (draws[i].key >> 32) == state_key; i++)
+        {
+            const RenderObject& r = draw_commands.opaque_surfaces[draws[i].index];
+            uint64_t surface = ((uint64_t)r.geometry_page << 32) | r.first_index;
+
+            size_t slot = (size_t)((surface * 0x9E3779B97F4A7C15ull) >> (64 - table_bits));
+            while (table[slot].run == run && table[slot].surface != surface)
+            {
+                slot = (slot + 1) & table_mask;
+            }
+            if (table[slot].run != run)
+            {
+                table[slot] = { surface, (uint32_t)instance_batches.size(), run };
+                instance_batches.push_back(InstanceBatch{ draws[i].index, 0, 0 });
+            }
+
+            instance_batches[table[slot].batch].instance_count++;
+            entry_batches[i] = table[slot].batch;
+        }
+
+        run++;
+        run_start = i;
+    }
+
+    // *** Instance Ranges ***
+    uint32_t first_instance = 0;
+    for (InstanceBatch& b : instance_batches)
+    {
+        b.first_instance = first_instance;
+        first_instance += b.instance_count;
+        b.instance_count = 0;     // Recounted while writing
+    }
+
+    UploadAllocation alloc = getCurrentFrame().upload_buffer.allocate(this, draws.size() * sizeof(GPUInstanceData));
+    GPUInstanceData* instances = (GPUInstanceData*)alloc.data;
+
+    for (size_t i = 0; i < draws.size(); i++)
+    {
+        InstanceBatch& b = instance_batches[entry_batches[i]];
+        instances[b.first_instance + b.instance_count++].transform = draw_commands.opaque_surfaces[draws[i].index].transform;
+    }
+
+    return alloc.address;
+}
+
+bool phVkEngine::useParallelRecording() const
+{
+    // GPU-driven frames only record a few indirect draws on the primary,
+    // and workers busy with scene loads would hold up the frame
+    return use_parallel_recording && !isGPUDriven() && jobs.workerCount() > 0 && pending_loads.empty() &&
+        draw_commands.opaque_surfaces.size() >= PARALLEL_RECORD_MIN_SURFACES;
+}
+
+bool phVkEngine::usesMeshlets(const RenderObject& r) const
+{
+    // Meshlets cover lods[0] only, simplified levels keep the indexed draw
+    return r.meshlet_address != 0 && r.material->pass_type != MaterialPass::transparent &&
+        r.first_index == r.mesh_first_index + r.surface->start_index;
+}
+
+bool phVkEngine::isInstancing() const
+{
+    return use_instancing && metal_rough_material.supportsInstancing();
+}
+
+uint32_t phVkEngine::recordChunkCount() const
+{
+    // Workers plus the waiting main thread, one buffer is kept for transparent surfaces
+    return std::min(jobs.workerCount() + 1, MAX_RECORD_THREADS - 1);
+}
+
+// Copies the transforms and bounds a scene graph update changed into the draw list
+// (the rest of each object, like its selected LOD range, stays as it is)
+static void PatchMovedObjects(const std::vector<FlatSceneGraph::IndexRange>& changed,
+    const std::vector<RenderObject>& source, std::vector<RenderObject>& target, uint32_t first)
+{
+    for (const FlatSceneGraph::IndexRange& range : changed)
+    {
+        for (uint32_t i = range.first; i < range.first + range.count; i++)
+        {
+            RenderObject& r = target[first + i];
+            r.transform = source[i].transform;
+            r.bounds = source[i].bounds;
+        }
+    }
+}
+
+void phVkEngine::updateScene()
+{
+    // Finish background scene loads whose CPU work is done
+    std::erase_if(pending_loads, [this](const std::shared_ptr<GLTFLoadRequest>& request)
+        {
+            return FinalizeGLTF(this, *request);
+        });
+
+    main_camera.update();
+
+    // Camera matrices
+    Mat4f view = main_camera.getViewMatrix();
+    Mat4f proj = main_camera.getProjectionMatrix((float)window_extent.width / (float)window_extent.height);
+
+    scene_data.view = view;
+    scene_data.proj = proj;
+    scene_data.view_proj = proj * view;
+
+    // Default lighting parameters
+    scene_data.ambient_color = Vec4f(0.1f, 0.1f, 0.1f, 1.f);
+    scene_data.sunlight_color = Vec4f(1.f, 1.f, 1.f, 1.f);
+    scene_data.sunlight_direction = Vec4f(0.f, 1.f, 0.5f, 1.f);
+
+    // Scene graphs keep their render objects between frames, the draw list is only rebuilt when
+    // objects are added or removed (scene loaded or replaced, graph built once its uploads land)
+    // Moved nodes are patched in place, so GPU visibility and LOD hysteresis carry over
+    bool objects_moved = false;
+    for (auto& [name, scene] : loaded_scenes)
+    {
+        const bool had_graph = scene->scene_graph != nullptr;
+        if (scene->update(Mat4f()))
+        {
+            if (had_graph)
+            {
+                objects_moved = true;
+            }
+            else
+            {
+                draw_commands_dirty = true;
+            }
+        }
+    }
+
+    if (draw_commands_dirty)
+    {
+        draw_commands.opaque_surfaces.clear();
+        draw_commands.transparent_surfaces.clear();
+
+        scene_cull_ranges.clear();
+        for (auto& [name, scene] : loaded_scenes)
+        {
+            if (scene->scene_graph)
+            {
+                scene_cull_ranges.push_back({ scene->scene_graph.get(), (uint32_t)draw_commands.opaque_surfaces.size(),
+                    (uint32_t)draw_commands.transparent_surfaces.size() });
+            }
+            scene->appendObjects(draw_commands);
+        }
+        draw_commands_dirty = false;
+        cull_spheres_dirty = true;
+        gpu_culling.resetVisibility();
+        gpu_culling.invalidateBatches();
+
+        // Rebuilt objects start at full detail
+        opaque_lods.assign(draw_commands.opaque_surfaces.size(), 0);
+        transparent_lods.assign(draw_commands.transparent_surfaces.size(), 0);
+    }
+    else if (objects_moved)
+    {
+        for (const SceneCullRange& scene : scene_cull_ranges)
+        {
+            const DrawContext& objects = scene.graph->objects();
+            PatchMovedObjects(scene.graph->changedOpaque(), objects.opaque_surfaces,
+                draw_commands.opaque_surfaces, scene.first_opaque);
+            for (const FlatSceneGraph::IndexRange& range : scene.graph->changedOpaque())
+            {
+                gpu_culling.markObjectsChanged(scene.first_opaque + range.first, range.count);
+            }
+            PatchMovedObjects(scene.graph->changedTransparent(), objects.transparent_surfaces,
+                draw_commands.transparent_surfaces, scene.first_transparent);
+        }
+        cull_spheres_dirty = true;
+    }
+
+    selectLODs();
+
+    if (texture_streamer.isEnabled())
+    {
+        requestTextureMips();
+        texture_streamer.update();
+    }
+}
+
+// Screen-space radius (pixels) of a render object's world bounding sphere, FLT_MAX with the eye inside it
+// pixel_scale: pixels per world unit at distance 1
+static float ProjectedRadius(const RenderObject& r, const Vec3f& eye, float pixel_scale, float near_plane)
+{
+    // World bounding sphere (column-major, translation in m[12..14])
+    float m[16];
+    memcpy(m, &r.transform, sizeof(m));
+
+    const Vec3f& o = r.bounds.origin;
+    float dx = m[0] * o.x + m[4] * o.y + m[8] * o.z + m[12] - eye.x;
+    float dy = m[1] * o.x + m[5] * o.y + m[9] * o.z + m[13] - eye.y;
+    float dz = m[2] * o.x + m[6] * o.y + m[10] * o.z + m[14] - eye.z;
+
+    float scale_x = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+    float scale_y = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+    float scale_z = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+    float radius = r.bounds.sphere_radius * std::sqrt(std::max(scale_x, std::max(scale_y, scale_z)));
+
+    float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (distance <= radius)
+    {
+        return FLT_MAX;
+    }
+
+    return radius * pixel_scale / std::max(distance, near_plane);
+}
+
+void phVkEngine::selectLODs()
+{
+    stats.lod_reduced = 0;
+
+    // Pixels per world unit at distance 1
+    const float pixel_scale = (float)window_extent.height / (2.f * std::tan(main_camera.fov_y * 0.5f));
+    const Vec3f eye = main_camera.position;
+
+    // gpu_objects: changed levels are patched into the GPU culling object buffer
+    auto select = [&](std::vector<RenderObject>& objects, std::vector<uint8_t>& lods, bool gpu_objects)
+        {
+            for (size_t i = 0; i < objects.size(); i++)
+            {
+                RenderObject& r = objects[i];
+                if (!r.surface || r.surface->lod_count <= 1)
+                {
+                    continue;
+                }
+
+                uint32_t lod = 0;
+                if (use_lods)
+                {
+                    // Camera inside the sphere: full detail
+                    float projected_radius = ProjectedRadius(r, eye, pixel_scale, main_camera.near_plane);
+                    if (projected_radius < FLT_MAX)
+                    {
+                        lod = SelectLOD(r.surface->lods, r.surface->lod_count, projected_radius, lod_error_pixels, lods[i]);
+                    }
+                }
+                if (gpu_objects && lod != lods[i])
+                {
+                    gpu_culling.markObjectsChanged((uint32_t)i, 1);
+                }
+                lods[i] = (uint8_t)lod;
+
+                const SurfaceLOD& level = r.surface->lods[lod];
+                r.first_index = r.mesh_first_index + level.start_index;
+                r.index_count = level.count;
+
+                if (lod > 0)
+                {
+                    stats.lod_reduced++;
+                }
+            }
+        };
+
+    select(draw_commands.opaque_surfaces, opaque_lods, true);
+    select(draw_commands.transparent_surfaces, transparent_lods, false);
+}
 
-        stats.drawcall_count++;
-        stats.triangle_count += r.index_count / 3;
-        vkCmdDrawIndexed(cmd, r.index_count, 1, r.first_index, 0, 0);
-        };
+void phVkEngine::requestTextureMips()
+{
+    // Same screen size as the LOD selection, the texture is assumed to span the surface once
+    const float pixel_scale = (float)window_extent.height / (2.f * std::tan(main_camera.fov_y * 0.5f));
+    const Vec3f eye = main_camera.position;
 
-    stats.drawcall_count = 0;
-    stats.triangle_count = 0;
+    auto request = [&](const std::vector<RenderObject>& objects)
+        {
+            for (const RenderObject& r : objects)
+            {
+                if (r.material->streamed_texture == TextureStreamer::INVALID_HANDLE)
+                {
+                    continue;
+                }
 
-    for (auto& r : opaque_draws) 
-    {
-        draw(draw_commands.opaque_surfaces[r]);
-    }
+                float projected_radius = ProjectedRadius(r, eye, pixel_scale, main_camera.near_plane);
+                texture_streamer.request(r.material->streamed_texture,
+                    projected_radius < FLT_MAX ? 2.f * projected_radius : FLT_MAX);
+            }
+        };
 
-    for (auto& r : draw_commands.transparent_surfaces) 
-    {
-        draw(r);
-    }
+    request(draw_commands.opaque_surfaces);
+    request(draw_commands.transparent_surfaces);
+}
+
+void phVkEngine::loadSceneAsync(const std::string& name, std::string_view file_path, VertexFormat vertex_format)
+{
+    pending_loads.push_back(LoadGLTFAsync(this, file_path,
+        [this, name](std::shared_ptr<LoadedGLTF> scene)
+        {
+            if (scene)
+            {
+                // Frames in flight may still draw a scene this replaces. Runs before the fence wait, so
+                // it's released with the previous frame's slot (flushed once every older frame is done)
+                std::shared_ptr<LoadedGLTF>& entry = loaded_scenes[name];
+                if (entry)
+                {
+                    frames[(frame_number + frame_overlap - 1) % frame_overlap].delete_queue.pushFunction(
+                        [replaced = std::move(entry)]() mutable { replaced.reset(); });
+                }
 
-    // we delete the draw commands now that we processed them
-    draw_commands.opaque_surfaces.clear();
-    draw_commands.transparent_surfaces.clear();
+                entry = scene;
+                draw_commands_dirty = true;
+            }
+            else
+            {
+                fmt::println("Failed to load scene {}", name);
+            }
+        }, vertex_format));
 }
 
 void phVkEngine::immediateSubmit(std::function<void(VkCommandBuffer cmd)>&& function)
 {
     // Similar to executing commands on the GPU --
     // the main difference is submit is not synchronized with the swapchain
-    // TODO: optimization - use use separate queue instead of graphics queue
+    // Blocking, only for one-off graphics work (asset uploads go through upload_manager)
 
     // Reset the fence and command buffer
     VK_CHECK(vkResetFences(device, 1, &imm_fence));
@@ -602,7 +1815,10 @@ void phVkEngine::immediateSubmit(std::function<void(VkCommandBuffer cmd)>&& func
     VkSubmitInfo2 submit = vkinit::submit_info(&cmd_info, nullptr, nullptr);
 
     // Submit command buffer to the queue and execute it
-    VK_CHECK(vkQueueSubmit2(graphics_queue, 1, &submit, imm_fence));
+    {
+        std::scoped_lock queue_lock(upload_manager.queue_mutex);
+        VK_CHECK(vkQueueSubmit2(graphics_queue, 1, &submit, imm_fence));
+    }
 
     // Wait for immediate command fence
     VK_CHECK(vkWaitForFences(device, 1, &imm_fence, true, 9999999999));
@@ -612,86 +1828,119 @@ void phVkEngine::immediateSubmit(std::function<void(VkCommandBuffer cmd)>&& func
 
 GPUMeshBuffers phVkEngine::uploadMesh(std::span<uint32_t> indices, std::span<Vertex> vertices)
 {
-    // Using GPU_ONLY buffers is highly recommended for mesh performance
-    // Few examples of CPU / CPU-accessible buffer might be CPU-driven particle system or dynamic effects
+    return uploadMeshData(indices, vertices.data(), vertices.size(), VertexFormat::standard);
+}
 
-    // TODO: Optimization - put this in a background thread so we don't..
-    //      have to wait for the GPU commands to complete
+GPUMeshBuffers phVkEngine::uploadMesh(std::span<uint32_t> indices, std::span<PackedVertex> vertices)
+{
+    // Positions must already be quantized against the surface bounds (see PackVertices)
+    return uploadMeshData(indices, vertices.data(), vertices.size(), VertexFormat::packed);
+}
 
+GPUMeshBuffers phVkEngine::uploadMeshData(std::span<const uint32_t> indices, const void* vertex_data, 
+    size_t vertex_count, VertexFormat format)
+{
+    // Using GPU_ONLY buffers is highly recommended for mesh performance
+    // Few examples of CPU / CPU-accessible buffer might be CPU-driven particle system or dynamic effects
 
-    // *** Create GPU Buffers ***
+    // *** Allocate Geometry ***
 
-    const size_t vertex_buf_size = vertices.size() * sizeof(Vertex);
+    const size_t vertex_stride = (format == VertexFormat::packed) ? sizeof(PackedVertex) : sizeof(Vertex);
+    const size_t vertex_buf_size = vertex_count * vertex_stride;
     const size_t index_buf_size = indices.size() * sizeof(uint32_t);
 
     GPUMeshBuffers new_mesh;
+    new_mesh.vertex_format = format;
 
-    // Create vertex buffer
-    new_mesh.vertex_buffer = createBuffer(vertex_buf_size, 
-        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | // SSBO | memory copy
-        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-        VMA_MEMORY_USAGE_GPU_ONLY);
-
-    // Find the adress of the vertex buffer
-    VkBufferDeviceAddressInfo device_addr_info{ 
-        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
-        .buffer = new_mesh.vertex_buffer.buffer };
-    new_mesh.vertex_buffer_address = vkGetBufferDeviceAddress(device, &device_addr_info);
-
-    // Create index buffer
-    new_mesh.index_buffer = createBuffer(index_buf_size, 
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,    // Index draws | memory copy
-        VMA_MEMORY_USAGE_GPU_ONLY);
+    // Ranges in the shared vertex / index buffers (indices stay relative to the mesh,
+    // the vertex address points at the mesh's first vertex)
+    new_mesh.geometry = geometry_pool.allocate((uint32_t)vertex_buf_size, (uint32_t)indices.size());
+    new_mesh.vertex_buffer_address = geometry_pool.vertexAddress(new_mesh.geometry);
 
 
 	// *** Copy Data to GPU ***
 
-    // Set up a staging buffer
-    AllocatedBuffer staging = createBuffer(vertex_buf_size + index_buf_size, 
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+    // Copies are batched on the transfer queue, the mesh is usable once new_mesh.upload is ready
+    upload_manager.uploadBuffer(geometry_pool.vertexBuffer(new_mesh.geometry.page), 
+        new_mesh.geometry.vertex_offset, vertex_data, vertex_buf_size,
+        VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+        (mesh_shading_supported ? VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT : 0), 
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+    new_mesh.upload = upload_manager.uploadBuffer(geometry_pool.indexBuffer(new_mesh.geometry.page), 
+        new_mesh.geometry.first_index * sizeof(uint32_t), indices.data(), index_buf_size,
+        VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT, VK_ACCESS_2_INDEX_READ_BIT);
 
-    void* data = staging.allocation->GetMappedData();
+    vertex_memory += vertex_buf_size;
+    vertex_memory_saved += vertex_count * sizeof(Vertex) - vertex_buf_size;
 
-    // Copy vertex buffer to staging
-    memcpy(data, vertices.data(), vertex_buf_size);
-    // Copy index buffer staging
-    memcpy((char*)data + vertex_buf_size, indices.data(), index_buf_size);
+    return new_mesh;
+}
 
-	// Submit commands to copy from staging to GPU buffer
-    immediateSubmit([&](VkCommandBuffer cmd) 
-        {
-            VkBufferCopy vertexCopy{ 0 };
-            vertexCopy.dstOffset = 0;
-            vertexCopy.srcOffset = 0;
-            vertexCopy.size = vertex_buf_size;
+void phVkEngine::uploadMeshlets(GPUMeshBuffers& mesh, const MeshletData& meshlets)
+{
+    uploadMeshlets(mesh, meshlets.meshlets, meshlets.data);
+}
 
-            vkCmdCopyBuffer(cmd, staging.buffer, new_mesh.vertex_buffer.buffer, 1, &vertexCopy);
+void phVkEngine::uploadMeshlets(GPUMeshBuffers& mesh, std::span<const GPUMeshlet> meshlets, 
+    std::span<const uint32_t> meshlet_data)
+{
+    if (meshlets.empty())
+    {
+        return;
+    }
 
-            VkBufferCopy indexCopy{ 0 };
-            indexCopy.dstOffset = 0;
-            indexCopy.srcOffset = vertex_buf_size;
-            indexCopy.size = index_buf_size;
+    // One buffer per mesh: GPUMeshlet[], then the vertex index / triangle words
+    const size_t meshlet_size = meshlets.size_bytes();
+    const size_t data_size = meshlet_data.size_bytes();
+
+    // (transfer source: may be moved by defragmentation)
+    mesh.meshlet_buffer = createBuffer(meshlet_size + data_size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | 
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, 
+        VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::mesh);
+    mesh.meshlet_address = getBufferAddress(mesh.meshlet_buffer.buffer);
+    mesh.meshlet_data_address = mesh.meshlet_address + meshlet_size;
+
+    const VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT;
+    upload_manager.uploadBuffer(mesh.meshlet_buffer.buffer, 0, meshlets.data(), meshlet_size,
+        stages, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+    mesh.upload = upload_manager.uploadBuffer(mesh.meshlet_buffer.buffer, meshlet_size, meshlet_data.data(), data_size,
+        stages, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+}
 
-            vkCmdCopyBuffer(cmd, staging.buffer, new_mesh.index_buffer.buffer, 1, &indexCopy);
-        });
+void phVkEngine::freeMesh(const GPUMeshBuffers& mesh)
+{
+    geometry_pool.free(mesh.geometry);
+    if (mesh.meshlet_buffer.buffer != VK_NULL_HANDLE)
+    {
+        destroyBuffer(mesh.meshlet_buffer);
+    }
 
-	// Destroy temporary staging buffer
-    destroyBuffer(staging);
+    const size_t vertex_stride = (mesh.vertex_format == VertexFormat::packed) ? sizeof(PackedVertex) : sizeof(Vertex);
+    const size_t vertex_count = mesh.geometry.vertex_size / vertex_stride;
 
-    return new_mesh;
+    vertex_memory -= mesh.geometry.vertex_size;
+    vertex_memory_saved -= vertex_count * sizeof(Vertex) - mesh.geometry.vertex_size;
 }
 
 AllocatedImage phVkEngine::createImage(VkExtent3D size, VkFormat format, VkImageUsageFlags usage, bool mipmapped)
+{
+    uint32_t mip_levels = 1;
+    if (mipmapped) 
+    {
+        mip_levels = static_cast<uint32_t>(std::floor(std::log2(std::max(size.width, size.height)))) + 1;
+    }
+
+    return createImage(size, format, usage, mip_levels);
+}
+
+AllocatedImage phVkEngine::createImage(VkExtent3D size, VkFormat format, VkImageUsageFlags usage, uint32_t mip_levels)
 {
     AllocatedImage new_image;
     new_image.format = format;
     new_image.extent = size;
 
     VkImageCreateInfo img_info = vkinit::image_create_info(format, usage, size);
-    if (mipmapped) 
-    {
-        img_info.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(size.width, size.height)))) + 1;
-    }
+    img_info.mipLevels = mip_levels;
 
     // Always allocate images on dedicated GPU memory
     VmaAllocationCreateInfo alloc_info = {};
@@ -701,6 +1950,12 @@ AllocatedImage phVkEngine::createImage(VkExtent3D size, VkFormat format, VkImage
     // Allocate and create the image
     VK_CHECK(vmaCreateImage(allocator, &img_info, &alloc_info, &new_image.image, &new_image.allocation, nullptr));
 
+    // Sampled-only images are textures, anything rendered or written to belongs to the frame
+    const VkImageUsageFlags written = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | 
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    memory_manager.trackImage(new_image.allocation, img_info, 
+        (usage & VK_IMAGE_USAGE_SAMPLED_BIT) && !(usage & written) ? MemoryCategory::texture : MemoryCategory::transient);
+
     // If the format is a depth format, must use the correct aspect flag
     VkImageAspectFlags aspectFlag = VK_IMAGE_ASPECT_COLOR_BIT;
     if (format == VK_FORMAT_D32_SFLOAT) 
@@ -720,50 +1975,78 @@ AllocatedImage phVkEngine::createImage(VkExtent3D size, VkFormat format, VkImage
 AllocatedImage phVkEngine::createImage(void* data, VkExtent3D size, VkFormat format, VkImageUsageFlags usage, bool mipmapped)
 {
     size_t data_size = size.depth * size.width * size.height * 4;
-    AllocatedBuffer uploadbuffer = createBuffer(data_size, 
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
-
-    memcpy(uploadbuffer.info.pMappedData, data, data_size);
 
     AllocatedImage new_image = createImage(size, format, usage | 
         VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, mipmapped);
 
-    immediateSubmit([&](VkCommandBuffer cmd) 
-        {
-            vkutil::transition_image(cmd, new_image.image, 
-                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    // Copy (and mip generation) batched on the transfer queue
+    upload_manager.uploadImage(new_image, data, data_size, mipmapped);
 
-            VkBufferImageCopy copy_region = {};
-            copy_region.bufferOffset = 0;
-            copy_region.bufferRowLength = 0;
-            copy_region.bufferImageHeight = 0;
+    return new_image;
+}
 
-            copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            copy_region.imageSubresource.mipLevel = 0;
-            copy_region.imageSubresource.baseArrayLayer = 0;
-            copy_region.imageSubresource.layerCount = 1;
-            copy_region.imageExtent = size;
+AllocatedImage phVkEngine::createImage(const void* data, VkDeviceSize data_size, VkExtent3D size, VkFormat format, 
+    VkImageUsageFlags usage, std::span<const VkDeviceSize> mip_offsets)
+{
+    // (transfer source: may be moved by defragmentation)
+    AllocatedImage new_image = createImage(size, format, usage | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 
+        (uint32_t)std::max<size_t>(mip_offsets.size(), 1));
 
-            // copy the buffer into the image
-            vkCmdCopyBufferToImage(cmd, uploadbuffer.buffer, new_image.image, 
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy_region);
+    // Every level is a plain copy, no blits
+    upload_manager.uploadImage(new_image, data, data_size, false, mip_offsets);
 
-            vkutil::transition_image(cmd, new_image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-        });
+    return new_image;
+}
 
-    destroyBuffer(uploadbuffer);
+// Allocations a defragmentation pass is moving are freed by the pass, only the handle goes
+static void DestroyImageMemory(VkDevice device, VmaAllocator allocator, const AllocatedImage& img)
+{
+    if (MemoryManager::Release(allocator, img.allocation))
+    {
+        vmaDestroyImage(allocator, img.image, img.allocation);
+    }
+    else
+    {
+        vkDestroyImage(device, img.image, nullptr);
+    }
+}
 
-    return new_image;
+static void DestroyBufferMemory(VkDevice device, VmaAllocator allocator, const AllocatedBuffer& buffer)
+{
+    if (MemoryManager::Release(allocator, buffer.allocation))
+    {
+        vmaDestroyBuffer(allocator, buffer.buffer, buffer.allocation);
+    }
+    else
+    {
+        vkDestroyBuffer(device, buffer.buffer, nullptr);
+    }
 }
 
 void phVkEngine::destroyImage(const AllocatedImage& img)
 {
     vkDestroyImageView(device, img.view, nullptr);
-    vmaDestroyImage(allocator, img.image, img.allocation);
+    DestroyImageMemory(device, allocator, img);
+}
+
+bool phVkEngine::supportsTextureFormat(VkFormat format) const
+{
+    if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK && !texture_compression_bc)
+        return false;
+    if (format >= VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK && format <= VK_FORMAT_EAC_R11G11_SNORM_BLOCK && !texture_compression_etc2)
+        return false;
+    if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK && !texture_compression_astc)
+        return false;
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(physical_device, format, &properties);
+
+    const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    return (properties.optimalTilingFeatures & required) == required;
 }
 
-AllocatedBuffer phVkEngine::createBuffer(size_t alloc_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage)
+AllocatedBuffer phVkEngine::createBuffer(size_t alloc_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage,
+    MemoryCategory category)
 {
     VkBufferCreateInfo buffer_info = { .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
     buffer_info.pNext = nullptr;
@@ -779,13 +2062,62 @@ AllocatedBuffer phVkEngine::createBuffer(size_t alloc_size, VkBufferUsageFlags u
     // Allocate the buffer
     VK_CHECK(vmaCreateBuffer(allocator, &buffer_info, &vmaallocInfo, 
         &new_buffer.buffer, &new_buffer.allocation, &new_buffer.info));
+    memory_manager.trackBuffer(new_buffer.allocation, buffer_info, category);
 
     return new_buffer;
 }
 
 void phVkEngine::destroyBuffer(const AllocatedBuffer& buffer)
 {
-    vmaDestroyBuffer(allocator, buffer.buffer, buffer.allocation);
+    DestroyBufferMemory(device, allocator, buffer);
+}
+
+void DeleteQueue::flush(VkDevice device, VmaAllocator allocator)
+{
+    for (VkPipeline pipeline : pipelines)
+    {
+        vkDestroyPipeline(device, pipeline, nullptr);
+    }
+    for (VkSampler sampler : samplers)
+    {
+        vkDestroySampler(device, sampler, nullptr);
+    }
+    for (VkImageView view : views)
+    {
+        vkDestroyImageView(device, view, nullptr);
+    }
+    for (const AllocatedImage& image : images)
+    {
+        vkDestroyImageView(device, image.view, nullptr);
+        DestroyImageMemory(device, allocator, image);
+    }
+    for (const AllocatedBuffer& buffer : buffers)
+    {
+        DestroyBufferMemory(device, allocator, buffer);
+    }
+
+    pipelines.clear();
+    samplers.clear();
+    views.clear();
+    images.clear();
+    buffers.clear();
+
+    // Reverse iterate the deletion queue to execute all the functions
+    for (auto it = functions.rbegin(); it != functions.rend(); it++) 
+    {
+        (*it)(); // Call function
+    }
+
+    functions.clear();
+}
+
+VkDeviceAddress phVkEngine::getBufferAddress(VkBuffer buffer)
+{
+    // Buffer must be created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+    VkBufferDeviceAddressInfo device_addr_info{ 
+        .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = buffer };
+    return vkGetBufferDeviceAddress(device, &device_addr_info);
 }
 
 void phVkEngine::createSwapchain(uint32_t width, uint32_t height)
@@ -794,16 +2126,22 @@ void phVkEngine::createSwapchain(uint32_t width, uint32_t height)
 
     swapchain_img_format = VK_FORMAT_B8G8R8A8_UNORM;
 
+    // Requested present mode if the surface supports it (FIFO always is)
+    uint32_t mode_count = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &mode_count, nullptr);
+    supported_present_modes.resize(mode_count);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physical_device, surface, &mode_count, supported_present_modes.data());
+
+    active_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+    if (std::find(supported_present_modes.begin(), supported_present_modes.end(), present_mode) != supported_present_modes.end())
+    {
+        active_present_mode = present_mode;
+    }
+
     vkb::Swapchain vkbSwapchain = swapchain_builder
         //.use_default_format_selection()
         .set_desired_format(VkSurfaceFormatKHR{ .format = swapchain_img_format, .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR })
-        //use vsync present mode
-        .set_desired_present_mode(
-            //VK_PRESENT_MODE_IMMEDIATE_KHR
-            //VK_PRESENT_MODE_MAILBOX_KHR
-            VK_PRESENT_MODE_FIFO_KHR
-            //VK_PRESENT_MODE_FIFO_RELAXED_KHR
-            )
+        .set_desired_present_mode(active_present_mode)
         .set_desired_extent(width, height)
         .add_image_usage_flags(VK_IMAGE_USAGE_TRANSFER_DST_BIT)
         .build()
@@ -814,6 +2152,9 @@ void phVkEngine::createSwapchain(uint32_t width, uint32_t height)
     swapchain = vkbSwapchain.swapchain;
     swapchain_images = vkbSwapchain.get_images().value();
     swapchain_image_views = vkbSwapchain.get_image_views().value();
+
+    // Present IDs only apply to the swapchain they were presented to
+    swapchain_first_present_id = present_id + 1;
 }
 
 
@@ -843,6 +2184,10 @@ void phVkEngine::resizeSwapchain()
     window_extent.height = h;
 
     createSwapchain(window_extent.width, window_extent.height);
+
+    // Timings at the old size don't predict the new one
+    render_scale_frame = (uint64_t)frame_number;
+    render_scale_samples = 0;
 }
 
 
@@ -878,6 +2223,13 @@ void phVkEngine::initVulkan()
     VkPhysicalDeviceVulkan12Features features12{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
     features12.bufferDeviceAddress = true;
     features12.descriptorIndexing = true;
+    features12.timelineSemaphore = true;        // Upload completion tracking
+    features12.runtimeDescriptorArray = true;   // Bindless materials (all part of the descriptorIndexing minimum)
+    features12.descriptorBindingPartiallyBound = true;
+    features12.descriptorBindingVariableDescriptorCount = true;
+    features12.descriptorBindingSampledImageUpdateAfterBind = true;
+    features12.descriptorBindingUpdateUnusedWhilePending = true;
+    features12.shaderSampledImageArrayNonUniformIndexing = true;
 
     // Use vkbootstrap to select a GPU (physical device)
     // We want a GPU that can write to the SDL surface and supports vulkan 1.3 with the correct features
@@ -890,13 +2242,112 @@ void phVkEngine::initVulkan()
         .select()
         .value();
 
+    // Optional: pipeline statistics queries for the GPU profiler
+    // (vk-bootstrap enables the selected device's features member)
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(vkb_physical_device.physical_device, &supported_features);
+    pipeline_statistics_supported = supported_features.pipelineStatisticsQuery;
+    if (pipeline_statistics_supported)
+    {
+        vkb_physical_device.features.pipelineStatisticsQuery = VK_TRUE;
+    }
+
+    // Optional: active queries carried into secondary command buffers (parallel recording)
+    inherited_queries_supported = supported_features.inheritedQueries;
+    if (inherited_queries_supported)
+    {
+        vkb_physical_device.features.inheritedQueries = VK_TRUE;
+    }
+
+    // Optional: GPU-driven culling (indirect count draws, object index in firstInstance),
+    // the CPU culling path is used without them
+    VkPhysicalDeviceVulkan12Features indirect_count_features { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    indirect_count_features.drawIndirectCount = VK_TRUE;
+    draw_indirect_count_supported = vkb_physical_device.enable_extension_features_if_present(indirect_count_features);
+
+    draw_indirect_first_instance_supported = supported_features.drawIndirectFirstInstance;
+    if (draw_indirect_first_instance_supported)
+    {
+        vkb_physical_device.features.drawIndirectFirstInstance = VK_TRUE;
+    }
+
+    // Optional: block-compressed textures (KTX2 files in BC / ETC2 / ASTC formats)
+    texture_compression_bc = supported_features.textureCompressionBC;
+    texture_compression_etc2 = supported_features.textureCompressionETC2;
+    texture_compression_astc = supported_features.textureCompressionASTC_LDR;
+    vkb_physical_device.features.textureCompressionBC = supported_features.textureCompressionBC;
+    vkb_physical_device.features.textureCompressionETC2 = supported_features.textureCompressionETC2;
+    vkb_physical_device.features.textureCompressionASTC_LDR = supported_features.textureCompressionASTC_LDR;
+
+    // Optional: cubic blit filtering (dynamic resolution upscale), checked against the draw format later
+    cubic_blit_supported = vkb_physical_device.enable_extension_if_present(VK_EXT_FILTER_CUBIC_EXTENSION_NAME);
+
+    // Optional: driver heap budgets for VMA (texture streaming budget), estimated otherwise
+    memory_budget_supported = vkb_physical_device.enable_extension_if_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    // Optional: task / mesh shaders for the meshlet path (only the two stages are enabled)
+    VkPhysicalDeviceMeshShaderFeaturesEXT mesh_shader_features { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT };
+    if (vkb_physical_device.enable_extension_if_present(VK_EXT_MESH_SHADER_EXTENSION_NAME))
+    {
+        VkPhysicalDeviceFeatures2 features2 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+        features2.pNext = &mesh_shader_features;
+        vkGetPhysicalDeviceFeatures2(vkb_physical_device.physical_device, &features2);
+        mesh_shading_supported = mesh_shader_features.taskShader && mesh_shader_features.meshShader;
+    }
+
+    VkPhysicalDeviceMeshShaderFeaturesEXT enabled_mesh_shader_features { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT };
+    enabled_mesh_shader_features.taskShader = VK_TRUE;
+    enabled_mesh_shader_features.meshShader = VK_TRUE;
+
+    // Optional: present IDs and waiting on them (low-latency frame pacing)
+    VkPhysicalDevicePresentIdFeaturesKHR present_id_features { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR };
+    VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR };
+    if (vkb_physical_device.is_extension_present(VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+        vkb_physical_device.is_extension_present(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+    {
+        VkPhysicalDeviceFeatures2 features2 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
+        features2.pNext = &present_id_features;
+        present_id_features.pNext = &present_wait_features;
+        vkGetPhysicalDeviceFeatures2(vkb_physical_device.physical_device, &features2);
+        present_id_features.pNext = nullptr;
+
+        present_wait_supported = present_id_features.presentId && present_wait_features.presentWait;
+        if (present_wait_supported)
+        {
+            vkb_physical_device.enable_extension_if_present(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+            vkb_physical_device.enable_extension_if_present(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+        }
+    }
+
     // Use vkbootstrap to create the logical Vulkan device
     vkb::DeviceBuilder device_builder{ vkb_physical_device };
+    if (mesh_shading_supported)
+    {
+        device_builder.add_pNext(&enabled_mesh_shader_features);
+    }
+    if (present_wait_supported)
+    {
+        device_builder.add_pNext(&present_id_features);
+        device_builder.add_pNext(&present_wait_features);
+    }
     vkb::Device vkbdevice = device_builder.build().value();
 
     // Get the VkDevice handle used in the rest of a vulkan application
     device = vkbdevice.device;
     physical_device = vkb_physical_device.physical_device;
+    physical_device_properties = vkb_physical_device.properties;
+
+    // Extension command, not exported by the loader
+    if (mesh_shading_supported)
+    {
+        cmd_draw_mesh_tasks = (PFN_vkCmdDrawMeshTasksEXT)vkGetDeviceProcAddr(device, "vkCmdDrawMeshTasksEXT");
+        mesh_shading_supported = cmd_draw_mesh_tasks != nullptr;
+    }
+    if (present_wait_supported)
+    {
+        wait_for_present = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(device, "vkWaitForPresentKHR");
+        present_wait_supported = wait_for_present != nullptr;
+    }
 
     
     // *** Init Queue ***
@@ -904,6 +2355,46 @@ void phVkEngine::initVulkan()
     graphics_queue = vkbdevice.get_queue(vkb::QueueType::graphics).value();
     graphics_queue_family = vkbdevice.get_queue_index(vkb::QueueType::graphics).value();
 
+    // Transfer queue for uploads: prefer a dedicated transfer-only family, then any
+    // non-graphics family with transfer support, otherwise share the graphics queue
+    auto dedicated_transfer = vkbdevice.get_dedicated_queue(vkb::QueueType::transfer);
+    auto separate_transfer = vkbdevice.get_queue(vkb::QueueType::transfer);
+    if (dedicated_transfer)
+    {
+        transfer_queue = dedicated_transfer.value();
+        transfer_queue_family = vkbdevice.get_dedicated_queue_index(vkb::QueueType::transfer).value();
+    }
+    else if (separate_transfer)
+    {
+        transfer_queue = separate_transfer.value();
+        transfer_queue_family = vkbdevice.get_queue_index(vkb::QueueType::transfer).value();
+    }
+    else
+    {
+        transfer_queue = graphics_queue;
+        transfer_queue_family = graphics_queue_family;
+    }
+
+    // Compute queue for async passes: prefer a compute-only family, then any non-graphics family
+    // with compute support, otherwise the passes run inline on the graphics queue
+    auto dedicated_compute = vkbdevice.get_dedicated_queue(vkb::QueueType::compute);
+    auto separate_compute = vkbdevice.get_queue(vkb::QueueType::compute);
+    if (dedicated_compute)
+    {
+        compute_queue = dedicated_compute.value();
+        compute_queue_family = vkbdevice.get_dedicated_queue_index(vkb::QueueType::compute).value();
+    }
+    else if (separate_compute)
+    {
+        compute_queue = separate_compute.value();
+        compute_queue_family = vkbdevice.get_queue_index(vkb::QueueType::compute).value();
+    }
+    else
+    {
+        compute_queue = graphics_queue;
+        compute_queue_family = graphics_queue_family;
+    }
+
 
     // *** Init Vulkan Memory Allocator (VMA) ***
     VmaAllocatorCreateInfo allocator_info = {};
@@ -911,14 +2402,29 @@ void phVkEngine::initVulkan()
     allocator_info.device = device;
     allocator_info.instance = instance;
     allocator_info.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+    if (memory_budget_supported)
+    {
+        allocator_info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
     vmaCreateAllocator(&allocator_info, &allocator);
 
+    // Tracks every allocation from here on
+    memory_manager.init(this);
+
     // Add memory allocator to delete queue
     main_delete_queue.pushFunction([&]()
         {
             vmaDestroyAllocator(allocator);
         });
 
+    // Samplers / descriptor set layouts shared by everything that creates them (destroyed before the device)
+    resource_cache.init(device);
+    texture_cache.init(this);
+    main_delete_queue.pushFunction([&]()
+        {
+            resource_cache.destroy();
+        });
+
 }
 
 // Initializes both the swapchain and Vulkan drawing image
@@ -941,68 +2447,152 @@ void phVkEngine::initSwapchain()
         1
     };
 
+    // Draw and depth images are transients of the frame's render graph
+    initRenderGraph(draw_extent);
+
+
+
+
+    // *** Init Background Images ***
+    //
+    // Async compute writes the background into a per-frame image while the previous frame
+    // still renders into the draw image (not needed when the effect runs inline)
+    if (compute_queue_family != graphics_queue_family)
+    {
+        for (FrameData& frame : frames)
+        {
+            frame.background_image = createImage(draw_extent, draw_image.format, 
+                VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+            main_delete_queue.pushImage(frame.background_image);
+        }
+    }
+}
+
+void phVkEngine::initRenderGraph(VkExtent3D extent)
+{
+    render_graph.init(this);
+
+    // *** Images ***
+    //
     // Draw format hardcoded
     // 64 bits per pixel
     // May be overkill, but useful in some cases
-    draw_image.format = VK_FORMAT_R16G16B16A16_SFLOAT;
-    draw_image.extent = draw_extent;
+    frame_graph.draw_image = render_graph.createTransient("Draw", extent, VK_FORMAT_R16G16B16A16_SFLOAT,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | 
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
 
-    // Define image usages
-    VkImageUsageFlags draw_image_usages{};
-    draw_image_usages |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-    draw_image_usages |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-    draw_image_usages |= VK_IMAGE_USAGE_STORAGE_BIT;
-    draw_image_usages |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // Sampled: depth pyramid source
+    frame_graph.depth_image = render_graph.createTransient("Depth", extent, VK_FORMAT_D32_SFLOAT,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
 
-    VkImageCreateInfo rimg_info = vkinit::image_create_info(draw_image.format, draw_image_usages, draw_extent);
+    frame_graph.swapchain_image = render_graph.importImage("Swapchain");
+    frame_graph.background_image = render_graph.importImage("Background");
 
-    // Allocate draw image from GPU local memory
-    // Configure for GPU-only access and fastest memory
-    VmaAllocationCreateInfo rimg_alloc_info = {};
-    rimg_alloc_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-    rimg_alloc_info.requiredFlags = VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    // Allocate and create the image
-    vmaCreateImage(allocator, &rimg_info, &rimg_alloc_info, &draw_image.image, &draw_image.allocation, nullptr);
+    // *** Passes ***
+    // In frame order, drawMain enables the ones the frame needs
+    //
+    // Background effect recorded inline (no async compute this frame)
+    frame_graph.background = render_graph.addPass("Background", [this](VkCommandBuffer cmd)
+        {
+            async_compute.recordGraphics(cmd);
+        });
+    render_graph.use(frame_graph.background, frame_graph.draw_image, GraphAccess::storage_write);
 
-    // Build an image-view for the draw image to use for rendering
-    // vkguide.dev always pairs vkimages with "default" imageview
-    VkImageViewCreateInfo rview_info = vkinit::imageview_create_info(draw_image.format, draw_image.image, VK_IMAGE_ASPECT_COLOR_BIT);
-    VK_CHECK(vkCreateImageView(device, &rview_info, nullptr, &draw_image.view));
+    // Background from the async compute queue: ownership acquire, then copied into the draw image
+    frame_graph.background_copy = render_graph.addPass("Background Copy", [this](VkCommandBuffer cmd)
+        {
+            async_compute.recordGraphics(cmd);
+
+            VkImageCopy2 region { .sType = VK_STRUCTURE_TYPE_IMAGE_COPY_2 };
+            region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.srcSubresource.layerCount = 1;
+            region.dstSubresource = region.srcSubresource;
+            region.extent.width = draw_extent.width;
+            region.extent.height = draw_extent.height;
+            region.extent.depth = 1;
+
+            VkCopyImageInfo2 copy_info { .sType = VK_STRUCTURE_TYPE_COPY_IMAGE_INFO_2 };
+            copy_info.srcImage = getCurrentFrame().background_image.image;
+            copy_info.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            copy_info.dstImage = draw_image.image;
+            copy_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            copy_info.regionCount = 1;
+            copy_info.pRegions = &region;
+
+            vkCmdCopyImage2(cmd, &copy_info);
+        });
+    render_graph.use(frame_graph.background_copy, frame_graph.background_image, GraphAccess::transfer_src);
+    render_graph.use(frame_graph.background_copy, frame_graph.draw_image, GraphAccess::transfer_dst);
 
+    // GPU-driven culling, prepared by drawMain before the graph runs
+    // Uses buffers only (no graph resources): GPUCulling records their barriers itself, see below
+    frame_graph.culling = render_graph.addPass("Culling", [this](VkCommandBuffer cmd)
+        {
+            gpu_culling.recordCull(cmd, this, getCurrentFrame(), scene_data.view_proj, 
+                isOcclusionCulling() ? CULL_PHASE_EARLY : CULL_PHASE_FRUSTUM, draw_extent);
+        });
 
+    // Occlusion culling: occluder depth, Hi-Z and the late cull against it
+    frame_graph.geometry_early = render_graph.addPass("Geometry (early)", [this](VkCommandBuffer cmd)
+        {
+            drawGeometryPass(cmd, true);
+        });
+    render_graph.use(frame_graph.geometry_early, frame_graph.draw_image, GraphAccess::color_attachment);
+    render_graph.use(frame_graph.geometry_early, frame_graph.depth_image, GraphAccess::depth_attachment);
 
+    frame_graph.hiz = render_graph.addPass("Hi-Z", [this](VkCommandBuffer cmd)
+        {
+            depth_pyramid.record(cmd, this);
+        });
+    render_graph.use(frame_graph.hiz, frame_graph.depth_image, GraphAccess::compute_sampled);
 
-    // *** Init Depth Image ***
-    //
-    depth_image.format = VK_FORMAT_D32_SFLOAT;
-    depth_image.extent = draw_extent;
-    VkImageUsageFlags depth_image_usages{};
-    depth_image_usages |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;  // Key to depth pass
+    frame_graph.culling_late = render_graph.addPass("Culling (late)", [this](VkCommandBuffer cmd)
+        {
+            gpu_culling.recordCull(cmd, this, getCurrentFrame(), scene_data.view_proj, CULL_PHASE_LATE, 
+                draw_extent);
+        });
 
-    VkImageCreateInfo dimg_info = vkinit::image_create_info(depth_image.format, depth_image_usages, draw_extent);
+    frame_graph.geometry = render_graph.addPass("Geometry", [this](VkCommandBuffer cmd)
+        {
+            drawGeometryPass(cmd, false);
+        });
+    render_graph.use(frame_graph.geometry, frame_graph.draw_image, GraphAccess::color_attachment);
+    render_graph.use(frame_graph.geometry, frame_graph.depth_image, GraphAccess::depth_attachment);
 
-    // Allocate and create the image
-    vmaCreateImage(allocator, &dimg_info, &rimg_alloc_info, &depth_image.image, &depth_image.allocation, nullptr);
+    // Draw image into the swapchain (upscaled below full resolution), then the UI on top
+    frame_graph.blit = render_graph.addPass("Blit", [this](VkCommandBuffer cmd)
+        {
+            vkutil::copy_image_to_image(cmd, draw_image.image, 
+                render_graph.image(frame_graph.swapchain_image).image, draw_extent, swapchain_extent,
+                blitFilter());
+        });
+    render_graph.use(frame_graph.blit, frame_graph.draw_image, GraphAccess::transfer_src);
+    render_graph.use(frame_graph.blit, frame_graph.swapchain_image, GraphAccess::transfer_dst);
 
-    // Build a image-view for the draw image to use for rendering
-    VkImageViewCreateInfo dview_info = vkinit::imageview_create_info(depth_image.format, depth_image.image, VK_IMAGE_ASPECT_DEPTH_BIT);
+    frame_graph.imgui = render_graph.addPass("ImGui", [this](VkCommandBuffer cmd)
+        {
+            drawImgui(cmd, render_graph.image(frame_graph.swapchain_image).view);
+        });
+    render_graph.use(frame_graph.imgui, frame_graph.swapchain_image, GraphAccess::color_attachment);
 
-    VK_CHECK(vkCreateImageView(device, &dview_info, nullptr, &depth_image.view));
+    render_graph.setFinalAccess(frame_graph.swapchain_image, GraphAccess::present);
 
+    render_graph.compile();
 
+    draw_image = render_graph.image(frame_graph.draw_image);
+    depth_image = render_graph.image(frame_graph.depth_image);
 
+    // Cubic upscale blits need the draw format's cubic filter feature
+    if (cubic_blit_supported)
+    {
+        VkFormatProperties format_properties;
+        vkGetPhysicalDeviceFormatProperties(physical_device, draw_image.format, &format_properties);
+        cubic_blit_supported = (format_properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_CUBIC_BIT_EXT) != 0;
+    }
 
-    // *** Cleanup ***
-    //
-    // Add to deletion functions to queue
-    main_delete_queue.pushFunction([=]() 
+    main_delete_queue.pushFunction([&]() 
         {
-            vkDestroyImageView(device, depth_image.view, nullptr);
-            vmaDestroyImage(allocator, depth_image.image, depth_image.allocation);
-            
-            vkDestroyImageView(device, draw_image.view, nullptr);
-            vmaDestroyImage(allocator, draw_image.image, draw_image.allocation);
+            render_graph.destroy();
         });
 }
 
@@ -1022,7 +2612,7 @@ void phVkEngine::initCommands()
     command_pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     command_pool_info.queueFamilyIndex = graphics_queue_family;
 
-    for (int i = 0; i < FRAME_OVERLAP; i++) 
+    for (int i = 0; i < MAX_FRAME_OVERLAP; i++) 
     {
         VK_CHECK(vkCreateCommandPool(device, &command_pool_info, nullptr, &frames[i].command_pool));
 
@@ -1035,6 +2625,21 @@ void phVkEngine::initCommands()
         cmd_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 
         VK_CHECK(vkAllocateCommandBuffers(device, &cmd_alloc_info, &frames[i].main_command_buffer));
+
+        // Secondary buffers for parallel recording, each in its own pool (reset per frame)
+        VkCommandPoolCreateInfo secondary_pool_info = command_pool_info;
+        secondary_pool_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        for (uint32_t t = 0; t < MAX_RECORD_THREADS; t++)
+        {
+            VK_CHECK(vkCreateCommandPool(device, &secondary_pool_info, nullptr, &frames[i].secondary_pools[t]));
+
+            VkCommandBufferAllocateInfo secondary_alloc_info = 
+                vkinit::command_buffer_allocate_info(frames[i].secondary_pools[t], 1);
+            secondary_alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+
+            VK_CHECK(vkAllocateCommandBuffers(device, &secondary_alloc_info, &frames[i].secondary_buffers[t]));
+        }
     }
 
 
@@ -1053,6 +2658,36 @@ void phVkEngine::initCommands()
         {
             vkDestroyCommandPool(device, imm_command_pool, nullptr);
         });
+
+
+    // *** Upload Commands ***
+
+    upload_manager.init(this, transfer_queue, transfer_queue_family, 64 * 1024 * 1024);
+
+    main_delete_queue.pushFunction([&]() 
+        {
+            upload_manager.destroy();
+        });
+
+
+    // *** Async Compute Commands ***
+
+    async_compute.init(this, compute_queue, compute_queue_family);
+
+    main_delete_queue.pushFunction([&]() 
+        {
+            async_compute.destroy();
+        });
+
+
+    // *** GPU Profiler Queries ***
+
+    gpu_profiler.init(this, graphics_queue_family, pipeline_statistics_supported);
+
+    main_delete_queue.pushFunction([&]() 
+        {
+            gpu_profiler.destroy(this);
+        });
 }
 
 void phVkEngine::initSyncStructures()
@@ -1066,7 +2701,7 @@ void phVkEngine::initSyncStructures()
     VkFenceCreateInfo fence_create_info = vkinit::fence_create_info(VK_FENCE_CREATE_SIGNALED_BIT);
     VkSemaphoreCreateInfo semaphore_create_info = vkinit::semaphore_create_info();
 
-    for (int i = 0; i < FRAME_OVERLAP; i++) {
+    for (int i = 0; i < MAX_FRAME_OVERLAP; i++) {
         VK_CHECK(vkCreateFence(device, &fence_create_info, nullptr, &frames[i].render_fence));
 
         VK_CHECK(vkCreateSemaphore(device, &semaphore_create_info, nullptr, &frames[i].swapchain_semaphore));
@@ -1085,7 +2720,9 @@ void phVkEngine::initDescriptors()
     std::vector<DescriptorAllocatorGrowable::PoolSizeRatio> sizes = { 
         { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3 },
         { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 },
-        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 } };
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 } };
 
     global_descriptor_allocator.init(device, 10, sizes);
 
@@ -1093,19 +2730,24 @@ void phVkEngine::initDescriptors()
     {       // Block/naked scope - not sure why this is necessary
         DescriptorLayoutBuilder builder;
         builder.addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
-        draw_image_descriptor_layout = builder.build(device, 
+        draw_image_descriptor_layout = builder.build(resource_cache, 
             VK_SHADER_STAGE_COMPUTE_BIT);
     }
     {
         DescriptorLayoutBuilder builder;
-        builder.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-        gpu_scene_data_descriptor_layout = builder.build(device, 
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+        // Dynamic offset into the frame's upload buffer
+        builder.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+        gpu_scene_data_descriptor_layout = builder.build(resource_cache, 
+            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | meshShaderStages());
+
+        VkDescriptorUpdateTemplateEntry entry = DescriptorUpdateTemplate::entry(0, 
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0);
+        scene_descriptor_template.build(device, gpu_scene_data_descriptor_layout, { &entry, 1 });
     }
     {
         DescriptorLayoutBuilder builder;
         builder.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-        single_image_descriptor_layout = builder.build(device, 
+        single_image_descriptor_layout = builder.build(resource_cache, 
             VK_SHADER_STAGE_FRAGMENT_BIT);
     }
 
@@ -1117,21 +2759,42 @@ void phVkEngine::initDescriptors()
     writer.writeImage(0, draw_image.view, VK_NULL_HANDLE, 
         VK_IMAGE_LAYOUT_GENERAL, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
 
-    writer.updateSet(device, draw_image_descriptors);
+    writer.updateSet(device, draw_image_descriptors);
+
+    // Async compute background targets (same layout as the draw image)
+    for (FrameData& frame : frames)
+    {
+        if (frame.background_image.image == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        frame.background_descriptors = global_descriptor_allocator.allocate(device, draw_image_descriptor_layout);
+
+        DescriptorWriter background_writer;
+        background_writer.writeImage(0, frame.background_image.view, VK_NULL_HANDLE, 
+            VK_IMAGE_LAYOUT_GENERAL, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+        background_writer.updateSet(device, frame.background_descriptors);
+    }
+
+    // Global bindless material set (pipelines fall back to per-material sets if invalid)
+    if (use_bindless)
+    {
+        bindless_registry.init(this);
+    }
 
     // Add delete functions to queue for descriptor allocator and layout
     main_delete_queue.pushFunction([&]() 
         {
             global_descriptor_allocator.destroyPools(device);
+            scene_descriptor_template.destroy(device);
 
-            vkDestroyDescriptorSetLayout(device, draw_image_descriptor_layout, nullptr);
-            vkDestroyDescriptorSetLayout(device, single_image_descriptor_layout, nullptr);
-            vkDestroyDescriptorSetLayout(device, gpu_scene_data_descriptor_layout, nullptr);
+            bindless_registry.destroy(this);
         });
 
 
 	// Initialize frame descriptor pool
-    for (int i = 0; i < FRAME_OVERLAP; i++) 
+    for (int i = 0; i < MAX_FRAME_OVERLAP; i++) 
     {
         // Create a descriptor pool
         std::vector<DescriptorAllocatorGrowable::PoolSizeRatio> frame_sizes = 
@@ -1145,16 +2808,73 @@ void phVkEngine::initDescriptors()
         frames[i].frame_descriptors = DescriptorAllocatorGrowable{};
         frames[i].frame_descriptors.init(device, 1000, frame_sizes);
 
+        // Upload buffer and its pre-built scene descriptor
+        VkDeviceSize upload_alignment = std::max(
+            physical_device_properties.limits.minUniformBufferOffsetAlignment,
+            physical_device_properties.limits.minStorageBufferOffsetAlignment);
+
+        frames[i].upload_buffer.init(this, 4 * 1024 * 1024, upload_alignment);
+        frames[i].arena.init(1024 * 1024);
+        frames[i].scene_descriptor = global_descriptor_allocator.allocate(device, 
+            gpu_scene_data_descriptor_layout);
+        writeSceneDescriptor(frames[i]);
+
         // Delete queue
         main_delete_queue.pushFunction([&, i]() 
             {
                 frames[i].frame_descriptors.destroyPools(device);
+                frames[i].upload_buffer.destroy(this);
             });
     }
 }
 
+void phVkEngine::writeSceneDescriptor(FrameData& frame)
+{
+    // Range covers one GPUSceneData, the offset is supplied when binding
+    VkDescriptorBufferInfo info { frame.upload_buffer.primaryBuffer(), 0, sizeof(GPUSceneData) };
+    scene_descriptor_template.updateSet(device, frame.scene_descriptor, &info);
+}
+
+void phVkEngine::collectDescriptorStats()
+{
+    stats.descriptor_pools = 0;
+    stats.descriptor_sets = 0;
+    stats.descriptor_retries = 0;
+
+    auto add = [&](DescriptorAllocatorGrowable& descriptor_allocator)
+        {
+            DescriptorAllocatorGrowable::Stats s = descriptor_allocator.takeStats();
+            stats.descriptor_pools += s.pools;
+            stats.descriptor_sets += s.sets;
+            stats.descriptor_retries += s.retries;
+        };
+
+    add(global_descriptor_allocator);
+    for (FrameData& frame : frames)
+    {
+        add(frame.frame_descriptors);
+    }
+    for (auto& [name, scene] : loaded_scenes)
+    {
+        add(scene->descriptor_pool);
+    }
+}
+
 void phVkEngine::initPipelines()
 {
+    // Persistent pipeline cache, saved at shutdown
+    pipeline_cache.init(this, "pipeline_cache.bin");
+    if (pipeline_cache.loadedSize() > 0)
+    {
+        fmt::println("Loaded pipeline cache ({} KB)", pipeline_cache.loadedSize() / 1024);
+    }
+
+    main_delete_queue.pushFunction([&]()
+        {
+            pipeline_cache.save();
+            pipeline_cache.destroy();
+        });
+
     // Compute Pipelines
     initBackgroundPipelines();
 
@@ -1162,6 +2882,16 @@ void phVkEngine::initPipelines()
 	initMeshPipeline();
 
     metal_rough_material.buildPipelines(this);
+
+    // Streamed textures are swapped by re-pointing their bindless slots
+    if (metal_rough_material.isBindless())
+    {
+        texture_streamer.init(this);
+    }
+
+    // GPU-driven culling (needs the material pipelines and the depth pyramid's set layout)
+    depth_pyramid.init(this);
+    gpu_culling.init(this);
 }
 
 void phVkEngine::initBackgroundPipelines()
@@ -1192,7 +2922,7 @@ void phVkEngine::initBackgroundPipelines()
     // Load shader code
     VkShaderModule gradient_shader;
     // TODO: abstract file paths (though this one is likely temporary anyway?)
-    if (!vkutil::load_shader_module("../../../../shaders/gradient_color.comp.spv", device, &gradient_shader))
+    if (!vkutil::load_shader_module(PHVK_SHADER_DIR "gradient_color.comp.spv", device, &gradient_shader))
     {
         fmt::print("Error when building the gradient shader \n");
     }
@@ -1200,7 +2930,7 @@ void phVkEngine::initBackgroundPipelines()
     // Load shader code
     VkShaderModule sky_shader;
     // TODO: abstract file paths (though this one is likely temporary anyway?)
-    if (!vkutil::load_shader_module("../../../../shaders/sky.comp.spv", device, &sky_shader))
+    if (!vkutil::load_shader_module(PHVK_SHADER_DIR "sky.comp.spv", device, &sky_shader))
     {
         fmt::print("Error when building the sky shader \n");
     }
@@ -1231,7 +2961,9 @@ void phVkEngine::initBackgroundPipelines()
     gradient.data.data1 = Vec4f(1, 0, 0, 1);
     gradient.data.data2 = Vec4f(0, 0, 1, 1);
 
-    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &compute_pipeline_create_info, nullptr, &gradient.pipeline));
+    // Both effects compile in parallel
+    PipelineCompileBatch batch;
+    batch.add(compute_pipeline_create_info, &gradient.pipeline);
 
     // Change the shader module only to create the sky shader
     compute_pipeline_create_info.stage.module = sky_shader;
@@ -1243,7 +2975,8 @@ void phVkEngine::initBackgroundPipelines()
     // Default sky parameters
     sky.data.data1 = Vec4f(0.1, 0.2, 0.4, 0.97);
 
-    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &compute_pipeline_create_info, nullptr, &sky.pipeline));
+    batch.add(compute_pipeline_create_info, &sky.pipeline);
+    batch.compile(this);
 
     // Add the two background effects into the array
     background_effects.push_back(gradient);
@@ -1257,11 +2990,11 @@ void phVkEngine::initBackgroundPipelines()
     vkDestroyShaderModule(device, sky_shader, nullptr);
 
     // Add delete functions to queue for pipeline and layout
+    main_delete_queue.pushPipeline(sky.pipeline);
+    main_delete_queue.pushPipeline(gradient.pipeline);
     main_delete_queue.pushFunction([=]()
         {
             vkDestroyPipelineLayout(device, gradient_pipeline_layout, nullptr);
-            vkDestroyPipeline(device, sky.pipeline, nullptr);
-            vkDestroyPipeline(device, gradient.pipeline, nullptr);
         });
 }
 
@@ -1269,7 +3002,7 @@ void phVkEngine::initMeshPipeline()
 {
 	// *** Pipeline Module ***
     VkShaderModule triangle_frag_shader;
-    if (!vkutil::load_shader_module("../../../../shaders/tex_image.frag.spv", 
+    if (!vkutil::load_shader_module(PHVK_SHADER_DIR "tex_image.frag.spv", 
         device, &triangle_frag_shader)) 
     {
         fmt::print("Error when building the fragment shader \n");
@@ -1280,7 +3013,7 @@ void phVkEngine::initMeshPipeline()
     }
 
     VkShaderModule triangle_vertex_shader;
-    if (!vkutil::load_shader_module("../../../../shaders/colored_triangle_mesh.vert.spv", 
+    if (!vkutil::load_shader_module(PHVK_SHADER_DIR "colored_triangle_mesh.vert.spv", 
         device, &triangle_vertex_shader))
     {
         fmt::print("Error when building the vertex shader \n");
@@ -1339,7 +3072,7 @@ void phVkEngine::initMeshPipeline()
     pipeline_builder.setDepthFormat(depth_image.format);
 
     // Build the pipeline
-    mesh_pipeline = pipeline_builder.buildPipeline(device);
+    mesh_pipeline = pipeline_builder.buildPipeline(device, pipeline_cache.cache);
 
 
 
@@ -1430,6 +3163,11 @@ void phVkEngine::initImgui()
 
 void phVkEngine::initDefaultData() 
 {
+    // *** Geometry Pool ***
+    // Pages of 128 MB vertex data + 32M indices, more are added on demand
+    geometry_pool.init(this, 128 * 1024 * 1024, 32 * 1024 * 1024);
+
+
     // Three default textures: white, grey, black. One pixel each
     uint32_t white = PackFloatInt4x8(Vec4f(1, 1, 1, 1));
     white_image = createImage((void*)&white, VkExtent3D{ 1, 1, 1 }, 
@@ -1461,22 +3199,16 @@ void phVkEngine::initDefaultData()
     sampl.magFilter = VK_FILTER_NEAREST;
     sampl.minFilter = VK_FILTER_NEAREST;
 
-    vkCreateSampler(device, &sampl, nullptr, &default_sampler_nearest);
+    default_sampler_nearest = resource_cache.getSampler(sampl);
 
     sampl.magFilter = VK_FILTER_LINEAR;
     sampl.minFilter = VK_FILTER_LINEAR;
-    vkCreateSampler(device, &sampl, nullptr, &default_sampler_linear);
+    default_sampler_linear = resource_cache.getSampler(sampl);
 
-    main_delete_queue.pushFunction([&]() 
-        {
-            vkDestroySampler(device, default_sampler_nearest, nullptr);
-            vkDestroySampler(device, default_sampler_linear, nullptr);
-
-            destroyImage(white_image);
-            destroyImage(grey_image);
-            destroyImage(black_image);
-            destroyImage(error_checkerboard_image);
-		});
+    main_delete_queue.pushImage(white_image);
+    main_delete_queue.pushImage(grey_image);
+    main_delete_queue.pushImage(black_image);
+    main_delete_queue.pushImage(error_checkerboard_image);
 
 
 
@@ -1499,13 +3231,11 @@ void phVkEngine::initDefaultData()
     sceneUniformData->metal_rough_factors = Vec4f{ 1, 0.5, 0, 0 };
 
     // Cleanup
-    main_delete_queue.pushFunction([=, this]() 
-        {
-            destroyBuffer(material_constants);
-        });
+    main_delete_queue.pushBuffer(material_constants);
 
     material_resources.data_buffer = material_constants.buffer;
     material_resources.data_buffer_offset = 0;
+    material_resources.constants = *sceneUniformData;
 
     default_data = metal_rough_material.writeMaterial(device, 
         MaterialPass::main_color, material_resources, global_descriptor_allocator);
@@ -1533,27 +3263,132 @@ void phVkEngine::initDefaultData()
 
         loaded_nodes[m->name] = std::move(new_node);
     }
+
+
+    // *** Finish Default Uploads ***
+    // Default images are referenced by every material, so block once here
+    // (acquired on the graphics queue at the start of the first frame)
+    upload_manager.wait(upload_manager.flush());
 }
 
 void GLTFMetallicRoughness::buildPipelines(phVkEngine* engine)
 {
     // *** Set Up Pipeline ***
 
-    VkShaderModule mesh_frag_shader;
-    if (!vkutil::load_shader_module("../../../../shaders/mesh.frag.spv", engine->device, &mesh_frag_shader)) 
+    // Bindless mode swaps every shader for its USE_BINDLESS variant, the base pair is
+    // required (otherwise fall back to per-material descriptor sets)
+    bindless = nullptr;
+    VkShaderModule mesh_frag_shader = VK_NULL_HANDLE;
+    VkShaderModule mesh_vertex_shader = VK_NULL_HANDLE;
+
+    if (engine->use_bindless && engine->bindless_registry.isValid())
+    {
+        if (vkutil::load_shader_module(PHVK_SHADER_DIR "mesh_bindless.frag.spv", engine->device, &mesh_frag_shader) &&
+            vkutil::load_shader_module(PHVK_SHADER_DIR "mesh_bindless.vert.spv", engine->device, &mesh_vertex_shader))
+        {
+            bindless = &engine->bindless_registry;
+        }
+        else
+        {
+            fmt::println("Error when building the bindless shader modules, using per-material descriptor sets");
+            if (mesh_frag_shader != VK_NULL_HANDLE)
+            {
+                vkDestroyShaderModule(engine->device, mesh_frag_shader, nullptr);
+                mesh_frag_shader = VK_NULL_HANDLE;
+            }
+        }
+    }
+
+    const char* suffix = bindless ? "_bindless" : "";
+
+    if (!bindless)
+    {
+        if (!vkutil::load_shader_module(PHVK_SHADER_DIR "mesh.frag.spv", engine->device, &mesh_frag_shader)) 
+        {
+            fmt::println("Error when building the fragment shader module");
+        }
+
+        if (!vkutil::load_shader_module(PHVK_SHADER_DIR "mesh.vert.spv", engine->device, &mesh_vertex_shader)) 
+        {
+            fmt::println("Error when building the vertex shader module");
+        }
+    }
+
+    // Optional vertex shader for the GPU-driven indirect path
+    VkShaderModule mesh_indirect_vertex_shader = VK_NULL_HANDLE;
+    std::string shader_path = fmt::format(PHVK_SHADER_DIR "mesh{}_indirect.vert.spv", suffix);
+    if (!vkutil::load_shader_module(shader_path.c_str(), engine->device, &mesh_indirect_vertex_shader)) 
+    {
+        fmt::println("Error when building the indirect vertex shader module");
+        mesh_indirect_vertex_shader = VK_NULL_HANDLE;
+    }
+
+    // Optional vertex shaders for PackedVertex meshes
+    VkShaderModule mesh_packed_vertex_shader = VK_NULL_HANDLE;
+    shader_path = fmt::format(PHVK_SHADER_DIR "mesh_packed{}.vert.spv", suffix);
+    if (!vkutil::load_shader_module(shader_path.c_str(), engine->device, &mesh_packed_vertex_shader)) 
+    {
+        fmt::println("Error when building the packed vertex shader module");
+        mesh_packed_vertex_shader = VK_NULL_HANDLE;
+    }
+
+    VkShaderModule mesh_packed_indirect_vertex_shader = VK_NULL_HANDLE;
+    shader_path = fmt::format(PHVK_SHADER_DIR "mesh_packed{}_indirect.vert.spv", suffix);
+    if (!vkutil::load_shader_module(shader_path.c_str(), engine->device, &mesh_packed_indirect_vertex_shader)) 
+    {
+        fmt::println("Error when building the packed indirect vertex shader module");
+        mesh_packed_indirect_vertex_shader = VK_NULL_HANDLE;
+    }
+
+    // Optional vertex shaders for instanced CPU-path draws (transforms from the instance buffer)
+    VkShaderModule mesh_instanced_vertex_shader = VK_NULL_HANDLE;
+    shader_path = fmt::format(PHVK_SHADER_DIR "mesh{}_instanced.vert.spv", suffix);
+    if (!vkutil::load_shader_module(shader_path.c_str(), engine->device, &mesh_instanced_vertex_shader)) 
+    {
+        fmt::println("Error when building the instanced vertex shader module");
+        mesh_instanced_vertex_shader = VK_NULL_HANDLE;
+    }
+
+    VkShaderModule mesh_packed_instanced_vertex_shader = VK_NULL_HANDLE;
+    shader_path = fmt::format(PHVK_SHADER_DIR "mesh_packed{}_instanced.vert.spv", suffix);
+    if (!vkutil::load_shader_module(shader_path.c_str(), engine->device, &mesh_packed_instanced_vertex_shader)) 
     {
-        fmt::println("Error when building the fragment shader module");
+        fmt::println("Error when building the packed instanced vertex shader module");
+        mesh_packed_instanced_vertex_shader = VK_NULL_HANDLE;
     }
 
-    VkShaderModule mesh_vertex_shader;
-    if (!vkutil::load_shader_module("../../../../shaders/mesh.vert.spv", engine->device, &mesh_vertex_shader)) 
+    // Optional task / mesh shaders (VK_EXT_mesh_shader), the task shader is shared by every variant
+    VkShaderModule meshlet_task_shader = VK_NULL_HANDLE;
+    VkShaderModule meshlet_mesh_shader = VK_NULL_HANDLE;
+    VkShaderModule meshlet_packed_mesh_shader = VK_NULL_HANDLE;
+    if (engine->mesh_shading_supported)
     {
-        fmt::println("Error when building the vertex shader module");
+        if (!vkutil::load_shader_module(PHVK_SHADER_DIR "meshlet.task.spv", engine->device, &meshlet_task_shader)) 
+        {
+            fmt::println("Error when building the meshlet task shader module");
+            meshlet_task_shader = VK_NULL_HANDLE;
+        }
+
+        shader_path = fmt::format(PHVK_SHADER_DIR "meshlet{}.mesh.spv", suffix);
+        if (!vkutil::load_shader_module(shader_path.c_str(), engine->device, &meshlet_mesh_shader)) 
+        {
+            fmt::println("Error when building the meshlet mesh shader module");
+            meshlet_mesh_shader = VK_NULL_HANDLE;
+        }
+
+        shader_path = fmt::format(PHVK_SHADER_DIR "meshlet_packed{}.mesh.spv", suffix);
+        if (!vkutil::load_shader_module(shader_path.c_str(), engine->device, &meshlet_packed_mesh_shader)) 
+        {
+            fmt::println("Error when building the packed meshlet mesh shader module");
+            meshlet_packed_mesh_shader = VK_NULL_HANDLE;
+        }
     }
 
+    // Sized for the largest variant (packed draws also push the dequantization bounds, 
+    // bindless draws the material index)
     VkPushConstantRange matrix_range{};
     matrix_range.offset = 0;
-    matrix_range.size = sizeof(GPUDrawPushConstants);
+    matrix_range.size = sizeof(GPUPackedDrawPushConstants);
     matrix_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
     DescriptorLayoutBuilder layout_builder;
@@ -1561,11 +3396,17 @@ void GLTFMetallicRoughness::buildPipelines(phVkEngine* engine)
     layout_builder.addBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
     layout_builder.addBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
 
-    material_layout = layout_builder.build(engine->device, 
-        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT);
+    material_layout = layout_builder.build(engine->resource_cache, 
+        VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | engine->meshShaderStages());
+
+    VkDescriptorUpdateTemplateEntry entries[] = {
+        DescriptorUpdateTemplate::entry(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, offsetof(MaterialDescriptors, constants)),
+        DescriptorUpdateTemplate::entry(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(MaterialDescriptors, color)),
+        DescriptorUpdateTemplate::entry(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, offsetof(MaterialDescriptors, metal_rough)) };
+    material_template.build(engine->device, material_layout, entries);
 
     VkDescriptorSetLayout layouts[] = { engine->gpu_scene_data_descriptor_layout,
-        material_layout };
+        bindless ? bindless->layout : material_layout };
 
     VkPipelineLayoutCreateInfo mesh_layout_info = vkinit::pipeline_layout_create_info();
     mesh_layout_info.setLayoutCount = 2;
@@ -1579,6 +3420,18 @@ void GLTFMetallicRoughness::buildPipelines(phVkEngine* engine)
     opaque_pipeline.layout = new_layout;
     transparent_pipeline.layout = new_layout;
 
+    // Meshlet variants push GPUMeshletDrawPushConstants to the task and mesh stages
+    if (meshlet_task_shader != VK_NULL_HANDLE && meshlet_mesh_shader != VK_NULL_HANDLE)
+    {
+        VkPushConstantRange meshlet_range{};
+        meshlet_range.offset = 0;
+        meshlet_range.size = sizeof(GPUMeshletDrawPushConstants);
+        meshlet_range.stageFlags = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT;
+
+        mesh_layout_info.pPushConstantRanges = &meshlet_range;
+        VK_CHECK(vkCreatePipelineLayout(engine->device, &mesh_layout_info, nullptr, &opaque_pipeline.meshlet_layout));
+    }
+
     // Build the stage-create-info for both vertex and fragment stages. This lets
     // the pipeline know the shader modules per stage
     PipelineBuilder pipelineBuilder;
@@ -1597,27 +3450,133 @@ void GLTFMetallicRoughness::buildPipelines(phVkEngine* engine)
     // Yse the triangle layout we created
     pipelineBuilder.pipeline_layout = new_layout;
 
-    // finally build the pipeline
-    opaque_pipeline.pipeline = pipelineBuilder.buildPipeline(engine->device);
+    // finally build the pipeline (every variant compiles in parallel, the builder state is
+    // copied when added)
+    PipelineCompileBatch batch;
+    batch.add(pipelineBuilder, &opaque_pipeline.pipeline);
+
+    // create the indirect variant (same state, object data read from the object buffer)
+    if (mesh_indirect_vertex_shader != VK_NULL_HANDLE)
+    {
+        pipelineBuilder.setShaders(mesh_indirect_vertex_shader, mesh_frag_shader);
+        batch.add(pipelineBuilder, &opaque_pipeline.indirect_pipeline);
+    }
+
+    // create the packed vertex variants
+    if (mesh_packed_vertex_shader != VK_NULL_HANDLE)
+    {
+        pipelineBuilder.setShaders(mesh_packed_vertex_shader, mesh_frag_shader);
+        batch.add(pipelineBuilder, &opaque_pipeline.packed_pipeline);
+    }
+    if (mesh_packed_indirect_vertex_shader != VK_NULL_HANDLE)
+    {
+        pipelineBuilder.setShaders(mesh_packed_indirect_vertex_shader, mesh_frag_shader);
+        batch.add(pipelineBuilder, &opaque_pipeline.packed_indirect_pipeline);
+    }
+
+    // create the instanced variants (opaque only, transparent draws keep their sorted order)
+    if (mesh_instanced_vertex_shader != VK_NULL_HANDLE)
+    {
+        pipelineBuilder.setShaders(mesh_instanced_vertex_shader, mesh_frag_shader);
+        batch.add(pipelineBuilder, &opaque_pipeline.instanced_pipeline);
+    }
+    if (mesh_packed_instanced_vertex_shader != VK_NULL_HANDLE)
+    {
+        pipelineBuilder.setShaders(mesh_packed_instanced_vertex_shader, mesh_frag_shader);
+        batch.add(pipelineBuilder, &opaque_pipeline.packed_instanced_pipeline);
+    }
+
+    // create the meshlet variants (own layout)
+    if (opaque_pipeline.meshlet_layout != VK_NULL_HANDLE)
+    {
+        pipelineBuilder.pipeline_layout = opaque_pipeline.meshlet_layout;
+        pipelineBuilder.setMeshShaders(meshlet_task_shader, meshlet_mesh_shader, mesh_frag_shader);
+        batch.add(pipelineBuilder, &opaque_pipeline.meshlet_pipeline);
+
+        if (meshlet_packed_mesh_shader != VK_NULL_HANDLE)
+        {
+            pipelineBuilder.setMeshShaders(meshlet_task_shader, meshlet_packed_mesh_shader, mesh_frag_shader);
+            batch.add(pipelineBuilder, &opaque_pipeline.packed_meshlet_pipeline);
+        }
+        pipelineBuilder.pipeline_layout = new_layout;
+    }
+
+    pipelineBuilder.setShaders(mesh_vertex_shader, mesh_frag_shader);
 
     // create the transparent variant
     pipelineBuilder.enableBlendingAdditive();
 
     pipelineBuilder.enableDepthtest(false, VK_COMPARE_OP_GREATER_OR_EQUAL);
 
-    transparent_pipeline.pipeline = pipelineBuilder.buildPipeline(engine->device);
+    batch.add(pipelineBuilder, &transparent_pipeline.pipeline);
+
+    if (mesh_packed_vertex_shader != VK_NULL_HANDLE)
+    {
+        pipelineBuilder.setShaders(mesh_packed_vertex_shader, mesh_frag_shader);
+        batch.add(pipelineBuilder, &transparent_pipeline.packed_pipeline);
+    }
+
+    batch.compile(engine);
 
     vkDestroyShaderModule(engine->device, mesh_frag_shader, nullptr);
     vkDestroyShaderModule(engine->device, mesh_vertex_shader, nullptr);
+    if (mesh_indirect_vertex_shader != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(engine->device, mesh_indirect_vertex_shader, nullptr);
+    }
+    if (mesh_packed_vertex_shader != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(engine->device, mesh_packed_vertex_shader, nullptr);
+    }
+    if (mesh_packed_indirect_vertex_shader != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(engine->device, mesh_packed_indirect_vertex_shader, nullptr);
+    }
+    if (mesh_instanced_vertex_shader != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(engine->device, mesh_instanced_vertex_shader, nullptr);
+    }
+    if (mesh_packed_instanced_vertex_shader != VK_NULL_HANDLE)
+    {
+        vkDestroyShaderModule(engine->device, mesh_packed_instanced_vertex_shader, nullptr);
+    }
+    for (VkShaderModule module : { meshlet_task_shader, meshlet_mesh_shader, meshlet_packed_mesh_shader })
+    {
+        if (module != VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(engine->device, module, nullptr);
+        }
+    }
 }
 
 void GLTFMetallicRoughness::clearResources(VkDevice device)
 {
-    vkDestroyDescriptorSetLayout(device, material_layout, nullptr);
+    material_template.destroy(device);
+
     vkDestroyPipelineLayout(device, transparent_pipeline.layout, nullptr);
 
     vkDestroyPipeline(device, transparent_pipeline.pipeline, nullptr);
     vkDestroyPipeline(device, opaque_pipeline.pipeline, nullptr);
+    if (opaque_pipeline.indirect_pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(device, opaque_pipeline.indirect_pipeline, nullptr);
+    }
+
+    // Packed vertex and instanced variants (optional)
+    for (VkPipeline p : { opaque_pipeline.packed_pipeline, opaque_pipeline.packed_indirect_pipeline,
+        transparent_pipeline.packed_pipeline, opaque_pipeline.instanced_pipeline, 
+        opaque_pipeline.packed_instanced_pipeline, opaque_pipeline.meshlet_pipeline, 
+        opaque_pipeline.packed_meshlet_pipeline })
+    {
+        if (p != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(device, p, nullptr);
+        }
+    }
+    if (opaque_pipeline.meshlet_layout != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineLayout(device, opaque_pipeline.meshlet_layout, nullptr);
+    }
 }
 
 MaterialInstance GLTFMetallicRoughness::writeMaterial(VkDevice device, MaterialPass pass, 
@@ -1625,6 +3584,7 @@ MaterialInstance GLTFMetallicRoughness::writeMaterial(VkDevice device, MaterialP
 {
     MaterialInstance mat_data;
     mat_data.pass_type = pass;
+    mat_data.sort_id = next_sort_id++;
     if (pass == MaterialPass::transparent) 
     {
         mat_data.pipeline = &transparent_pipeline;
@@ -1634,40 +3594,293 @@ MaterialInstance GLTFMetallicRoughness::writeMaterial(VkDevice device, MaterialP
         mat_data.pipeline = &opaque_pipeline;
     }
 
-    mat_data.material_set = descriptor_allocator.allocate(device, material_layout);
+    if (bindless)
+    {
+        // Textures and constants go into the global set, the material is just an index
+        GPUBindlessMaterial material {};
+        material.color_factors = resources.constants.color_factors;
+        material.metal_rough_factors = resources.constants.metal_rough_factors;
+        material.color_tex_id = bindless->registerTexture(resources.color_image.view, resources.color_sampler);
+        material.metal_rough_tex_id = bindless->registerTexture(resources.metal_rough_image.view, resources.metal_rough_sampler);
+
+        mat_data.material_set = bindless->set;
+        mat_data.material_index = bindless->allocateMaterial(material);
+
+        return mat_data;
+    }
 
+    mat_data.material_set = descriptor_allocator.allocate(device, material_layout);
 
-    writer.clear();
-    writer.writeBuffer(0, resources.data_buffer, sizeof(MaterialConstants), 
-        resources.data_buffer_offset, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
-    writer.writeImage(1, resources.color_image.view, resources.color_sampler, 
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-    writer.writeImage(2, resources.metal_rough_image.view, resources.metal_rough_sampler, 
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    MaterialDescriptors descriptors;
+    descriptors.constants = { resources.data_buffer, resources.data_buffer_offset, sizeof(MaterialConstants) };
+    descriptors.color = { resources.color_sampler, resources.color_image.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    descriptors.metal_rough = { resources.metal_rough_sampler, resources.metal_rough_image.view, 
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
 
-    writer.updateSet(device, mat_data.material_set);
+    material_template.updateSet(device, mat_data.material_set, &descriptors);
 
     return mat_data;
 }
 
+void GLTFMetallicRoughness::releaseMaterial(const MaterialInstance& material)
+{
+    // Per-material sets are freed with their descriptor pool
+    if (bindless)
+    {
+        bindless->freeMaterial(material.material_index);
+    }
+}
+
 void MeshNode::draw(const Mat4f& top_matrix, DrawContext& ctx)
 {
-    Mat4f node_matrix = top_matrix * world_transform;
+    addSurfaces(top_matrix * world_transform, ctx);
+
+    // recurse down
+    Node::draw(top_matrix, ctx);
+}
 
+void MeshNode::addSurfaces(const Mat4f& node_matrix, DrawContext& ctx) const
+{
     for (auto& s : mesh->surfaces)
     {
         RenderObject def;
         def.index_count = s.count;
-        def.first_index = s.start_index;
-        def.index_buffer = mesh->mesh_buffers.index_buffer.buffer;
+        def.first_index = mesh->mesh_buffers.geometry.first_index + s.start_index;
+        def.surface = &s;
+        def.mesh_first_index = mesh->mesh_buffers.geometry.first_index;
+
+        def.meshlet_address = 0;
+        def.meshlet_data_address = mesh->mesh_buffers.meshlet_data_address;
+        if (mesh->mesh_buffers.meshlet_address != 0 && s.meshlet_count > 0)
+        {
+            def.meshlet_address = mesh->mesh_buffers.meshlet_address + s.first_meshlet * sizeof(GPUMeshlet);
+        }
+        def.geometry_page = mesh->mesh_buffers.geometry.page;
         def.material = &s.material->data;
+        def.bounds = s.bounds;
 
         def.transform = node_matrix;
         def.vertex_buffer_address = mesh->mesh_buffers.vertex_buffer_address;
+        def.vertex_format = mesh->mesh_buffers.vertex_format;
+
+        // Pipeline variant = pass + vertex format
+        uint32_t pipeline_id = ((uint32_t)s.material->data.pass_type << 1) | (uint32_t)def.vertex_format;
+        def.state_key = DrawStateKey(pipeline_id, s.material->data.sort_id, def.geometry_page);
+
+        if (s.material->data.pass_type == MaterialPass::transparent)
+        {
+            ctx.transparent_surfaces.push_back(def);
+        }
+        else
+        {
+            ctx.opaque_surfaces.push_back(def);
+        }
+    }
+}
 
-        ctx.opaque_surfaces.push_back(def);
+void Node::setLocalTransform(const Mat4f& m)
+{
+    local_transform = m;
+    if (graph)
+    {
+        graph->markDirty(graph_index);
     }
+}
 
-    // recurse down
-    Node::draw(top_matrix, ctx);
+
+// *** Flattened Scene Graph ***
+
+void FlatSceneGraph::build(const std::vector<std::shared_ptr<Node>>& top_nodes)
+{
+    nodes.clear();
+    parents.clear();
+    ranges.clear();
+    cache.opaque_surfaces.clear();
+    cache.transparent_surfaces.clear();
+
+    // Depth-first, so every parent lands before its children
+    std::vector<std::pair<Node*, int32_t>> stack;
+    for (auto it = top_nodes.rbegin(); it != top_nodes.rend(); ++it)
+    {
+        stack.push_back({ it->get(), -1 });
+    }
+
+    while (!stack.empty())
+    {
+        auto [node, parent] = stack.back();
+        stack.pop_back();
+
+        uint32_t index = (uint32_t)nodes.size();
+        node->graph = this;
+        node->graph_index = index;
+        nodes.push_back(node);
+        parents.push_back(parent);
+
+        // Objects start at the current transforms, update() patches them from here on
+        ObjectRange range;
+        range.opaque_first = (uint32_t)cache.opaque_surfaces.size();
+        range.transparent_first = (uint32_t)cache.transparent_surfaces.size();
+        if (MeshNode* mesh_node = dynamic_cast<MeshNode*>(node))
+        {
+            mesh_node->addSurfaces(node->world_transform, cache);
+        }
+        range.opaque_count = (uint32_t)cache.opaque_surfaces.size() - range.opaque_first;
+        range.transparent_count = (uint32_t)cache.transparent_surfaces.size() - range.transparent_first;
+        ranges.push_back(range);
+
+        for (auto it = node->children.rbegin(); it != node->children.rend(); ++it)
+        {
+            stack.push_back({ it->get(), (int32_t)index });
+        }
+    }
+
+    dirty.assign(nodes.size(), 1);
+    changed.assign(nodes.size(), 0);
+    any_dirty = true;
+
+    // Topology is fixed from here on, moved nodes only refit the boxes
+    opaque_boxes.resize(cache.opaque_surfaces.size());
+    for (size_t i = 0; i < opaque_boxes.size(); i++)
+    {
+        opaque_boxes[i] = WorldBoundingBox(cache.opaque_surfaces[i]);
+    }
+    bvh.build(opaque_boxes);
+}
+
+// Adds [first, first + count) to a sorted range list, merged with the last range if adjacent
+static void AppendRange(std::vector<FlatSceneGraph::IndexRange>& ranges, uint32_t first, uint32_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (!ranges.empty() && ranges.back().first + ranges.back().count == first)
+    {
+        ranges.back().count += count;
+    }
+    else
+    {
+        ranges.push_back({ first, count });
+    }
+}
+
+bool FlatSceneGraph::update(const Mat4f& top_matrix)
+{
+    changed_opaque.clear();
+    changed_transparent.clear();
+
+    if (memcmp(&top_matrix, &this->top_matrix, sizeof(Mat4f)) != 0)
+    {
+        this->top_matrix = top_matrix;
+        std::fill(dirty.begin(), dirty.end(), (uint8_t)1);
+        any_dirty = true;
+    }
+
+    if (!any_dirty)
+    {
+        return false;
+    }
+
+    // One pass in parent-before-child order: a node is recomputed if it or any ancestor is dirty
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        int32_t parent = parents[i];
+        changed[i] = dirty[i] || (parent >= 0 && changed[parent]);
+        dirty[i] = 0;
+
+        if (!changed[i])
+        {
+            continue;
+        }
+
+        Node* node = nodes[i];
+        node->world_transform = (parent >= 0) ?
+            nodes[parent]->world_transform * node->local_transform : node->local_transform;
+
+        const ObjectRange& range = ranges[i];
+        if (range.opaque_count + range.transparent_count == 0)
+        {
+            continue;
+        }
+
+        Mat4f node_matrix = top_matrix * node->world_transform;
+        for (uint32_t o = 0; o < range.opaque_count; o++)
+        {
+            RenderObject& r = cache.opaque_surfaces[range.opaque_first + o];
+            r.transform = node_matrix;
+            opaque_boxes[range.opaque_first + o] = WorldBoundingBox(r);
+        }
+        for (uint32_t o = 0; o < range.transparent_count; o++)
+        {
+            cache.transparent_surfaces[range.transparent_first + o].transform = node_matrix;
+        }
+
+        // Parent-before-child order keeps a moved subtree's objects consecutive
+        AppendRange(changed_opaque, range.opaque_first, range.opaque_count);
+        AppendRange(changed_transparent, range.transparent_first, range.transparent_count);
+    }
+
+    bvh.refit(opaque_boxes);
+
+    any_dirty = false;
+    return true;
+}
+
+void FlatSceneGraph::append(DrawContext& ctx) const
+{
+    ctx.opaque_surfaces.insert(ctx.opaque_surfaces.end(),
+        cache.opaque_surfaces.begin(), cache.opaque_surfaces.end());
+    ctx.transparent_surfaces.insert(ctx.transparent_surfaces.end(),
+        cache.transparent_surfaces.begin(), cache.transparent_surfaces.end());
+}
+
+void FlatSceneGraph::relocateMeshlets(VkDeviceAddress old_address, VkDeviceSize size, VkDeviceAddress new_address)
+{
+    cache.relocateMeshlets(old_address, size, new_address);
+}
+
+void DrawContext::relocateMeshlets(VkDeviceAddress old_address, VkDeviceSize size, VkDeviceAddress new_address)
+{
+    auto relocate = [&](VkDeviceAddress& address)
+        {
+            if (address >= old_address && address < old_address + size)
+            {
+                address = new_address + (address - old_address);
+            }
+        };
+
+    for (std::vector<RenderObject>* objects : { &opaque_surfaces, &transparent_surfaces })
+    {
+        for (RenderObject& r : *objects)
+        {
+            relocate(r.meshlet_address);
+            relocate(r.meshlet_data_address);
+        }
+    }
+}
+
+void DrawContext::relocateGeometry(const GeometryAllocation& old_geometry, VkDeviceAddress old_address,
+    const GeometryAllocation& new_geometry, VkDeviceAddress new_address)
+{
+    for (std::vector<RenderObject>* objects : { &opaque_surfaces, &transparent_surfaces })
+    {
+        for (RenderObject& r : *objects)
+        {
+            // Vertex ranges don't overlap, so page + address identify the mesh
+            if (r.geometry_page != old_geometry.page || r.vertex_buffer_address != old_address)
+            {
+                continue;
+            }
+
+            // Index ranges (selected LOD included) keep their place relative to the mesh
+            r.first_index = r.first_index - old_geometry.first_index + new_geometry.first_index;
+            r.mesh_first_index = new_geometry.first_index;
+            r.geometry_page = new_geometry.page;
+            r.vertex_buffer_address = new_address;
+
+            uint32_t pipeline_id = ((uint32_t)r.material->pass_type << 1) | (uint32_t)r.vertex_format;
+            r.state_key = DrawStateKey(pipeline_id, r.material->sort_id, r.geometry_page);
+        }
+    }
 }
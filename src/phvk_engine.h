@@ -14,38 +14,66 @@
 
 #include <deque>
 #include <functional>
+#include <atomic>
+#include <chrono>
 
 #include "phvk_descriptors.h"
 #include "phvk_loader.h"
+#include "phvk_meshlet.h"
+#include "phvk_culling.h"
+#include "phvk_bvh.h"
+#include "phvk_occlusion.h"
+#include "phvk_buffers.h"
+#include "phvk_upload.h"
+#include "phvk_async_compute.h"
+#include "phvk_render_graph.h"
+#include "phvk_jobs.h"
+#include "phvk_geometry.h"
+#include "phvk_bindless.h"
+#include "phvk_pipeline_cache.h"
+#include "phvk_profiler.h"
+#include "phvk_memory.h"
+#include "phvk_resource_cache.h"
+#include "phvk_sort.h"
+#include "phvk_streaming.h"
+#include "phvk_arena.h"
 
 #include "phvk_camera.h"
 
-// Number of buffering frames
-constexpr unsigned int FRAME_OVERLAP = 2;
+// Number of buffering frames (frame slots allocated, phVkEngine::frame_overlap are in use)
+constexpr unsigned int MAX_FRAME_OVERLAP = 3;
+constexpr uint32_t MAX_RECORD_THREADS = 16;	// Secondary command buffers per frame
+constexpr size_t PARALLEL_RECORD_MIN_SURFACES = 1024;	// Smaller lists are recorded inline
 
 // DEBUG: Validation layers switch
 constexpr bool use_validation_layers = true;
 
 // Queue for deleting objects in FIFO order
+// Deferred destruction, common object types are kept in typed arrays and destroyed in bulk
+// (no closure per object), anything else goes through pushFunction
+// Arrays keep their capacity, so a frame's queue stops allocating once warmed up
 struct DeleteQueue
 {
-	std::deque<std::function<void()>> fifo;
+	std::vector<AllocatedBuffer> buffers;
+	std::vector<AllocatedImage> images;		// Image and view
+	std::vector<VkImageView> views;
+	std::vector<VkSampler> samplers;
+	std::vector<VkPipeline> pipelines;
+	std::vector<std::function<void()>> functions;
+
+	void pushBuffer(const AllocatedBuffer& buffer) { buffers.push_back(buffer); }
+	void pushImage(const AllocatedImage& image) { images.push_back(image); }
+	void pushView(VkImageView view) { views.push_back(view); }
+	void pushSampler(VkSampler sampler) { samplers.push_back(sampler); }
+	void pushPipeline(VkPipeline pipeline) { pipelines.push_back(pipeline); }
 
 	void pushFunction(std::function<void()>&& function) 
 	{
-		fifo.push_back(function);
+		functions.push_back(std::move(function));
 	}
 
-	void flush() 
-	{
-		// Reverse iterate the deletion queue to execute all the functions
-		for (auto it = fifo.rbegin(); it != fifo.rend(); it++) 
-		{
-			(*it)(); // Call function
-		}
-
-		fifo.clear();
-	}
+	// Typed objects first, then the functions in reverse order (the last ones destroy the allocator / device)
+	void flush(VkDevice device, VmaAllocator allocator);
 };
 
 
@@ -58,36 +86,217 @@ struct FrameData
 	VkCommandPool command_pool;
 	VkCommandBuffer main_command_buffer;
 
+	// Parallel draw recording, one pool per recording job so pools are never shared between threads
+	VkCommandPool secondary_pools[MAX_RECORD_THREADS];
+	VkCommandBuffer secondary_buffers[MAX_RECORD_THREADS];
+
 	DescriptorAllocatorGrowable frame_descriptors;
 
+	// Transient per-frame data (scene uniforms, culling inputs, etc.)
+	LinearUploadBuffer upload_buffer;
+	VkDescriptorSet scene_descriptor;	// Pre-built, bound with a dynamic offset
+	uint32_t scene_data_offset;			// Dynamic offset of this frame's GPUSceneData
+
+	GPUCullingBuffers culling_buffers;
+	GPUProfilerFrame profiler_frame;
+
 	DeleteQueue delete_queue;
+
+	// Transient CPU data of the frame (culling output, etc.)
+	FrameArena arena;
+
+	// Background effect target on the async compute queue, copied into the draw image
+	// (only created when the device has a separate compute family)
+	AllocatedImage background_image {};
+	VkDescriptorSet background_descriptors { VK_NULL_HANDLE };
+
+	// Latency tracking
+	std::chrono::steady_clock::time_point input_time;	// Input sampled for this frame
+	uint64_t present_id { 0 };			// VK_KHR_present_id of the frame's present (0 if none)
+};
+
+// Frame pacing
+//   throughput: frames queue up to frame_overlap deep (blocks on the fence / acquire)
+//   low_latency: input is sampled just before the predicted GPU-ready point, with present wait
+//   at most one frame waits for the display
+enum class FramePacing
+{
+	throughput,
+	low_latency
 };
 
 struct RenderObject
 {
 	uint32_t index_count;
-	uint32_t first_index;
-	VkBuffer index_buffer;
+	uint32_t first_index;		// Into the geometry page's index buffer
+	uint32_t geometry_page;		// GeometryPool page (selects the index buffer)
 
 	MaterialInstance* material;
 	Bounds bounds;
 
 	Mat4f transform;
 	VkDeviceAddress vertex_buffer_address;
+	VertexFormat vertex_format;
+	uint32_t state_key;			// Pipeline / material / page part of the draw key (DrawStateKey)
+
+	const GeoSurface* surface;	// Source surface (detail levels, see phVkEngine::selectLODs)
+	uint32_t mesh_first_index;	// Mesh's first index in the page, LOD ranges are relative to it
+
+	VkDeviceAddress meshlet_address;		// Surface's first GPUMeshlet, 0 without meshlets
+	VkDeviceAddress meshlet_data_address;
 };
 
 struct DrawContext 
 {
 	std::vector<RenderObject> opaque_surfaces;
 	std::vector<RenderObject> transparent_surfaces;
+
+	// Meshlet addresses in [old_address, old_address + size) moved to new_address
+	void relocateMeshlets(VkDeviceAddress old_address, VkDeviceSize size, VkDeviceAddress new_address);
+
+	// Objects of the mesh at old_geometry (vertices at old_address) moved to new_geometry
+	void relocateGeometry(const GeometryAllocation& old_geometry, VkDeviceAddress old_address,
+		const GeometryAllocation& new_geometry, VkDeviceAddress new_address);
+};
+
+// Node hierarchy flattened parent-before-child, with the render objects of its mesh nodes cached
+// update() only recomputes dirty subtrees and patches their objects, an unchanged graph costs nothing
+// The opaque objects also get a BVH for hierarchical culling
+struct FlatSceneGraph
+{
+	// Consecutive cached objects (index into objects().opaque_surfaces / transparent_surfaces)
+	struct IndexRange
+	{
+		uint32_t first, count;
+	};
+
+	void build(const std::vector<std::shared_ptr<Node>>& top_nodes);
+
+	// Returns true if any transform (and so any cached object) changed
+	// The patched objects are listed by changedOpaque() / changedTransparent() until the next update
+	bool update(const Mat4f& top_matrix);
+
+	// Appends the cached render objects
+	void append(DrawContext& ctx) const;
+
+	// Meshlet addresses of cached objects in [old_address, old_address + size) moved to new_address
+	void relocateMeshlets(VkDeviceAddress old_address, VkDeviceSize size, VkDeviceAddress new_address);
+
+	// Cached objects of a mesh moved to another geometry pool range, see DrawContext::relocateGeometry
+	void relocateGeometry(const GeometryAllocation& old_geometry, VkDeviceAddress old_address,
+		const GeometryAllocation& new_geometry, VkDeviceAddress new_address)
+	{
+		cache.relocateGeometry(old_geometry, old_address, new_geometry, new_address);
+	}
+
+	void markDirty(uint32_t index)
+	{
+		dirty[index] = 1;
+		any_dirty = true;
+	}
+
+	size_t nodeCount() const { return nodes.size(); }
+	const DrawContext& objects() const { return cache; }
+	const std::vector<IndexRange>& changedOpaque() const { return changed_opaque; }
+	const std::vector<IndexRange>& changedTransparent() const { return changed_transparent; }
+
+	// BVH over the world boxes of the cached opaque objects (items index cache.opaque_surfaces)
+	const BoundsHierarchy& hierarchy() const { return bvh; }
+	const std::vector<BoundingBox>& opaqueBoxes() const { return opaque_boxes; }
+
+private:
+	// Cached objects of one node in cache.opaque_surfaces / transparent_surfaces
+	struct ObjectRange
+	{
+		uint32_t opaque_first, opaque_count;
+		uint32_t transparent_first, transparent_count;
+	};
+
+	std::vector<Node*> nodes;			// Owned by the scene
+	std::vector<int32_t> parents;		// Index into nodes, -1 for top nodes
+	std::vector<uint8_t> dirty;			// Local transform changed since the last update
+	std::vector<uint8_t> changed;		// World transform recomputed in the current update
+	std::vector<ObjectRange> ranges;
+	DrawContext cache;
+	std::vector<IndexRange> changed_opaque;			// Objects patched by the last update (merged)
+	std::vector<IndexRange> changed_transparent;
+	std::vector<BoundingBox> opaque_boxes;
+	BoundsHierarchy bvh;			// Built once, refit when transforms change
+
+	Mat4f top_matrix;
+	bool any_dirty { true };
+};
+
+// Objects of one scene graph in draw_commands, starting at first_opaque / first_transparent
+struct SceneCullRange
+{
+	const FlatSceneGraph* graph;
+	uint32_t first_opaque;
+	uint32_t first_transparent;
+};
+
+// Bound state while recording surfaces into one command buffer
+struct DrawRecordState
+{
+	VkPipeline pipeline { VK_NULL_HANDLE };
+	VkDescriptorSet material_set { VK_NULL_HANDLE };
+	uint32_t geometry_page { UINT32_MAX };
+	int drawcall_count { 0 };
+	int triangle_count { 0 };
+	int instance_count { 0 };
+};
+
+// Opaque surfaces drawn as one instanced draw (transforms at first_instance in the instance buffer)
+struct InstanceBatch
+{
+	uint32_t object;			// Representative surface in draw_commands.opaque_surfaces
+	uint32_t first_instance;
+	uint32_t instance_count;
 };
 
 struct EngineStats 
 {
-	float frame_time;
+	float frame_time;		// ms, CPU time between frames
 	int triangle_count;
 	int drawcall_count;
+	int instance_count;		// Surfaces drawn (equals drawcall_count without instancing)
+	int cull_tested;		// Opaque surfaces tested by CPU culling (0 on the GPU-driven path)
+	int cull_visible;
+	int cull_box_tests;		// Surfaces crossing a frustum plane that needed the precise box test
+	int cull_bvh_nodes;		// BVH nodes visited (0 with flat culling)
+	int lod_reduced;		// Surfaces using a simplified LOD
 	float mesh_draw_time;
+	int heap_allocations;	// operator new calls during the last frame (all threads)
+	int descriptor_pools;	// Pools alive across the engine's growable allocators
+	int descriptor_sets;	// Sets allocated last frame
+	int descriptor_retries;	// Allocations last frame that found their pool full
+	float pacing_wait;		// ms, sleep / present wait before sampling input (low-latency pacing)
+	float fence_wait;		// ms, blocked on the frame's render fence
+	float input_latency;	// ms, input sampled to queue submit
+	float present_latency;	// ms, input sampled to present complete (low-latency pacing with present wait)
+	int graph_barriers;		// Image barriers recorded by the render graph last frame
+	int graph_barrier_batches;	// Dependencies they were batched into
+};
+
+// Render graph handles of the frame (see phVkEngine::initRenderGraph)
+struct FrameGraph
+{
+	// Images
+	uint32_t draw_image;
+	uint32_t depth_image;
+	uint32_t swapchain_image;
+	uint32_t background_image;	// Async compute output of the frame slot
+
+	// Passes
+	uint32_t background;		// Inline background effect
+	uint32_t background_copy;	// Async compute background copied in
+	uint32_t culling;
+	uint32_t geometry_early;
+	uint32_t hiz;
+	uint32_t culling_late;
+	uint32_t geometry;
+	uint32_t blit;
+	uint32_t imgui;
 };
 
 struct MeshNode : public Node 
@@ -96,6 +305,9 @@ struct MeshNode : public Node
 	std::shared_ptr<MeshAsset> mesh;
 
 	virtual void draw(const Mat4f& top_matrix, DrawContext& ctx) override;
+
+	// Appends a render object per surface (no recursion)
+	void addSurfaces(const Mat4f& node_matrix, DrawContext& ctx) const;
 };
 
 struct ComputePushConstants 
@@ -138,15 +350,55 @@ struct GLTFMetallicRoughness
 		VkSampler metal_rough_sampler;
 		VkBuffer data_buffer;
 		uint32_t data_buffer_offset;
+		MaterialConstants constants;	// Copied into the material buffer in bindless mode
 	};
 
-	DescriptorWriter writer;
+	// Per-material set written in one call (bindings laid out as MaterialDescriptors)
+	struct MaterialDescriptors
+	{
+		VkDescriptorBufferInfo constants;
+		VkDescriptorImageInfo color;
+		VkDescriptorImageInfo metal_rough;
+	};
+	DescriptorUpdateTemplate material_template;
+
+	// Global material set, non-null when the bindless pipelines were built
+	BindlessRegistry* bindless { nullptr };
 
+	uint32_t next_sort_id { 1 };	// MaterialInstance::sort_id (0 is the default material)
+
+	// Uses bindless pipelines if the engine's registry is valid and the shaders are available
 	void buildPipelines(phVkEngine* engine);
+
+	bool isBindless() const { return bindless != nullptr; }
+
+	// Instanced pipelines exist for every vertex format with a regular opaque pipeline
+	bool supportsInstancing() const
+	{
+		return opaque_pipeline.instanced_pipeline != VK_NULL_HANDLE &&
+			(opaque_pipeline.packed_pipeline == VK_NULL_HANDLE || opaque_pipeline.packed_instanced_pipeline != VK_NULL_HANDLE);
+	}
+
+	// Meshlet pipelines exist for every vertex format with a regular opaque pipeline
+	bool supportsMeshlets() const
+	{
+		return opaque_pipeline.meshlet_pipeline != VK_NULL_HANDLE &&
+			(opaque_pipeline.packed_pipeline == VK_NULL_HANDLE || opaque_pipeline.packed_meshlet_pipeline != VK_NULL_HANDLE);
+	}
+
+	// PackedVertex pipelines were built for every path the engine can use
+	bool supportsPackedVertices() const
+	{
+		return opaque_pipeline.packed_pipeline != VK_NULL_HANDLE &&
+			(opaque_pipeline.indirect_pipeline == VK_NULL_HANDLE || opaque_pipeline.packed_indirect_pipeline != VK_NULL_HANDLE);
+	}
 	void clearResources(VkDevice device);
 
 	MaterialInstance writeMaterial(VkDevice device, MaterialPass pass, 
 		const MaterialResources& resources, DescriptorAllocatorGrowable& descriptor_allocator);
+
+	// Frees the bindless material slot and texture references (no-op otherwise)
+	void releaseMaterial(const MaterialInstance& material);
 };
 
 
@@ -162,6 +414,10 @@ public:
 	bool stop_rendering { false };
 	bool resize_requested { false };
 
+	// Startup options (set before init)
+	bool headless { false };			// Hidden window, frames render offscreen without acquire / present
+	bool load_default_scene { true };	// Stream in assets/structure.glb
+
 	struct SDL_Window* window { nullptr };
 
 	// Extents
@@ -170,6 +426,19 @@ public:
 	VkExtent2D swapchain_extent;
 	float render_scale = { 1.f };
 
+	// Dynamic resolution: render_scale follows the GPU frame time (see updateRenderScale)
+	bool dynamic_resolution { false };
+	float target_gpu_time { 16.f };				// ms
+	float min_render_scale { 0.5f };
+	float gpu_time_estimate { 0.f };			// ms, smoothed over the frames at the current scale
+	uint64_t render_scale_frame { 0 };			// First frame rendered at the current scale
+	uint64_t render_scale_sample { 0 };			// Last profiler frame taken into the estimate
+	uint32_t render_scale_samples { 0 };		// Samples in the estimate
+
+	// Final blit filter below full resolution (CUBIC needs cubic_blit_supported)
+	VkFilter upscale_filter { VK_FILTER_LINEAR };
+	bool cubic_blit_supported { false };		// VK_EXT_filter_cubic, cubic filtering of the draw image format
+
 	// Background effects objects
 	std::vector<ComputeEffect> background_effects;
 	int current_background_effect { 0 };
@@ -178,20 +447,28 @@ public:
 	VkInstance instance;				// Vulkan library handle
 	VkDebugUtilsMessengerEXT debug_messenger;	// Vulkan debug output handle
 	VkPhysicalDevice physical_device;	// GPU chosen as the default device
+	VkPhysicalDeviceProperties physical_device_properties;	// Limits, vendor/device IDs
 	VkDevice device;					// Vulkan device for commands
 	VkSurfaceKHR surface;				// Vulkan window surface
 
 	// Swapchain objects
 	VkSwapchainKHR swapchain;			// Swapchain handle
 	VkFormat swapchain_img_format;		// Image format	
+	VkPresentModeKHR present_mode { VK_PRESENT_MODE_FIFO_KHR };			// Requested (applied on swapchain rebuild)
+	VkPresentModeKHR active_present_mode { VK_PRESENT_MODE_FIFO_KHR };	// FIFO if the request is unsupported
+	std::vector<VkPresentModeKHR> supported_present_modes;
 	std::vector<VkImage> swapchain_images;	// Image handles
 	std::vector<VkImageView> swapchain_image_views;	// Image view handles
 
 	// GPU Scene Data
 	GPUSceneData scene_data;
 
+	// Frame passes, owns the draw / depth images (transients)
+	RenderGraph render_graph;
+	FrameGraph frame_graph;
+
 	// Image resources
-	AllocatedImage draw_image;
+	AllocatedImage draw_image;		// Render graph transients (each has its own device-local allocation)
 	AllocatedImage depth_image;
 
 	AllocatedImage white_image;		// Default texture image
@@ -207,10 +484,52 @@ public:
 	MaterialInstance default_data;	// TODO: re-name?
 	GLTFMetallicRoughness metal_rough_material;
 
+	// Bindless materials (per-material descriptor sets are used when disabled or unsupported)
+	BindlessRegistry bindless_registry;
+	bool use_bindless { true };
+
+	// Bindless textures keep only their mip tail resident, larger levels stream in by screen size
+	// (full chains are uploaded when disabled or without bindless, read when a load starts)
+	TextureStreamer texture_streamer;
+	bool use_texture_streaming { true };
+
+	// GPU-driven culling (CPU IsVisible path is used when disabled or unsupported)
+	GPUCulling gpu_culling;
+	bool use_gpu_culling { true };
+
+	// Two-phase Hi-Z occlusion culling on the GPU-driven path
+	DepthPyramid depth_pyramid;
+	bool use_occlusion_culling { true };
+
+	// CPU path: record opaque draws on the job system into secondary command buffers
+	bool use_parallel_recording { true };
+
+	// CPU path: repeated opaque surfaces are drawn instanced (needs the instanced shaders)
+	bool use_instancing { true };
+
+	// CPU path: opaque full-detail surfaces go through the task / mesh shaders (per-meshlet culling)
+	bool use_mesh_shading { true };
+	bool use_bvh_culling { true };
+
 	// Queue / frame objects
-	FrameData frames[FRAME_OVERLAP];	// Use get_current_frame() to access
+	FrameData frames[MAX_FRAME_OVERLAP];	// Use get_current_frame() to access
+	uint32_t frame_overlap { 2 };		// Frames in flight (1 - MAX_FRAME_OVERLAP), see setFrameOverlap
 	VkQueue graphics_queue;				// Graphics queue handle
 	uint32_t graphics_queue_family;		// Graphics queue family
+	VkQueue transfer_queue;				// Transfer queue handle (graphics queue if no separate family)
+	uint32_t transfer_queue_family;		// Transfer queue family
+	VkQueue compute_queue;				// Async compute queue handle (graphics queue if no separate family)
+	uint32_t compute_queue_family;		// Compute queue family
+
+	// Asynchronous uploads (staging ring on the transfer queue)
+	UploadManager upload_manager;
+
+	// Compute passes on the async compute queue (background effect), inline without one
+	AsyncCompute async_compute;
+
+	// Deduplicated samplers / descriptor set layouts, and image files shared across loaded scenes
+	ResourceCache resource_cache;
+	TextureCache texture_cache;
 
 	// Immediate-submit structures
 	VkFence imm_fence;
@@ -221,28 +540,77 @@ public:
 	DescriptorAllocatorGrowable global_descriptor_allocator;
 	VkDescriptorSet draw_image_descriptors;
 	VkDescriptorSetLayout gpu_scene_data_descriptor_layout;
+	DescriptorUpdateTemplate scene_descriptor_template;	// Binding 0 from one VkDescriptorBufferInfo
 	VkDescriptorSetLayout draw_image_descriptor_layout;
 	VkDescriptorSetLayout single_image_descriptor_layout;
 
 	// Pipelines
+	PipelineCache pipeline_cache;		// Used by every pipeline build, persisted to disk
 	VkPipeline gradient_pipeline;
 	VkPipelineLayout gradient_pipeline_layout;
 	VkPipeline mesh_pipeline;
 	VkPipelineLayout mesh_pipeline_layout;
 
 	// Mesh data
+	GeometryPool geometry_pool;		// Vertex / index megabuffers for every mesh
 	std::vector<std::shared_ptr<MeshAsset>> test_meshes;
 	DrawContext main_draw_context;
-	DrawContext draw_commands;
+	DrawContext draw_commands;		// Persistent, rebuilt when objects are added / removed, moved ones patched
+	bool draw_commands_dirty { true };
+	CullingSpheres cull_spheres;		// SoA world bounds of draw_commands.opaque_surfaces
+	std::vector<CullResult> cull_results;
+	bool cull_spheres_dirty { true };
+	std::vector<SceneCullRange> scene_cull_ranges;	// Scene BVHs covering draw_commands.opaque_surfaces
+	bool use_lods { true };
+	float lod_error_pixels { 2.f };			// Largest allowed LOD error on screen
+	std::vector<uint8_t> opaque_lods;		// Current LOD of each draw_commands surface (hysteresis state)
+	std::vector<uint8_t> transparent_lods;
+	std::vector<DrawSortEntry> opaque_sort_entries;		// Sorted draw lists, kept to reuse their storage
+	std::vector<DrawSortEntry> transparent_sort_entries;
+	std::vector<DrawSortEntry> sort_scratch;
+	std::vector<InstanceBatch> instance_batches;
 	std::unordered_map<std::string, std::shared_ptr<Node>> loaded_nodes;
 
 	// GLTF scenes
 	std::unordered_map<std::string, std::shared_ptr<LoadedGLTF>> loaded_scenes;
+	std::vector<std::shared_ptr<GLTFLoadRequest>> pending_loads;	// Finalized in updateScene()
+	bool use_scene_cache { true };		// Bake loaded files to .acid_cache, later loads map the bake
+
+	// Worker threads (asset loading)
+	JobSystem jobs;
 
 	// Camera
 	Camera main_camera;
 
 	EngineStats stats;
+	uint64_t last_heap_allocations { 0 };	// HeapAllocationCount() at the start of the last frame
+	GPUProfiler gpu_profiler;			// GPU pass timings (see "GPU Profiler" window)
+	MemoryManager memory_manager;		// Heap budgets, allocation categories, defragmentation ("Memory" window)
+	bool pipeline_statistics_supported { false };
+	bool inherited_queries_supported { false };
+	bool draw_indirect_count_supported { false };			// GPU culling requirements (CPU culling otherwise)
+	bool draw_indirect_first_instance_supported { false };
+	bool mesh_shading_supported { false };		// VK_EXT_mesh_shader task + mesh shaders enabled
+	bool texture_compression_bc { false };		// Block-compressed texture families enabled on the device
+	bool texture_compression_etc2 { false };
+	bool texture_compression_astc { false };
+	bool memory_budget_supported { false };		// VK_EXT_memory_budget (VMA heap budgets from the driver)
+	PFN_vkCmdDrawMeshTasksEXT cmd_draw_mesh_tasks { nullptr };
+	bool present_wait_supported { false };		// VK_KHR_present_id + VK_KHR_present_wait enabled
+	PFN_vkWaitForPresentKHR wait_for_present { nullptr };
+
+	// Frame pacing (see FramePacing)
+	FramePacing frame_pacing { FramePacing::throughput };
+	float pacing_margin { 1.f };				// ms, extra lead before the predicted GPU-ready point
+	float cpu_frame_estimate { 0.f };			// ms, smoothed input-to-submit time
+	std::chrono::steady_clock::time_point input_time;		// Input sampled for the current frame
+	std::chrono::steady_clock::time_point last_submit_time;
+	uint64_t present_id { 0 };					// Last VK_KHR_present_id used
+	uint64_t swapchain_first_present_id { 1 };	// First ID presented to the current swapchain
+
+	// Vertex memory of every uploaded mesh, and what packing saved vs. the standard layout
+	std::atomic<size_t> vertex_memory { 0 };
+	std::atomic<size_t> vertex_memory_saved { 0 };
 
 	// Vulkan Memory Allocator (VMA)
 	VmaAllocator allocator;
@@ -254,7 +622,24 @@ public:
 
 	// *** Get Functions ***
 
-	FrameData& getCurrentFrame() { return frames[frame_number % FRAME_OVERLAP]; };
+	FrameData& getCurrentFrame() { return frames[frame_number % frame_overlap]; };
+
+	// Waits for the device and flushes every frame slot, then uses count slots (clamped)
+	void setFrameOverlap(uint32_t count);
+
+	// Start of a frame, before input is read: sleeps / waits as the pacing mode asks
+	void paceFrame();
+
+	// Dynamic resolution step, before the frame's draw_extent is computed
+	void updateRenderScale();
+	VkFilter blitFilter() const;
+	bool isGPUDriven() const { return use_gpu_culling && gpu_culling.isSupported(); };
+	bool isOcclusionCulling() const { return use_occlusion_culling && isGPUDriven() && depth_pyramid.isSupported(); };
+	bool isMeshShading() const { return use_mesh_shading && !isGPUDriven() && metal_rough_material.supportsMeshlets(); };
+	VkShaderStageFlags meshShaderStages() const 
+	{
+		return mesh_shading_supported ? VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT : 0;
+	};
 	static phVkEngine& getLoadedEngine();	// Singleton implementation
 
 
@@ -272,26 +657,62 @@ public:
 	// Draw loop
 	void draw();
 	void drawMain(VkCommandBuffer cmd);
-	void drawGeometry(VkCommandBuffer cmd);
+	void scheduleBackground();	// Background effect pass (frame's background image on async compute, else the draw image)
+	void recordBackground(VkCommandBuffer cmd, VkDescriptorSet target);
+	void drawGeometryPass(VkCommandBuffer cmd, bool early);	// Rendering instance of a geometry pass
+	void drawGeometry(VkCommandBuffer cmd, bool parallel);
+	void recordSurface(VkCommandBuffer cmd, const RenderObject& r, DrawRecordState& state,
+		const InstanceBatch* batch = nullptr, VkDeviceAddress instance_address = 0);
+	bool usesMeshlets(const RenderObject& r) const;		// Opaque, at full detail, with meshlets
+	VkDeviceAddress buildInstanceBatches(const std::vector<DrawSortEntry>& draws);	// Returns the instance buffer
+	bool isInstancing() const;
+	bool useParallelRecording() const;
+	uint32_t recordChunkCount() const;
 	void drawImgui(VkCommandBuffer cmd, VkImageView target_image_view);
 
 	// Scene
 	void updateScene();
+	void selectLODs();		// Point draw_commands at the detail level their screen size needs
+	void requestTextureMips();	// Desired mip level of every streamed texture in draw_commands
+
+	// Load a glTF scene in the background, added to loaded_scenes[name] once finished
+	void loadSceneAsync(const std::string& name, std::string_view file_path,
+		VertexFormat vertex_format = VertexFormat::standard);
 
 	// Immediate submit
 	void immediateSubmit(std::function<void(VkCommandBuffer cmd)>&& function);
 
-	// Upload a mesh to the GPU
+	// Upload a mesh to the GPU (asynchronous, see GPUMeshBuffers::upload)
 	GPUMeshBuffers uploadMesh(std::span<uint32_t> indices, std::span<Vertex> vertices);
+	GPUMeshBuffers uploadMesh(std::span<uint32_t> indices, std::span<PackedVertex> vertices);
+	// Vertices already laid out in format (baked scenes)
+	GPUMeshBuffers uploadMeshData(std::span<const uint32_t> indices, const void* vertex_data, 
+		size_t vertex_count, VertexFormat format);
+
+	// Upload a mesh's meshlets next to its geometry (asynchronous, mesh.upload is updated)
+	void uploadMeshlets(GPUMeshBuffers& mesh, const MeshletData& meshlets);
+	void uploadMeshlets(GPUMeshBuffers& mesh, std::span<const GPUMeshlet> meshlets, std::span<const uint32_t> meshlet_data);
+
+	// Return a mesh's geometry ranges to the pool (GPU must no longer use them)
+	void freeMesh(const GPUMeshBuffers& mesh);
 
 	// Images
 	AllocatedImage createImage(VkExtent3D size, VkFormat format, VkImageUsageFlags usage, bool mipmapped = false);
+	AllocatedImage createImage(VkExtent3D size, VkFormat format, VkImageUsageFlags usage, uint32_t mip_levels);
+	// Asynchronous, the image is usable once the upload manager's next flush is ready
 	AllocatedImage createImage(void* data, VkExtent3D size, VkFormat format, VkImageUsageFlags usage, bool mipmapped = false);
+	// Pre-built mip chain in data (mip_offsets: byte offset of every level, down to 1x1 if more than one)
+	AllocatedImage createImage(const void* data, VkDeviceSize data_size, VkExtent3D size, VkFormat format, 
+		VkImageUsageFlags usage, std::span<const VkDeviceSize> mip_offsets);
 	void destroyImage(const AllocatedImage& img);
+	// Format can be sampled and uploaded to (block formats need their compression family enabled)
+	bool supportsTextureFormat(VkFormat format) const;
 
 	// Buffers
-	AllocatedBuffer createBuffer(size_t alloc_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage);
+	AllocatedBuffer createBuffer(size_t alloc_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage,
+		MemoryCategory category = MemoryCategory::other);
 	void destroyBuffer(const AllocatedBuffer& buffer);
+	VkDeviceAddress getBufferAddress(VkBuffer buffer);
 
 private:
 
@@ -303,6 +724,7 @@ private:
 	// Private initializers
 	void initVulkan();
 	void initSwapchain();
+	void initRenderGraph(VkExtent3D extent);
 	void initCommands();
 	void initSyncStructures();
 	void initDescriptors();
@@ -311,4 +733,9 @@ private:
 	void initMeshPipeline();
 	void initImgui();
 	void initDefaultData();
+
+	void writeSceneDescriptor(FrameData& frame);
+
+	// Descriptor allocator counters into stats (once per frame)
+	void collectDescriptorStats();
 };
\ No newline at end of file
@@ -0,0 +1,397 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Geometry pool (shared vertex / index megabuffers)
+
+#include "phvk_geometry.h"
+
+#include "phvk_engine.h"
+
+#include <algorithm>
+
+// *** RangeAllocator ***
+
+void RangeAllocator::init(uint32_t size)
+{
+    free_by_offset.clear();
+    free_by_size.clear();
+    total_size = size;
+    free_size = 0;
+
+    insertFree(0, size);
+}
+
+bool RangeAllocator::allocate(uint32_t size, uint32_t alignment, uint32_t& offset)
+{
+    if (size == 0)
+    {
+        offset = 0;
+        return true;
+    }
+
+    // Smallest free range that fits, including alignment padding
+    for (auto it = free_by_size.lower_bound(size); it != free_by_size.end(); it++)
+    {
+        uint32_t range_size = it->first;
+        uint32_t range_offset = it->second;
+
+        uint32_t aligned = (range_offset + alignment - 1) / alignment * alignment;
+        uint32_t padding = aligned - range_offset;
+
+        if (padding + size > range_size)
+        {
+            continue;
+        }
+
+        eraseFree(free_by_offset.find(range_offset));
+
+        // Return leftovers on either side
+        if (padding > 0)
+        {
+            insertFree(range_offset, padding);
+        }
+        if (padding + size < range_size)
+        {
+            insertFree(aligned + size, range_size - padding - size);
+        }
+
+        offset = aligned;
+        return true;
+    }
+
+    return false;
+}
+
+void RangeAllocator::free(uint32_t offset, uint32_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    // Coalesce with the following range
+    auto next = free_by_offset.find(offset + size);
+    if (next != free_by_offset.end())
+    {
+        size += next->second;
+        eraseFree(next);
+    }
+
+    // Coalesce with the preceding range
+    auto prev = free_by_offset.lower_bound(offset);
+    if (prev != free_by_offset.begin())
+    {
+        prev--;
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            eraseFree(prev);
+        }
+    }
+
+    insertFree(offset, size);
+}
+
+uint32_t RangeAllocator::largestFreeRange() const
+{
+    return free_by_size.empty() ? 0 : free_by_size.rbegin()->first;
+}
+
+void RangeAllocator::insertFree(uint32_t offset, uint32_t size)
+{
+    free_by_offset[offset] = size;
+    free_by_size.emplace(size, offset);
+    free_size += size;
+}
+
+void RangeAllocator::eraseFree(std::map<uint32_t, uint32_t>::iterator it)
+{
+    auto [first, last] = free_by_size.equal_range(it->second);
+    for (auto s = first; s != last; s++)
+    {
+        if (s->second == it->first)
+        {
+            free_by_size.erase(s);
+            break;
+        }
+    }
+
+    free_size -= it->second;
+    free_by_offset.erase(it);
+}
+
+
+// *** GeometryPool ***
+
+void GeometryPool::init(phVkEngine* engine, uint32_t vertex_page_size, uint32_t index_page_count)
+{
+    this->engine = engine;
+    this->vertex_page_size = vertex_page_size;
+    this->index_page_count = index_page_count;
+
+    std::scoped_lock lock(mutex);
+    createPage(vertex_page_size, index_page_count);
+}
+
+void GeometryPool::destroy()
+{
+    std::scoped_lock lock(mutex);
+
+    for (uint32_t i = 0; i < page_count; i++)
+    {
+        if (pages[i].live())
+        {
+            engine->destroyBuffer(pages[i].vertex_buffer);
+            engine->destroyBuffer(pages[i].index_buffer);
+        }
+        pages[i] = Page();
+    }
+    page_count = 0;
+}
+
+GeometryAllocation GeometryPool::allocate(uint32_t vertex_size, uint32_t index_count)
+{
+    std::scoped_lock lock(mutex);
+
+    GeometryAllocation alloc;
+    alloc.vertex_size = vertex_size;
+    alloc.index_count = index_count;
+
+    for (uint32_t i = 0; i < page_count; i++)
+    {
+        if (allocateInPage(i, vertex_size, index_count, alloc))
+        {
+            return alloc;
+        }
+    }
+
+    // No room: add a page (at least the default size)
+    uint32_t page_index = createPage(std::max(vertex_size, vertex_page_size), std::max(index_count, index_page_count));
+    Page& page = pages[page_index];
+
+    bool allocated = page.vertex_ranges.allocate(vertex_size, VERTEX_ALIGNMENT, alloc.vertex_offset) &&
+        page.index_ranges.allocate(index_count, 1, alloc.first_index);
+    assert(allocated);
+
+    alloc.page = page_index;
+    return alloc;
+}
+
+bool GeometryPool::allocateOutside(const GeometryAllocation& allocation, GeometryAllocation& moved)
+{
+    std::scoped_lock lock(mutex);
+
+    moved = GeometryAllocation();
+    moved.vertex_size = allocation.vertex_size;
+    moved.index_count = allocation.index_count;
+
+    for (uint32_t i = 0; i < page_count; i++)
+    {
+        if (i != allocation.page && allocateInPage(i, allocation.vertex_size, allocation.index_count, moved))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GeometryPool::free(const GeometryAllocation& allocation)
+{
+    std::scoped_lock lock(mutex);
+
+    Page& page = pages[allocation.page];
+    page.vertex_ranges.free(allocation.vertex_offset, allocation.vertex_size);
+    page.index_ranges.free(allocation.first_index, allocation.index_count);
+
+    // Nothing left in an extra page, give its memory back
+    if (allocation.page != 0 &&
+        page.vertex_ranges.freeSpace() == page.vertex_ranges.capacity() &&
+        page.index_ranges.freeSpace() == page.index_ranges.capacity())
+    {
+        releasePage(allocation.page);
+    }
+}
+
+uint32_t GeometryPool::sparsestPage(float max_occupancy) const
+{
+    std::scoped_lock lock(mutex);
+
+    uint32_t best = INVALID_PAGE;
+    float best_occupancy = max_occupancy;
+    for (uint32_t i = 1; i < page_count; i++)
+    {
+        const Page& p = pages[i];
+        if (!p.live())
+        {
+            continue;
+        }
+
+        // The fuller of the two buffers decides
+        float occupancy = std::max(
+            1.f - (float)p.vertex_ranges.freeSpace() / (float)p.vertex_ranges.capacity(),
+            1.f - (float)p.index_ranges.freeSpace() / (float)std::max(p.index_ranges.capacity(), 1u));
+        if (occupancy <= best_occupancy)
+        {
+            best = i;
+            best_occupancy = occupancy;
+        }
+    }
+    return best;
+}
+
+uint32_t GeometryPool::livePageCount() const
+{
+    std::scoped_lock lock(mutex);
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < page_count; i++)
+    {
+        count += pages[i].live() ? 1 : 0;
+    }
+    return count;
+}
+
+VkDeviceSize GeometryPool::capacityBytes() const
+{
+    std::scoped_lock lock(mutex);
+
+    VkDeviceSize total = 0;
+    for (uint32_t i = 0; i < page_count; i++)
+    {
+        total += pages[i].vertex_ranges.capacity() + (VkDeviceSize)pages[i].index_ranges.capacity() * sizeof(uint32_t);
+    }
+    return total;
+}
+
+VkDeviceSize GeometryPool::usedBytes() const
+{
+    std::scoped_lock lock(mutex);
+
+    VkDeviceSize used = 0;
+    for (uint32_t i = 0; i < page_count; i++)
+    {
+        const Page& p = pages[i];
+        used += (p.vertex_ranges.capacity() - p.vertex_ranges.freeSpace()) +
+            (VkDeviceSize)(p.index_ranges.capacity() - p.index_ranges.freeSpace()) * sizeof(uint32_t);
+    }
+    return used;
+}
+
+float GeometryPool::fragmentation() const
+{
+    std::scoped_lock lock(mutex);
+
+    VkDeviceSize free_bytes = 0;
+    VkDeviceSize largest_bytes = 0;
+    for (uint32_t i = 0; i < page_count; i++)
+    {
+        const Page& p = pages[i];
+        free_bytes += p.vertex_ranges.freeSpace() + (VkDeviceSize)p.index_ranges.freeSpace() * sizeof(uint32_t);
+        largest_bytes += p.vertex_ranges.largestFreeRange() +
+            (VkDeviceSize)p.index_ranges.largestFreeRange() * sizeof(uint32_t);
+    }
+    return free_bytes > 0 ? 1.f - (float)largest_bytes / (float)free_bytes : 0.f;
+}
+
+uint32_t GeometryPool::freeRangeCount() const
+{
+    std::scoped_lock lock(mutex);
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < page_count; i++)
+    {
+        count += pages[i].vertex_ranges.freeRangeCount() + pages[i].index_ranges.freeRangeCount();
+    }
+    return count;
+}
+
+uint32_t GeometryPool::createPage(uint32_t vertex_size, uint32_t index_count)
+{
+    // Slot of a released page first
+    uint32_t count = page_count.load(std::memory_order_relaxed);
+    uint32_t index = count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (!pages[i].live())
+        {
+            index = i;
+            break;
+        }
+    }
+
+    if (index >= MAX_PAGES)
+    {
+        fmt::println("Geometry pool out of pages ({} max)", MAX_PAGES);
+        abort();
+    }
+
+    vertex_size = (vertex_size + VERTEX_ALIGNMENT - 1) / VERTEX_ALIGNMENT * VERTEX_ALIGNMENT;
+
+    Page& page = pages[index];
+
+    // Transfer source: meshes are copied out of sparse pages
+    page.vertex_buffer = engine->createBuffer(vertex_size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |   // SSBO | memory copy
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::mesh);
+    page.vertex_address = engine->getBufferAddress(page.vertex_buffer.buffer);
+
+    page.index_buffer = engine->createBuffer((size_t)index_count * sizeof(uint32_t),
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |   // Index draws | memory copy
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY, MemoryCategory::mesh);
+
+    page.vertex_ranges.init(vertex_size);
+    page.index_ranges.init(index_count);
+
+    // Publish the page to readers on other threads
+    if (index == count)
+    {
+        page_count.store(index + 1, std::memory_order_release);
+    }
+
+    return index;
+}
+
+bool GeometryPool::allocateInPage(uint32_t page_index, uint32_t vertex_size, uint32_t index_count,
+    GeometryAllocation& alloc)
+{
+    Page& page = pages[page_index];
+    if (!page.live())
+    {
+        return false;
+    }
+
+    // Both ranges must land in the same page
+    uint32_t vertex_offset;
+    if (!page.vertex_ranges.allocate(vertex_size, VERTEX_ALIGNMENT, vertex_offset))
+    {
+        return false;
+    }
+
+    uint32_t first_index;
+    if (!page.index_ranges.allocate(index_count, 1, first_index))
+    {
+        page.vertex_ranges.free(vertex_offset, vertex_size);
+        return false;
+    }
+
+    alloc.page = page_index;
+    alloc.vertex_offset = vertex_offset;
+    alloc.first_index = first_index;
+    return true;
+}
+
+void GeometryPool::releasePage(uint32_t page_index)
+{
+    Page& page = pages[page_index];
+
+    fmt::println("Geometry pool: released page {} ({:.1f} MB)", page_index,
+        (page.vertex_ranges.capacity() + (VkDeviceSize)page.index_ranges.capacity() * sizeof(uint32_t)) / (1024.f * 1024.f));
+
+    engine->destroyBuffer(page.vertex_buffer);
+    engine->destroyBuffer(page.index_buffer);
+    page = Page();
+    pages_released++;
+}
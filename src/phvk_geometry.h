@@ -0,0 +1,116 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Geometry pool (shared vertex / index megabuffers)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+class phVkEngine;
+
+// Offset allocator over a fixed range
+// Best-fit free list, neighbouring free ranges are coalesced on free
+struct RangeAllocator
+{
+    void init(uint32_t size);
+
+    // Returns false if no free range fits
+    bool allocate(uint32_t size, uint32_t alignment, uint32_t& offset);
+    void free(uint32_t offset, uint32_t size);
+
+    uint32_t capacity() const { return total_size; }
+    uint32_t freeSpace() const { return free_size; }
+    uint32_t largestFreeRange() const;
+    uint32_t freeRangeCount() const { return (uint32_t)free_by_offset.size(); }
+
+private:
+    std::map<uint32_t, uint32_t> free_by_offset;        // offset -> size
+    std::multimap<uint32_t, uint32_t> free_by_size;     // size -> offset (best-fit lookup)
+    uint32_t total_size { 0 };
+    uint32_t free_size { 0 };
+
+    void insertFree(uint32_t offset, uint32_t size);
+    void eraseFree(std::map<uint32_t, uint32_t>::iterator it);
+};
+
+// All mesh geometry lives in a few large device-local buffers. Each page holds one vertex
+// buffer (addressed through BDA) and one index buffer; meshes get ranges in both.
+// Draws only rebind the index buffer when the page changes (normally never), which also
+// allows multi-draw indirect across meshes.
+// Extra pages are released once their last range is freed (page 0 is kept), their slot is
+// reused by the next page. MemoryManager empties sparse pages by moving meshes out of them.
+// Thread-safe (loader workers allocate through uploadMesh)
+struct GeometryPool
+{
+    static constexpr uint32_t MAX_PAGES = 16;
+    static constexpr uint32_t VERTEX_ALIGNMENT = 16;    // buffer_reference alignment
+    static constexpr uint32_t INVALID_PAGE = UINT32_MAX;
+
+    struct Page
+    {
+        AllocatedBuffer vertex_buffer;
+        AllocatedBuffer index_buffer;
+        VkDeviceAddress vertex_address;
+
+        RangeAllocator vertex_ranges;   // Bytes
+        RangeAllocator index_ranges;    // Indices
+
+        bool live() const { return vertex_buffer.buffer != VK_NULL_HANDLE; }
+    };
+
+    void init(phVkEngine* engine, uint32_t vertex_page_size, uint32_t index_page_count);
+    void destroy();
+
+    // Pages are created as needed (meshes larger than a page get their own page)
+    GeometryAllocation allocate(uint32_t vertex_size, uint32_t index_count);
+
+    // Ranges for a copy of allocation in another existing page, false if none has room (no page is added)
+    bool allocateOutside(const GeometryAllocation& allocation, GeometryAllocation& moved);
+
+    // GPU must no longer use the ranges, releases the page if it ends up empty
+    void free(const GeometryAllocation& allocation);
+
+    // Live page other than page 0 with the lowest used fraction, if at most max_occupancy
+    // (INVALID_PAGE otherwise)
+    uint32_t sparsestPage(float max_occupancy) const;
+
+    VkBuffer vertexBuffer(uint32_t page) const { return pages[page].vertex_buffer.buffer; }
+    VkBuffer indexBuffer(uint32_t page) const { return pages[page].index_buffer.buffer; }
+    VkDeviceAddress vertexAddress(const GeometryAllocation& allocation) const
+    {
+        return pages[allocation.page].vertex_address + allocation.vertex_offset;
+    }
+
+    uint32_t pageCount() const { return page_count.load(std::memory_order_acquire); }     // Slots in use
+    uint32_t livePageCount() const;
+
+    // Stats (bytes)
+    VkDeviceSize capacityBytes() const;
+    VkDeviceSize usedBytes() const;
+
+    // Free space outside the largest free range of each page (0 = every page's free space is one range)
+    float fragmentation() const;
+    uint32_t freeRangeCount() const;
+    uint32_t pages_released { 0 };
+
+private:
+    phVkEngine* engine { nullptr };
+    uint32_t vertex_page_size { 0 };
+    uint32_t index_page_count { 0 };
+
+    // Fixed array so other threads can read existing pages while a new one is added
+    std::array<Page, MAX_PAGES> pages;
+    std::atomic<uint32_t> page_count { 0 };
+
+    mutable std::mutex mutex;
+
+    // Callers must hold mutex
+    uint32_t createPage(uint32_t vertex_size, uint32_t index_count);
+    bool allocateInPage(uint32_t page, uint32_t vertex_size, uint32_t index_count, GeometryAllocation& alloc);
+    void releasePage(uint32_t page);
+};
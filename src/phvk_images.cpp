@@ -44,7 +44,8 @@ void vkutil::transition_image(VkCommandBuffer cmd, VkImage image, VkImageLayout
 }
 //< transition
 //> copyimg
-void vkutil::copy_image_to_image(VkCommandBuffer cmd, VkImage source, VkImage destination, VkExtent2D srcSize, VkExtent2D dstSize)
+void vkutil::copy_image_to_image(VkCommandBuffer cmd, VkImage source, VkImage destination, VkExtent2D srcSize, VkExtent2D dstSize,
+    VkFilter filter)
 {
 	VkImageBlit2 blitRegion{ .sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2, .pNext = nullptr };
 
@@ -71,7 +72,7 @@ void vkutil::copy_image_to_image(VkCommandBuffer cmd, VkImage source, VkImage de
 	blitInfo.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 	blitInfo.srcImage = source;
 	blitInfo.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-	blitInfo.filter = VK_FILTER_LINEAR;
+	blitInfo.filter = filter;
 	blitInfo.regionCount = 1;
 	blitInfo.pRegions = &blitRegion;
 
@@ -82,71 +83,93 @@ void vkutil::copy_image_to_image(VkCommandBuffer cmd, VkImage source, VkImage de
 void vkutil::generate_mipmaps(VkCommandBuffer cmd, VkImage image, VkExtent2D imageSize)
 {
     int mipLevels = int(std::floor(std::log2(std::max(imageSize.width, imageSize.height)))) + 1;
-    for (int mip = 0; mip < mipLevels; mip++) {
 
-        VkExtent2D halfSize = imageSize;
-        halfSize.width /= 2;
-        halfSize.height /= 2;
+    // Level written by the copy (or the previous blit), read by the next blit
+    VkImageMemoryBarrier2 imageBarrier { .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2, .pNext = nullptr };
 
-        VkImageMemoryBarrier2 imageBarrier { .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2, .pNext = nullptr };
+    imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT;
+    imageBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+    imageBarrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
 
-        imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-        imageBarrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
-        imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-        imageBarrier.dstAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT;
+    imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
 
-        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    imageBarrier.subresourceRange = vkinit::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT);
+    imageBarrier.subresourceRange.levelCount = 1;
+    imageBarrier.image = image;
 
-        VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imageBarrier.subresourceRange = vkinit::image_subresource_range(aspectMask);
-        imageBarrier.subresourceRange.levelCount = 1;
-        imageBarrier.subresourceRange.baseMipLevel = mip;
-        imageBarrier.image = image;
+    VkDependencyInfo depInfo { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO, .pNext = nullptr };
+    depInfo.imageMemoryBarrierCount = 1;
+    depInfo.pImageMemoryBarriers = &imageBarrier;
+
+    for (int mip = 0; mip < mipLevels - 1; mip++) {
 
-        VkDependencyInfo depInfo { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO, .pNext = nullptr };
-        depInfo.imageMemoryBarrierCount = 1;
-        depInfo.pImageMemoryBarriers = &imageBarrier;
+        VkExtent2D halfSize = imageSize;
+        halfSize.width = std::max(halfSize.width / 2, 1u);
+        halfSize.height = std::max(halfSize.height / 2, 1u);
 
+        imageBarrier.subresourceRange.baseMipLevel = mip;
         vkCmdPipelineBarrier2(cmd, &depInfo);
 
-        if (mip < mipLevels - 1) {
-            VkImageBlit2 blitRegion { .sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2, .pNext = nullptr };
+        VkImageBlit2 blitRegion { .sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2, .pNext = nullptr };
 
-            blitRegion.srcOffsets[1].x = imageSize.width;
-            blitRegion.srcOffsets[1].y = imageSize.height;
-            blitRegion.srcOffsets[1].z = 1;
+        blitRegion.srcOffsets[1].x = imageSize.width;
+        blitRegion.srcOffsets[1].y = imageSize.height;
+        blitRegion.srcOffsets[1].z = 1;
 
-            blitRegion.dstOffsets[1].x = halfSize.width;
-            blitRegion.dstOffsets[1].y = halfSize.height;
-            blitRegion.dstOffsets[1].z = 1;
+        blitRegion.dstOffsets[1].x = halfSize.width;
+        blitRegion.dstOffsets[1].y = halfSize.height;
+        blitRegion.dstOffsets[1].z = 1;
 
-            blitRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            blitRegion.srcSubresource.baseArrayLayer = 0;
-            blitRegion.srcSubresource.layerCount = 1;
-            blitRegion.srcSubresource.mipLevel = mip;
+        blitRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blitRegion.srcSubresource.baseArrayLayer = 0;
+        blitRegion.srcSubresource.layerCount = 1;
+        blitRegion.srcSubresource.mipLevel = mip;
 
-            blitRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            blitRegion.dstSubresource.baseArrayLayer = 0;
-            blitRegion.dstSubresource.layerCount = 1;
-            blitRegion.dstSubresource.mipLevel = mip + 1;
+        blitRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blitRegion.dstSubresource.baseArrayLayer = 0;
+        blitRegion.dstSubresource.layerCount = 1;
+        blitRegion.dstSubresource.mipLevel = mip + 1;
 
-            VkBlitImageInfo2 blitInfo {.sType = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2, .pNext = nullptr};
-            blitInfo.dstImage = image;
-            blitInfo.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-            blitInfo.srcImage = image;
-            blitInfo.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-            blitInfo.filter = VK_FILTER_LINEAR;
-            blitInfo.regionCount = 1;
-            blitInfo.pRegions = &blitRegion;
+        VkBlitImageInfo2 blitInfo {.sType = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2, .pNext = nullptr};
+        blitInfo.dstImage = image;
+        blitInfo.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        blitInfo.srcImage = image;
+        blitInfo.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        blitInfo.filter = VK_FILTER_LINEAR;
+        blitInfo.regionCount = 1;
+        blitInfo.pRegions = &blitRegion;
 
-            vkCmdBlitImage2(cmd, &blitInfo);
+        vkCmdBlitImage2(cmd, &blitInfo);
 
-            imageSize = halfSize;
-        }
+        imageSize = halfSize;
     }
 
-    // transition all mip levels into the final read_only layout
-    transition_image(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // Every level into the final read_only layout in one dependency, for the shaders sampling it:
+    // blit sources (only read, nothing to make visible) and the last level, still a blit / copy destination
+    VkImageMemoryBarrier2 finalBarriers[2] = { imageBarrier, imageBarrier };
+
+    finalBarriers[0].srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT;
+    finalBarriers[0].srcAccessMask = VK_ACCESS_2_NONE;
+    finalBarriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    finalBarriers[0].subresourceRange.baseMipLevel = 0;
+    finalBarriers[0].subresourceRange.levelCount = mipLevels - 1;
+
+    finalBarriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    finalBarriers[1].subresourceRange.baseMipLevel = mipLevels - 1;
+
+    for (VkImageMemoryBarrier2& barrier : finalBarriers)
+    {
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    // Single level images have no blit sources
+    depInfo.imageMemoryBarrierCount = mipLevels > 1 ? 2 : 1;
+    depInfo.pImageMemoryBarriers = mipLevels > 1 ? finalBarriers : &finalBarriers[1];
+
+    vkCmdPipelineBarrier2(cmd, &depInfo);
 }
 //< mipgen
\ No newline at end of file
@@ -13,7 +13,9 @@ namespace vkutil
 
 void transition_image(VkCommandBuffer cmd, VkImage image, VkImageLayout currentLayout, VkImageLayout newLayout);
 
-void copy_image_to_image(VkCommandBuffer cmd, VkImage source, VkImage destination,VkExtent2D srcSize, VkExtent2D dstSize);
+// Blit between sizes, CUBIC (VK_EXT_filter_cubic) needs the source format's cubic filter feature
+void copy_image_to_image(VkCommandBuffer cmd, VkImage source, VkImage destination,VkExtent2D srcSize, VkExtent2D dstSize,
+    VkFilter filter = VK_FILTER_LINEAR);
 
 void generate_mipmaps(VkCommandBuffer cmd, VkImage image, VkExtent2D imageSize);
 
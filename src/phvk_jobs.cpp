@@ -0,0 +1,150 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Job system (worker thread pool)
+
+#include "phvk_jobs.h"
+
+#include <algorithm>
+
+void JobSystem::init(uint32_t thread_count)
+{
+    if (thread_count == 0)
+    {
+        thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    stopping = false;
+
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        workers.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+void JobSystem::shutdown()
+{
+    {
+        std::scoped_lock lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (std::thread& t : workers)
+    {
+        t.join();
+    }
+    workers.clear();
+}
+
+void JobSystem::schedule(std::function<void()>&& job, JobCounter* counter)
+{
+    if (counter)
+    {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (workers.empty())
+    {
+        // No workers (not initialized or shut down): run inline
+        Job inline_job { std::move(job), counter };
+        execute(inline_job);
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mutex);
+        push({ std::move(job), counter });
+    }
+    wake.notify_one();
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+    while (!counter.isDone())
+    {
+        // Help out instead of blocking, the outstanding jobs may be queued behind others
+        if (!runOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::runOne()
+{
+    Job job;
+    {
+        std::scoped_lock lock(mutex);
+        if (queue_count == 0)
+        {
+            return false;
+        }
+
+        job = pop();
+    }
+
+    execute(job);
+    return true;
+}
+
+void JobSystem::workerLoop()
+{
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [this]() { return stopping || queue_count > 0; });
+
+            // Drain the queue before exiting so pending counters always complete
+            if (queue_count == 0)
+            {
+                return;
+            }
+
+            job = pop();
+        }
+
+        execute(job);
+    }
+}
+
+void JobSystem::push(Job&& job)
+{
+    if (queue_count == queue.size())
+    {
+        // Full: unroll into a larger ring
+        std::vector<Job> grown(std::max<size_t>(64, queue.size() * 2));
+        for (size_t i = 0; i < queue_count; i++)
+        {
+            grown[i] = std::move(queue[(queue_head + i) % queue.size()]);
+        }
+        queue = std::move(grown);
+        queue_head = 0;
+    }
+
+    queue[(queue_head + queue_count) % queue.size()] = std::move(job);
+    queue_count++;
+}
+
+JobSystem::Job JobSystem::pop()
+{
+    Job job = std::move(queue[queue_head]);
+    queue[queue_head].function = nullptr;
+
+    queue_head = (queue_head + 1) % queue.size();
+    queue_count--;
+
+    return job;
+}
+
+void JobSystem::execute(Job& job)
+{
+    job.function();
+
+    if (job.counter)
+    {
+        job.counter->pending.fetch_sub(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,69 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Job system (worker thread pool)
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Tracks a group of scheduled jobs, done when every job has finished
+struct JobCounter
+{
+    std::atomic<uint32_t> pending { 0 };
+
+    bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+// Fixed pool of worker threads pulling from a single FIFO queue
+// Waiting threads (including the main thread) execute queued jobs instead of blocking,
+// so jobs may schedule and wait on other jobs
+struct JobSystem
+{
+    // thread_count = 0 uses one worker per hardware thread, minus the main thread
+    void init(uint32_t thread_count = 0);
+
+    // Finishes every queued job, then joins the workers
+    void shutdown();
+
+    void schedule(std::function<void()>&& job, JobCounter* counter = nullptr);
+
+    // Run jobs on the calling thread until the counter reaches zero
+    void wait(JobCounter& counter);
+
+    // Run one queued job on the calling thread, returns false if the queue was empty
+    bool runOne();
+
+    uint32_t workerCount() const { return (uint32_t)workers.size(); }
+
+private:
+    struct Job
+    {
+        std::function<void()> function;
+        JobCounter* counter { nullptr };
+    };
+
+    std::vector<std::thread> workers;
+
+    // FIFO ring buffer, doubles when full and keeps its size (no allocation per job once warmed up)
+    std::vector<Job> queue;
+    size_t queue_head { 0 };
+    size_t queue_count { 0 };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping { false };
+
+    // Queue access, mutex held
+    void push(Job&& job);
+    Job pop();
+
+    void workerLoop();
+    static void execute(Job& job);
+};
@@ -0,0 +1,216 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// KTX2 texture container (block-compressed mips uploaded as stored)
+
+#include "phvk_ktx.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+// Level data alignment in KTXTexture::data (covers every block size and the copy's 4-byte rule)
+static constexpr size_t KTX_LEVEL_ALIGNMENT = 16;
+
+// File header after the identifier (KTX 2.0 spec, section 3), up to the
+// supercompression global data (unused without supercompression)
+struct KTX2Header
+{
+    uint32_t vk_format;
+    uint32_t type_size;
+    uint32_t pixel_width;
+    uint32_t pixel_height;
+    uint32_t pixel_depth;
+    uint32_t layer_count;
+    uint32_t face_count;
+    uint32_t level_count;
+    uint32_t supercompression_scheme;
+
+    uint32_t dfd_byte_offset;
+    uint32_t dfd_byte_length;
+    uint32_t kvd_byte_offset;
+    uint32_t kvd_byte_length;
+};
+static_assert(sizeof(KTX2Header) == 52, "KTX2Header must match the file layout");
+
+// Identifier, header and the supercompression global data offset / length
+static constexpr size_t KTX2_LEVEL_INDEX_OFFSET = 80;
+
+struct KTX2Level
+{
+    uint64_t byte_offset;
+    uint64_t byte_length;
+    uint64_t uncompressed_byte_length;
+};
+
+// sRGB formats as their UNORM twin
+static VkFormat LinearFormat(VkFormat format)
+{
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_SRGB:               return VK_FORMAT_R8G8B8A8_UNORM;
+    case VK_FORMAT_BC1_RGB_SRGB_BLOCK:          return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+    case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:         return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+    case VK_FORMAT_BC2_SRGB_BLOCK:              return VK_FORMAT_BC2_UNORM_BLOCK;
+    case VK_FORMAT_BC3_SRGB_BLOCK:              return VK_FORMAT_BC3_UNORM_BLOCK;
+    case VK_FORMAT_BC7_SRGB_BLOCK:              return VK_FORMAT_BC7_UNORM_BLOCK;
+    case VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK:      return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+    case VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK:    return VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK;
+    case VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK:    return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+    default:
+        break;
+    }
+
+    // ASTC LDR formats alternate UNORM / SRGB
+    if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK &&
+        (format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) % 2 == 1)
+    {
+        return (VkFormat)(format - 1);
+    }
+
+    return format;
+}
+
+bool FormatBlockInfo(VkFormat format, uint32_t& block_width, uint32_t& block_height, uint32_t& block_bytes)
+{
+    block_width = 4;
+    block_height = 4;
+
+    switch (format)
+    {
+    case VK_FORMAT_R8G8B8A8_UNORM:
+        block_width = 1;
+        block_height = 1;
+        block_bytes = 4;
+        return true;
+
+    case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    case VK_FORMAT_BC4_UNORM_BLOCK:
+    case VK_FORMAT_BC4_SNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11_SNORM_BLOCK:
+        block_bytes = 8;
+        return true;
+
+    case VK_FORMAT_BC2_UNORM_BLOCK:
+    case VK_FORMAT_BC3_UNORM_BLOCK:
+    case VK_FORMAT_BC5_UNORM_BLOCK:
+    case VK_FORMAT_BC5_SNORM_BLOCK:
+    case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+    case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+    case VK_FORMAT_BC7_UNORM_BLOCK:
+    case VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11G11_UNORM_BLOCK:
+    case VK_FORMAT_EAC_R11G11_SNORM_BLOCK:
+        block_bytes = 16;
+        return true;
+
+    default:
+        break;
+    }
+
+    // Every ASTC block is 16 bytes, only the footprint changes
+    if (format >= VK_FORMAT_ASTC_4x4_UNORM_BLOCK && format <= VK_FORMAT_ASTC_12x12_SRGB_BLOCK)
+    {
+        static const uint8_t footprints[14][2] = {
+            { 4, 4 }, { 5, 4 }, { 5, 5 }, { 6, 5 }, { 6, 6 }, { 8, 5 }, { 8, 6 },
+            { 8, 8 }, { 10, 5 }, { 10, 6 }, { 10, 8 }, { 10, 10 }, { 12, 10 }, { 12, 12 } };
+
+        const uint32_t i = (format - VK_FORMAT_ASTC_4x4_UNORM_BLOCK) / 2;
+        block_width = footprints[i][0];
+        block_height = footprints[i][1];
+        block_bytes = 16;
+        return true;
+    }
+
+    return false;
+}
+
+bool IsKTX2(std::span<const uint8_t> bytes)
+{
+    return bytes.size() >= sizeof(KTX2_IDENTIFIER) && memcmp(bytes.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+}
+
+bool ParseKTX2(std::span<const uint8_t> bytes, KTXTexture& out)
+{
+    if (!IsKTX2(bytes) || bytes.size() < KTX2_LEVEL_INDEX_OFFSET)
+    {
+        return false;
+    }
+
+    KTX2Header header;
+    memcpy(&header, bytes.data() + sizeof(KTX2_IDENTIFIER), sizeof(header));
+
+    // *** Supported Layouts ***
+    if (header.vk_format == VK_FORMAT_UNDEFINED)
+    {
+        fmt::println("KTX2: Basis Universal texture needs a transcoder");
+        return false;
+    }
+    if (header.supercompression_scheme != 0)
+    {
+        fmt::println("KTX2: supercompression scheme {} is not supported", header.supercompression_scheme);
+        return false;
+    }
+    if (header.pixel_width == 0 || header.pixel_height == 0 || header.pixel_depth > 1 ||
+        header.layer_count > 1 || header.face_count != 1)
+    {
+        fmt::println("KTX2: only 2D textures are supported");
+        return false;
+    }
+
+    const VkFormat format = LinearFormat((VkFormat)header.vk_format);
+
+    uint32_t block_width, block_height, block_bytes;
+    if (!FormatBlockInfo(format, block_width, block_height, block_bytes))
+    {
+        fmt::println("KTX2: format {} is not supported", header.vk_format);
+        return false;
+    }
+
+    // Level 0 only means "generate the mips", which isn't possible for block formats
+    const uint32_t full_chain = (uint32_t)std::floor(std::log2(std::max(header.pixel_width, header.pixel_height))) + 1;
+    const uint32_t level_count = std::min(std::max(header.level_count, 1u), full_chain);
+
+    const size_t level_index = KTX2_LEVEL_INDEX_OFFSET;
+    if (bytes.size() < level_index + level_count * sizeof(KTX2Level))
+    {
+        return false;
+    }
+
+    // *** Levels ***
+    // Stored smallest first in the file, the level index lists them from mip 0
+    out.format = format;
+    out.width = header.pixel_width;
+    out.height = header.pixel_height;
+    out.data.clear();
+    out.mip_offsets.clear();
+
+    for (uint32_t level = 0; level < level_count; level++)
+    {
+        KTX2Level entry;
+        memcpy(&entry, bytes.data() + level_index + level * sizeof(KTX2Level), sizeof(entry));
+
+        const uint64_t blocks_x = (std::max(out.width >> level, 1u) + block_width - 1) / block_width;
+        const uint64_t blocks_y = (std::max(out.height >> level, 1u) + block_height - 1) / block_height;
+        const uint64_t level_size = blocks_x * blocks_y * block_bytes;
+
+        if (entry.byte_length < level_size || entry.byte_offset > bytes.size() ||
+            level_size > bytes.size() - entry.byte_offset)
+        {
+            fmt::println("KTX2: level {} is truncated", level);
+            return false;
+        }
+
+        out.data.resize((out.data.size() + KTX_LEVEL_ALIGNMENT - 1) & ~(KTX_LEVEL_ALIGNMENT - 1));
+        out.mip_offsets.push_back(out.data.size());
+        out.data.insert(out.data.end(), bytes.data() + entry.byte_offset, bytes.data() + entry.byte_offset + level_size);
+    }
+
+    return true;
+}
@@ -0,0 +1,32 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// KTX2 texture container (block-compressed mips uploaded as stored)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <span>
+#include <vector>
+
+// Texels of a supported KTX2 file, every level 16-byte aligned for the buffer to image copies
+struct KTXTexture
+{
+    VkFormat format { VK_FORMAT_UNDEFINED };
+    uint32_t width { 0 };
+    uint32_t height { 0 };
+    std::vector<uint8_t> data;
+    std::vector<VkDeviceSize> mip_offsets;      // Byte offset of each level in data, from mip 0
+};
+
+// True if bytes start with the KTX2 identifier
+bool IsKTX2(std::span<const uint8_t> bytes);
+
+// Parse a 2D, single layer / face KTX2 file stored in a Vulkan format (no supercompression)
+// Basis Universal payloads (BasisLZ / UASTC) and zstd / zlib levels need a transcoder and are rejected
+// sRGB formats are returned as their UNORM twin (color textures are sampled as UNORM, like the stb path)
+bool ParseKTX2(std::span<const uint8_t> bytes, KTXTexture& out);
+
+// Texel block of a KTX2-loadable format (1x1 for uncompressed), false if the format isn't handled
+bool FormatBlockInfo(VkFormat format, uint32_t& block_width, uint32_t& block_height, uint32_t& block_bytes);
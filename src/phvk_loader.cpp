@@ -9,6 +9,8 @@
 #include <iostream>
 
 #include "phvk_loader.h"
+#include "phvk_scene_cache.h"
+#include "phvk_ktx.h"
 
 #include "phvk_engine.h"
 #include "phvk_initializers.h"
@@ -21,51 +23,92 @@
 #include <fastgltf/util.hpp>
 
 #include <variant>
-
-std::optional<AllocatedImage> LoadImage(phVkEngine* engine, fastgltf::Asset& asset, fastgltf::Image& image)
+#include <thread>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+// Decode an encoded image (KTX2 or anything stb_image reads) into a full mip chain
+// KTX2 levels are kept as stored if the device can sample their format, other images get
+// their mips built on the CPU (texels holds the chain, baked describes it)
+static bool DecodeImage(phVkEngine* engine, std::span<const uint8_t> bytes, std::vector<uint8_t>& texels, 
+    BakedImage& baked)
 {
-    AllocatedImage new_image{};
+    if (IsKTX2(bytes))
+    {
+        KTXTexture ktx;
+        if (!ParseKTX2(bytes, ktx))
+        {
+            return false;
+        }
+        if (!engine->supportsTextureFormat(ktx.format))
+        {
+            fmt::println("KTX2: format {} is not supported by the device", (uint32_t)ktx.format);
+            return false;
+        }
+
+        texels = std::move(ktx.data);
+        baked.format = ktx.format;
+        baked.width = ktx.width;
+        baked.height = ktx.height;
+        baked.mip_offsets = std::move(ktx.mip_offsets);
+        baked.texels = texels;
+        return true;
+    }
 
     int width, height, num_channels;
+    unsigned char* data = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), 
+        &width, &height, &num_channels, 4);
+    if (!data)
+    {
+        return false;
+    }
+
+    texels.clear();
+    BuildMipChain(data, (uint32_t)width, (uint32_t)height, texels, baked.mip_offsets);
+    stbi_image_free(data);
+
+    baked.format = VK_FORMAT_R8G8B8A8_UNORM;
+    baked.width = (uint32_t)width;
+    baked.height = (uint32_t)height;
+    baked.texels = texels;
+    return true;
+}
+
+// Queue the upload of a decoded image with every mip as stored
+static AllocatedImage UploadImage(phVkEngine* engine, const BakedImage& image)
+{
+    return engine->createImage(image.texels.data(), image.texels.size(), VkExtent3D { image.width, image.height, 1 },
+        image.format, VK_IMAGE_USAGE_SAMPLED_BIT, image.mip_offsets);
+}
+
+// Decode a glTF image on the CPU, false if any of the attempts failed
+bool LoadImage(phVkEngine* engine, fastgltf::Asset& asset, fastgltf::Image& image,
+    std::vector<uint8_t>& texels, BakedImage& baked)
+{
+    bool decoded = false;
 
     std::visit(
         fastgltf::visitor{
             [](auto& arg) {},
             [&](fastgltf::sources::URI& filePath) {
-                assert(filePath.fileByteOffset == 0);   // We don't support offsets with stbi.
+                assert(filePath.fileByteOffset == 0);   // We don't support offsets.
                 assert(filePath.uri.isLocalPath());     // We're only capable of loading
                                                         // local files.
 
                 const std::string path(filePath.uri.path().begin(),
                     filePath.uri.path().end()); // Thanks C++.
-                unsigned char* data = stbi_load(path.c_str(), &width, &height, &num_channels, 4);
-                if (data) {
-                    VkExtent3D imagesize;
-                    imagesize.width = width;
-                    imagesize.height = height;
-                    imagesize.depth = 1;
 
-                    new_image = engine->createImage(data, imagesize, 
-                        VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT,false);
-
-                    stbi_image_free(data);
+                std::ifstream file(path, std::ios::binary);
+                std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                if (!bytes.empty()) {
+                    decoded = DecodeImage(engine, bytes, texels, baked);
                 }
                 },
                 [&](fastgltf::sources::Vector& vector) {
-                    unsigned char* data = stbi_load_from_memory(
-                        reinterpret_cast<const stbi_uc *>(vector.bytes.data()), 
-                        static_cast<int>(vector.bytes.size()),
-                        &width, &height, &num_channels, 4);
-                    if (data) {
-                        VkExtent3D imagesize;
-                        imagesize.width = width;
-                        imagesize.height = height;
-                        imagesize.depth = 1;
-
-                        new_image = engine->createImage(data, imagesize, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT,false);
-
-                        stbi_image_free(data);
-                    }
+                    decoded = DecodeImage(engine, std::span<const uint8_t>(
+                        reinterpret_cast<const uint8_t*>(vector.bytes.data()), vector.bytes.size()), texels, baked);
                 },
                 [&](fastgltf::sources::BufferView& view) {
                     auto& bufferView = asset.bufferViews[view.bufferViewIndex];
@@ -76,40 +119,214 @@ std::optional<AllocatedImage> LoadImage(phVkEngine* engine, fastgltf::Asset& ass
                         // are already loaded into a vector.
                 [](auto& arg) {},
                 [&](fastgltf::sources::Vector& vector) {
-                    unsigned char* data = stbi_load_from_memory(
-                        reinterpret_cast<const stbi_uc*>(vector.bytes.data()) + bufferView.byteOffset,
-                        static_cast<int>(bufferView.byteLength),
-                        &width, &height, &num_channels, 4);
-                    if (data) {
-                        VkExtent3D imagesize;
-                        imagesize.width = width;
-                        imagesize.height = height;
-                        imagesize.depth = 1;
-
-                        new_image = engine->createImage(data, imagesize, VK_FORMAT_R8G8B8A8_UNORM,
-                            VK_IMAGE_USAGE_SAMPLED_BIT,false);
-
-                        stbi_image_free(data);
-                    }
+                    decoded = DecodeImage(engine, std::span<const uint8_t>(
+                        reinterpret_cast<const uint8_t*>(vector.bytes.data()) + bufferView.byteOffset,
+                        bufferView.byteLength), texels, baked);
                 } },
                 buffer.data);
                 },
         },
         image.data);
 
-    // if any of the attempts to load the data failed, we havent written the image
-    // so handle is null
-    if (new_image.image == VK_NULL_HANDLE) 
+    return decoded;
+}
+
+Bounds ComputeBounds(std::span<const Vertex> vertices)
+{
+    Bounds bounds{};
+
+    if (vertices.empty())
     {
-        return {};
+        return bounds;
     }
-    else 
+
+    Vec3f min_pos = vertices[0].position;
+    Vec3f max_pos = vertices[0].position;
+
+    for (const Vertex& v : vertices)
+    {
+        min_pos = Vec3f(std::min(min_pos.x, v.position.x), 
+            std::min(min_pos.y, v.position.y), 
+            std::min(min_pos.z, v.position.z));
+        max_pos = Vec3f(std::max(max_pos.x, v.position.x), 
+            std::max(max_pos.y, v.position.y), 
+            std::max(max_pos.z, v.position.z));
+    }
+
+    bounds.origin = Vec3f((max_pos.x + min_pos.x) * 0.5f, 
+        (max_pos.y + min_pos.y) * 0.5f, 
+        (max_pos.z + min_pos.z) * 0.5f);
+    bounds.extents = Vec3f((max_pos.x - min_pos.x) * 0.5f, 
+        (max_pos.y - min_pos.y) * 0.5f, 
+        (max_pos.z - min_pos.z) * 0.5f);
+    bounds.sphere_radius = std::sqrt(bounds.extents.x * bounds.extents.x + 
+        bounds.extents.y * bounds.extents.y + 
+        bounds.extents.z * bounds.extents.z);
+
+    return bounds;
+}
+
+// Float to IEEE half (round to nearest)
+static uint16_t FloatToHalf(float f)
+{
+    uint32_t x;
+    memcpy(&x, &f, sizeof(x));
+
+    uint32_t sign = (x >> 16) & 0x8000;
+    int32_t exp = (int32_t)((x >> 23) & 0xff) - 127 + 15;
+    uint32_t mant = x & 0x7fffff;
+
+    if (((x >> 23) & 0xff) == 0xff)
+    {
+        return (uint16_t)(sign | 0x7c00 | (mant ? 0x200 : 0));    // Inf / NaN
+    }
+    if (exp >= 31)
+    {
+        return (uint16_t)(sign | 0x7c00);                         // Overflow to Inf
+    }
+    if (exp <= 0)
+    {
+        // Subnormal (or zero)
+        if (exp < -10)
+        {
+            return (uint16_t)sign;
+        }
+
+        mant |= 0x800000;
+        uint32_t shift = 14 - exp;
+        uint32_t h = mant >> shift;
+        if ((mant >> (shift - 1)) & 1)
+        {
+            h++;
+        }
+        return (uint16_t)(sign | h);
+    }
+
+    // Rounding may carry into the exponent, which is still correct
+    uint32_t h = sign | ((uint32_t)exp << 10) | (mant >> 13);
+    if (mant & 0x1000)
+    {
+        h++;
+    }
+    return (uint16_t)h;
+}
+
+static uint16_t QuantizeUnorm16(float v)
+{
+    return (uint16_t)std::lround(std::clamp(v, 0.f, 1.f) * 65535.f);
+}
+
+static int8_t QuantizeSnorm8(float v)
+{
+    return (int8_t)std::lround(std::clamp(v, -1.f, 1.f) * 127.f);
+}
+
+static uint32_t PackUnorm4x8(const Vec4f& v)
+{
+    auto q = [](float c) { return (uint32_t)std::lround(std::clamp(c, 0.f, 1.f) * 255.f); };
+    return q(v.x) | (q(v.y) << 8) | (q(v.z) << 16) | (q(v.w) << 24);
+}
+
+void PackVertices(std::span<const Vertex> vertices, const Bounds& bounds, std::span<PackedVertex> out)
+{
+    assert(out.size() >= vertices.size());
+
+    // Quantize across the bounds AABB (degenerate axes map everything to the origin)
+    float inv_size[3];
+    const float extents[3] = { bounds.extents.x, bounds.extents.y, bounds.extents.z };
+    for (int a = 0; a < 3; a++)
+    {
+        inv_size[a] = extents[a] > 0.f ? 1.f / (2.f * extents[a]) : 0.f;
+    }
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        const Vertex& v = vertices[i];
+        PackedVertex& p = out[i];
+
+        p.position[0] = QuantizeUnorm16((v.position.x - bounds.origin.x + extents[0]) * inv_size[0]);
+        p.position[1] = QuantizeUnorm16((v.position.y - bounds.origin.y + extents[1]) * inv_size[1]);
+        p.position[2] = QuantizeUnorm16((v.position.z - bounds.origin.z + extents[2]) * inv_size[2]);
+
+        // Octahedral normal: project onto the octahedron, fold the lower hemisphere
+        float nx = v.normal.x, ny = v.normal.y, nz = v.normal.z;
+        float l1 = std::abs(nx) + std::abs(ny) + std::abs(nz);
+        if (l1 > 0.f)
+        {
+            nx /= l1;
+            ny /= l1;
+            nz /= l1;
+        }
+        if (nz < 0.f)
+        {
+            float fx = (1.f - std::abs(ny)) * (nx >= 0.f ? 1.f : -1.f);
+            float fy = (1.f - std::abs(nx)) * (ny >= 0.f ? 1.f : -1.f);
+            nx = fx;
+            ny = fy;
+        }
+        p.normal[0] = QuantizeSnorm8(nx);
+        p.normal[1] = QuantizeSnorm8(ny);
+
+        p.uv[0] = FloatToHalf(v.uv_x);
+        p.uv[1] = FloatToHalf(v.uv_y);
+
+        p.color = PackUnorm4x8(v.color);
+    }
+}
+
+// Upload a mesh in the requested format, packed meshes are quantized per surface
+// (surface_first_vertex[i] is where surface i's vertices start), meshlets are uploaded if there are any
+// vertex_bytes (optional) receives the vertices as uploaded
+static GPUMeshBuffers UploadMeshAs(phVkEngine* engine, VertexFormat format, std::vector<uint32_t>& indices,
+    std::vector<Vertex>& vertices, const std::vector<GeoSurface>& surfaces, const std::vector<size_t>& surface_first_vertex,
+    const MeshletData& meshlets, std::vector<uint8_t>* vertex_bytes = nullptr)
+{
+    if (format != VertexFormat::packed)
+    {
+        if (vertex_bytes)
+        {
+            vertex_bytes->assign((const uint8_t*)vertices.data(), (const uint8_t*)(vertices.data() + vertices.size()));
+        }
+
+        GPUMeshBuffers mesh = engine->uploadMesh(indices, vertices);
+        engine->uploadMeshlets(mesh, meshlets);
+        return mesh;
+    }
+
+    std::vector<PackedVertex> packed(vertices.size());
+    for (size_t i = 0; i < surfaces.size(); i++)
+    {
+        size_t first = surface_first_vertex[i];
+        size_t last = (i + 1 < surfaces.size()) ? surface_first_vertex[i + 1] : vertices.size();
+
+        PackVertices(std::span<const Vertex>(vertices).subspan(first, last - first), surfaces[i].bounds,
+            std::span<PackedVertex>(packed).subspan(first, last - first));
+    }
+
+    if (vertex_bytes)
     {
-        return new_image;
+        vertex_bytes->assign((const uint8_t*)packed.data(), (const uint8_t*)(packed.data() + packed.size()));
     }
+
+    GPUMeshBuffers mesh = engine->uploadMesh(indices, packed);
+    engine->uploadMeshlets(mesh, meshlets);
+    return mesh;
 }
 
-std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGLTFMeshes(phVkEngine* engine, std::filesystem::path file_path)
+// Append simplified index ranges for every surface (after all surfaces are loaded,
+// so the original ranges stay contiguous)
+static void BuildMeshLODs(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+    std::vector<GeoSurface>& surfaces)
+{
+    for (GeoSurface& s : surfaces)
+    {
+        s.lod_count = BuildSurfaceLODs(vertices, indices, s.start_index, s.count,
+            s.bounds.origin, s.bounds.sphere_radius, s.lods);
+    }
+}
+
+std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGLTFMeshes(phVkEngine* engine, std::filesystem::path file_path,
+    VertexFormat vertex_format)
 {
     // TODO: switch to {fmt} (doesn't work for some reason?)
     //fmt::print("Loading glTF: ", file_path.string(), "\n");
@@ -151,6 +368,8 @@ std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGLTFMeshes(phVkEngine
 
         indices.clear();
         vertices.clear();
+        std::vector<size_t> surface_first_vertex;
+        MeshletData meshlets;
 
         for (auto&& p : mesh.primitives) {
             GeoSurface new_surface;
@@ -158,6 +377,7 @@ std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGLTFMeshes(phVkEngine
             new_surface.count = (uint32_t)gltf.accessors[p.indicesAccessor.value()].count;
 
             size_t initial_vert = vertices.size();
+            surface_first_vertex.push_back(initial_vert);
 
             // Load indexes
             {
@@ -222,6 +442,17 @@ std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGLTFMeshes(phVkEngine
 						vertices[initial_vert + index].color = Vec4f(v.x, v.y, v.z, v.w);
                     });
             }
+
+            // Bounds of this primitive only
+            new_surface.bounds = ComputeBounds(std::span<const Vertex>(vertices).subspan(initial_vert));
+
+            if (engine->mesh_shading_supported)
+            {
+                new_surface.first_meshlet = BuildMeshlets(vertices, 
+                    std::span<const uint32_t>(indices).subspan(new_surface.start_index, new_surface.count), true, meshlets);
+                new_surface.meshlet_count = (uint32_t)meshlets.meshlets.size() - new_surface.first_meshlet;
+            }
+
             new_mesh.surfaces.push_back(new_surface);
         }
 
@@ -232,7 +463,10 @@ std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGLTFMeshes(phVkEngine
                 vert.color = Vec4f(vert.normal, 1.f);
             }
         }
-        new_mesh.mesh_buffers = engine->uploadMesh(indices, vertices);
+        BuildMeshLODs(vertices, indices, new_mesh.surfaces);
+
+        new_mesh.mesh_buffers = UploadMeshAs(engine, vertex_format, indices, vertices, 
+            new_mesh.surfaces, surface_first_vertex, meshlets);
 
         meshes.emplace_back(std::make_shared<MeshAsset>(std::move(new_mesh)));
     }
@@ -276,28 +510,155 @@ VkSamplerMipmapMode extract_mipmap_mode(fastgltf::Filter filter)
 }
 //< filters
 
-std::optional<std::shared_ptr<LoadedGLTF>> LoadGLTF(phVkEngine* engine, std::string_view file_path)
+// Fall back to the standard layout when the packed pipelines could not be built
+static VertexFormat SupportedVertexFormat(phVkEngine* engine, VertexFormat format)
 {
-    fmt::print("Loading GLTF: {}", file_path);
-	fmt::print("\n");
+    if (format == VertexFormat::packed && !engine->metal_rough_material.supportsPackedVertices())
+    {
+        fmt::println("Packed vertex shaders unavailable, loading with the standard vertex format");
+        return VertexFormat::standard;
+    }
+    return format;
+}
 
-    std::shared_ptr<LoadedGLTF> scene = std::make_shared<LoadedGLTF>();
-    scene->creator = engine;
-    LoadedGLTF& file = *scene.get();
+// Uploaded arrays of one mesh, kept for the scene cache
+struct MeshBake
+{
+    std::vector<uint8_t> vertices;
+    std::vector<uint32_t> indices;
+    MeshletData meshlets;
+};
 
-    fastgltf::Parser parser{};
+// Intermediate state shared by the jobs of one glTF load
+// (vectors are indexed like the matching glTF arrays)
+struct GLTFLoadState
+{
+    std::filesystem::path path;
+    VertexFormat vertex_format;
+    fastgltf::Asset gltf;
 
-    constexpr auto gltf_options = 
-        fastgltf::Options::DontRequireValidAssetMember | fastgltf::Options::AllowDouble | 
-        fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers;
-    // fastgltf::Options::LoadExternalImages;
+    std::vector<std::shared_ptr<MeshAsset>> meshes;
+    std::vector<std::shared_ptr<Node>> nodes;
+    std::vector<std::optional<AllocatedImage>> images;
+    std::vector<std::shared_ptr<GLTFMaterial>> materials;
 
-    //fastgltf::GltfDataBuffer data;
-    auto data = fastgltf::GltfDataBuffer::FromPath(file_path);
+    // Scene read from the cache, or captured while loading the source (materials are always
+    // filled, FinalizeGLTF writes them from here)
+    BakedScene baked;
+    bool write_cache { false };
+    bool stream_textures { false };                     // Images stay on the CPU, FinalizeGLTF creates streamed textures
+    std::vector<std::shared_ptr<const void>> image_owners;      // Keep baked.images texels alive (capture / streaming)
+    std::vector<std::shared_ptr<SharedTexture>> shared_images;  // TextureCache entries of external image files
+    std::vector<int32_t> image_fallbacks;               // Regular source of a KTX2 texture image, or -1
+    std::vector<uint8_t> image_decoded;
+    std::vector<MeshBake> mesh_bakes;                   // Arrays behind baked.meshes (capture only)
+
+    JobCounter jobs;
+};
+
+// Decoded (uploaded, or kept on the CPU for streaming)
+static bool ImageLoaded(const GLTFLoadState& state, size_t i)
+{
+    return state.images[i].has_value() || !state.baked.images[i].texels.empty();
+}
 
-    fastgltf::Asset gltf;
+// Streamer source of a decoded image (owner keeps its texels alive)
+static TextureSource StreamSource(const BakedImage& image, std::shared_ptr<const void> owner)
+{
+    TextureSource source;
+    source.format = image.format;
+    source.width = image.width;
+    source.height = image.height;
+    source.mip_offsets = image.mip_offsets;
+    source.texels = image.texels;
+    source.owner = std::move(owner);
+    return source;
+}
 
-    std::filesystem::path path = file_path;
+// Canonical path of an image stored in its own file (TextureCache key), empty if embedded
+static std::string ImageFileKey(const fastgltf::Image& image)
+{
+    const fastgltf::sources::URI* file_path = std::get_if<fastgltf::sources::URI>(&image.data);
+    if (!file_path || !file_path->uri.isLocalPath())
+    {
+        return {};
+    }
+
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::weakly_canonical(
+        std::string(file_path->uri.path().begin(), file_path->uri.path().end()), error);
+    return error ? std::string() : path.string();
+}
+
+// Publish an image this load decoded (or read from its bake) to its cache entry
+static void PublishSharedImage(GLTFLoadState& state, size_t i)
+{
+    SharedTexture& shared = *state.shared_images[i];
+    shared.failed = !ImageLoaded(state, i);
+    shared.image = state.baked.images[i];
+    shared.texels_owner = state.image_owners[i];
+    shared.gpu_image = state.images[i];
+    shared.decoded.store(true, std::memory_order_release);
+}
+
+// Wait until the load that owns the cache entry has published it, then take its GPU image,
+// or its CPU chain if it's streamed (a bake has its own copy in the mapping)
+// Idempotent, also fine for entries this load published
+static void ResolveSharedImage(phVkEngine* engine, GLTFLoadState& state, size_t i)
+{
+    const SharedTexture& shared = *state.shared_images[i];
+    while (!shared.decoded.load(std::memory_order_acquire))
+    {
+        if (!engine->jobs.runOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    if (shared.failed)
+    {
+        return;
+    }
+
+    state.images[i] = shared.gpu_image;
+
+    BakedImage& baked = state.baked.images[i];
+    if (!baked.texels.empty())
+    {
+        return;
+    }
+
+    if (std::shared_ptr<const void> owner = shared.texels_owner.lock())
+    {
+        const std::string name = baked.name;
+        baked = shared.image;
+        baked.name = name;
+        state.image_owners[i] = std::move(owner);
+    }
+    else if (state.write_cache)
+    {
+        // GPU image is shared, but the bake needs the texels (the owner dropped its copy)
+        std::vector<uint8_t> texels;
+        if (LoadImage(engine, state.gltf, state.gltf.images[i], texels, baked))
+        {
+            state.image_owners[i] = std::make_shared<std::vector<uint8_t>>(std::move(texels));
+        }
+    }
+}
+
+// load_buffers: false keeps the buffer sources as they are in the file (URIs of external buffers)
+static bool ParseGLTF(const std::filesystem::path& path, fastgltf::Asset& gltf, bool load_buffers = true)
+{
+    // KTX2 texture sources (Texture::basisuImageIndex), files that require it would fail to parse otherwise
+    fastgltf::Parser parser(fastgltf::Extensions::KHR_texture_basisu);
+
+    constexpr auto base_options = fastgltf::Options::DontRequireValidAssetMember | fastgltf::Options::AllowDouble;
+    const auto gltf_options = load_buffers ? 
+        base_options | fastgltf::Options::LoadGLBBuffers | fastgltf::Options::LoadExternalBuffers : base_options;
+    // fastgltf::Options::LoadExternalImages;
+
+    //fastgltf::GltfDataBuffer data;
+    auto data = fastgltf::GltfDataBuffer::FromPath(path);
 
     auto type = fastgltf::determineGltfFileType(data.get());
     if (type == fastgltf::GltfType::glTF) 
@@ -311,7 +672,7 @@ std::optional<std::shared_ptr<LoadedGLTF>> LoadGLTF(phVkEngine* engine, std::str
         else 
         {
             std::cerr << "Failed to load glTF: " << fastgltf::to_underlying(load.error()) << std::endl;
-            return {};
+            return false;
         }
     }
     else if (type == fastgltf::GltfType::GLB) 
@@ -325,235 +686,567 @@ std::optional<std::shared_ptr<LoadedGLTF>> LoadGLTF(phVkEngine* engine, std::str
         else 
         {
             std::cerr << "Failed to load glTF: " << fastgltf::to_underlying(load.error()) << std::endl;
-            return {};
+            return false;
         }
     }
     else 
     {
         std::cerr << "Failed to determine glTF container" << std::endl;
-        return {};
+        return false;
     }
 
-    // We can stimate the descriptors we will need accurately
-    std::vector<DescriptorAllocatorGrowable::PoolSizeRatio> sizes = { 
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3 },
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 },
-        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 } };
+    return true;
+}
 
-    file.descriptor_pool.init(engine->device, gltf.materials.size(), sizes);
+// Build the vertex / index arrays of one mesh and queue its upload (runs on a worker)
+// bake / baked (optional) capture the uploaded mesh for the scene cache
+static void LoadMesh(phVkEngine* engine, fastgltf::Asset& gltf, fastgltf::Mesh& mesh, MeshAsset& new_mesh,
+    const std::vector<std::shared_ptr<GLTFMaterial>>& materials, VertexFormat vertex_format,
+    MeshBake* bake = nullptr, BakedMesh* baked = nullptr)
+{
+    std::vector<uint32_t> indices;
+    std::vector<Vertex> vertices;
+    std::vector<size_t> surface_first_vertex;
+    std::vector<int32_t> surface_materials;
+    MeshletData meshlets;
 
-    // Load samplers
-    for (fastgltf::Sampler& sampler : gltf.samplers)
+    for (auto&& p : mesh.primitives) 
     {
+        GeoSurface newSurface;
+        newSurface.start_index = (uint32_t)indices.size();
+        newSurface.count = (uint32_t)gltf.accessors[p.indicesAccessor.value()].count;
 
-        VkSamplerCreateInfo sampl = {
-            .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO, .pNext = nullptr };
-        sampl.maxLod = VK_LOD_CLAMP_NONE;
-        sampl.minLod = 0;
+        size_t initial_vtx = vertices.size();
+        surface_first_vertex.push_back(initial_vtx);
 
-        sampl.magFilter = ExtractFilter(sampler.magFilter.value_or(fastgltf::Filter::Nearest));
-        sampl.minFilter = ExtractFilter(sampler.minFilter.value_or(fastgltf::Filter::Nearest));
+        // load indexes
+        {
+            fastgltf::Accessor& indexaccessor = gltf.accessors[p.indicesAccessor.value()];
+            indices.reserve(indices.size() + indexaccessor.count);
+
+            fastgltf::iterateAccessor<std::uint32_t>(gltf, indexaccessor,
+                [&](std::uint32_t idx) 
+                {
+                    indices.push_back(idx + initial_vtx);
+                });
+        }
 
-        sampl.mipmapMode = extract_mipmap_mode(sampler.minFilter.value_or(fastgltf::Filter::Nearest));
+        // load vertex positions
+        {
+            fastgltf::Accessor& posAccessor = gltf.accessors[p.findAttribute("POSITION")->accessorIndex];
+            vertices.resize(vertices.size() + posAccessor.count);
+
+            fastgltf::iterateAccessorWithIndex<Vec3f>(gltf, posAccessor,
+                [&](Vec3f v, size_t index) 
+                {
+                    Vertex new_vtx;
+                    new_vtx.position = v;
+                    new_vtx.normal = { 1, 0, 0 };
+                    new_vtx.color = Vec4f(1.f, 1.f, 1.f, 1.f);
+                    new_vtx.uv_x = 0;
+                    new_vtx.uv_y = 0;
+                    vertices[initial_vtx + index] = new_vtx;
+                });
+        }
 
-        VkSampler new_sampler;
-        vkCreateSampler(engine->device, &sampl, nullptr, &new_sampler);
+        // load vertex normals
+        auto normals = p.findAttribute("NORMAL");
+        if (normals != p.attributes.end()) 
+        {
+            fastgltf::iterateAccessorWithIndex<Vec3f>(gltf, gltf.accessors[(*normals).accessorIndex],
+                [&](Vec3f v, size_t index) 
+                {
+                    vertices[initial_vtx + index].normal = v;
+                });
+        }
 
-        file.samplers.push_back(new_sampler);
-    }
+        // load UVs
+        auto uv = p.findAttribute("TEXCOORD_0");
+        if (uv != p.attributes.end()) {
 
-    // Temporal arrays for all the objects to use while creating the GLTF data
-    std::vector<std::shared_ptr<MeshAsset>> meshes;
-    std::vector<std::shared_ptr<Node>> nodes;
-    std::vector<AllocatedImage> images;
-    std::vector<std::shared_ptr<GLTFMaterial>> materials;
+            fastgltf::iterateAccessorWithIndex<Vec2f>(gltf, gltf.accessors[(*uv).accessorIndex],
+                [&](Vec2f v, size_t index) 
+                {
+                    vertices[initial_vtx + index].uv_x = v.x;
+                    vertices[initial_vtx + index].uv_y = v.y;
+                });
+        }
 
-    // load all textures
-    for (fastgltf::Image& image : gltf.images) 
-    {
-        std::optional<AllocatedImage> img = LoadImage(engine, gltf, image);
+        // load vertex colors
+        auto colors = p.findAttribute("COLOR_0");
+        if (colors != p.attributes.end()) 
+        {
+            fastgltf::iterateAccessorWithIndex<Vec4f>(gltf, gltf.accessors[(*colors).accessorIndex],
+                [&](Vec4f v, size_t index) 
+                {
+                    vertices[initial_vtx + index].color = v;
+                });
+        }
 
-        if (img.has_value()) 
+        // Material data is written later on the main thread (FinalizeGLTF),
+        // the shared pointers already exist
+        if (p.materialIndex.has_value()) 
         {
-            images.push_back(*img);
-            file.images[image.name.c_str()] = *img;
+            newSurface.material = materials[p.materialIndex.value()];
+            surface_materials.push_back((int32_t)p.materialIndex.value());
         }
         else 
         {
-            // we failed to load, so lets give the slot a default white texture to not
-            // completely break loading
-            images.push_back(engine->error_checkerboard_image);
-            std::cout << "gltf failed to load texture " << image.name << std::endl;
+            newSurface.material = materials[0];
+            surface_materials.push_back(0);
         }
+
+        // Bounds of this primitive only
+        newSurface.bounds = ComputeBounds(std::span<const Vertex>(vertices).subspan(initial_vtx));
+
+        // Double-sided surfaces show their back faces, their meshlets can't be cone culled
+        if (engine->mesh_shading_supported)
+        {
+            bool double_sided = p.materialIndex.has_value() && gltf.materials[p.materialIndex.value()].doubleSided;
+            newSurface.first_meshlet = BuildMeshlets(vertices, 
+                std::span<const uint32_t>(indices).subspan(newSurface.start_index, newSurface.count), !double_sided, meshlets);
+            newSurface.meshlet_count = (uint32_t)meshlets.meshlets.size() - newSurface.first_meshlet;
+        }
+
+        new_mesh.surfaces.push_back(newSurface);
     }
 
-    // Load all textures
-    for (fastgltf::Image& image : gltf.images) 
+    BuildMeshLODs(vertices, indices, new_mesh.surfaces);
+
+    new_mesh.mesh_buffers = UploadMeshAs(engine, vertex_format, indices, vertices, 
+        new_mesh.surfaces, surface_first_vertex, meshlets, bake ? &bake->vertices : nullptr);
+
+    if (bake)
     {
-        // TEMP
-        images.push_back(engine->error_checkerboard_image);
+        // Everything is in staging by now, the cache can take the arrays
+        bake->indices = std::move(indices);
+        bake->meshlets = std::move(meshlets);
+
+        baked->name = new_mesh.name;
+        baked->vertex_count = (uint32_t)vertices.size();
+        baked->vertices = bake->vertices;
+        baked->indices = bake->indices;
+        baked->meshlets = bake->meshlets.meshlets;
+        baked->meshlet_data = bake->meshlets.data;
+
+        for (size_t i = 0; i < new_mesh.surfaces.size(); i++)
+        {
+            const GeoSurface& s = new_mesh.surfaces[i];
+
+            BakedSurface& b = baked->surfaces.emplace_back();
+            b.start_index = s.start_index;
+            b.count = s.count;
+            b.bounds = s.bounds;
+            b.material = surface_materials[i];
+            std::copy(std::begin(s.lods), std::end(s.lods), std::begin(b.lods));
+            b.lod_count = s.lod_count;
+            b.first_meshlet = s.first_meshlet;
+            b.meshlet_count = s.meshlet_count;
+        }
     }
+}
 
-    // Create buffer to hold the material data
-    file.material_data_buffer = engine->createBuffer(sizeof(GLTFMetallicRoughness::MaterialConstants) * gltf.materials.size(),
-        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
-    int data_index = 0;
-    GLTFMetallicRoughness::MaterialConstants* scene_material_constants = (GLTFMetallicRoughness::MaterialConstants*)file.material_data_buffer.info.pMappedData;
+static VkSampler CreateSampler(phVkEngine* engine, const BakedSampler& sampler)
+{
+    VkSamplerCreateInfo sampl = {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO, .pNext = nullptr };
+    sampl.maxLod = VK_LOD_CLAMP_NONE;
+    sampl.minLod = 0;
 
-    for (fastgltf::Material& mat : gltf.materials) 
-    {
-        std::shared_ptr<GLTFMaterial> new_mat = std::make_shared<GLTFMaterial>();
-        materials.push_back(new_mat);
-        file.materials[mat.name.c_str()] = new_mat;
+    sampl.magFilter = (VkFilter)sampler.mag_filter;
+    sampl.minFilter = (VkFilter)sampler.min_filter;
+    sampl.mipmapMode = (VkSamplerMipmapMode)sampler.mipmap_mode;
 
-        GLTFMetallicRoughness::MaterialConstants constants;
-        constants.color_factors.x = mat.pbrData.baseColorFactor[0];
-        constants.color_factors.y = mat.pbrData.baseColorFactor[1];
-        constants.color_factors.z = mat.pbrData.baseColorFactor[2];
-        constants.color_factors.w = mat.pbrData.baseColorFactor[3];
+    // Files with identical filters share one sampler
+    return engine->resource_cache.getSampler(sampl);
+}
 
-        constants.metal_rough_factors.x = mat.pbrData.metallicFactor;
-        constants.metal_rough_factors.y = mat.pbrData.roughnessFactor;
-        
-        // Write material parameters to buffer
-        scene_material_constants[data_index] = constants;
+// Build the scene from a mapped bake (runs on a worker): no parsing, decoding or mesh processing,
+// the blobs are copied straight from the mapping into staging
+static void LoadBakedScene(phVkEngine* engine, GLTFLoadState& state, LoadedGLTF& file)
+{
+    const BakedScene& baked = state.baked;
 
-        MaterialPass passType = MaterialPass::main_color;
-        if (mat.alphaMode == fastgltf::AlphaMode::Blend) {
-            passType = MaterialPass::transparent;
-        }
+    for (const BakedSampler& sampler : baked.samplers)
+    {
+        file.samplers.push_back(CreateSampler(engine, sampler));
+    }
 
-        GLTFMetallicRoughness::MaterialResources material_resources;
-        // default the material textures
-        material_resources.color_image = engine->white_image;
-        material_resources.color_sampler = engine->default_sampler_linear;
-        material_resources.metal_rough_image = engine->white_image;
-        material_resources.metal_rough_sampler = engine->default_sampler_linear;
+    for (const BakedMaterial& mat : baked.materials)
+    {
+        std::shared_ptr<GLTFMaterial> new_mat = std::make_shared<GLTFMaterial>();
+        state.materials.push_back(new_mat);
+        file.materials[mat.name] = new_mat;
+    }
 
-        // set the uniform buffer for the material data
-        material_resources.data_buffer = file.material_data_buffer.buffer;
-        material_resources.data_buffer_offset = data_index * sizeof(GLTFMetallicRoughness::MaterialConstants);
-        
-        // grab textures from gltf file
-        if (mat.pbrData.baseColorTexture.has_value()) 
+    state.images.resize(baked.images.size());
+    state.image_owners.assign(baked.images.size(), baked.file);
+    state.shared_images.resize(baked.images.size());
+    for (size_t i = 0; i < baked.images.size(); i++)
+    {
+        // Unused images (KTX2 fallbacks that were never decoded) are baked empty
+        const BakedImage& image = baked.images[i];
+        if (image.texels.empty())
         {
-            size_t img = gltf.textures[mat.pbrData.baseColorTexture.value().textureIndex].imageIndex.value();
-            size_t sampler = gltf.textures[mat.pbrData.baseColorTexture.value().textureIndex].samplerIndex.value();
+            continue;
+        }
 
-            material_resources.color_image = images[img];
-            material_resources.color_sampler = file.samplers[sampler];
+        // External files another scene already loaded are taken from it
+        if (!image.uri.empty())
+        {
+            bool created;
+            state.shared_images[i] = engine->texture_cache.acquire(image.uri, created);
+            if (!created)
+            {
+                continue;
+            }
         }
-        
-        // build material
-        new_mat->data = engine->metal_rough_material.writeMaterial(engine->device, passType, material_resources, file.descriptor_pool);
 
-        data_index++;
+        // Streamed ones are created from the mapping by FinalizeGLTF
+        if (!state.stream_textures)
+        {
+            state.images[i] = UploadImage(engine, image);
+            if (!state.shared_images[i])
+            {
+                file.images[image.name] = *state.images[i];
+            }
+        }
+
+        if (state.shared_images[i])
+        {
+            PublishSharedImage(state, i);
+        }
     }
 
-    // use the same vectors for all meshes so that the memory doesnt reallocate as
-    // often
-    std::vector<uint32_t> indices;
-    std::vector<Vertex> vertices;
+    for (size_t i = 0; i < baked.images.size(); i++)
+    {
+        if (state.shared_images[i])
+        {
+            ResolveSharedImage(engine, state, i);
+        }
+    }
 
-    for (fastgltf::Mesh& mesh : gltf.meshes) 
+    for (const BakedMesh& mesh : baked.meshes)
     {
         std::shared_ptr<MeshAsset> new_mesh = std::make_shared<MeshAsset>();
-        meshes.push_back(new_mesh);
-        file.meshes[mesh.name.c_str()] = new_mesh;
+        state.meshes.push_back(new_mesh);
+        file.meshes[mesh.name] = new_mesh;
         new_mesh->name = mesh.name;
 
-        // clear the mesh arrays each mesh, we dont want to merge them by error
-        indices.clear();
-        vertices.clear();
+        for (const BakedSurface& b : mesh.surfaces)
+        {
+            GeoSurface& s = new_mesh->surfaces.emplace_back();
+            s.start_index = b.start_index;
+            s.count = b.count;
+            s.bounds = b.bounds;
+            if (b.material >= 0)
+            {
+                s.material = state.materials[b.material];
+            }
+            std::copy(std::begin(b.lods), std::end(b.lods), std::begin(s.lods));
+            s.lod_count = b.lod_count;
+            s.first_meshlet = b.first_meshlet;
+            s.meshlet_count = b.meshlet_count;
+        }
+
+        new_mesh->mesh_buffers = engine->uploadMeshData(mesh.indices, mesh.vertices.data(), mesh.vertex_count,
+            baked.vertex_format);
+        engine->uploadMeshlets(new_mesh->mesh_buffers, mesh.meshlets, mesh.meshlet_data);
+    }
 
-        for (auto&& p : mesh.primitives) 
+    for (const BakedNode& node : baked.nodes)
+    {
+        std::shared_ptr<Node> new_node;
+        if (node.mesh >= 0)
         {
-            GeoSurface newSurface;
-            newSurface.start_index = (uint32_t)indices.size();
-            newSurface.count = (uint32_t)gltf.accessors[p.indicesAccessor.value()].count;
+            new_node = std::make_shared<MeshNode>();
+            static_cast<MeshNode*>(new_node.get())->mesh = state.meshes[node.mesh];
+        }
+        else
+        {
+            new_node = std::make_shared<Node>();
+        }
+        new_node->local_transform = node.local_transform;
 
-            size_t initial_vtx = vertices.size();
+        state.nodes.push_back(new_node);
+        file.nodes[node.name];
+    }
 
-            // load indexes
-            {
-                fastgltf::Accessor& indexaccessor = gltf.accessors[p.indicesAccessor.value()];
-                indices.reserve(indices.size() + indexaccessor.count);
+    for (size_t i = 0; i < baked.nodes.size(); i++)
+    {
+        if (baked.nodes[i].parent >= 0)
+        {
+            state.nodes[baked.nodes[i].parent]->children.push_back(state.nodes[i]);
+            state.nodes[i]->parent = state.nodes[baked.nodes[i].parent];
+        }
+    }
 
-                fastgltf::iterateAccessor<std::uint32_t>(gltf, indexaccessor,
-                    [&](std::uint32_t idx) 
-                    {
-                        indices.push_back(idx + initial_vtx);
-                    });
-            }
+    for (auto& node : state.nodes) 
+    {
+        if (node->parent.lock() == nullptr) {
+            file.top_nodes.push_back(node);
+            node->refreshTransform(Mat4f());
+        }
+    }
+}
 
-            // load vertex positions
-            {
-                fastgltf::Accessor& posAccessor = gltf.accessors[p.findAttribute("POSITION")->accessorIndex];
-                vertices.resize(vertices.size() + posAccessor.count);
+// External buffer and image files of a glTF (the bake is only valid while they are unchanged)
+static bool CollectSourceFiles(const std::filesystem::path& path, std::vector<BakedSourceFile>& files)
+{
+    // Parsed again without the buffers, loaded buffers no longer have their URIs
+    fastgltf::Asset asset;
+    if (!ParseGLTF(path, asset, false))
+    {
+        return false;
+    }
 
-                fastgltf::iterateAccessorWithIndex<Vec3f>(gltf, posAccessor,
-                    [&](Vec3f v, size_t index) 
-                    {
-                        Vertex new_vtx;
-                        new_vtx.position = v;
-                        new_vtx.normal = { 1, 0, 0 };
-                        new_vtx.color = Vec4f(1.f, 1.f, 1.f, 1.f);
-                        new_vtx.uv_x = 0;
-                        new_vtx.uv_y = 0;
-                        vertices[initial_vtx + index] = new_vtx;
-                    });
+    auto add = [&](const fastgltf::DataSource& source)
+        {
+            const fastgltf::sources::URI* file_path = std::get_if<fastgltf::sources::URI>(&source);
+            if (!file_path || !file_path->uri.isLocalPath())
+            {
+                return true;
             }
 
-            // load vertex normals
-            auto normals = p.findAttribute("NORMAL");
-            if (normals != p.attributes.end()) 
+            // Relative to the asset, unless only the path as written exists
+            std::filesystem::path file(std::string(file_path->uri.path().begin(), file_path->uri.path().end()));
+            std::error_code error;
+            if (file.is_relative() && std::filesystem::exists(path.parent_path() / file, error))
             {
-                fastgltf::iterateAccessorWithIndex<Vec3f>(gltf, gltf.accessors[(*normals).accessorIndex],
-                    [&](Vec3f v, size_t index) 
-                    {
-                        vertices[initial_vtx + index].normal = v;
-                    });
+                file = path.parent_path() / file;
             }
 
-            // load UVs
-            auto uv = p.findAttribute("TEXCOORD_0");
-            if (uv != p.attributes.end()) {
+            BakedSourceFile& source_file = files.emplace_back();
+            source_file.path = file.string();
+            return StatSourceFile(file, source_file);
+        };
 
-                fastgltf::iterateAccessorWithIndex<Vec2f>(gltf, gltf.accessors[(*uv).accessorIndex],
-                    [&](Vec2f v, size_t index) 
-                    {
-                        vertices[initial_vtx + index].uv_x = v.x;
-                        vertices[initial_vtx + index].uv_y = v.y;
-                    });
-            }
+    files.clear();
+    for (const fastgltf::Buffer& buffer : asset.buffers)
+    {
+        if (!add(buffer.data))
+        {
+            return false;
+        }
+    }
+    for (const fastgltf::Image& image : asset.images)
+    {
+        if (!add(image.data))
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
-            // load vertex colors
-            auto colors = p.findAttribute("COLOR_0");
-            if (colors != p.attributes.end()) 
-            {
-                fastgltf::iterateAccessorWithIndex<Vec4f>(gltf, gltf.accessors[(*colors).accessorIndex],
-                    [&](Vec4f v, size_t index) 
-                    {
-                        vertices[initial_vtx + index].color = v;
-                    });
-            }
+// Bake the captured scene (runs on the load's worker, after every job finished)
+static void WriteBakedScene(GLTFLoadState& state, const std::filesystem::path& cache_path)
+{
+    // A missing texture may be temporary, don't make it stick
+    for (const BakedMaterial& mat : state.baked.materials)
+    {
+        if (mat.color_image >= 0 && state.baked.images[mat.color_image].texels.empty())
+        {
+            return;
+        }
+    }
+
+    if (CollectSourceFiles(state.path, state.baked.source_files) && WriteSceneCache(cache_path, state.baked))
+    {
+        fmt::println("Baked scene cache: {}", cache_path.string());
+    }
+    else
+    {
+        fmt::println("Failed to write scene cache: {}", cache_path.string());
+    }
+}
 
-            if (p.materialIndex.has_value()) 
+// CPU side of a load (runs on a worker): parse, then decode images and build meshes as parallel jobs
+static void LoadGLTFJob(phVkEngine* engine, GLTFLoadRequest& request)
+{
+    GLTFLoadState& state = *request.state;
+    LoadedGLTF& file = *request.scene;
+    fastgltf::Asset& gltf = state.gltf;
+
+    // A current bake skips everything below
+    const std::filesystem::path cache_path = SceneCachePath(state.path);
+    if (engine->use_scene_cache)
+    {
+        state.baked.source_hash = HashFileContents(state.path);
+        state.baked.vertex_format = state.vertex_format;
+        state.baked.has_meshlets = engine->mesh_shading_supported;
+
+        if (state.baked.source_hash != 0 && ReadSceneCache(cache_path, state.baked.source_hash, state.vertex_format,
+            engine->mesh_shading_supported, state.baked))
+        {
+            // Block-compressed textures baked on another device may not be usable here
+            bool formats_supported = std::all_of(state.baked.images.begin(), state.baked.images.end(),
+                [engine](const BakedImage& image) { return image.texels.empty() || engine->supportsTextureFormat(image.format); });
+
+            if (formats_supported)
             {
-                newSurface.material = materials[p.materialIndex.value()];
+                LoadBakedScene(engine, state, file);
+                request.cpu_done.store(true, std::memory_order_release);
+                return;
             }
-            else 
+            state.baked.clear();
+        }
+        state.write_cache = state.baked.source_hash != 0;
+    }
+
+    if (!ParseGLTF(state.path, gltf))
+    {
+        request.failed = true;
+        request.cpu_done.store(true, std::memory_order_release);
+        return;
+    }
+
+    // Load samplers
+    for (fastgltf::Sampler& sampler : gltf.samplers)
+    {
+        BakedSampler& sampl = state.baked.samplers.emplace_back();
+        sampl.mag_filter = ExtractFilter(sampler.magFilter.value_or(fastgltf::Filter::Nearest));
+        sampl.min_filter = ExtractFilter(sampler.minFilter.value_or(fastgltf::Filter::Nearest));
+        sampl.mipmap_mode = extract_mipmap_mode(sampler.minFilter.value_or(fastgltf::Filter::Nearest));
+
+        file.samplers.push_back(CreateSampler(engine, sampl));
+    }
+
+    // Create materials and meshes up front so meshes and nodes can reference them from any job
+    // (material parameters are written by FinalizeGLTF)
+    for (fastgltf::Material& mat : gltf.materials) 
+    {
+        std::shared_ptr<GLTFMaterial> new_mat = std::make_shared<GLTFMaterial>();
+        state.materials.push_back(new_mat);
+        file.materials[mat.name.c_str()] = new_mat;
+
+        BakedMaterial& desc = state.baked.materials.emplace_back();
+        desc.name = mat.name.c_str();
+        desc.color_factors = Vec4f(mat.pbrData.baseColorFactor[0], mat.pbrData.baseColorFactor[1],
+            mat.pbrData.baseColorFactor[2], mat.pbrData.baseColorFactor[3]);
+        desc.metal_rough_factors = Vec4f(mat.pbrData.metallicFactor, mat.pbrData.roughnessFactor, 0.f, 0.f);
+
+        desc.pass = MaterialPass::main_color;
+        if (mat.alphaMode == fastgltf::AlphaMode::Blend) {
+            desc.pass = MaterialPass::transparent;
+        }
+
+        if (mat.pbrData.baseColorTexture.has_value()) 
+        {
+            fastgltf::Texture& texture = gltf.textures[mat.pbrData.baseColorTexture.value().textureIndex];
+            desc.color_image = texture.basisuImageIndex.has_value() ? 
+                (int32_t)texture.basisuImageIndex.value() : (int32_t)texture.imageIndex.value();
+            desc.color_sampler = texture.samplerIndex.has_value() ? (int32_t)texture.samplerIndex.value() : -1;
+        }
+    }
+
+    for (fastgltf::Mesh& mesh : gltf.meshes) 
+    {
+        std::shared_ptr<MeshAsset> new_mesh = std::make_shared<MeshAsset>();
+        state.meshes.push_back(new_mesh);
+        file.meshes[mesh.name.c_str()] = new_mesh;
+        new_mesh->name = mesh.name;
+    }
+
+    // KHR_texture_basisu: textures prefer their KTX2 image, the regular source is only decoded
+    // if the KTX2 one can't be used (see below)
+    state.image_fallbacks.assign(gltf.images.size(), -1);
+    std::vector<bool> primary_image(gltf.images.size(), false);
+    for (fastgltf::Texture& texture : gltf.textures)
+    {
+        if (texture.basisuImageIndex.has_value())
+        {
+            primary_image[texture.basisuImageIndex.value()] = true;
+            if (texture.imageIndex.has_value())
             {
-                newSurface.material = materials[0];
+                state.image_fallbacks[texture.basisuImageIndex.value()] = (int32_t)texture.imageIndex.value();
             }
+        }
+        else if (texture.imageIndex.has_value())
+        {
+            primary_image[texture.imageIndex.value()] = true;
+        }
+    }
+
+    // Decode every image independently (stb_image dominates load time)
+    state.images.resize(gltf.images.size());
+    state.image_owners.resize(gltf.images.size());
+    state.shared_images.resize(gltf.images.size());
+    state.image_decoded.assign(gltf.images.size(), false);
+    state.baked.images.resize(gltf.images.size());
+
+    auto decode_image = [engine, &state](size_t i)
+        {
+            state.image_decoded[i] = true;
+            engine->jobs.schedule([engine, &state, i]()
+                {
+                    // External files are decoded once and shared with every scene using them
+                    BakedImage& baked = state.baked.images[i];
+                    baked.uri = ImageFileKey(state.gltf.images[i]);
+                    if (!baked.uri.empty())
+                    {
+                        bool created;
+                        state.shared_images[i] = engine->texture_cache.acquire(baked.uri, created);
+                        if (!created)
+                        {
+                            return;     // ResolveSharedImage
+                        }
+                    }
+
+                    std::vector<uint8_t> texels;
+                    if (LoadImage(engine, state.gltf, state.gltf.images[i], texels, baked))
+                    {
+                        // Moving keeps the buffer, baked.texels stays valid
+                        state.image_owners[i] = std::make_shared<std::vector<uint8_t>>(std::move(texels));
+
+                        // Already in staging, only the cache and the streamer need the mips
+                        if (!state.stream_textures)
+                        {
+                            state.images[i] = UploadImage(engine, baked);
+                            if (!state.write_cache)
+                            {
+                                state.image_owners[i].reset();
+                                baked.texels = {};
+                            }
+                        }
+                    }
+
+                    if (state.shared_images[i])
+                    {
+                        PublishSharedImage(state, i);
+                    }
+                }, &state.jobs);
+        };
 
-            new_mesh->surfaces.push_back(newSurface);
+    for (size_t i = 0; i < gltf.images.size(); i++)
+    {
+        state.baked.images[i].name = gltf.images[i].name.c_str();
+
+        bool fallback_only = !primary_image[i] && 
+            std::find(state.image_fallbacks.begin(), state.image_fallbacks.end(), (int32_t)i) != state.image_fallbacks.end();
+        if (!fallback_only)
+        {
+            decode_image(i);
         }
+    }
 
-        new_mesh->mesh_buffers = engine->uploadMesh(indices, vertices);
+    // Build and upload meshes in parallel
+    if (state.write_cache)
+    {
+        state.mesh_bakes.resize(gltf.meshes.size());
+        state.baked.meshes.resize(gltf.meshes.size());
+    }
+    for (size_t i = 0; i < gltf.meshes.size(); i++)
+    {
+        engine->jobs.schedule([engine, &state, i]()
+            {
+                LoadMesh(engine, state.gltf, state.gltf.meshes[i], *state.meshes[i], state.materials,
+                    state.vertex_format, state.write_cache ? &state.mesh_bakes[i] : nullptr,
+                    state.write_cache ? &state.baked.meshes[i] : nullptr);
+            }, &state.jobs);
     }
 
-    // load all nodes and their meshes
+    // load all nodes and their meshes (while the jobs run)
     for (fastgltf::Node& node : gltf.nodes) 
     {
         std::shared_ptr<Node> new_node;
@@ -562,16 +1255,23 @@ std::optional<std::shared_ptr<LoadedGLTF>> LoadGLTF(phVkEngine* engine, std::str
         if (node.meshIndex.has_value()) 
         {
             new_node = std::make_shared<MeshNode>();
-            static_cast<MeshNode*>(new_node.get())->mesh = meshes[*node.meshIndex];
+            static_cast<MeshNode*>(new_node.get())->mesh = state.meshes[*node.meshIndex];
         }
         else 
         {
             new_node = std::make_shared<Node>();
         }
 
-        nodes.push_back(new_node);
+        state.nodes.push_back(new_node);
         file.nodes[node.name.c_str()];
 
+        if (state.write_cache)
+        {
+            BakedNode& baked_node = state.baked.nodes.emplace_back();
+            baked_node.name = node.name.c_str();
+            baked_node.mesh = node.meshIndex.has_value() ? (int32_t)*node.meshIndex : -1;
+        }
+
         std::visit(fastgltf::visitor{ [&](fastgltf::math::fmat4x4 matrix) {
                                   memcpy(&new_node->local_transform, matrix.data(), sizeof(matrix));
                               },
@@ -595,32 +1295,325 @@ std::optional<std::shared_ptr<LoadedGLTF>> LoadGLTF(phVkEngine* engine, std::str
     for (int i = 0; i < gltf.nodes.size(); i++) 
     {
         fastgltf::Node& node = gltf.nodes[i];
-        std::shared_ptr<Node>& scene_node = nodes[i];
+        std::shared_ptr<Node>& scene_node = state.nodes[i];
 
         for (auto& c : node.children) {
-            scene_node->children.push_back(nodes[c]);
-            nodes[c]->parent = scene_node;
+            scene_node->children.push_back(state.nodes[c]);
+            state.nodes[c]->parent = scene_node;
+        }
+
+        if (state.write_cache)
+        {
+            state.baked.nodes[i].local_transform = scene_node->local_transform;
+            for (auto& c : node.children)
+            {
+                state.baked.nodes[c].parent = i;
+            }
         }
     }
 
     // find the top nodes, with no parents
-    for (auto& node : nodes) 
+    for (auto& node : state.nodes) 
     {
         if (node->parent.lock() == nullptr) {
             file.top_nodes.push_back(node);
             node->refreshTransform(Mat4f());
         }
     }
-    return scene;
+
+    // Runs queued image / mesh jobs on this thread while waiting
+    engine->jobs.wait(state.jobs);
+
+    auto resolve_shared_images = [engine, &state]()
+        {
+            for (size_t i = 0; i < state.shared_images.size(); i++)
+            {
+                if (state.shared_images[i])
+                {
+                    ResolveSharedImage(engine, state, i);
+                }
+            }
+        };
+    resolve_shared_images();
+
+    // KTX2 images the device can't use (Basis Universal payloads, unsupported block formats):
+    // switch their materials to the regular source (RGBA8 with CPU mips)
+    for (BakedMaterial& mat : state.baked.materials)
+    {
+        if (mat.color_image < 0 || ImageLoaded(state, mat.color_image) || state.image_fallbacks[mat.color_image] < 0)
+        {
+            continue;
+        }
+
+        mat.color_image = state.image_fallbacks[mat.color_image];
+        if (!state.image_decoded[mat.color_image])
+        {
+            decode_image(mat.color_image);
+        }
+    }
+    engine->jobs.wait(state.jobs);
+    resolve_shared_images();
+
+    for (size_t i = 0; i < gltf.images.size(); i++)
+    {
+        if (state.images[i].has_value() && !state.shared_images[i])
+        {
+            file.images[gltf.images[i].name.c_str()] = *state.images[i];
+        }
+        else if (state.image_decoded[i] && !ImageLoaded(state, i))
+        {
+            // we failed to load, materials get the error checkerboard texture
+            // to not completely break loading
+            std::cout << "gltf failed to load texture " << gltf.images[i].name << std::endl;
+        }
+    }
+
+    if (state.write_cache)
+    {
+        WriteBakedScene(state, cache_path);
+
+        // Streamed textures keep their mip chains until FinalizeGLTF
+        if (!state.stream_textures)
+        {
+            state.image_owners.clear();
+            state.baked.images.clear();
+        }
+        state.mesh_bakes.clear();
+        state.baked.meshes.clear();
+        state.baked.nodes.clear();
+    }
+
+    request.cpu_done.store(true, std::memory_order_release);
 }
 
-void LoadedGLTF::draw(const Mat4f& top_matrix, DrawContext& ctx)
+std::shared_ptr<GLTFLoadRequest> LoadGLTFAsync(phVkEngine* engine, std::string_view file_path,
+    std::function<void(std::shared_ptr<LoadedGLTF>)> on_loaded, VertexFormat vertex_format)
 {
-    // create renderables from the scenenodes
-    for (auto& n : top_nodes) 
+    fmt::print("Loading GLTF: {}", file_path);
+	fmt::print("\n");
+
+    vertex_format = SupportedVertexFormat(engine, vertex_format);
+
+    std::shared_ptr<GLTFLoadRequest> request = std::make_shared<GLTFLoadRequest>();
+    request->path = file_path;
+    request->on_loaded = std::move(on_loaded);
+
+    request->scene = std::make_shared<LoadedGLTF>();
+    request->scene->creator = engine;
+
+    request->state = std::make_shared<GLTFLoadState>();
+    request->state->path = file_path;
+    request->state->vertex_format = vertex_format;
+    request->state->stream_textures = engine->use_texture_streaming && engine->texture_streamer.isEnabled();
+
+    engine->jobs.schedule([engine, request]()
+        {
+            LoadGLTFJob(engine, *request);
+        });
+
+    return request;
+}
+
+bool FinalizeGLTF(phVkEngine* engine, GLTFLoadRequest& request)
+{
+    if (request.finished)
+    {
+        return true;
+    }
+
+    if (!request.cpu_done.load(std::memory_order_acquire))
     {
-        n->draw(top_matrix, ctx);
+        return false;
     }
+
+    if (request.failed)
+    {
+        request.scene.reset();
+    }
+    else
+    {
+        GLTFLoadState& state = *request.state;
+        LoadedGLTF& file = *request.scene;
+        const std::vector<BakedMaterial>& materials = state.baked.materials;
+
+        // We can stimate the descriptors we will need accurately
+        std::vector<DescriptorAllocatorGrowable::PoolSizeRatio> sizes = { 
+            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3 },
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3 },
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 } };
+
+        file.descriptor_pool.init(engine->device, materials.size(), sizes);
+
+        // Create buffer to hold the material data
+        file.material_data_buffer = engine->createBuffer(sizeof(GLTFMetallicRoughness::MaterialConstants) * materials.size(),
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+        int data_index = 0;
+
+        // Streamed textures start with their mip tail, the CPU chain stays alive with them
+        // Shared images are created once (by the first scene to finalize) and owned by the texture cache
+        std::vector<uint32_t> stream_handles(state.images.size(), TextureStreamer::INVALID_HANDLE);
+        for (size_t i = 0; i < state.shared_images.size(); i++)
+        {
+            if (!state.shared_images[i])
+            {
+                continue;
+            }
+
+            SharedTexture& shared = *state.shared_images[i];
+            file.shared_textures.push_back(state.shared_images[i]);
+            if (shared.failed || shared.gpu_image.has_value())
+            {
+                continue;
+            }
+
+            if (shared.streamed_texture == TextureStreamer::INVALID_HANDLE)
+            {
+                shared.streamed_texture = engine->texture_streamer.create(StreamSource(shared.image, shared.texels_owner.lock()));
+            }
+            stream_handles[i] = shared.streamed_texture;
+        }
+
+        if (state.stream_textures)
+        {
+            for (size_t i = 0; i < state.baked.images.size(); i++)
+            {
+                if (state.baked.images[i].texels.empty() || state.shared_images[i])
+                {
+                    continue;
+                }
+
+                stream_handles[i] = engine->texture_streamer.create(StreamSource(state.baked.images[i], state.image_owners[i]));
+                file.streamed_textures.push_back(stream_handles[i]);
+            }
+        }
+
+        GLTFMetallicRoughness::MaterialConstants* scene_material_constants = (GLTFMetallicRoughness::MaterialConstants*)file.material_data_buffer.info.pMappedData;
+
+        for (const BakedMaterial& mat : materials) 
+        {
+            std::shared_ptr<GLTFMaterial> new_mat = state.materials[data_index];
+
+            GLTFMetallicRoughness::MaterialConstants constants;
+            constants.color_factors = mat.color_factors;
+            constants.metal_rough_factors = mat.metal_rough_factors;
+            
+            // Write material parameters to buffer
+            scene_material_constants[data_index] = constants;
+
+            GLTFMetallicRoughness::MaterialResources material_resources;
+            // default the material textures
+            material_resources.color_image = engine->white_image;
+            material_resources.color_sampler = engine->default_sampler_linear;
+            material_resources.metal_rough_image = engine->white_image;
+            material_resources.metal_rough_sampler = engine->default_sampler_linear;
+
+            // set the uniform buffer for the material data
+            material_resources.data_buffer = file.material_data_buffer.buffer;
+            material_resources.data_buffer_offset = data_index * sizeof(GLTFMetallicRoughness::MaterialConstants);
+            material_resources.constants = constants;
+            
+            // grab textures from gltf file
+            uint32_t streamed_texture = TextureStreamer::INVALID_HANDLE;
+            if (mat.color_image >= 0) 
+            {
+                material_resources.color_image = state.images[mat.color_image].value_or(engine->error_checkerboard_image);
+                if (stream_handles[mat.color_image] != TextureStreamer::INVALID_HANDLE)
+                {
+                    streamed_texture = stream_handles[mat.color_image];
+                    material_resources.color_image = engine->texture_streamer.image(streamed_texture);
+                }
+                if (mat.color_sampler >= 0)
+                {
+                    material_resources.color_sampler = file.samplers[mat.color_sampler];
+                }
+            }
+            
+            // build material (descriptor writes are not thread-safe, so this stays on the main thread)
+            new_mat->data = engine->metal_rough_material.writeMaterial(engine->device, mat.pass, material_resources, file.descriptor_pool);
+            new_mat->data.streamed_texture = streamed_texture;
+
+            data_index++;
+        }
+
+        // Submit the file's copies as one batch, the scene is drawn once it lands
+        file.upload = engine->upload_manager.flush();
+
+        // Defragmentation may move the scene's own meshlet buffers and images once they've landed
+        // (shared textures are copied into other loads, streamed ones are replaced by the streamer)
+        for (auto& [name, mesh] : file.meshes)
+        {
+            engine->memory_manager.setMovable(mesh->mesh_buffers, file.upload);
+        }
+        for (auto& [name, image] : file.images)
+        {
+            if (image.image != engine->error_checkerboard_image.image)
+            {
+                engine->memory_manager.setMovable(image, file.upload);
+            }
+        }
+    }
+
+    // Release the parsed asset
+    request.state.reset();
+    request.finished = true;
+
+    if (request.on_loaded)
+    {
+        request.on_loaded(request.scene);
+    }
+
+    return true;
+}
+
+std::optional<std::shared_ptr<LoadedGLTF>> LoadGLTF(phVkEngine* engine, std::string_view file_path,
+    VertexFormat vertex_format)
+{
+    std::shared_ptr<GLTFLoadRequest> request = LoadGLTFAsync(engine, file_path, nullptr, vertex_format);
+
+    // Blocking: help the workers until the CPU side is done, then finalize here
+    while (!FinalizeGLTF(engine, *request))
+    {
+        if (!engine->jobs.runOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    if (!request->scene)
+    {
+        return {};
+    }
+
+    return request->scene;
+}
+
+bool LoadedGLTF::update(const Mat4f& top_matrix)
+{
+    if (!scene_graph)
+    {
+        // Buffers / images still in flight on the transfer queue
+        if (!creator->upload_manager.isReady(upload))
+            return false;
+
+        scene_graph = std::make_shared<FlatSceneGraph>();
+        scene_graph->build(top_nodes);
+    }
+
+    return scene_graph->update(top_matrix);
+}
+
+void LoadedGLTF::appendObjects(DrawContext& ctx) const
+{
+    if (scene_graph)
+    {
+        scene_graph->append(ctx);
+    }
+}
+
+void LoadedGLTF::draw(const Mat4f& top_matrix, DrawContext& ctx)
+{
+    update(top_matrix);
+    appendObjects(ctx);
 }
 
 void LoadedGLTF::clearAll()
@@ -629,8 +1622,19 @@ void LoadedGLTF::clearAll()
 
     for (auto& [k, v] : meshes) {
 
-        creator->destroyBuffer(v->mesh_buffers.index_buffer);
-        creator->destroyBuffer(v->mesh_buffers.vertex_buffer);
+        // Return the mesh ranges to the shared pool
+        creator->freeMesh(v->mesh_buffers);
+    }
+
+    for (auto& [k, v] : materials) {
+
+        // Bindless slots and texture references
+        creator->metal_rough_material.releaseMaterial(v->data);
+    }
+
+    for (uint32_t handle : streamed_textures)
+    {
+        creator->texture_streamer.release(handle);
     }
 
     for (auto& [k, v] : images) {
@@ -643,13 +1647,13 @@ void LoadedGLTF::clearAll()
         creator->destroyImage(v);
     }
 
-    for (auto& sampler : samplers) 
+    // Samplers belong to the engine's resource cache, shared textures to its texture cache
+    for (auto& texture : shared_textures)
     {
-        vkDestroySampler(dv, sampler, nullptr);
+        creator->texture_cache.release(texture);
     }
 
     auto materialBuffer = material_data_buffer;
-    auto samplersToDestroy = samplers;
 
     descriptor_pool.destroyPools(dv);
 
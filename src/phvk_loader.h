@@ -8,14 +8,17 @@
 
 #include "phvk_types.h"
 #include "phvk_descriptors.h"
+#include "phvk_lod.h"
 
 #include <unordered_map>
 #include <filesystem>
+#include <atomic>
 
 // DEBUG: Replace vertex colors with vertex normals
 constexpr bool override_colors = false;
 
 class phVkEngine;
+struct SharedTexture;
 
 struct Bounds 
 {
@@ -33,7 +36,16 @@ struct GeoSurface
 {
     uint32_t start_index;
     uint32_t count;
+    Bounds bounds;
     std::shared_ptr<GLTFMaterial> material;
+
+    // Detail levels, lods[0] is [start_index, start_index + count)
+    SurfaceLOD lods[MAX_MESH_LODS] {};
+    uint32_t lod_count { 1 };
+
+    // Meshlets of lods[0] in the mesh's meshlet buffer (mesh shading only)
+    uint32_t first_meshlet { 0 };
+    uint32_t meshlet_count { 0 };
 };
 
 struct MeshAsset 
@@ -44,9 +56,16 @@ struct MeshAsset
     GPUMeshBuffers mesh_buffers;
 };
 
+// Compute object-space bounds (AABB + bounding sphere) of a vertex range
+Bounds ComputeBounds(std::span<const Vertex> vertices);
+
+// Encode a vertex range as PackedVertex, positions quantized against the range's bounds
+void PackVertices(std::span<const Vertex> vertices, const Bounds& bounds, std::span<PackedVertex> out);
+
 // Loader function
 // Note: std::optional wraps a type and allows for it to be errored or null to fail safely
-std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGLTFMeshes(phVkEngine* engine, std::filesystem::path file_path);
+std::optional<std::vector<std::shared_ptr<MeshAsset>>> loadGLTFMeshes(phVkEngine* engine, std::filesystem::path file_path,
+    VertexFormat vertex_format = VertexFormat::standard);
 
 struct LoadedGLTF : public IRenderable 
 {
@@ -55,6 +74,8 @@ struct LoadedGLTF : public IRenderable
     std::unordered_map<std::string, std::shared_ptr<MeshAsset>> meshes;
     std::unordered_map<std::string, std::shared_ptr<Node>> nodes;
     std::unordered_map<std::string, AllocatedImage> images;
+    std::vector<uint32_t> streamed_textures;    // TextureStreamer handles (images not in the map)
+    std::vector<std::shared_ptr<SharedTexture>> shared_textures;    // External image files (engine's TextureCache)
     std::unordered_map<std::string, std::shared_ptr<GLTFMaterial>> materials;
 
     // nodes that dont have a parent, for iterating through the file in tree order
@@ -64,12 +85,24 @@ struct LoadedGLTF : public IRenderable
 
     DescriptorAllocatorGrowable descriptor_pool;
 
-    AllocatedBuffer material_data_buffer;
+    AllocatedBuffer material_data_buffer {};
+
+    UploadHandle upload;    // Covers every buffer and image in the file
+
+    // Flattened nodes and cached render objects, built on the first update once uploads are ready
+    std::shared_ptr<FlatSceneGraph> scene_graph;
 
     phVkEngine* creator;
 
     ~LoadedGLTF() { clearAll(); };
 
+    // Propagates dirty transforms, returns true if the cached render objects changed
+    bool update(const Mat4f& top_matrix);
+
+    // Appends the cached render objects (as of the last update)
+    void appendObjects(DrawContext& ctx) const;
+
+    // update() + appendObjects()
     virtual void draw(const Mat4f& top_matrix, DrawContext& ctx);
 
 private:
@@ -77,6 +110,37 @@ private:
     void clearAll();
 };
 
-// Loader function
+struct GLTFLoadState;    // Loader-internal intermediate data
+
+// In-flight asynchronous glTF load (see LoadGLTFAsync)
+struct GLTFLoadRequest
+{
+    std::string path;
+    std::function<void(std::shared_ptr<LoadedGLTF>)> on_loaded;    // Main thread, null on failure
+
+    std::shared_ptr<LoadedGLTF> scene;      // Scene being built (null after a failed load)
+    bool finished { false };                // Finalized, on_loaded has been called
+
+    // Set by the worker once parsing, image decoding and mesh building are done
+    std::atomic<bool> cpu_done { false };
+    bool failed { false };
+
+    std::shared_ptr<GLTFLoadState> state;
+};
+
+// Loader functions
+// Parsing, image decoding and vertex / index building run on the engine's job system and feed
+// the upload manager; materials are written on the main thread by FinalizeGLTF
+// vertex_format selects the mesh vertex layout for the whole file (falls back to standard
+// if the packed pipelines are unavailable)
+std::shared_ptr<GLTFLoadRequest> LoadGLTFAsync(phVkEngine* engine, std::string_view file_path,
+    std::function<void(std::shared_ptr<LoadedGLTF>)> on_loaded = nullptr, 
+    VertexFormat vertex_format = VertexFormat::standard);
+
+// Call from the main thread until it returns true (finishes the load once the CPU side is done)
+bool FinalizeGLTF(phVkEngine* engine, GLTFLoadRequest& request);
+
+// Blocking load
 // Note: std::optional wraps a type and allows for it to be errored or null to fail safely
-std::optional<std::shared_ptr<LoadedGLTF>> LoadGLTF(phVkEngine* engine, std::string_view file_path);
+std::optional<std::shared_ptr<LoadedGLTF>> LoadGLTF(phVkEngine* engine, std::string_view file_path,
+    VertexFormat vertex_format = VertexFormat::standard);
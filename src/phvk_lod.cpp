@@ -0,0 +1,183 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Mesh LODs (index buffer simplification and screen-space selection)
+
+#include "phvk_lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
+// Grid resolution (cells across the bounding sphere diameter) of the first simplified level,
+// halved for every following level
+static constexpr uint32_t LOD_BASE_GRID = 64;
+
+// A level is only kept if it has at most this fraction of the previous level's triangles
+static constexpr float LOD_MIN_REDUCTION = 0.75f;
+
+// Surfaces below this triangle count are not simplified further
+static constexpr uint32_t LOD_MIN_TRIANGLES = 16;
+
+// Cluster the triangles of src onto a grid of cell_size, appending the kept triangles to out
+static void ClusterTriangles(std::span<const Vertex> vertices, std::span<const uint32_t> src, Vec3f origin,
+    float radius, float cell_size, std::vector<uint32_t>& out)
+{
+    auto cell_key = [&](const Vec3f& p)
+        {
+            // 21 bits per axis, relative to the sphere's min corner
+            auto axis = [&](float v, float o)
+                {
+                    float c = std::floor((v - o + radius) / cell_size);
+                    return (uint64_t)std::clamp(c, 0.f, 2097151.f);
+                };
+            return axis(p.x, origin.x) | (axis(p.y, origin.y) << 21) | (axis(p.z, origin.z) << 42);
+        };
+
+    // *** Cell Centers ***
+    struct Cell
+    {
+        Vec3f sum;
+        uint32_t count;
+        uint32_t vertex;
+        float best;
+    };
+    std::unordered_map<uint64_t, Cell> cells;
+    std::unordered_map<uint32_t, uint64_t> vertex_cells;
+
+    for (uint32_t v : src)
+    {
+        auto [it, inserted] = vertex_cells.try_emplace(v, 0);
+        if (!inserted)
+        {
+            continue;
+        }
+
+        const Vec3f& p = vertices[v].position;
+        it->second = cell_key(p);
+
+        Cell& cell = cells.try_emplace(it->second, Cell{ Vec3f(0.f, 0.f, 0.f), 0, v, 0.f }).first->second;
+        cell.sum = Vec3f(cell.sum.x + p.x, cell.sum.y + p.y, cell.sum.z + p.z);
+        cell.count++;
+    }
+
+    // *** Representatives ***
+    // Existing vertex nearest to the mean of its cell
+    for (auto& [v, key] : vertex_cells)
+    {
+        Cell& cell = cells[key];
+        const Vec3f& p = vertices[v].position;
+
+        float dx = p.x - cell.sum.x / cell.count;
+        float dy = p.y - cell.sum.y / cell.count;
+        float dz = p.z - cell.sum.z / cell.count;
+        float d = dx * dx + dy * dy + dz * dz;
+
+        if (cell.vertex == v || d < cell.best)
+        {
+            cell.vertex = v;
+            cell.best = d;
+        }
+    }
+
+    // *** Remap ***
+    // Drop collapsed and duplicate triangles (rotated so the smallest index leads, winding kept)
+    std::unordered_set<uint64_t> seen;
+    for (size_t t = 0; t + 2 < src.size(); t += 3)
+    {
+        uint32_t a = cells[vertex_cells[src[t]]].vertex;
+        uint32_t b = cells[vertex_cells[src[t + 1]]].vertex;
+        uint32_t c = cells[vertex_cells[src[t + 2]]].vertex;
+
+        if (a == b || b == c || a == c)
+        {
+            continue;
+        }
+
+        while (a > b || a > c)
+        {
+            uint32_t tmp = a;
+            a = b;
+            b = c;
+            c = tmp;
+        }
+
+        uint64_t key = ((uint64_t)a * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)b << 32 | c);
+        if (!seen.insert(key).second)
+        {
+            continue;
+        }
+
+        out.push_back(a);
+        out.push_back(b);
+        out.push_back(c);
+    }
+}
+
+uint32_t BuildSurfaceLODs(std::span<const Vertex> vertices, std::vector<uint32_t>& indices, uint32_t first,
+    uint32_t count, Vec3f origin, float radius, SurfaceLOD lods[MAX_MESH_LODS])
+{
+    lods[0] = { first, count, 0.f };
+    uint32_t lod_count = 1;
+
+    if (radius <= 0.f || count / 3 < LOD_MIN_TRIANGLES)
+    {
+        return lod_count;
+    }
+
+    std::vector<uint32_t> source(indices.begin() + first, indices.begin() + first + count);
+    std::vector<uint32_t> simplified;
+
+    for (uint32_t grid = LOD_BASE_GRID; grid >= 2 && lod_count < MAX_MESH_LODS; grid /= 2)
+    {
+        float cell_size = 2.f * radius / grid;
+
+        simplified.clear();
+        ClusterTriangles(vertices, source, origin, radius, cell_size, simplified);
+
+        // Not enough of a reduction to be worth the indices, try a coarser grid
+        if (simplified.size() > source.size() * LOD_MIN_REDUCTION || simplified.empty())
+        {
+            continue;
+        }
+
+        lods[lod_count].start_index = (uint32_t)indices.size();
+        lods[lod_count].count = (uint32_t)simplified.size();
+        lods[lod_count].error = cell_size / radius;
+        lod_count++;
+
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+
+        if (simplified.size() / 3 < LOD_MIN_TRIANGLES)
+        {
+            break;
+        }
+        source.swap(simplified);
+    }
+
+    return lod_count;
+}
+
+uint32_t SelectLOD(const SurfaceLOD* lods, uint32_t lod_count, float projected_radius, float error_pixels,
+    uint32_t current)
+{
+    current = std::min(current, lod_count - 1);
+
+    // Too coarse for the current size: refine right away
+    if (lods[current].error * projected_radius > error_pixels)
+    {
+        while (current > 0 && lods[current].error * projected_radius > error_pixels)
+        {
+            current--;
+        }
+        return current;
+    }
+
+    // Coarsen only with some margin
+    while (current + 1 < lod_count && lods[current + 1].error * projected_radius <= error_pixels * LOD_HYSTERESIS)
+    {
+        current++;
+    }
+    return current;
+}
@@ -0,0 +1,38 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Mesh LODs (index buffer simplification and screen-space selection)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <span>
+#include <vector>
+
+constexpr uint32_t MAX_MESH_LODS = 4;      // Including the full detail level
+
+// Index range of one detail level, every level shares the mesh's vertices
+struct SurfaceLOD
+{
+    uint32_t start_index;
+    uint32_t count;
+    float error;        // Geometric error relative to the surface's bounding sphere radius (0 for LOD 0)
+};
+
+// Simplify indices[first, first + count) by vertex clustering on successively coarser grids
+// Each cluster collapses onto one of its existing vertices, so the vertex buffer is unchanged
+// The simplified ranges are appended to indices, lods[0] is the original range
+// Returns the number of levels written to lods (1 if the surface can't be reduced)
+uint32_t BuildSurfaceLODs(std::span<const Vertex> vertices, std::vector<uint32_t>& indices, uint32_t first,
+    uint32_t count, Vec3f origin, float radius, SurfaceLOD lods[MAX_MESH_LODS]);
+
+// *** Selection ***
+// Going coarser only happens once the error is below threshold * LOD_HYSTERESIS,
+// so objects sitting on a switching distance don't alternate every frame
+constexpr float LOD_HYSTERESIS = 0.75f;
+
+// Coarsest level whose error projects to at most error_pixels
+// projected_radius: bounding sphere radius in pixels, current: level used last frame
+uint32_t SelectLOD(const SurfaceLOD* lods, uint32_t lod_count, float projected_radius, float error_pixels,
+    uint32_t current);
@@ -0,0 +1,710 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// GPU memory telemetry (heap budgets, per-category totals) and incremental VMA defragmentation
+
+#include "phvk_memory.h"
+
+#include "phvk_engine.h"
+#include "phvk_initializers.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+
+static float Megabytes(VkDeviceSize bytes)
+{
+    return bytes / (1024.f * 1024.f);
+}
+
+void MemoryManager::init(phVkEngine* engine)
+{
+    this->engine = engine;
+    device = engine->device;
+    allocator = engine->allocator;
+
+    const VkPhysicalDeviceMemoryProperties* memory_properties;
+    vmaGetMemoryProperties(allocator, &memory_properties);
+
+    heap_count = memory_properties->memoryHeapCount;
+    for (uint32_t i = 0; i < heap_count; i++)
+    {
+        heaps[i].device_local = (memory_properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+    }
+}
+
+void MemoryManager::destroy()
+{
+    if (context == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // Device is idle, the pass in flight can finish right away
+    if (pass_frame >= 0)
+    {
+        if (!views_replaced)
+        {
+            replaceViews();
+        }
+        endPass();
+    }
+    if (context != VK_NULL_HANDLE)
+    {
+        endDefragmentation();
+    }
+}
+
+MemoryManager::Record* MemoryManager::addRecord(VmaAllocation allocation, MemoryCategory category)
+{
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(allocator, allocation, &info);
+
+    Record* record = new Record { this, category, info.size };
+    vmaSetAllocationUserData(allocator, allocation, record);
+
+    category_bytes[(size_t)category] += info.size;
+    category_counts[(size_t)category]++;
+
+    return record;
+}
+
+MemoryManager::Record* MemoryManager::findRecord(VmaAllocation allocation) const
+{
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(allocator, allocation, &info);
+    return (Record*)info.pUserData;
+}
+
+void MemoryManager::trackBuffer(VmaAllocation allocation, const VkBufferCreateInfo& info, MemoryCategory category)
+{
+    Record* record = addRecord(allocation, category);
+    record->buffer_info = info;
+    record->buffer_info.pNext = nullptr;
+}
+
+void MemoryManager::trackImage(VmaAllocation allocation, const VkImageCreateInfo& info, MemoryCategory category)
+{
+    Record* record = addRecord(allocation, category);
+    record->is_image = true;
+    record->image_info = info;
+    record->image_info.pNext = nullptr;
+}
+
+void MemoryManager::trackMemory(VmaAllocation allocation, MemoryCategory category)
+{
+    addRecord(allocation, category);
+}
+
+bool MemoryManager::Release(VmaAllocator allocator, VmaAllocation allocation)
+{
+    if (allocation == VK_NULL_HANDLE)
+    {
+        return true;
+    }
+
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(allocator, allocation, &info);
+
+    Record* record = (Record*)info.pUserData;
+    if (!record)
+    {
+        return true;
+    }
+
+    MemoryManager& manager = *record->manager;
+    manager.category_bytes[(size_t)record->category] -= record->size;
+    manager.category_counts[(size_t)record->category]--;
+
+    const uint32_t move_index = record->move_index;
+    vmaSetAllocationUserData(allocator, allocation, nullptr);
+    delete record;
+
+    if (move_index == UINT32_MAX)
+    {
+        return true;
+    }
+
+    // Abandoned during the pass: VMA frees the source and destination memory when it ends,
+    // the old resources of a copy are still destroyed by the pass
+    manager.moves[move_index].record = nullptr;
+    manager.pass_info.pMoves[move_index].operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+    return false;
+}
+
+void MemoryManager::setMovable(GPUMeshBuffers& mesh, UploadHandle upload)
+{
+    if (mesh.meshlet_buffer.allocation == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    Record* record = findRecord(mesh.meshlet_buffer.allocation);
+    if (record && !record->is_image)
+    {
+        record->mesh = &mesh;
+        record->upload = upload;
+    }
+}
+
+void MemoryManager::setMovable(AllocatedImage& image, UploadHandle upload)
+{
+    if (!engine->metal_rough_material.isBindless())
+    {
+        return;
+    }
+
+    Record* record = findRecord(image.allocation);
+    if (record && record->is_image)
+    {
+        record->image = &image;
+        record->upload = upload;
+    }
+}
+
+void MemoryManager::update(VkCommandBuffer cmd, bool idle)
+{
+    const int frame = engine->frame_number;
+
+    // *** Budgets ***
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(allocator, budgets);
+
+    for (uint32_t i = 0; i < heap_count; i++)
+    {
+        heaps[i].budget = budgets[i].budget;
+        heaps[i].usage = budgets[i].usage;
+    }
+
+    // *** Statistics ***
+    // Walks every block, so only now and then
+    if (frame - stats_frame >= (int)STATS_INTERVAL)
+    {
+        collectStatistics();
+        stats_frame = frame;
+
+        // *** Geometry Compaction ***
+        if (idle && defrag_enabled)
+        {
+            compactGeometry(cmd);
+        }
+    }
+
+    // *** Defragmentation ***
+    if (pass_frame >= 0)
+    {
+        if (!views_replaced && frame >= pass_frame + (int)MAX_FRAME_OVERLAP - 1)
+        {
+            replaceViews();
+        }
+        if (frame < pass_frame + (int)std::max(MAX_FRAME_OVERLAP, 2 * MAX_FRAME_OVERLAP - 2))
+        {
+            return;
+        }
+        endPass();
+    }
+
+    if (context != VK_NULL_HANDLE && !defrag_enabled)
+    {
+        endDefragmentation();
+    }
+
+    if (!idle || !defrag_enabled)
+    {
+        return;
+    }
+
+    if (context == VK_NULL_HANDLE)
+    {
+        if (frame < retry_frame || frag_ratio < fragmentation_threshold || free_block_bytes < MIN_FREE_BYTES)
+        {
+            return;
+        }
+
+        VmaDefragmentationInfo info {};
+        info.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+        info.pool = nullptr;    // Default pools
+        info.maxBytesPerPass = MAX_PASS_BYTES;
+        info.maxAllocationsPerPass = MAX_PASS_MOVES;
+        VK_CHECK(vmaBeginDefragmentation(allocator, &info, &context));
+
+        fmt::println("Defragmenting GPU memory ({:.1f}% of device-local blocks unused, {:.1f} MB)",
+            frag_ratio * 100.f, Megabytes(free_block_bytes));
+    }
+
+    beginPass(cmd);
+}
+
+void MemoryManager::collectStatistics()
+{
+    VmaTotalStatistics total;
+    vmaCalculateStatistics(allocator, &total);
+
+    VkDeviceSize block_bytes = 0;
+    VkDeviceSize allocation_bytes = 0;
+    for (uint32_t i = 0; i < heap_count; i++)
+    {
+        const VmaStatistics& statistics = total.memoryHeap[i].statistics;
+        heaps[i].block_bytes = statistics.blockBytes;
+        heaps[i].allocation_bytes = statistics.allocationBytes;
+        heaps[i].allocation_count = statistics.allocationCount;
+
+        if (heaps[i].device_local)
+        {
+            block_bytes += statistics.blockBytes;
+            allocation_bytes += statistics.allocationBytes;
+        }
+    }
+
+    free_block_bytes = block_bytes - allocation_bytes;
+    frag_ratio = block_bytes > 0 ? (float)free_block_bytes / (float)block_bytes : 0.f;
+}
+
+void MemoryManager::compactGeometry(VkCommandBuffer cmd)
+{
+    GeometryPool& pool = engine->geometry_pool;
+
+    const uint32_t page = pool.sparsestPage(GEOMETRY_COMPACT_OCCUPANCY);
+    if (page == GeometryPool::INVALID_PAGE)
+    {
+        return;
+    }
+
+    // Up to a pass worth of meshes, the rest follows with the next statistics
+    VkDeviceSize moved_bytes = 0;
+    for (auto& [name, scene] : engine->loaded_scenes)
+    {
+        for (auto& [mesh_name, mesh] : scene->meshes)
+        {
+            GPUMeshBuffers& buffers = mesh->mesh_buffers;
+            if (buffers.geometry.page != page || !engine->upload_manager.isReady(buffers.upload) ||
+                moved_bytes >= MAX_PASS_BYTES)
+            {
+                continue;
+            }
+
+            const GeometryAllocation old_geometry = buffers.geometry;
+            GeometryAllocation new_geometry;
+            if (!pool.allocateOutside(old_geometry, new_geometry))
+            {
+                continue;
+            }
+
+            VkBufferCopy vertex_copy { old_geometry.vertex_offset, new_geometry.vertex_offset, old_geometry.vertex_size };
+            vkCmdCopyBuffer(cmd, pool.vertexBuffer(old_geometry.page), pool.vertexBuffer(new_geometry.page), 1, &vertex_copy);
+
+            VkBufferCopy index_copy { old_geometry.first_index * sizeof(uint32_t), new_geometry.first_index * sizeof(uint32_t),
+                old_geometry.index_count * sizeof(uint32_t) };
+            vkCmdCopyBuffer(cmd, pool.indexBuffer(old_geometry.page), pool.indexBuffer(new_geometry.page), 1, &index_copy);
+
+            // Patched right away, frames in flight keep drawing from the old ranges until they are freed
+            const VkDeviceAddress old_address = buffers.vertex_buffer_address;
+            buffers.geometry = new_geometry;
+            buffers.vertex_buffer_address = pool.vertexAddress(new_geometry);
+
+            for (auto& [other_name, other] : engine->loaded_scenes)
+            {
+                if (other->scene_graph)
+                {
+                    other->scene_graph->relocateGeometry(old_geometry, old_address, new_geometry, buffers.vertex_buffer_address);
+                }
+            }
+            engine->draw_commands.relocateGeometry(old_geometry, old_address, new_geometry, buffers.vertex_buffer_address);
+            engine->gpu_culling.invalidateBatches();
+
+            engine->getCurrentFrame().delete_queue.pushFunction([&pool, old_geometry]()
+                {
+                    pool.free(old_geometry);
+                });
+
+            moved_bytes += old_geometry.vertex_size + (VkDeviceSize)old_geometry.index_count * sizeof(uint32_t);
+            geometry_moves++;
+        }
+    }
+
+    if (moved_bytes == 0)
+    {
+        return;
+    }
+    geometry_moved_bytes += moved_bytes;
+
+    // This frame's draws read the new ranges
+    VkMemoryBarrier2 barrier { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT |
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+        (engine->mesh_shading_supported ? VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT : VK_PIPELINE_STAGE_2_NONE);
+    barrier.dstAccessMask = VK_ACCESS_2_INDEX_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+
+    VkDependencyInfo dep_info { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep_info.memoryBarrierCount = 1;
+    dep_info.pMemoryBarriers = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dep_info);
+}
+
+void MemoryManager::beginPass(VkCommandBuffer cmd)
+{
+    VkResult result = vmaBeginDefragmentationPass(allocator, context, &pass_info);
+    if (result == VK_SUCCESS)
+    {
+        // Nothing left to move
+        endDefragmentation();
+        return;
+    }
+    if (result != VK_INCOMPLETE)
+    {
+        VK_CHECK(result);
+    }
+
+    // Only allocations with an owner to patch (and no upload in flight) move, VMA keeps the rest
+    moves.clear();
+    moves.resize(pass_info.moveCount);
+    pass_copies = 0;
+
+    for (uint32_t i = 0; i < pass_info.moveCount; i++)
+    {
+        VmaDefragmentationMove& vma_move = pass_info.pMoves[i];
+        Move& move = moves[i];
+
+        move.record = findRecord(vma_move.srcAllocation);
+        if (move.record)
+        {
+            Record& record = *move.record;
+            record.move_index = i;
+
+            if (record.mesh && engine->upload_manager.isReady(record.upload))
+            {
+                move.copied = prepareBufferMove(vma_move, record, move);
+            }
+            else if (record.image && engine->upload_manager.isReady(record.upload))
+            {
+                move.copied = prepareImageMove(vma_move, record, move);
+            }
+        }
+
+        if (move.copied)
+        {
+            pass_copies++;
+        }
+        else
+        {
+            vma_move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+        }
+    }
+
+    recordCopies(cmd);
+
+    pass_frame = engine->frame_number;
+    views_replaced = false;
+    defrag_passes++;
+}
+
+bool MemoryManager::prepareBufferMove(const VmaDefragmentationMove& vma_move, Record& record, Move& move)
+{
+    VkBuffer new_buffer;
+    VK_CHECK(vkCreateBuffer(device, &record.buffer_info, nullptr, &new_buffer));
+    if (vmaBindBufferMemory(allocator, vma_move.dstTmpAllocation, new_buffer) != VK_SUCCESS)
+    {
+        vkDestroyBuffer(device, new_buffer, nullptr);
+        return false;
+    }
+
+    // Patched right away, frames already recorded keep reading the old buffer until the pass ends
+    GPUMeshBuffers& mesh = *record.mesh;
+    move.old_buffer = mesh.meshlet_buffer.buffer;
+    move.new_buffer = new_buffer;
+
+    const VkDeviceAddress old_address = mesh.meshlet_address;
+    const VkDeviceAddress new_address = engine->getBufferAddress(new_buffer);
+
+    mesh.meshlet_buffer.buffer = new_buffer;
+    mesh.meshlet_data_address = new_address + (mesh.meshlet_data_address - old_address);
+    mesh.meshlet_address = new_address;
+
+    // Cached render objects and the draw list point into the buffer too
+    for (auto& [name, scene] : engine->loaded_scenes)
+    {
+        if (scene->scene_graph)
+        {
+            scene->scene_graph->relocateMeshlets(old_address, record.buffer_info.size, new_address);
+        }
+    }
+    engine->draw_commands.relocateMeshlets(old_address, record.buffer_info.size, new_address);
+
+    return true;
+}
+
+bool MemoryManager::prepareImageMove(const VmaDefragmentationMove& vma_move, Record& record, Move& move)
+{
+    VkImage new_image;
+    VK_CHECK(vkCreateImage(device, &record.image_info, nullptr, &new_image));
+    if (vmaBindImageMemory(allocator, vma_move.dstTmpAllocation, new_image) != VK_SUCCESS)
+    {
+        vkDestroyImage(device, new_image, nullptr);
+        return false;
+    }
+
+    AllocatedImage& image = *record.image;
+
+    VkImageViewCreateInfo view_info = vkinit::imageview_create_info(image.format, new_image, VK_IMAGE_ASPECT_COLOR_BIT);
+    view_info.subresourceRange.levelCount = record.image_info.mipLevels;
+    VK_CHECK(vkCreateImageView(device, &view_info, nullptr, &move.new_view));
+
+    // Owner gets the new handles, bindless materials keep the old view until replaceViews()
+    move.old_image = image.image;
+    move.old_view = image.view;
+    move.new_image = new_image;
+
+    image.image = new_image;
+    image.view = move.new_view;
+
+    return true;
+}
+
+void MemoryManager::recordCopies(VkCommandBuffer cmd)
+{
+    if (pass_copies == 0)
+    {
+        return;
+    }
+
+    pre_barriers.clear();
+    post_barriers.clear();
+    bool buffers_copied = false;
+
+    for (const Move& move : moves)
+    {
+        if (!move.copied)
+        {
+            continue;
+        }
+        if (move.new_buffer != VK_NULL_HANDLE)
+        {
+            buffers_copied = true;
+            continue;
+        }
+
+        // Old image is copied from and goes back to shader reads (frames in flight sample it),
+        // the new one starts undefined
+        VkImageMemoryBarrier2 barrier { .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange = vkinit::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT);
+
+        VkImageMemoryBarrier2 src = barrier;
+        src.srcStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        src.srcAccessMask = VK_ACCESS_2_NONE;
+        src.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        src.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+        src.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        src.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        src.image = move.old_image;
+        pre_barriers.push_back(src);
+
+        VkImageMemoryBarrier2 dst = barrier;
+        dst.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        dst.srcAccessMask = VK_ACCESS_2_NONE;
+        dst.dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        dst.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        dst.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        dst.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        dst.image = move.new_image;
+        pre_barriers.push_back(dst);
+
+        src.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        src.srcAccessMask = VK_ACCESS_2_NONE;
+        src.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        src.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        src.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        src.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        post_barriers.push_back(src);
+
+        dst.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        dst.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        dst.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        dst.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        dst.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        dst.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        post_barriers.push_back(dst);
+    }
+
+    if (!pre_barriers.empty())
+    {
+        VkDependencyInfo dep_info { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep_info.imageMemoryBarrierCount = (uint32_t)pre_barriers.size();
+        dep_info.pImageMemoryBarriers = pre_barriers.data();
+        vkCmdPipelineBarrier2(cmd, &dep_info);
+    }
+
+    for (const Move& move : moves)
+    {
+        if (!move.copied)
+        {
+            continue;
+        }
+
+        if (move.new_buffer != VK_NULL_HANDLE)
+        {
+            VkBufferCopy copy { 0, 0, move.record->buffer_info.size };
+            vkCmdCopyBuffer(cmd, move.old_buffer, move.new_buffer, 1, &copy);
+            continue;
+        }
+
+        // Every level of the chain (block formats: the level extent covers whole blocks)
+        const VkImageCreateInfo& info = move.record->image_info;
+        image_copies.clear();
+        for (uint32_t level = 0; level < info.mipLevels; level++)
+        {
+            VkImageCopy2 region { .sType = VK_STRUCTURE_TYPE_IMAGE_COPY_2 };
+            region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.srcSubresource.mipLevel = level;
+            region.srcSubresource.layerCount = 1;
+            region.dstSubresource = region.srcSubresource;
+            region.extent.width = std::max(info.extent.width >> level, 1u);
+            region.extent.height = std::max(info.extent.height >> level, 1u);
+            region.extent.depth = 1;
+            image_copies.push_back(region);
+        }
+
+        VkCopyImageInfo2 copy_info { .sType = VK_STRUCTURE_TYPE_COPY_IMAGE_INFO_2 };
+        copy_info.srcImage = move.old_image;
+        copy_info.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        copy_info.dstImage = move.new_image;
+        copy_info.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        copy_info.regionCount = (uint32_t)image_copies.size();
+        copy_info.pRegions = image_copies.data();
+        vkCmdCopyImage2(cmd, &copy_info);
+    }
+
+    // Meshlet buffers are only read by the task / mesh shaders
+    VkMemoryBarrier2 memory_barrier { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    memory_barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+    memory_barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    memory_barrier.dstStageMask = VK_PIPELINE_STAGE_2_TASK_SHADER_BIT_EXT | VK_PIPELINE_STAGE_2_MESH_SHADER_BIT_EXT;
+    memory_barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+
+    VkDependencyInfo dep_info { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep_info.memoryBarrierCount = buffers_copied ? 1 : 0;
+    dep_info.pMemoryBarriers = &memory_barrier;
+    dep_info.imageMemoryBarrierCount = (uint32_t)post_barriers.size();
+    dep_info.pImageMemoryBarriers = post_barriers.data();
+    vkCmdPipelineBarrier2(cmd, &dep_info);
+}
+
+void MemoryManager::replaceViews()
+{
+    // New slots for the new views, older frames (still in flight until the pass ends) keep the old ones
+    for (Move& move : moves)
+    {
+        if (move.copied && move.record && move.new_view != VK_NULL_HANDLE)
+        {
+            engine->bindless_registry.replaceView(move.old_view, move.new_view, move.retired_slots);
+        }
+    }
+    views_replaced = true;
+}
+
+void MemoryManager::endPass()
+{
+    // No frame in flight reads the old resources anymore
+    for (Move& move : moves)
+    {
+        for (uint32_t slot : move.retired_slots)
+        {
+            engine->bindless_registry.releaseTexture(slot);
+        }
+        if (move.old_view != VK_NULL_HANDLE)
+        {
+            vkDestroyImageView(device, move.old_view, nullptr);
+        }
+        if (move.old_image != VK_NULL_HANDLE)
+        {
+            vkDestroyImage(device, move.old_image, nullptr);
+        }
+        if (move.old_buffer != VK_NULL_HANDLE)
+        {
+            vkDestroyBuffer(device, move.old_buffer, nullptr);
+        }
+        if (move.record)
+        {
+            move.record->move_index = UINT32_MAX;
+        }
+    }
+
+    // Copied allocations now refer to their new memory
+    VkResult result = vmaEndDefragmentationPass(allocator, context, &pass_info);
+
+    for (Move& move : moves)
+    {
+        if (move.copied && move.record && move.record->mesh)
+        {
+            AllocatedBuffer& buffer = move.record->mesh->meshlet_buffer;
+            vmaGetAllocationInfo(allocator, buffer.allocation, &buffer.info);
+        }
+    }
+
+    moves.clear();
+    pass_frame = -1;
+
+    // Done, or nothing in reach could move (the rest is pinned until the next run)
+    if (result == VK_SUCCESS || pass_copies == 0)
+    {
+        endDefragmentation();
+    }
+}
+
+void MemoryManager::endDefragmentation()
+{
+    VmaDefragmentationStats stats {};
+    vmaEndDefragmentation(allocator, context, &stats);
+    context = VK_NULL_HANDLE;
+
+    defrag_runs++;
+    defrag_moves += stats.allocationsMoved;
+    defrag_bytes += stats.bytesMoved;
+    defrag_freed_bytes += stats.bytesFreed;
+
+    // Statistics refreshed next frame, the next run waits a while
+    retry_frame = engine->frame_number + (int)RETRY_FRAMES;
+    stats_frame = engine->frame_number - (int)STATS_INTERVAL;
+
+    fmt::println("GPU memory defragmented: {} allocations moved ({:.1f} MB), {} blocks freed ({:.1f} MB)",
+        stats.allocationsMoved, Megabytes(stats.bytesMoved), stats.deviceMemoryBlocksFreed, Megabytes(stats.bytesFreed));
+}
+
+void MemoryManager::drawImGui()
+{
+    if (ImGui::Begin("Memory"))
+    {
+        for (uint32_t i = 0; i < heap_count; i++)
+        {
+            const HeapStats& h = heaps[i];
+            ImGui::Text("Heap %u%s: %.1f / %.1f MB (%u allocations)", i, h.device_local ? " (device local)" : "",
+                Megabytes(h.usage), Megabytes(h.budget), h.allocation_count);
+        }
+
+        ImGui::Separator();
+        static const char* category_names[] = { "Meshes", "Textures", "Transient", "Other" };
+        for (size_t c = 0; c < (size_t)MemoryCategory::count; c++)
+        {
+            ImGui::Text("%s: %.1f MB (%u)", category_names[c], Megabytes(category_bytes[c].load()), category_counts[c].load());
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Fragmentation: %.1f%% (%.1f MB unused in blocks)", frag_ratio * 100.f, Megabytes(free_block_bytes));
+        ImGui::Checkbox("Defragment When Idle", &defrag_enabled);
+        ImGui::SliderFloat("Threshold", &fragmentation_threshold, 0.05f, 0.9f);
+        ImGui::Text("Defragmentation: %s", isDefragmenting() ? "running" : "idle");
+        ImGui::Text("Runs: %u, passes: %u", defrag_runs, defrag_passes);
+        ImGui::Text("Moved: %u (%.1f MB), freed: %.1f MB", defrag_moves, Megabytes(defrag_bytes), Megabytes(defrag_freed_bytes));
+
+        ImGui::Separator();
+        const GeometryPool& pool = engine->geometry_pool;
+        ImGui::Text("Geometry pool: %.1f / %.1f MB in %u pages (%u released)", Megabytes(pool.usedBytes()),
+            Megabytes(pool.capacityBytes()), pool.livePageCount(), pool.pages_released);
+        ImGui::Text("Pool fragmentation: %.1f%% (%u free ranges)", pool.fragmentation() * 100.f, pool.freeRangeCount());
+        ImGui::Text("Compaction: %u meshes moved (%.1f MB)", geometry_moves, Megabytes(geometry_moved_bytes));
+    }
+    ImGui::End();
+}
@@ -0,0 +1,181 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// GPU memory telemetry (heap budgets, per-category totals) and incremental VMA defragmentation
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+class phVkEngine;
+
+// What an allocation holds, for the per-category totals
+enum class MemoryCategory
+{
+    mesh,           // Geometry pages, meshlet buffers
+    texture,        // Sampled-only images
+    transient,      // Per-frame buffers, render targets and render graph memory
+    other,
+    count
+};
+
+// Every allocation made through the engine carries a record (VMA user data) with its category
+// and creation parameters. Owners can register allocations they are able to patch as movable.
+//
+// Defragmentation runs in idle frames (no scene loads or texture transitions in flight) once the
+// unused fraction of device-local blocks goes over the threshold. One VMA pass at a time
+// (K = MAX_FRAME_OVERLAP, so changing the frames in flight mid-pass is safe):
+//   pass frame N       - movable allocations are copied into their new place on the frame's command
+//                        buffer, owners are patched right away (mesh addresses, image handles)
+//   N + K - 1          - bindless materials switch to the new views (no older frame is in flight)
+//   N + max(K, 2K - 2) - no frame can read the old resources, they are destroyed and the pass ends
+// Anything not registered (or still uploading) is left in place for the pass.
+//
+// Geometry pool pages are suballocated, so VMA can't compact them: with the statistics, idle frames
+// copy scene meshes out of the sparsest extra page into room in the others (patching the meshes and
+// the cached render objects). The old ranges are freed with the frame, the emptied page is released.
+// Tracking is thread-safe, the rest is driven by the render loop
+class MemoryManager
+{
+public:
+    static constexpr uint32_t STATS_INTERVAL = 60;          // Frames between full statistics
+    static constexpr uint32_t RETRY_FRAMES = 600;           // After a defragmentation, before the next
+    static constexpr VkDeviceSize MAX_PASS_BYTES = 16 * 1024 * 1024;
+    static constexpr uint32_t MAX_PASS_MOVES = 64;
+    static constexpr VkDeviceSize MIN_FREE_BYTES = 32 * 1024 * 1024;    // Worth defragmenting
+    static constexpr float GEOMETRY_COMPACT_OCCUPANCY = 0.25f;          // Used fraction of a page to empty it
+
+    // Switched by the UI
+    bool defrag_enabled { true };
+    float fragmentation_threshold { 0.2f };     // Unused fraction of device-local blocks
+
+    void init(phVkEngine* engine);
+    // Device must be idle, finishes a defragmentation in progress (tracking keeps working)
+    void destroy();
+
+    // *** Tracking ***
+    void trackBuffer(VmaAllocation allocation, const VkBufferCreateInfo& info, MemoryCategory category);
+    void trackImage(VmaAllocation allocation, const VkImageCreateInfo& info, MemoryCategory category);
+    void trackMemory(VmaAllocation allocation, MemoryCategory category);    // Bound by the caller, never moved
+
+    // Forgets the allocation before it is freed. Returns false while a defragmentation pass moves
+    // it: VMA frees the memory when the pass ends, the caller only destroys the buffer / image
+    static bool Release(VmaAllocator allocator, VmaAllocation allocation);
+
+    // Owner patched when the allocation moves, may only be used once the upload is ready
+    // Meshes: meshlet buffer (buffer and addresses, scene graph objects are relocated)
+    // Images: handle and view, bindless materials only (descriptor sets would keep the old view)
+    void setMovable(GPUMeshBuffers& mesh, UploadHandle upload);
+    void setMovable(AllocatedImage& image, UploadHandle upload);
+
+    // Heap budgets, statistics and the defragmentation pass for this frame
+    // Called on the frame's command buffer after the upload acquires
+    void update(VkCommandBuffer cmd, bool idle);
+
+    void drawImGui();
+
+    bool isDefragmenting() const { return context != VK_NULL_HANDLE; }
+
+    // Stats
+    struct HeapStats
+    {
+        VkDeviceSize budget { 0 };
+        VkDeviceSize usage { 0 };
+        VkDeviceSize block_bytes { 0 };
+        VkDeviceSize allocation_bytes { 0 };
+        uint32_t allocation_count { 0 };
+        bool device_local { false };
+    };
+
+    uint32_t heapCount() const { return heap_count; }
+    const HeapStats& heap(uint32_t i) const { return heaps[i]; }
+    VkDeviceSize categoryBytes(MemoryCategory category) const { return category_bytes[(size_t)category].load(); }
+    uint32_t categoryCount(MemoryCategory category) const { return category_counts[(size_t)category].load(); }
+    float fragmentation() const { return frag_ratio; }
+    VkDeviceSize freeBlockBytes() const { return free_block_bytes; }
+
+    uint32_t defrag_runs { 0 };             // Completed defragmentations
+    uint32_t defrag_passes { 0 };
+    uint32_t defrag_moves { 0 };            // Allocations moved (all runs)
+    VkDeviceSize defrag_bytes { 0 };
+    VkDeviceSize defrag_freed_bytes { 0 };  // Device memory blocks given back
+    uint32_t geometry_moves { 0 };          // Meshes moved between geometry pool pages
+    VkDeviceSize geometry_moved_bytes { 0 };
+
+private:
+    struct Record
+    {
+        MemoryManager* manager;
+        MemoryCategory category;
+        VkDeviceSize size;
+        bool is_image { false };
+        VkBufferCreateInfo buffer_info {};
+        VkImageCreateInfo image_info {};
+
+        // Movable owner (at most one)
+        GPUMeshBuffers* mesh { nullptr };
+        AllocatedImage* image { nullptr };
+        UploadHandle upload;
+
+        uint32_t move_index { UINT32_MAX };  // In the current pass
+    };
+
+    // Copy in the current pass, the old handles are destroyed when it ends
+    struct Move
+    {
+        Record* record { nullptr };         // Null once released
+        bool copied { false };              // Otherwise ignored for the pass
+        VkBuffer old_buffer { VK_NULL_HANDLE };
+        VkBuffer new_buffer { VK_NULL_HANDLE };
+        VkImage old_image { VK_NULL_HANDLE };
+        VkImage new_image { VK_NULL_HANDLE };
+        VkImageView old_view { VK_NULL_HANDLE };
+        VkImageView new_view { VK_NULL_HANDLE };
+        std::vector<uint32_t> retired_slots;    // Bindless slots of the old view
+    };
+
+    Record* addRecord(VmaAllocation allocation, MemoryCategory category);
+    Record* findRecord(VmaAllocation allocation) const;
+    void collectStatistics();
+    void compactGeometry(VkCommandBuffer cmd);
+
+    // Pass steps (see the class comment)
+    void beginPass(VkCommandBuffer cmd);
+    // New resource bound to the move's destination, owner patched (false = can't move)
+    bool prepareBufferMove(const VmaDefragmentationMove& vma_move, Record& record, Move& move);
+    bool prepareImageMove(const VmaDefragmentationMove& vma_move, Record& record, Move& move);
+    void recordCopies(VkCommandBuffer cmd);
+    void replaceViews();
+    void endPass();
+    void endDefragmentation();
+
+    phVkEngine* engine { nullptr };
+    VkDevice device { VK_NULL_HANDLE };
+    VmaAllocator allocator { VK_NULL_HANDLE };
+
+    std::array<std::atomic<VkDeviceSize>, (size_t)MemoryCategory::count> category_bytes {};
+    std::array<std::atomic<uint32_t>, (size_t)MemoryCategory::count> category_counts {};
+
+    std::array<HeapStats, VK_MAX_MEMORY_HEAPS> heaps {};
+    uint32_t heap_count { 0 };
+    int stats_frame { -(int)STATS_INTERVAL };
+    float frag_ratio { 0.f };
+    VkDeviceSize free_block_bytes { 0 };
+
+    VmaDefragmentationContext context { VK_NULL_HANDLE };
+    VmaDefragmentationPassMoveInfo pass_info {};
+    std::vector<Move> moves;                // Parallel to pass_info.pMoves
+    int pass_frame { -1 };                  // -1 = no pass in flight
+    bool views_replaced { false };
+    uint32_t pass_copies { 0 };
+    int retry_frame { 0 };                  // No new defragmentation before
+
+    // Barriers of the pass copies (kept for their capacity)
+    std::vector<VkImageMemoryBarrier2> pre_barriers;
+    std::vector<VkImageMemoryBarrier2> post_barriers;
+    std::vector<VkImageCopy2> image_copies;
+};
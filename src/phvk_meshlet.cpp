@@ -0,0 +1,166 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Meshlets (VK_EXT_mesh_shader geometry path)
+
+#include "phvk_meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+// Bounding sphere and normal cone of one finished meshlet
+static void ComputeMeshletBounds(std::span<const Vertex> vertices, const MeshletData& out, GPUMeshlet& m,
+    bool cone_culling)
+{
+    // *** Sphere ***
+    // Center of the AABB, radius to the farthest vertex
+    Vec3f min = vertices[out.data[m.vertex_offset]].position;
+    Vec3f max = min;
+    for (uint32_t i = 0; i < m.vertex_count; i++)
+    {
+        const Vec3f& p = vertices[out.data[m.vertex_offset + i]].position;
+        min = Vec3f(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+        max = Vec3f(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+    }
+    m.center = Vec3f((min.x + max.x) * 0.5f, (min.y + max.y) * 0.5f, (min.z + max.z) * 0.5f);
+
+    float radius_sq = 0.f;
+    for (uint32_t i = 0; i < m.vertex_count; i++)
+    {
+        const Vec3f& p = vertices[out.data[m.vertex_offset + i]].position;
+        float dx = p.x - m.center.x;
+        float dy = p.y - m.center.y;
+        float dz = p.z - m.center.z;
+        radius_sq = std::max(radius_sq, dx * dx + dy * dy + dz * dz);
+    }
+    m.radius = std::sqrt(radius_sq);
+
+    // *** Cone ***
+    // Axis is the average unit normal, the cutoff covers the widest normal around it
+    // (a cone wider than a hemisphere is left open)
+    m.cone_axis = Vec3f(0.f, 0.f, 0.f);
+    m.cone_cutoff = 1.f;
+    if (!cone_culling)
+    {
+        return;
+    }
+
+    std::vector<Vec3f> normals;
+    normals.reserve(m.triangle_count);
+
+    float ax = 0.f, ay = 0.f, az = 0.f;
+    for (uint32_t t = 0; t < m.triangle_count; t++)
+    {
+        uint32_t packed = out.data[m.triangle_offset + t];
+        const Vec3f& a = vertices[out.data[m.vertex_offset + (packed & 0xFF)]].position;
+        const Vec3f& b = vertices[out.data[m.vertex_offset + ((packed >> 8) & 0xFF)]].position;
+        const Vec3f& c = vertices[out.data[m.vertex_offset + ((packed >> 16) & 0xFF)]].position;
+
+        float e1x = b.x - a.x, e1y = b.y - a.y, e1z = b.z - a.z;
+        float e2x = c.x - a.x, e2y = c.y - a.y, e2z = c.z - a.z;
+        float nx = e1y * e2z - e1z * e2y;
+        float ny = e1z * e2x - e1x * e2z;
+        float nz = e1x * e2y - e1y * e2x;
+
+        float length = std::sqrt(nx * nx + ny * ny + nz * nz);
+        if (length <= 0.f)
+        {
+            continue;
+        }
+        normals.push_back(Vec3f(nx / length, ny / length, nz / length));
+
+        ax += normals.back().x;
+        ay += normals.back().y;
+        az += normals.back().z;
+    }
+
+    float axis_length = std::sqrt(ax * ax + ay * ay + az * az);
+    if (normals.empty() || axis_length <= 0.f)
+    {
+        return;
+    }
+    m.cone_axis = Vec3f(ax / axis_length, ay / axis_length, az / axis_length);
+
+    float min_dot = 1.f;
+    for (const Vec3f& n : normals)
+    {
+        min_dot = std::min(min_dot, n.x * m.cone_axis.x + n.y * m.cone_axis.y + n.z * m.cone_axis.z);
+    }
+
+    if (min_dot > 0.f)
+    {
+        m.cone_cutoff = std::sqrt(1.f - min_dot * min_dot);
+    }
+}
+
+uint32_t BuildMeshlets(std::span<const Vertex> vertices, std::span<const uint32_t> indices, bool cone_culling,
+    MeshletData& out)
+{
+    const uint32_t first_meshlet = (uint32_t)out.meshlets.size();
+
+    // Local index of each mesh vertex in the current meshlet
+    std::unordered_map<uint32_t, uint8_t> local;
+    std::vector<uint32_t> meshlet_vertices;
+    std::vector<uint32_t> meshlet_triangles;
+
+    auto flush = [&]()
+        {
+            if (meshlet_triangles.empty())
+            {
+                return;
+            }
+
+            GPUMeshlet m {};
+            m.vertex_offset = (uint32_t)out.data.size();
+            m.vertex_count = (uint32_t)meshlet_vertices.size();
+            out.data.insert(out.data.end(), meshlet_vertices.begin(), meshlet_vertices.end());
+
+            m.triangle_offset = (uint32_t)out.data.size();
+            m.triangle_count = (uint32_t)meshlet_triangles.size();
+            out.data.insert(out.data.end(), meshlet_triangles.begin(), meshlet_triangles.end());
+
+            ComputeMeshletBounds(vertices, out, m, cone_culling);
+            out.meshlets.push_back(m);
+
+            local.clear();
+            meshlet_vertices.clear();
+            meshlet_triangles.clear();
+        };
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        const uint32_t tri[3] = { indices[t], indices[t + 1], indices[t + 2] };
+
+        uint32_t new_vertices = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+            if (!repeated && !local.contains(tri[k]))
+            {
+                new_vertices++;
+            }
+        }
+
+        if (meshlet_vertices.size() + new_vertices > MESHLET_MAX_VERTICES ||
+            meshlet_triangles.size() + 1 > MESHLET_MAX_TRIANGLES)
+        {
+            flush();
+        }
+
+        uint32_t packed = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            auto [it, inserted] = local.try_emplace(tri[k], (uint8_t)meshlet_vertices.size());
+            if (inserted)
+            {
+                meshlet_vertices.push_back(tri[k]);
+            }
+            packed |= (uint32_t)it->second << (8 * k);
+        }
+        meshlet_triangles.push_back(packed);
+    }
+    flush();
+
+    return first_meshlet;
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Meshlets (VK_EXT_mesh_shader geometry path)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <span>
+#include <vector>
+
+// Sized for the mesh shader outputs (meshlet.glsl)
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// Meshlets handled per task shader workgroup (meshlet.task)
+constexpr uint32_t MESHLET_TASK_GROUP_SIZE = 32;
+
+// std430 layout, must match Meshlet in meshlet.glsl
+struct GPUMeshlet
+{
+    Vec3f center;               // Object-space bounding sphere
+    float radius;
+    Vec3f cone_axis;            // Average triangle normal
+    float cone_cutoff;          // Sine of the normal cone's half angle, 1 = never backface culled
+    uint32_t vertex_offset;     // Into MeshletData::data: mesh-local vertex indices
+    uint32_t triangle_offset;   // Into MeshletData::data: one word per triangle (3 x 8-bit local indices)
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+};
+static_assert(sizeof(GPUMeshlet) == 48, "GPUMeshlet must match meshlet.glsl");
+
+// Meshlets of one mesh, every surface owns a contiguous range
+struct MeshletData
+{
+    std::vector<GPUMeshlet> meshlets;
+    std::vector<uint32_t> data;         // Vertex indices and packed triangles of every meshlet
+};
+
+// Split the triangles of indices (mesh-local) into meshlets, appended to out
+// Triangles are taken in index order, so locality follows the source's vertex cache order
+// cone_culling = false leaves every cone open (double-sided surfaces)
+// Returns the index of the first new meshlet
+uint32_t BuildMeshlets(std::span<const Vertex> vertices, std::span<const uint32_t> indices, bool cone_culling,
+    MeshletData& out);
@@ -0,0 +1,193 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Occlusion culling (Hi-Z depth pyramid)
+
+#include "phvk_occlusion.h"
+
+#include "phvk_engine.h"
+#include "phvk_images.h"
+#include "phvk_initializers.h"
+#include "phvk_pipelines.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Compute writes to the pyramid visible to the next reduction / cull dispatch
+static void PyramidBarrier(VkCommandBuffer cmd)
+{
+    VkMemoryBarrier2 barrier { .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2 };
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+
+    VkDependencyInfo dep_info { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep_info.memoryBarrierCount = 1;
+    dep_info.pMemoryBarriers = &barrier;
+
+    vkCmdPipelineBarrier2(cmd, &dep_info);
+}
+
+void DepthPyramid::init(phVkEngine* engine)
+{
+    VkDevice device = engine->device;
+
+    // *** Image ***
+    depth_extent = { engine->depth_image.extent.width, engine->depth_image.extent.height };
+    extent = { std::max(1u, (depth_extent.width + 1) / 2), std::max(1u, (depth_extent.height + 1) / 2) };
+
+    image = engine->createImage(VkExtent3D{ extent.width, extent.height, 1 }, VK_FORMAT_R32_SFLOAT,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, true);
+
+    mip_count = std::min(MAX_MIPS,
+        static_cast<uint32_t>(std::floor(std::log2(std::max(extent.width, extent.height)))) + 1);
+
+    for (uint32_t i = 0; i < mip_count; i++)
+    {
+        VkImageViewCreateInfo view_info = vkinit::imageview_create_info(image.format, image.image, VK_IMAGE_ASPECT_COLOR_BIT);
+        view_info.subresourceRange.baseMipLevel = i;
+        VK_CHECK(vkCreateImageView(device, &view_info, nullptr, &mip_views[i]));
+    }
+
+    engine->immediateSubmit([&](VkCommandBuffer cmd)
+        {
+            vkutil::transition_image(cmd, image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+        });
+
+    VkSamplerCreateInfo sampler_info = { .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO };
+    sampler_info.magFilter = VK_FILTER_NEAREST;
+    sampler_info.minFilter = VK_FILTER_NEAREST;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sampler_info.maxLod = VK_LOD_CLAMP_NONE;
+    sampler = engine->resource_cache.getSampler(sampler_info);
+
+    // *** Descriptors ***
+    std::vector<DescriptorAllocatorGrowable::PoolSizeRatio> sizes = {
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 } };
+    descriptor_pool.init(device, MAX_MIPS + 1, sizes);
+
+    {
+        DescriptorLayoutBuilder builder;
+        builder.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        sample_layout = builder.build(engine->resource_cache, VK_SHADER_STAGE_COMPUTE_BIT);
+    }
+    {
+        DescriptorLayoutBuilder builder;
+        builder.addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        builder.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+        reduce_layout = builder.build(engine->resource_cache, VK_SHADER_STAGE_COMPUTE_BIT);
+    }
+
+    sample_set = descriptor_pool.allocate(device, sample_layout);
+
+    DescriptorWriter writer;
+    writer.writeImage(0, image.view, sampler, VK_IMAGE_LAYOUT_GENERAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+    writer.updateSet(device, sample_set);
+
+    for (uint32_t i = 0; i < mip_count; i++)
+    {
+        reduce_sets[i] = descriptor_pool.allocate(device, reduce_layout);
+
+        writer.clear();
+        if (i == 0)
+        {
+            writer.writeImage(0, engine->depth_image.view, sampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        }
+        else
+        {
+            writer.writeImage(0, mip_views[i - 1], sampler, VK_IMAGE_LAYOUT_GENERAL,
+                VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        }
+        writer.writeImage(1, mip_views[i], VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+        writer.updateSet(device, reduce_sets[i]);
+    }
+
+    // *** Pipeline ***
+    VkShaderModule reduce_shader;
+    if (!vkutil::load_shader_module(PHVK_SHADER_DIR "hiz.comp.spv", device, &reduce_shader))
+    {
+        fmt::println("Occlusion culling disabled: error when building the depth reduce shader");
+        return;
+    }
+
+    VkPushConstantRange push_constant{};
+    push_constant.offset = 0;
+    push_constant.size = sizeof(GPUDepthReducePushConstants);
+    push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkPipelineLayoutCreateInfo layout_info = vkinit::pipeline_layout_create_info();
+    layout_info.pSetLayouts = &reduce_layout;
+    layout_info.setLayoutCount = 1;
+    layout_info.pPushConstantRanges = &push_constant;
+    layout_info.pushConstantRangeCount = 1;
+
+    VK_CHECK(vkCreatePipelineLayout(device, &layout_info, nullptr, &layout));
+
+    VkComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.pNext = nullptr;
+    pipeline_info.layout = layout;
+    pipeline_info.stage = vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_COMPUTE_BIT, reduce_shader);
+
+    VK_CHECK(vkCreateComputePipelines(device, engine->pipeline_cache.cache, 1, &pipeline_info, nullptr, &pipeline));
+
+    vkDestroyShaderModule(device, reduce_shader, nullptr);
+}
+
+void DepthPyramid::destroy(phVkEngine* engine)
+{
+    VkDevice device = engine->device;
+
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        vkDestroyPipeline(device, pipeline, nullptr);
+        vkDestroyPipelineLayout(device, layout, nullptr);
+    }
+
+    // Layouts and the sampler belong to the resource cache
+    descriptor_pool.destroyPools(device);
+
+    for (uint32_t i = 0; i < mip_count; i++)
+    {
+        vkDestroyImageView(device, mip_views[i], nullptr);
+    }
+    if (image.image != VK_NULL_HANDLE)
+    {
+        engine->destroyImage(image);
+    }
+
+    *this = DepthPyramid();
+}
+
+void DepthPyramid::record(VkCommandBuffer cmd, phVkEngine* engine)
+{
+    if (!isSupported())
+    {
+        return;
+    }
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+
+    for (uint32_t i = 0; i < mip_count; i++)
+    {
+        GPUDepthReducePushConstants push_constants;
+        push_constants.dst_width = std::max(1u, extent.width >> i);
+        push_constants.dst_height = std::max(1u, extent.height >> i);
+
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &reduce_sets[i], 0, nullptr);
+        vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GPUDepthReducePushConstants),
+            &push_constants);
+
+        // 8x8 threads per workgroup, one destination texel per thread
+        vkCmdDispatch(cmd, (push_constants.dst_width + 7) / 8, (push_constants.dst_height + 7) / 8, 1);
+
+        // Next mip reads this one (the last barrier covers the cull dispatch)
+        PyramidBarrier(cmd);
+    }
+}
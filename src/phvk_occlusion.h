@@ -0,0 +1,60 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Occlusion culling (Hi-Z depth pyramid)
+
+#pragma once
+
+#include "phvk_types.h"
+#include "phvk_descriptors.h"
+
+class phVkEngine;
+
+// Push constants for hiz.comp
+struct GPUDepthReducePushConstants
+{
+    uint32_t dst_width;
+    uint32_t dst_height;
+};
+
+// Hierarchical depth built from depth_image after the early geometry pass
+// Mip 0 is half the depth resolution, every texel holds the farthest depth it covers
+// (reversed depth: the minimum), so a box nearer than every texel under it is visible
+struct DepthPyramid
+{
+    static constexpr uint32_t MAX_MIPS = 16;
+
+    AllocatedImage image {};                // R32_SFLOAT, kept in GENERAL layout
+    VkImageView mip_views[MAX_MIPS] {};
+    uint32_t mip_count { 0 };
+    VkExtent2D extent {};                   // Mip 0
+    VkExtent2D depth_extent {};             // Source depth image
+
+    VkSampler sampler { VK_NULL_HANDLE };   // Nearest, clamp to edge
+
+    // Sampled by cull.comp (set 0, binding 0: whole pyramid)
+    VkDescriptorSetLayout sample_layout { VK_NULL_HANDLE };
+    VkDescriptorSet sample_set { VK_NULL_HANDLE };
+
+    // True when the reduce pipeline was created
+    bool isSupported() const { return pipeline != VK_NULL_HANDLE; }
+
+    // Depth image must exist and have VK_IMAGE_USAGE_SAMPLED_BIT
+    // The image and sample set are always created so cull.comp can bind them
+    void init(phVkEngine* engine);
+    void destroy(phVkEngine* engine);
+
+    // Reduce depth_image into every mip (must be recorded outside of rendering)
+    // Depth is expected in SHADER_READ_ONLY_OPTIMAL, visible to compute (render graph Hi-Z pass)
+    void record(VkCommandBuffer cmd, phVkEngine* engine);
+
+private:
+    VkPipeline pipeline { VK_NULL_HANDLE };
+    VkPipelineLayout layout { VK_NULL_HANDLE };
+
+    // Per mip: binding 0 source (depth or previous mip), binding 1 destination
+    VkDescriptorSetLayout reduce_layout { VK_NULL_HANDLE };
+    VkDescriptorSet reduce_sets[MAX_MIPS] {};
+
+    DescriptorAllocatorGrowable descriptor_pool;
+};
@@ -0,0 +1,172 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Pipeline cache persistence and parallel pipeline compilation
+
+#include "phvk_pipeline_cache.h"
+
+#include "phvk_engine.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+// *** PipelineCache ***
+
+// True if the cache data was written by this device and driver
+static bool ValidateCacheHeader(const std::vector<char>& data, const VkPhysicalDeviceProperties& props)
+{
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+
+    return header.headerSize >= sizeof(header) &&
+        header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header.vendorID == props.vendorID &&
+        header.deviceID == props.deviceID &&
+        memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void PipelineCache::init(phVkEngine* engine, const std::filesystem::path& file_path)
+{
+    device = engine->device;
+    path = file_path;
+    loaded_size = 0;
+
+    // *** Load ***
+    std::vector<char> data;
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (file.is_open())
+    {
+        data.resize((size_t)file.tellg());
+        file.seekg(0);
+        file.read(data.data(), data.size());
+
+        if (!file || !ValidateCacheHeader(data, engine->physical_device_properties))
+        {
+            fmt::println("Pipeline cache {} is stale or invalid, starting empty", path.string());
+            data.clear();
+        }
+    }
+
+    // *** Create ***
+    VkPipelineCacheCreateInfo info = { .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+    info.initialDataSize = data.size();
+    info.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(device, &info, nullptr, &cache) != VK_SUCCESS)
+    {
+        // Driver rejected the data anyway, retry empty
+        info.initialDataSize = 0;
+        info.pInitialData = nullptr;
+        data.clear();
+        VK_CHECK(vkCreatePipelineCache(device, &info, nullptr, &cache));
+    }
+
+    loaded_size = data.size();
+}
+
+void PipelineCache::destroy()
+{
+    if (cache != VK_NULL_HANDLE)
+    {
+        vkDestroyPipelineCache(device, cache, nullptr);
+        cache = VK_NULL_HANDLE;
+    }
+}
+
+bool PipelineCache::save()
+{
+    if (cache == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+
+    size_t size = 0;
+    VK_CHECK(vkGetPipelineCacheData(device, cache, &size, nullptr));
+
+    std::vector<char> data(size);
+    if (size == 0 || vkGetPipelineCacheData(device, cache, &size, data.data()) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    // Write to a temporary file first so an interrupted save can't leave a truncated cache
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open() || !file.write(data.data(), size))
+        {
+            fmt::println("Failed to write pipeline cache {}", temp_path.string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec)
+    {
+        fmt::println("Failed to write pipeline cache {}: {}", path.string(), ec.message());
+        return false;
+    }
+
+    return true;
+}
+
+
+// *** PipelineCompileBatch ***
+
+void PipelineCompileBatch::add(const PipelineBuilder& builder, VkPipeline* out_pipeline)
+{
+    graphics.emplace_back(builder, out_pipeline);
+}
+
+void PipelineCompileBatch::add(const VkComputePipelineCreateInfo& info, VkPipeline* out_pipeline)
+{
+    compute.emplace_back(info, out_pipeline);
+}
+
+void PipelineCompileBatch::compile(phVkEngine* engine)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    VkDevice device = engine->device;
+    VkPipelineCache cache = engine->pipeline_cache.cache;   // Internally synchronized
+
+    // One job per pipeline, drivers compile independent pipelines in parallel
+    JobCounter counter;
+
+    for (auto& [builder, out_pipeline] : graphics)
+    {
+        engine->jobs.schedule([&builder, out_pipeline, device, cache]()
+            {
+                *out_pipeline = builder.buildPipeline(device, cache);
+            }, &counter);
+    }
+
+    for (auto& [info, out_pipeline] : compute)
+    {
+        engine->jobs.schedule([&info, out_pipeline, device, cache]()
+            {
+                if (vkCreateComputePipelines(device, cache, 1, &info, nullptr, out_pipeline) != VK_SUCCESS)
+                {
+                    fmt::println("failed to create compute pipeline");
+                    *out_pipeline = VK_NULL_HANDLE;
+                }
+            }, &counter);
+    }
+
+    engine->jobs.wait(counter);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    fmt::println("Compiled {} pipelines in {:.1f} ms", size(), elapsed.count() / 1000.f);
+
+    graphics.clear();
+    compute.clear();
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Pipeline cache persistence and parallel pipeline compilation
+
+#pragma once
+
+#include "phvk_types.h"
+#include "phvk_pipelines.h"
+
+#include <deque>
+#include <filesystem>
+
+class phVkEngine;
+
+// VkPipelineCache backed by a file, loaded at startup and saved at shutdown
+// Cache data from a different device / driver (header mismatch) is discarded
+struct PipelineCache
+{
+    VkPipelineCache cache { VK_NULL_HANDLE };
+
+    void init(phVkEngine* engine, const std::filesystem::path& file_path);
+    void destroy();
+
+    // Write the current cache contents to disk, returns false on failure
+    bool save();
+
+    // Bytes of valid cache data found on disk at startup (0 on a cold start)
+    size_t loadedSize() const { return loaded_size; }
+
+private:
+    VkDevice device { VK_NULL_HANDLE };
+    std::filesystem::path path;
+    size_t loaded_size { 0 };
+};
+
+// Batch of pipelines compiled concurrently on the engine's job system (using its pipeline cache)
+// Builders and create infos are copied, the shader modules and layouts they reference
+// must stay alive until compile() returns
+struct PipelineCompileBatch
+{
+    void add(const PipelineBuilder& builder, VkPipeline* out_pipeline);
+    void add(const VkComputePipelineCreateInfo& info, VkPipeline* out_pipeline);
+
+    // Blocks (running jobs on the calling thread) until every pipeline is built
+    // Failed pipelines are left as VK_NULL_HANDLE
+    void compile(phVkEngine* engine);
+
+    size_t size() const { return graphics.size() + compute.size(); }
+
+private:
+    std::deque<std::pair<PipelineBuilder, VkPipeline*>> graphics;
+    std::vector<std::pair<VkComputePipelineCreateInfo, VkPipeline*>> compute;
+};
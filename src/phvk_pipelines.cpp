@@ -32,8 +32,14 @@ void PipelineBuilder::clear()
 //< pipe_clear
 
 //> buildPipeline_1
-VkPipeline PipelineBuilder::buildPipeline(VkDevice device)
+VkPipeline PipelineBuilder::buildPipeline(VkDevice device, VkPipelineCache cache)
 {
+    // Re-point the format at this builder (builders are copied for parallel compiles)
+    if (render_info.colorAttachmentCount > 0)
+    {
+        render_info.pColorAttachmentFormats = &color_attachment_format;
+    }
+
     // Make viewport state from our stored viewport and scissor
     // at the moment we wont support multiple viewports or scissors
     VkPipelineViewportStateCreateInfo viewport_state = {};
@@ -92,7 +98,7 @@ VkPipeline PipelineBuilder::buildPipeline(VkDevice device)
     // It's easy to error out on create graphics pipeline, so we handle it a bit
     // better than the common VK_CHECK case
     VkPipeline new_pipeline;
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeline_info,
+    if (vkCreateGraphicsPipelines(device, cache, 1, &pipeline_info,
             nullptr, &new_pipeline)
         != VK_SUCCESS) {
         fmt::println("failed to create pipeline");
@@ -114,6 +120,20 @@ void PipelineBuilder::setShaders(VkShaderModule vertex_shader, VkShaderModule fr
         vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_FRAGMENT_BIT, fragment_shader));
 }
 //< setShaders
+void PipelineBuilder::setMeshShaders(VkShaderModule task_shader, VkShaderModule mesh_shader, 
+    VkShaderModule fragment_shader)
+{
+    shader_stages.clear();
+
+    shader_stages.push_back(
+        vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_TASK_BIT_EXT, task_shader));
+
+    shader_stages.push_back(
+        vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_MESH_BIT_EXT, mesh_shader));
+
+    shader_stages.push_back(
+        vkinit::pipeline_shader_stage_create_info(VK_SHADER_STAGE_FRAGMENT_BIT, fragment_shader));
+}
 //> set_topo
 void PipelineBuilder::setInputTopology(VkPrimitiveTopology topology)
 {
@@ -8,6 +8,11 @@
 
 #include "phvk_types.h"
 
+// Compiled shader directory (set by CMake: the build tree, or shaders/ with pre-built binaries)
+#ifndef PHVK_SHADER_DIR
+#define PHVK_SHADER_DIR "../../../../shaders/"
+#endif
+
 class PipelineBuilder {
 //> pipeline
 public:
@@ -26,9 +31,11 @@ public:
 
     void clear();
 
-    VkPipeline buildPipeline(VkDevice device);
+    VkPipeline buildPipeline(VkDevice device, VkPipelineCache cache = VK_NULL_HANDLE);
 //< pipeline
     void setShaders(VkShaderModule vertex_shader, VkShaderModule fragment_shader);
+    // Task + mesh shader pipeline (vertex input / input assembly state is ignored)
+    void setMeshShaders(VkShaderModule task_shader, VkShaderModule mesh_shader, VkShaderModule fragment_shader);
     void setInputTopology(VkPrimitiveTopology topology);
     void setPolygonMode(VkPolygonMode mode);
     void setCullMode(VkCullModeFlags cull_mode, VkFrontFace front_face);
@@ -0,0 +1,414 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// GPU profiler (timestamp scopes and pipeline statistics)
+
+#include "phvk_profiler.h"
+
+#include "phvk_engine.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cstring>
+
+// *** ScopeHistory ***
+
+void GPUProfiler::ScopeHistory::add(float ms)
+{
+    samples[next] = ms;
+    next = (next + 1) % HISTORY;
+    count = std::min(count + 1, HISTORY);
+}
+
+void GPUProfiler::ScopeHistory::minAvgMax(float& min, float& avg, float& max) const
+{
+    min = max = avg = 0.f;
+    if (count == 0)
+    {
+        return;
+    }
+
+    min = samples[0];
+    max = samples[0];
+    float sum = 0.f;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        min = std::min(min, samples[i]);
+        max = std::max(max, samples[i]);
+        sum += samples[i];
+    }
+    avg = sum / count;
+}
+
+
+// *** GPUProfiler ***
+
+void GPUProfiler::init(phVkEngine* engine, uint32_t queue_family, bool statistics_supported)
+{
+    device = engine->device;
+    this->statistics_supported = statistics_supported;
+
+    // Timestamps need valid bits on the queue that records them
+    uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(engine->physical_device, &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(engine->physical_device, &family_count, families.data());
+
+    uint32_t valid_bits = families[queue_family].timestampValidBits;
+    if (valid_bits == 0 || engine->physical_device_properties.limits.timestampPeriod <= 0.f)
+    {
+        fmt::println("GPU profiler disabled: queue family has no timestamp support");
+        timestamp_period = 0.f;
+        return;
+    }
+
+    timestamp_period = engine->physical_device_properties.limits.timestampPeriod;
+    timestamp_mask = (valid_bits >= 64) ? ~0ull : ((1ull << valid_bits) - 1);
+
+    for (int i = 0; i < MAX_FRAME_OVERLAP; i++)
+    {
+        GPUProfilerFrame& frame = engine->frames[i].profiler_frame;
+
+        VkQueryPoolCreateInfo info = { .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+        info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        info.queryCount = MAX_SCOPES * 2;
+        VK_CHECK(vkCreateQueryPool(device, &info, nullptr, &frame.timestamp_pool));
+
+        if (statistics_supported)
+        {
+            info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            info.queryCount = 1;
+            info.pipelineStatistics = STATISTIC_FLAGS;
+            VK_CHECK(vkCreateQueryPool(device, &info, nullptr, &frame.statistics_pool));
+        }
+
+        frame.scope_count = 0;
+        frame.statistics_written = false;
+    }
+}
+
+void GPUProfiler::destroy(phVkEngine* engine)
+{
+    stopCSV();
+
+    for (int i = 0; i < MAX_FRAME_OVERLAP; i++)
+    {
+        GPUProfilerFrame& frame = engine->frames[i].profiler_frame;
+
+        if (frame.timestamp_pool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(device, frame.timestamp_pool, nullptr);
+        }
+        if (frame.statistics_pool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(device, frame.statistics_pool, nullptr);
+        }
+
+        frame = GPUProfilerFrame();
+    }
+}
+
+void GPUProfiler::beginFrame(VkCommandBuffer cmd, GPUProfilerFrame& frame, uint64_t frame_number)
+{
+    current = nullptr;
+    if (!isSupported())
+    {
+        return;
+    }
+
+    resolve(frame);
+
+    frame.scope_count = 0;
+    frame.statistics_written = false;
+    frame.frame_number = frame_number;
+
+    if (!enabled)
+    {
+        return;
+    }
+
+    vkCmdResetQueryPool(cmd, frame.timestamp_pool, 0, MAX_SCOPES * 2);
+    if (frame.statistics_pool != VK_NULL_HANDLE)
+    {
+        vkCmdResetQueryPool(cmd, frame.statistics_pool, 0, 1);
+    }
+
+    current = &frame;
+}
+
+uint32_t GPUProfiler::beginScope(VkCommandBuffer cmd, const char* name)
+{
+    if (!current || current->scope_count >= MAX_SCOPES)
+    {
+        return UINT32_MAX;
+    }
+
+    uint32_t scope = current->scope_count++;
+    current->scope_names[scope] = name;
+
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, current->timestamp_pool, scope * 2);
+
+    return scope;
+}
+
+void GPUProfiler::endScope(VkCommandBuffer cmd, uint32_t scope)
+{
+    if (!current || scope == UINT32_MAX)
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, current->timestamp_pool, scope * 2 + 1);
+}
+
+void GPUProfiler::beginStatistics(VkCommandBuffer cmd)
+{
+    if (!current || current->statistics_pool == VK_NULL_HANDLE || !collect_statistics || current->statistics_written)
+    {
+        return;
+    }
+
+    vkCmdBeginQuery(cmd, current->statistics_pool, 0, 0);
+    statistics_active = true;
+}
+
+void GPUProfiler::endStatistics(VkCommandBuffer cmd)
+{
+    if (!statistics_active)
+    {
+        return;
+    }
+
+    vkCmdEndQuery(cmd, current->statistics_pool, 0);
+    current->statistics_written = true;
+    statistics_active = false;
+}
+
+void GPUProfiler::resolve(GPUProfilerFrame& frame)
+{
+    // *** Timestamps ***
+    if (frame.scope_count > 0)
+    {
+        uint64_t ticks[MAX_SCOPES * 2];
+
+        // The frame's fence has signaled, so the results are available without waiting
+        VkResult result = vkGetQueryPoolResults(device, frame.timestamp_pool, 0, frame.scope_count * 2,
+            sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+        if (result == VK_SUCCESS)
+        {
+            uint64_t first = UINT64_MAX;
+            uint64_t last = 0;
+
+            for (uint32_t i = 0; i < frame.scope_count; i++)
+            {
+                uint64_t begin = ticks[i * 2] & timestamp_mask;
+                uint64_t end = ticks[i * 2 + 1] & timestamp_mask;
+                first = std::min(first, begin);
+                last = std::max(last, end);
+
+                float ms = (end >= begin) ? (end - begin) * timestamp_period / 1000000.f : 0.f;
+
+                ScopeHistory& history = findScope(frame.scope_names[i]);
+                history.add(ms);
+                history.last_frame = frame.frame_number;
+
+                if (csv.is_open())
+                {
+                    csv << frame.frame_number << ",gpu." << history.name << ".ms," << ms << "\n";
+                }
+                if (on_sample)
+                {
+                    on_sample(frame.frame_number, history.name, ms);
+                }
+            }
+
+            float frame_ms = (last >= first) ? (last - first) * timestamp_period / 1000000.f : 0.f;
+            frame_history.add(frame_ms);
+            frame_history.last_frame = frame.frame_number;
+
+            if (csv.is_open())
+            {
+                csv << frame.frame_number << ",gpu.frame.ms," << frame_ms << "\n";
+            }
+            if (on_sample)
+            {
+                on_sample(frame.frame_number, "frame", frame_ms);
+            }
+        }
+    }
+
+    // *** Pipeline Statistics ***
+    if (frame.statistics_written)
+    {
+        uint64_t values[STATISTIC_COUNT];
+        VkResult result = vkGetQueryPoolResults(device, frame.statistics_pool, 0, 1,
+            sizeof(values), values, sizeof(values), VK_QUERY_RESULT_64_BIT);
+
+        if (result == VK_SUCCESS)
+        {
+            memcpy(statistics, values, sizeof(values));
+            statistics_frame = frame.frame_number;
+
+            if (csv.is_open())
+            {
+                for (uint32_t i = 0; i < STATISTIC_COUNT; i++)
+                {
+                    csv << frame.frame_number << ",stats." << STATISTIC_NAMES[i] << "," << values[i] << "\n";
+                }
+            }
+        }
+    }
+}
+
+GPUProfiler::ScopeHistory& GPUProfiler::findScope(const char* name)
+{
+    for (ScopeHistory& s : scopes)
+    {
+        if (s.name == name)
+        {
+            return s;
+        }
+    }
+
+    scopes.emplace_back();
+    scopes.back().name = name;
+    return scopes.back();
+}
+
+float GPUProfiler::averageScopeTime(const char* name) const
+{
+    for (const ScopeHistory& s : scopes)
+    {
+        if (s.name == name)
+        {
+            float min, avg, max;
+            s.minAvgMax(min, avg, max);
+            return avg;
+        }
+    }
+    return 0.f;
+}
+
+float GPUProfiler::averageFrameTime() const
+{
+    float min, avg, max;
+    frame_history.minAvgMax(min, avg, max);
+    return avg;
+}
+
+float GPUProfiler::latestFrameTime(uint64_t& frame_number) const
+{
+    frame_number = frame_history.last_frame;
+    if (frame_history.count == 0)
+    {
+        return 0.f;
+    }
+    return frame_history.samples[(frame_history.next + HISTORY - 1) % HISTORY];
+}
+
+bool GPUProfiler::startCSV(const std::filesystem::path& path)
+{
+    stopCSV();
+
+    csv.open(path, std::ios::trunc);
+    if (!csv.is_open())
+    {
+        fmt::println("Failed to open profiler CSV {}", path.string());
+        return false;
+    }
+
+    csv << "frame,metric,value\n";
+    return true;
+}
+
+void GPUProfiler::stopCSV()
+{
+    if (csv.is_open())
+    {
+        csv.close();
+    }
+}
+
+void GPUProfiler::drawImGui()
+{
+    if (ImGui::Begin("GPU Profiler"))
+    {
+        if (!isSupported())
+        {
+            ImGui::Text("Timestamps unsupported on this queue");
+            ImGui::End();
+            return;
+        }
+
+        ImGui::Checkbox("Enabled", &enabled);
+
+        ImGui::BeginDisabled(!statistics_supported);
+        ImGui::SameLine();
+        ImGui::Checkbox("Pipeline statistics", &collect_statistics);
+        ImGui::EndDisabled();
+
+        if (ImGui::Button(csv.is_open() ? "Stop CSV" : "Start CSV"))
+        {
+            if (csv.is_open())
+            {
+                stopCSV();
+            }
+            else
+            {
+                startCSV("gpu_profile.csv");
+            }
+        }
+
+        // Rolling timings (scopes not recorded for a while are hidden)
+        uint64_t newest = 0;
+        for (const ScopeHistory& s : scopes)
+        {
+            newest = std::max(newest, s.last_frame);
+        }
+
+        if (ImGui::BeginTable("scopes", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit))
+        {
+            ImGui::TableSetupColumn("Scope");
+            ImGui::TableSetupColumn("Min (ms)");
+            ImGui::TableSetupColumn("Avg (ms)");
+            ImGui::TableSetupColumn("Max (ms)");
+            ImGui::TableHeadersRow();
+
+            auto row = [](const char* name, const ScopeHistory& s)
+                {
+                    float min, avg, max;
+                    s.minAvgMax(min, avg, max);
+
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn(); ImGui::TextUnformatted(name);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", min);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", avg);
+                    ImGui::TableNextColumn(); ImGui::Text("%.3f", max);
+                };
+
+            for (const ScopeHistory& s : scopes)
+            {
+                if (s.last_frame + HISTORY >= newest)
+                {
+                    row(s.name.c_str(), s);
+                }
+            }
+            row("Frame (GPU)", frame_history);
+
+            ImGui::EndTable();
+        }
+
+        if (statistics_supported && collect_statistics && statistics_frame > 0)
+        {
+            ImGui::Separator();
+            ImGui::Text("Pipeline statistics (frame %llu)", (unsigned long long)statistics_frame);
+            for (uint32_t i = 0; i < STATISTIC_COUNT; i++)
+            {
+                ImGui::Text("%s: %llu", STATISTIC_NAMES[i], (unsigned long long)statistics[i]);
+            }
+        }
+    }
+    ImGui::End();
+}
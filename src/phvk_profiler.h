@@ -0,0 +1,137 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// GPU profiler (timestamp scopes and pipeline statistics)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+
+class phVkEngine;
+
+struct GPUProfilerFrame;
+
+struct GPUProfiler
+{
+    static constexpr uint32_t MAX_SCOPES = 32;
+    static constexpr uint32_t HISTORY = 128;           // Rolling window (frames)
+
+    // Pipeline statistics counters, in the order the query returns them
+    static constexpr uint32_t STATISTIC_COUNT = 7;
+    static constexpr const char* STATISTIC_NAMES[STATISTIC_COUNT] = {
+        "Input vertices", "Input primitives", "Vertex invocations",
+        "Clipping invocations", "Clipping primitives", "Fragment invocations",
+        "Compute invocations" };
+    static constexpr VkQueryPipelineStatisticFlags STATISTIC_FLAGS =
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+        VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+    bool enabled { true };
+    bool collect_statistics { true };
+
+    // Optional sink for every resolved time (scope name, or "frame" for the whole-frame total)
+    std::function<void(uint64_t frame_number, const std::string& metric, float ms)> on_sample;
+
+    bool isSupported() const { return timestamp_period > 0.f; }
+    bool statisticsSupported() const { return statistics_supported; }
+    bool statisticsActive() const { return statistics_active; }    // Secondaries must inherit the query
+
+    // statistics_supported: device was created with pipelineStatisticsQuery
+    void init(phVkEngine* engine, uint32_t queue_family, bool statistics_supported);
+    void destroy(phVkEngine* engine);
+
+    // Resolve the frame slot's previous results, then reset its pools
+    // Record right after vkBeginCommandBuffer (the frame's fence must have been waited on)
+    void beginFrame(VkCommandBuffer cmd, GPUProfilerFrame& frame, uint64_t frame_number);
+
+    // Timestamps around a pass, name must outlive the frame (string literal)
+    // Returns UINT32_MAX when disabled or out of scopes (endScope ignores it)
+    uint32_t beginScope(VkCommandBuffer cmd, const char* name);
+    void endScope(VkCommandBuffer cmd, uint32_t scope);
+
+    // Pipeline statistics around one span per frame (outside or around whole rendering instances)
+    void beginStatistics(VkCommandBuffer cmd);
+    void endStatistics(VkCommandBuffer cmd);
+
+    // ImGui panel with rolling min / avg / max
+    void drawImGui();
+
+    // CSV export (frame,metric,value rows), one row per scope and statistic per resolved frame
+    bool startCSV(const std::filesystem::path& path);
+    void stopCSV();
+    bool isWritingCSV() const { return csv.is_open(); }
+
+    // Average GPU time of a scope over the history window (ms, 0 if unknown)
+    float averageScopeTime(const char* name) const;
+    float averageFrameTime() const;
+
+    // Most recently resolved GPU frame time (ms, 0 if none yet) and the frame it was recorded in
+    float latestFrameTime(uint64_t& frame_number) const;
+
+private:
+    struct ScopeHistory
+    {
+        std::string name;
+        float samples[HISTORY] {};
+        uint32_t count { 0 };       // Valid samples (up to HISTORY)
+        uint32_t next { 0 };        // Ring position
+        uint64_t last_frame { 0 };  // Last frame this scope was seen
+
+        void add(float ms);
+        void minAvgMax(float& min, float& avg, float& max) const;
+    };
+
+    VkDevice device { VK_NULL_HANDLE };
+    float timestamp_period { 0.f };         // ns per tick, 0 if timestamps are unsupported
+    uint64_t timestamp_mask { 0 };
+    bool statistics_supported { false };
+
+    GPUProfilerFrame* current { nullptr };
+    bool statistics_active { false };
+
+    std::vector<ScopeHistory> scopes;       // Stable order of first appearance
+    ScopeHistory frame_history;             // First begin to last end
+    uint64_t statistics[STATISTIC_COUNT] {};
+    uint64_t statistics_frame { 0 };
+
+    std::ofstream csv;
+
+    ScopeHistory& findScope(const char* name);
+    void resolve(GPUProfilerFrame& frame);
+};
+
+// Per-frame query pools (owned by FrameData)
+// Results are read back the next time the frame slot is recorded, after its fence has
+// signaled, so reading never stalls (frame_overlap frames late)
+struct GPUProfilerFrame
+{
+    VkQueryPool timestamp_pool { VK_NULL_HANDLE };     // Two queries per scope (begin / end)
+    VkQueryPool statistics_pool { VK_NULL_HANDLE };    // One pipeline statistics query
+
+    const char* scope_names[GPUProfiler::MAX_SCOPES];
+    uint32_t scope_count { 0 };
+    bool statistics_written { false };
+    uint64_t frame_number { 0 };
+};
+
+// RAII helper for a profiler scope
+struct GPUProfileScope
+{
+    GPUProfileScope(GPUProfiler& profiler, VkCommandBuffer cmd, const char* name)
+        : profiler(profiler), cmd(cmd), scope(profiler.beginScope(cmd, name)) {}
+    ~GPUProfileScope() { profiler.endScope(cmd, scope); }
+
+    GPUProfiler& profiler;
+    VkCommandBuffer cmd;
+    uint32_t scope;
+};
@@ -0,0 +1,290 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Frame render graph (pass image usage, batched barriers, transient images)
+
+#include "phvk_render_graph.h"
+
+#include "phvk_engine.h"
+#include "phvk_initializers.h"
+
+#include <algorithm>
+
+// Layout / synchronization scope of an access
+struct GraphAccessInfo
+{
+    VkImageLayout layout;
+    VkPipelineStageFlags2 stages;
+    VkAccessFlags2 access;
+    bool write;
+};
+
+static GraphAccessInfo GetAccessInfo(GraphAccess access)
+{
+    switch (access)
+    {
+    case GraphAccess::storage_write:
+        return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, true };
+    case GraphAccess::compute_sampled:
+        return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, false };
+    case GraphAccess::color_attachment:
+        return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT, true };
+    case GraphAccess::depth_attachment:
+        return { VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL,
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, true };
+    case GraphAccess::transfer_src:
+        return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT,
+            VK_ACCESS_2_TRANSFER_READ_BIT, false };
+    case GraphAccess::transfer_dst:
+        return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT,
+            VK_ACCESS_2_TRANSFER_WRITE_BIT, true };
+    case GraphAccess::present:
+    default:
+        // Nothing reads it on the device, the render semaphore signal (all graphics stages) covers the transition
+        return { VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_2_NONE, false };
+    }
+}
+
+void RenderGraph::init(phVkEngine* engine)
+{
+    this->engine = engine;
+}
+
+void RenderGraph::destroy()
+{
+    // Device must be idle
+    for (Image& image : images)
+    {
+        if (!image.transient)
+        {
+            continue;
+        }
+        vkDestroyImageView(engine->device, image.image.view, nullptr);
+        vkDestroyImage(engine->device, image.image.image, nullptr);
+
+        // (freed by the defragmentation pass moving it otherwise)
+        if (MemoryManager::Release(engine->allocator, image.allocation))
+        {
+            vmaFreeMemory(engine->allocator, image.allocation);
+        }
+    }
+
+    images.clear();
+    passes.clear();
+    transient_bytes = 0;
+}
+
+uint32_t RenderGraph::createTransient(const char* name, VkExtent3D extent, VkFormat format, VkImageUsageFlags usage)
+{
+    Image& image = images.emplace_back();
+    image.name = name;
+    image.image.extent = extent;
+    image.image.format = format;
+    image.aspect = (format == VK_FORMAT_D32_SFLOAT) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    image.usage = usage;
+    image.transient = true;
+
+    return (uint32_t)images.size() - 1;
+}
+
+uint32_t RenderGraph::importImage(const char* name, VkImageAspectFlags aspect)
+{
+    Image& image = images.emplace_back();
+    image.name = name;
+    image.aspect = aspect;
+
+    return (uint32_t)images.size() - 1;
+}
+
+uint32_t RenderGraph::addPass(const char* name, ExecuteFunction&& execute)
+{
+    Pass& pass = passes.emplace_back();
+    pass.name = name;
+    pass.execute = std::move(execute);
+
+    return (uint32_t)passes.size() - 1;
+}
+
+void RenderGraph::use(uint32_t pass, uint32_t image, GraphAccess access)
+{
+    assert(access != GraphAccess::present);
+    assert(std::none_of(passes[pass].uses.begin(), passes[pass].uses.end(),
+        [image](const Use& u) { return u.image == image; }));
+
+    passes[pass].uses.push_back({ image, access });
+}
+
+void RenderGraph::setFinalAccess(uint32_t image, GraphAccess access)
+{
+    images[image].final_access = access;
+    images[image].has_final_access = true;
+}
+
+void RenderGraph::compile()
+{
+    // *** Transient Images ***
+    VmaAllocationCreateInfo alloc_info = {};
+    alloc_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    alloc_info.requiredFlags = VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    uint32_t transient_count = 0;
+    for (Image& image : images)
+    {
+        if (!image.transient)
+        {
+            continue;
+        }
+
+        VkImageCreateInfo image_info = vkinit::image_create_info(image.image.format, image.usage, image.image.extent);
+        VK_CHECK(vkCreateImage(engine->device, &image_info, nullptr, &image.image.image));
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(engine->device, image.image.image, &requirements);
+        VK_CHECK(vmaAllocateMemory(engine->allocator, &requirements, &alloc_info, &image.allocation, nullptr));
+        engine->memory_manager.trackMemory(image.allocation, MemoryCategory::transient);
+        VK_CHECK(vmaBindImageMemory(engine->allocator, image.allocation, image.image.image));
+        transient_bytes += requirements.size;
+
+        VkImageViewCreateInfo view_info = vkinit::imageview_create_info(image.image.format, image.image.image, image.aspect);
+        VK_CHECK(vkCreateImageView(engine->device, &view_info, nullptr, &image.image.view));
+
+        transient_count++;
+    }
+
+    fmt::println("Render graph: {} passes, {} transient images ({:.1f} MB)",
+        passes.size(), transient_count, transient_bytes / (1024.f * 1024.f));
+}
+
+void RenderGraph::setImported(uint32_t image, VkImage vk_image, VkImageView view, VkImageLayout layout,
+    VkPipelineStageFlags2 stages, VkAccessFlags2 access)
+{
+    Image& imported = images[image];
+    assert(!imported.transient);
+
+    imported.image.image = vk_image;
+    imported.image.view = view;
+
+    // Contents are visible to stages / access, the first barrier chains with them
+    imported.state = ImageState();
+    imported.state.layout = layout;
+    imported.state.write_stages = stages;
+    imported.state.visible_stages = stages;
+    imported.state.visible_access = access;
+}
+
+void RenderGraph::execute(VkCommandBuffer cmd)
+{
+    barriers_recorded = 0;
+    batches_recorded = 0;
+
+    for (Image& image : images)
+    {
+        image.used = false;
+    }
+
+    for (Pass& pass : passes)
+    {
+        if (!pass.enabled)
+        {
+            continue;
+        }
+
+        for (const Use& u : pass.uses)
+        {
+            transition(u.image, u.access);
+        }
+        flushBarriers(cmd);
+
+        GPUProfileScope scope(engine->gpu_profiler, cmd, pass.name);
+        pass.execute(cmd);
+    }
+
+    for (uint32_t i = 0; i < images.size(); i++)
+    {
+        if (images[i].used && images[i].has_final_access)
+        {
+            transition(i, images[i].final_access);
+        }
+    }
+    flushBarriers(cmd);
+}
+
+void RenderGraph::transition(uint32_t index, GraphAccess access)
+{
+    Image& image = images[index];
+    ImageState& state = image.state;
+    const GraphAccessInfo info = GetAccessInfo(access);
+
+    // First use this frame: a transient's contents are discarded, it still waits for its last use
+    // in the previous frame
+    if (!image.used)
+    {
+        image.used = true;
+        if (image.transient)
+        {
+            state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        }
+    }
+
+    VkImageMemoryBarrier2 barrier { .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+    barrier.oldLayout = state.layout;
+    barrier.newLayout = info.layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.image.image;
+    barrier.subresourceRange = vkinit::image_subresource_range(image.aspect);
+    barrier.dstStageMask = info.stages;
+    barrier.dstAccessMask = info.access;
+
+    if (state.layout != info.layout || info.write)
+    {
+        // Layout transitions and writes wait for every earlier access (write-after-read included)
+        barrier.srcStageMask = state.write_stages | state.read_stages;
+        barrier.srcAccessMask = state.write_access;
+        barriers.push_back(barrier);
+
+        // A transition is a write visible to this access only, later readers chain on its stages
+        state.layout = info.layout;
+        state.write_stages = info.stages;
+        state.write_access = info.write ? info.access : VK_ACCESS_2_NONE;
+        state.read_stages = info.write ? VK_PIPELINE_STAGE_2_NONE : info.stages;
+        state.visible_stages = info.stages;
+        state.visible_access = info.access;
+        return;
+    }
+
+    // Read in the same layout: only if the last write isn't visible to it yet
+    if (state.write_stages != VK_PIPELINE_STAGE_2_NONE &&
+        ((info.stages & ~state.visible_stages) || (info.access & ~state.visible_access)))
+    {
+        barrier.srcStageMask = state.write_stages;
+        barrier.srcAccessMask = state.write_access;
+        barriers.push_back(barrier);
+
+        state.visible_stages |= info.stages;
+        state.visible_access |= info.access;
+    }
+    state.read_stages |= info.stages;
+}
+
+void RenderGraph::flushBarriers(VkCommandBuffer cmd)
+{
+    if (barriers.empty())
+    {
+        return;
+    }
+
+    VkDependencyInfo dep_info { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+    dep_info.imageMemoryBarrierCount = (uint32_t)barriers.size();
+    dep_info.pImageMemoryBarriers = barriers.data();
+    vkCmdPipelineBarrier2(cmd, &dep_info);
+
+    barriers_recorded += (uint32_t)barriers.size();
+    batches_recorded++;
+    barriers.clear();
+}
@@ -0,0 +1,139 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Frame render graph (pass image usage, batched barriers, transient images)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <functional>
+#include <vector>
+
+class phVkEngine;
+
+// How a pass uses an image, the layout / stages / access flags follow from it
+enum class GraphAccess
+{
+    storage_write,      // Compute shader storage image write (GENERAL)
+    compute_sampled,    // Compute shader sampled read (SHADER_READ_ONLY)
+    color_attachment,   // Color attachment load / store (COLOR_ATTACHMENT)
+    depth_attachment,   // Depth test and write (DEPTH_ATTACHMENT)
+    transfer_src,       // Copy / blit source (TRANSFER_SRC)
+    transfer_dst,       // Copy / blit destination (TRANSFER_DST)
+    present             // Presentation engine (PRESENT_SRC), final access only
+};
+
+// Passes run in the order they were added and declare the images they use. Before every pass
+// the graph records one dependency with the barriers its images need, with the stage and access
+// masks of the previous use as the source (no barrier for a read that is already visible).
+//
+// Images are either
+//   transient - created by the graph (own allocation), contents discarded every frame
+//   imported  - owned elsewhere (swapchain, async compute output), bound every frame with the
+//               layout and stages of the last use outside the graph
+// Transient state carries over to the next frame, so its first barrier waits for the last use
+// of the memory by the frame before (frames in flight share the images).
+//
+// Only images are tracked. Buffer hazards are handled outside the graph by the code that owns the
+// buffers: GPUCulling's barriers order count resets, visibility and indirect commands (compute ->
+// compute -> DRAW_INDIRECT), per-frame buffers are written on the CPU before execute(). A pass with
+// no image uses gets no barriers from the graph.
+//
+// The pass list is fixed after compile(), passes not needed in a frame are disabled
+// Not thread-safe, built at init and executed by the render loop
+class RenderGraph
+{
+public:
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    using ExecuteFunction = std::function<void(VkCommandBuffer)>;
+
+    // *** Build ***
+    void init(phVkEngine* engine);
+    void destroy();
+
+    uint32_t createTransient(const char* name, VkExtent3D extent, VkFormat format, VkImageUsageFlags usage);
+    uint32_t importImage(const char* name, VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT);
+
+    // Pass recorded inside a GPU profiler scope with its name (name must outlive the graph)
+    uint32_t addPass(const char* name, ExecuteFunction&& execute);
+    void use(uint32_t pass, uint32_t image, GraphAccess access);
+
+    // Access the image is left in after the last pass that used it this frame
+    void setFinalAccess(uint32_t image, GraphAccess access);
+
+    // Creates the transient images
+    void compile();
+
+    // Transient: valid after compile(), imported: this frame's image
+    const AllocatedImage& image(uint32_t image) const { return images[image].image; }
+
+    // *** Frame ***
+    void setEnabled(uint32_t pass, bool enabled) { passes[pass].enabled = enabled; }
+
+    // Last use before this frame's first pass (layout UNDEFINED discards the contents)
+    void setImported(uint32_t image, VkImage vk_image, VkImageView view, VkImageLayout layout,
+        VkPipelineStageFlags2 stages, VkAccessFlags2 write_access = VK_ACCESS_2_NONE);
+
+    void execute(VkCommandBuffer cmd);
+
+    // Stats
+    uint32_t barriers_recorded { 0 };       // Image barriers last frame
+    uint32_t batches_recorded { 0 };        // vkCmdPipelineBarrier2 calls last frame
+    VkDeviceSize transientBytes() const { return transient_bytes; }
+
+private:
+    // Stages / access still to be synchronized with the next use
+    struct ImageState
+    {
+        VkImageLayout layout { VK_IMAGE_LAYOUT_UNDEFINED };
+        VkPipelineStageFlags2 write_stages { VK_PIPELINE_STAGE_2_NONE };
+        VkAccessFlags2 write_access { VK_ACCESS_2_NONE };
+        VkPipelineStageFlags2 read_stages { VK_PIPELINE_STAGE_2_NONE };     // Since the last write
+        VkPipelineStageFlags2 visible_stages { VK_PIPELINE_STAGE_2_NONE };  // Write made visible to
+        VkAccessFlags2 visible_access { VK_ACCESS_2_NONE };
+    };
+
+    struct Image
+    {
+        const char* name;
+        AllocatedImage image {};
+        VkImageAspectFlags aspect { VK_IMAGE_ASPECT_COLOR_BIT };
+        VkImageUsageFlags usage { 0 };
+        bool transient { false };
+        VmaAllocation allocation { VK_NULL_HANDLE };   // Transients
+
+        GraphAccess final_access { GraphAccess::present };
+        bool has_final_access { false };
+
+        ImageState state;
+        bool used { false };                // This frame
+    };
+
+    struct Use
+    {
+        uint32_t image;
+        GraphAccess access;
+    };
+
+    struct Pass
+    {
+        const char* name;
+        ExecuteFunction execute;
+        std::vector<Use> uses;
+        bool enabled { true };
+    };
+
+    // Barrier (if any) from the image's state to the access, updates the state
+    void transition(uint32_t image, GraphAccess access);
+    void flushBarriers(VkCommandBuffer cmd);
+
+    phVkEngine* engine { nullptr };
+
+    std::vector<Image> images;
+    std::vector<Pass> passes;
+    std::vector<VkImageMemoryBarrier2> barriers;    // Pending batch
+
+    VkDeviceSize transient_bytes { 0 };
+};
@@ -0,0 +1,196 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Shared resource caches (samplers, descriptor set layouts, textures loaded from files)
+
+#include "phvk_resource_cache.h"
+
+#include "phvk_engine.h"
+
+// Append raw field bytes to a cache key
+template <typename T>
+static void AppendKey(std::string& key, const T& value)
+{
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// *** Resource Cache ***
+
+void ResourceCache::init(VkDevice device)
+{
+    this->device = device;
+}
+
+void ResourceCache::destroy()
+{
+    for (auto& [key, sampler] : samplers)
+    {
+        vkDestroySampler(device, sampler, nullptr);
+    }
+    for (auto& [key, layout] : layouts)
+    {
+        vkDestroyDescriptorSetLayout(device, layout, nullptr);
+    }
+
+    samplers.clear();
+    layouts.clear();
+}
+
+VkSampler ResourceCache::getSampler(const VkSamplerCreateInfo& info)
+{
+    std::string key;
+    AppendKey(key, info.flags);
+    AppendKey(key, info.magFilter);
+    AppendKey(key, info.minFilter);
+    AppendKey(key, info.mipmapMode);
+    AppendKey(key, info.addressModeU);
+    AppendKey(key, info.addressModeV);
+    AppendKey(key, info.addressModeW);
+    AppendKey(key, info.mipLodBias);
+    AppendKey(key, info.anisotropyEnable);
+    AppendKey(key, info.maxAnisotropy);
+    AppendKey(key, info.compareEnable);
+    AppendKey(key, info.compareOp);
+    AppendKey(key, info.minLod);
+    AppendKey(key, info.maxLod);
+    AppendKey(key, info.borderColor);
+    AppendKey(key, info.unnormalizedCoordinates);
+
+    for (const VkBaseInStructure* next = (const VkBaseInStructure*)info.pNext; next; next = next->pNext)
+    {
+        assert(next->sType == VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO);
+        AppendKey(key, next->sType);
+        AppendKey(key, ((const VkSamplerReductionModeCreateInfo*)next)->reductionMode);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = samplers.find(key);
+    if (it != samplers.end())
+    {
+        cache_hits++;
+        return it->second;
+    }
+
+    VkSampler sampler;
+    VK_CHECK(vkCreateSampler(device, &info, nullptr, &sampler));
+    samplers.emplace(std::move(key), sampler);
+
+    return sampler;
+}
+
+VkDescriptorSetLayout ResourceCache::getDescriptorLayout(const VkDescriptorSetLayoutCreateInfo& info)
+{
+    std::string key;
+    AppendKey(key, info.flags);
+    AppendKey(key, info.bindingCount);
+
+    for (uint32_t i = 0; i < info.bindingCount; i++)
+    {
+        const VkDescriptorSetLayoutBinding& binding = info.pBindings[i];
+        AppendKey(key, binding.binding);
+        AppendKey(key, binding.descriptorType);
+        AppendKey(key, binding.descriptorCount);
+        AppendKey(key, binding.stageFlags);
+
+        const bool immutable = binding.pImmutableSamplers != nullptr;
+        AppendKey(key, immutable);
+        for (uint32_t s = 0; immutable && s < binding.descriptorCount; s++)
+        {
+            AppendKey(key, binding.pImmutableSamplers[s]);
+        }
+    }
+
+    for (const VkBaseInStructure* next = (const VkBaseInStructure*)info.pNext; next; next = next->pNext)
+    {
+        assert(next->sType == VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO);
+        const VkDescriptorSetLayoutBindingFlagsCreateInfo* flags = (const VkDescriptorSetLayoutBindingFlagsCreateInfo*)next;
+
+        AppendKey(key, next->sType);
+        AppendKey(key, flags->bindingCount);
+        for (uint32_t i = 0; i < flags->bindingCount; i++)
+        {
+            AppendKey(key, flags->pBindingFlags[i]);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = layouts.find(key);
+    if (it != layouts.end())
+    {
+        cache_hits++;
+        return it->second;
+    }
+
+    VkDescriptorSetLayout layout;
+    VK_CHECK(vkCreateDescriptorSetLayout(device, &info, nullptr, &layout));
+    layouts.emplace(std::move(key), layout);
+
+    return layout;
+}
+
+// *** Texture Cache ***
+
+void TextureCache::init(phVkEngine* engine)
+{
+    this->engine = engine;
+}
+
+void TextureCache::destroy()
+{
+    // Scenes release their references first, anything left is destroyed regardless
+    for (auto& [key, texture] : textures)
+    {
+        destroyTexture(*texture);
+    }
+    textures.clear();
+}
+
+std::shared_ptr<SharedTexture> TextureCache::acquire(const std::string& key, bool& created)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::shared_ptr<SharedTexture>& texture = textures[key];
+    created = texture == nullptr;
+    if (created)
+    {
+        texture = std::make_shared<SharedTexture>();
+        texture->key = key;
+    }
+    else
+    {
+        cache_hits++;
+    }
+
+    texture->refs++;
+    return texture;
+}
+
+void TextureCache::release(const std::shared_ptr<SharedTexture>& texture)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    assert(texture->refs > 0);
+    if (--texture->refs > 0)
+    {
+        return;
+    }
+
+    destroyTexture(*texture);
+    textures.erase(texture->key);
+}
+
+void TextureCache::destroyTexture(SharedTexture& texture)
+{
+    if (texture.gpu_image.has_value())
+    {
+        engine->destroyImage(*texture.gpu_image);
+        texture.gpu_image.reset();
+    }
+    if (texture.streamed_texture != TextureStreamer::INVALID_HANDLE)
+    {
+        engine->texture_streamer.release(texture.streamed_texture);
+        texture.streamed_texture = TextureStreamer::INVALID_HANDLE;
+    }
+}
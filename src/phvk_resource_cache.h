@@ -0,0 +1,96 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Shared resource caches (samplers, descriptor set layouts, textures loaded from files)
+
+#pragma once
+
+#include "phvk_types.h"
+#include "phvk_scene_cache.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+class phVkEngine;
+
+// Samplers and descriptor set layouts deduplicated by their create info
+// Objects are owned by the cache and live until destroy(), callers never destroy them
+// Thread-safe (loader jobs create samplers)
+class ResourceCache
+{
+public:
+    void init(VkDevice device);
+    void destroy();
+
+    // Supported pNext: VkSamplerReductionModeCreateInfo
+    VkSampler getSampler(const VkSamplerCreateInfo& info);
+
+    // Supported pNext: VkDescriptorSetLayoutBindingFlagsCreateInfo
+    VkDescriptorSetLayout getDescriptorLayout(const VkDescriptorSetLayoutCreateInfo& info);
+
+    // Stats
+    size_t samplerCount() const { return samplers.size(); }
+    size_t layoutCount() const { return layouts.size(); }
+    uint32_t hits() const { return cache_hits; }
+
+private:
+    VkDevice device { VK_NULL_HANDLE };
+    std::mutex mutex;
+
+    // Keyed by the create info's fields (pointers replaced by what they point to)
+    std::unordered_map<std::string, VkSampler> samplers;
+    std::unordered_map<std::string, VkDescriptorSetLayout> layouts;
+
+    uint32_t cache_hits { 0 };
+};
+
+// Image file decoded once and shared by every scene that references it
+struct SharedTexture
+{
+    std::string key;                            // Canonical path
+
+    // Written by the load that acquired it first, read by the others once decoded is set
+    std::atomic<bool> decoded { false };
+    bool failed { false };
+    BakedImage image;                           // Texels valid while texels_owner is alive
+    std::weak_ptr<const void> texels_owner;     // CPU chain (held by the loads, the streamer or a mapped bake)
+
+    // GPU side: full chain uploaded, or a streamed texture (created by the first FinalizeGLTF)
+    std::optional<AllocatedImage> gpu_image;
+    uint32_t streamed_texture { UINT32_MAX };
+
+    uint32_t refs { 0 };                        // Guarded by the cache
+};
+
+// Path-keyed, reference-counted textures shared across LoadedGLTF instances
+// acquire() is thread-safe, release() destroys GPU objects and runs on the main thread
+class TextureCache
+{
+public:
+    void init(phVkEngine* engine);
+    void destroy();
+
+    // Entry for key, created is true if the caller has to decode it (then set decoded)
+    std::shared_ptr<SharedTexture> acquire(const std::string& key, bool& created);
+
+    // Last reference destroys the image (or releases the streamed texture)
+    void release(const std::shared_ptr<SharedTexture>& texture);
+
+    // Stats
+    size_t size() const { return textures.size(); }
+    uint32_t hits() const { return cache_hits; }
+
+private:
+    void destroyTexture(SharedTexture& texture);
+
+    phVkEngine* engine { nullptr };
+    std::mutex mutex;
+
+    std::unordered_map<std::string, std::shared_ptr<SharedTexture>> textures;
+
+    uint32_t cache_hits { 0 };
+};
@@ -0,0 +1,601 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Baked scene cache (binary, memory-mapped, keyed by the source file's content hash and the
+// size and modification time of its external files)
+
+#include "phvk_scene_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// File layout (native endianness, blobs aligned to BLOB_ALIGNMENT from the file start):
+//   SceneCacheHeader
+//   sources:   path, size, write time
+//   samplers:  BakedSampler
+//   images:    name, uri, format, width, height, mip count, size, mip offsets, texels
+//   materials: name, CacheMaterial
+//   meshes:    name, CacheMeshCounts, vertices, indices, BakedSurface[], GPUMeshlet[], meshlet data
+//   nodes:     name, mesh, parent, local transform
+
+static constexpr uint32_t SCENE_CACHE_MAGIC = 0x4B424341;   // "ACBK"
+static constexpr size_t BLOB_ALIGNMENT = 16;
+
+struct SceneCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t source_hash;
+    uint32_t vertex_format;
+    uint32_t has_meshlets;
+    uint32_t sampler_count;
+    uint32_t image_count;
+    uint32_t material_count;
+    uint32_t mesh_count;
+    uint32_t node_count;
+    uint32_t source_file_count;
+};
+
+struct CacheMaterial
+{
+    Vec4f color_factors;
+    Vec4f metal_rough_factors;
+    uint32_t pass;
+    int32_t color_image;
+    int32_t color_sampler;
+    uint32_t pad;
+};
+
+struct CacheMeshCounts
+{
+    uint32_t vertex_count;
+    uint32_t vertex_bytes;
+    uint32_t index_count;
+    uint32_t surface_count;
+    uint32_t meshlet_count;
+    uint32_t meshlet_data_count;
+};
+
+
+// *** Mapped File ***
+
+bool MappedFile::open(const std::filesystem::path& path)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view)
+    {
+        if (mapping)
+        {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        return false;
+    }
+
+    file_handle = file;
+    mapping_handle = mapping;
+    bytes = (const uint8_t*)view;
+    length = (size_t)file_size.QuadPart;
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED)
+    {
+        ::close(file);
+        return false;
+    }
+
+    fd = file;
+    bytes = (const uint8_t*)view;
+    length = (size_t)info.st_size;
+#endif
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!bytes)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(bytes);
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+    file_handle = nullptr;
+    mapping_handle = nullptr;
+#else
+    munmap((void*)bytes, length);
+    ::close(fd);
+    fd = -1;
+#endif
+
+    bytes = nullptr;
+    length = 0;
+}
+
+
+// *** Hashing ***
+
+uint64_t HashFileContents(const std::filesystem::path& path)
+{
+    MappedFile file;
+    if (!file.open(path))
+    {
+        return 0;
+    }
+
+    // FNV-1a over 8-byte words (change detection, not security), tail bytes folded in one by one
+    const uint64_t prime = 0x100000001B3ull;
+    uint64_t hash = 0xCBF29CE484222325ull ^ file.size();
+
+    const size_t words = file.size() / 8;
+    for (size_t i = 0; i < words; i++)
+    {
+        uint64_t word;
+        memcpy(&word, file.data() + i * 8, 8);
+        hash = (hash ^ word) * prime;
+    }
+    for (size_t i = words * 8; i < file.size(); i++)
+    {
+        hash = (hash ^ file.data()[i]) * prime;
+    }
+
+    // Final avalanche, so nearby inputs don't give nearby keys
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+
+    return hash == 0 ? 1 : hash;
+}
+
+bool StatSourceFile(const std::filesystem::path& path, BakedSourceFile& file)
+{
+    std::error_code error;
+    file.size = std::filesystem::file_size(path, error);
+    if (error)
+    {
+        return false;
+    }
+
+    file.write_time = (int64_t)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    return !error;
+}
+
+std::filesystem::path SceneCachePath(const std::filesystem::path& source)
+{
+    return source.parent_path() / ".acid_cache" / (source.filename().string() + ".bake");
+}
+
+
+// *** Writing ***
+
+// Sequential writer with blob alignment relative to the file start
+struct CacheWriter
+{
+    std::ofstream out;
+    size_t position { 0 };
+
+    void write(const void* data, size_t size)
+    {
+        out.write((const char*)data, size);
+        position += size;
+    }
+
+    template<typename T>
+    void write(const T& value) { write(&value, sizeof(T)); }
+
+    void writeString(const std::string& s)
+    {
+        write((uint32_t)s.size());
+        write(s.data(), s.size());
+    }
+
+    void align()
+    {
+        static const uint8_t zeros[BLOB_ALIGNMENT] = {};
+        size_t padding = (BLOB_ALIGNMENT - position % BLOB_ALIGNMENT) % BLOB_ALIGNMENT;
+        write(zeros, padding);
+    }
+
+    template<typename T>
+    void writeBlob(std::span<const T> blob)
+    {
+        align();
+        write(blob.data(), blob.size_bytes());
+    }
+};
+
+bool WriteSceneCache(const std::filesystem::path& path, const BakedScene& scene)
+{
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp";
+
+    {
+        CacheWriter writer;
+        writer.out.open(temp_path, std::ios::binary | std::ios::trunc);
+        if (!writer.out)
+        {
+            return false;
+        }
+
+        SceneCacheHeader header {};
+        header.magic = SCENE_CACHE_MAGIC;
+        header.version = SCENE_CACHE_VERSION;
+        header.source_hash = scene.source_hash;
+        header.vertex_format = (uint32_t)scene.vertex_format;
+        header.has_meshlets = scene.has_meshlets ? 1 : 0;
+        header.sampler_count = (uint32_t)scene.samplers.size();
+        header.image_count = (uint32_t)scene.images.size();
+        header.material_count = (uint32_t)scene.materials.size();
+        header.mesh_count = (uint32_t)scene.meshes.size();
+        header.node_count = (uint32_t)scene.nodes.size();
+        header.source_file_count = (uint32_t)scene.source_files.size();
+        writer.write(header);
+
+        for (const BakedSourceFile& file : scene.source_files)
+        {
+            writer.writeString(file.path);
+            writer.write(file.size);
+            writer.write(file.write_time);
+        }
+
+        for (const BakedSampler& sampler : scene.samplers)
+        {
+            writer.write(sampler);
+        }
+
+        for (const BakedImage& image : scene.images)
+        {
+            writer.writeString(image.name);
+            writer.writeString(image.uri);
+            writer.write((uint32_t)image.format);
+            writer.write(image.width);
+            writer.write(image.height);
+            writer.write((uint32_t)image.mip_offsets.size());
+            writer.write((uint64_t)image.texels.size());
+            writer.writeBlob(std::span<const VkDeviceSize>(image.mip_offsets));
+            writer.writeBlob(image.texels);
+        }
+
+        for (const BakedMaterial& material : scene.materials)
+        {
+            writer.writeString(material.name);
+
+            CacheMaterial m {};
+            m.color_factors = material.color_factors;
+            m.metal_rough_factors = material.metal_rough_factors;
+            m.pass = (uint32_t)material.pass;
+            m.color_image = material.color_image;
+            m.color_sampler = material.color_sampler;
+            writer.write(m);
+        }
+
+        for (const BakedMesh& mesh : scene.meshes)
+        {
+            writer.writeString(mesh.name);
+
+            CacheMeshCounts counts {};
+            counts.vertex_count = mesh.vertex_count;
+            counts.vertex_bytes = (uint32_t)mesh.vertices.size();
+            counts.index_count = (uint32_t)mesh.indices.size();
+            counts.surface_count = (uint32_t)mesh.surfaces.size();
+            counts.meshlet_count = (uint32_t)mesh.meshlets.size();
+            counts.meshlet_data_count = (uint32_t)mesh.meshlet_data.size();
+            writer.write(counts);
+
+            writer.writeBlob(mesh.vertices);
+            writer.writeBlob(mesh.indices);
+            writer.writeBlob(std::span<const BakedSurface>(mesh.surfaces));
+            writer.writeBlob(mesh.meshlets);
+            writer.writeBlob(mesh.meshlet_data);
+        }
+
+        for (const BakedNode& node : scene.nodes)
+        {
+            writer.writeString(node.name);
+            writer.write(node.mesh);
+            writer.write(node.parent);
+            writer.write(node.local_transform);
+        }
+
+        if (!writer.out)
+        {
+            writer.out.close();
+            std::filesystem::remove(temp_path, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temp_path, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+
+// *** Reading ***
+
+// Bounds-checked cursor over the mapped file, views point straight into the mapping
+struct CacheReader
+{
+    const uint8_t* data;
+    size_t size;
+    size_t position { 0 };
+    bool ok { true };
+
+    const uint8_t* take(size_t count)
+    {
+        if (!ok || count > size - position)
+        {
+            ok = false;
+            return nullptr;
+        }
+        const uint8_t* p = data + position;
+        position += count;
+        return p;
+    }
+
+    template<typename T>
+    T read()
+    {
+        T value {};
+        if (const uint8_t* p = take(sizeof(T)))
+        {
+            memcpy(&value, p, sizeof(T));
+        }
+        return value;
+    }
+
+    std::string readString()
+    {
+        uint32_t length = read<uint32_t>();
+        const uint8_t* p = take(length);
+        return p ? std::string((const char*)p, length) : std::string();
+    }
+
+    void align()
+    {
+        size_t padding = (BLOB_ALIGNMENT - position % BLOB_ALIGNMENT) % BLOB_ALIGNMENT;
+        take(padding);
+    }
+
+    template<typename T>
+    std::span<const T> readBlob(size_t count)
+    {
+        align();
+        if (count > size / sizeof(T))
+        {
+            ok = false;
+            return {};
+        }
+        const uint8_t* p = take(count * sizeof(T));
+        return p ? std::span<const T>((const T*)p, count) : std::span<const T>();
+    }
+};
+
+bool ReadSceneCache(const std::filesystem::path& path, uint64_t source_hash, VertexFormat vertex_format,
+    bool has_meshlets, BakedScene& scene)
+{
+    if (!scene.file->open(path))
+    {
+        return false;
+    }
+
+    CacheReader reader { scene.file->data(), scene.file->size() };
+
+    SceneCacheHeader header = reader.read<SceneCacheHeader>();
+    if (!reader.ok || header.magic != SCENE_CACHE_MAGIC || header.version != SCENE_CACHE_VERSION ||
+        header.source_hash != source_hash || header.vertex_format != (uint32_t)vertex_format ||
+        (header.has_meshlets != 0) != has_meshlets)
+    {
+        scene.file->close();
+        return false;
+    }
+
+    // External files are only checked for changes, not hashed
+    for (uint32_t i = 0; i < header.source_file_count && reader.ok; i++)
+    {
+        BakedSourceFile& file = scene.source_files.emplace_back();
+        file.path = reader.readString();
+        file.size = reader.read<uint64_t>();
+        file.write_time = reader.read<int64_t>();
+
+        BakedSourceFile current;
+        if (reader.ok && (!StatSourceFile(file.path, current) || current.size != file.size || 
+            current.write_time != file.write_time))
+        {
+            scene.clear();
+            return false;
+        }
+    }
+
+    scene.source_hash = header.source_hash;
+    scene.vertex_format = vertex_format;
+    scene.has_meshlets = has_meshlets;
+
+    const size_t vertex_stride = (vertex_format == VertexFormat::packed) ? sizeof(PackedVertex) : sizeof(Vertex);
+
+    for (uint32_t i = 0; i < header.sampler_count && reader.ok; i++)
+    {
+        scene.samplers.push_back(reader.read<BakedSampler>());
+    }
+
+    for (uint32_t i = 0; i < header.image_count && reader.ok; i++)
+    {
+        BakedImage& image = scene.images.emplace_back();
+        image.name = reader.readString();
+        image.uri = reader.readString();
+        image.format = (VkFormat)reader.read<uint32_t>();
+        image.width = reader.read<uint32_t>();
+        image.height = reader.read<uint32_t>();
+        uint32_t mip_count = reader.read<uint32_t>();
+        uint64_t texel_size = reader.read<uint64_t>();
+
+        std::span<const VkDeviceSize> offsets = reader.readBlob<VkDeviceSize>(mip_count);
+        image.mip_offsets.assign(offsets.begin(), offsets.end());
+        image.texels = reader.readBlob<uint8_t>(texel_size);
+
+        for (VkDeviceSize offset : image.mip_offsets)
+        {
+            reader.ok = reader.ok && offset < texel_size;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.material_count && reader.ok; i++)
+    {
+        BakedMaterial& material = scene.materials.emplace_back();
+        material.name = reader.readString();
+
+        CacheMaterial m = reader.read<CacheMaterial>();
+        material.color_factors = m.color_factors;
+        material.metal_rough_factors = m.metal_rough_factors;
+        material.pass = (MaterialPass)m.pass;
+        material.color_image = m.color_image;
+        material.color_sampler = m.color_sampler;
+
+        reader.ok = reader.ok && m.color_image < (int32_t)header.image_count &&
+            m.color_sampler < (int32_t)header.sampler_count;
+    }
+
+    for (uint32_t i = 0; i < header.mesh_count && reader.ok; i++)
+    {
+        BakedMesh& mesh = scene.meshes.emplace_back();
+        mesh.name = reader.readString();
+
+        CacheMeshCounts counts = reader.read<CacheMeshCounts>();
+        mesh.vertex_count = counts.vertex_count;
+        reader.ok = reader.ok && (size_t)counts.vertex_count * vertex_stride == counts.vertex_bytes;
+
+        mesh.vertices = reader.readBlob<uint8_t>(counts.vertex_bytes);
+        mesh.indices = reader.readBlob<uint32_t>(counts.index_count);
+
+        std::span<const BakedSurface> surfaces = reader.readBlob<BakedSurface>(counts.surface_count);
+        mesh.surfaces.assign(surfaces.begin(), surfaces.end());
+
+        mesh.meshlets = reader.readBlob<GPUMeshlet>(counts.meshlet_count);
+        mesh.meshlet_data = reader.readBlob<uint32_t>(counts.meshlet_data_count);
+
+        for (const BakedSurface& s : mesh.surfaces)
+        {
+            reader.ok = reader.ok && s.material < (int32_t)header.material_count &&
+                s.lod_count >= 1 && s.lod_count <= MAX_MESH_LODS;
+        }
+    }
+
+    for (uint32_t i = 0; i < header.node_count && reader.ok; i++)
+    {
+        BakedNode& node = scene.nodes.emplace_back();
+        node.name = reader.readString();
+        node.mesh = reader.read<int32_t>();
+        node.parent = reader.read<int32_t>();
+        node.local_transform = reader.read<Mat4f>();
+
+        reader.ok = reader.ok && node.mesh < (int32_t)header.mesh_count && node.parent < (int32_t)header.node_count;
+    }
+
+    if (!reader.ok)
+    {
+        fmt::println("Scene cache {} is damaged, rebuilding", path.string());
+        scene.clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+// *** Mip Chain ***
+
+void BuildMipChain(const uint8_t* texels, uint32_t width, uint32_t height, std::vector<uint8_t>& out,
+    std::vector<VkDeviceSize>& mip_offsets)
+{
+    size_t base = out.size();
+    mip_offsets.clear();
+    mip_offsets.push_back(0);
+    out.insert(out.end(), texels, texels + (size_t)width * height * 4);
+
+    while (width > 1 || height > 1)
+    {
+        uint32_t next_width = std::max(width / 2, 1u);
+        uint32_t next_height = std::max(height / 2, 1u);
+
+        size_t src = base + mip_offsets.back();
+        size_t dst = out.size();
+        mip_offsets.push_back(dst - base);
+        out.resize(dst + (size_t)next_width * next_height * 4);
+
+        // Average of the 2x2 footprint (clamped on 1-wide axes, odd edges drop the last texel)
+        for (uint32_t y = 0; y < next_height; y++)
+        {
+            uint32_t y0 = std::min(y * 2, height - 1);
+            uint32_t y1 = std::min(y * 2 + 1, height - 1);
+
+            for (uint32_t x = 0; x < next_width; x++)
+            {
+                uint32_t x0 = std::min(x * 2, width - 1);
+                uint32_t x1 = std::min(x * 2 + 1, width - 1);
+
+                for (uint32_t c = 0; c < 4; c++)
+                {
+                    uint32_t sum = out[src + ((size_t)y0 * width + x0) * 4 + c] + out[src + ((size_t)y0 * width + x1) * 4 + c] +
+                        out[src + ((size_t)y1 * width + x0) * 4 + c] + out[src + ((size_t)y1 * width + x1) * 4 + c];
+                    out[dst + ((size_t)y * next_width + x) * 4 + c] = (uint8_t)((sum + 2) / 4);
+                }
+            }
+        }
+
+        width = next_width;
+        height = next_height;
+    }
+}
@@ -0,0 +1,168 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Baked scene cache (binary, memory-mapped, keyed by the source file's content hash and the
+// size and modification time of its external files)
+
+#pragma once
+
+#include "phvk_types.h"
+#include "phvk_loader.h"
+#include "phvk_meshlet.h"
+
+#include <filesystem>
+#include <memory>
+
+// Bump whenever the layout or anything baked into it changes (vertex packing, LODs, meshlets, mips, image keys)
+constexpr uint32_t SCENE_CACHE_VERSION = 4;
+
+// Read-only file mapping, released on destruction
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t* bytes { nullptr };
+    size_t length { 0 };
+#ifdef _WIN32
+    void* file_handle { nullptr };
+    void* mapping_handle { nullptr };
+#else
+    int fd { -1 };
+#endif
+};
+
+// *** Baked Scene ***
+// Views into the mapped cache when read, into the loader's data when written
+
+struct BakedSampler
+{
+    uint32_t mag_filter;        // VkFilter
+    uint32_t min_filter;
+    uint32_t mipmap_mode;       // VkSamplerMipmapMode
+};
+
+// R8G8B8A8_UNORM with every mip down to 1x1, or a KTX2 file's levels as stored, packed from mip 0
+// (empty texels: failed to load or never decoded)
+struct BakedImage
+{
+    std::string name;
+    std::string uri;            // TextureCache key of an external image file, empty if embedded
+    VkFormat format { VK_FORMAT_R8G8B8A8_UNORM };
+    uint32_t width { 0 };
+    uint32_t height { 0 };
+    std::vector<VkDeviceSize> mip_offsets;
+    std::span<const uint8_t> texels;
+};
+
+struct BakedMaterial
+{
+    std::string name;
+    Vec4f color_factors;
+    Vec4f metal_rough_factors;
+    MaterialPass pass;
+    int32_t color_image { -1 };     // -1: default white texture
+    int32_t color_sampler { -1 };
+};
+
+// GeoSurface without the material pointer
+struct BakedSurface
+{
+    uint32_t start_index;
+    uint32_t count;
+    Bounds bounds;
+    int32_t material;
+    SurfaceLOD lods[MAX_MESH_LODS];
+    uint32_t lod_count;
+    uint32_t first_meshlet;
+    uint32_t meshlet_count;
+};
+
+struct BakedMesh
+{
+    std::string name;
+    uint32_t vertex_count { 0 };
+    std::span<const uint8_t> vertices;          // Vertex[] or PackedVertex[] (BakedScene::vertex_format)
+    std::span<const uint32_t> indices;          // Including the LOD ranges
+    std::vector<BakedSurface> surfaces;
+    std::span<const GPUMeshlet> meshlets;
+    std::span<const uint32_t> meshlet_data;
+};
+
+struct BakedNode
+{
+    std::string name;
+    int32_t mesh { -1 };
+    int32_t parent { -1 };
+    Mat4f local_transform;
+};
+
+// External buffer or image file of the source, a bake is stale once either of them changes
+struct BakedSourceFile
+{
+    std::string path;
+    uint64_t size { 0 };
+    int64_t write_time { 0 };   // std::filesystem::file_time_type ticks
+};
+
+struct BakedScene
+{
+    uint64_t source_hash { 0 };
+    VertexFormat vertex_format { VertexFormat::standard };
+    bool has_meshlets { false };
+    std::vector<BakedSourceFile> source_files;
+
+    std::vector<BakedSampler> samplers;
+    std::vector<BakedImage> images;
+    std::vector<BakedMaterial> materials;
+    std::vector<BakedMesh> meshes;
+    std::vector<BakedNode> nodes;
+
+    // Backs the spans of a scene read from disk (shared with streamed textures, which keep
+    // their mip chains in the mapping)
+    std::shared_ptr<MappedFile> file { std::make_shared<MappedFile>() };
+
+    // Drop the contents and this scene's reference to the mapping
+    void clear()
+    {
+        source_files.clear();
+        samplers.clear();
+        images.clear();
+        materials.clear();
+        meshes.clear();
+        nodes.clear();
+        file = std::make_shared<MappedFile>();
+    }
+};
+
+// Content hash of a file (0 if it can't be read)
+uint64_t HashFileContents(const std::filesystem::path& path);
+
+// Size and modification time of path (false if it can't be read)
+bool StatSourceFile(const std::filesystem::path& path, BakedSourceFile& file);
+
+// <asset dir>/.acid_cache/<asset name>.bake
+std::filesystem::path SceneCachePath(const std::filesystem::path& source);
+
+// Written to a temporary file first, so an interrupted bake never leaves a partial cache
+bool WriteSceneCache(const std::filesystem::path& path, const BakedScene& scene);
+
+// Maps the cache and fills scene with views into it
+// Fails (without logging) if it is missing, stale (source hash or any external file) or was baked
+// with different settings
+bool ReadSceneCache(const std::filesystem::path& path, uint64_t source_hash, VertexFormat vertex_format,
+    bool has_meshlets, BakedScene& scene);
+
+// Box-filtered RGBA8 mip chain down to 1x1, appended to out (offsets of every level)
+void BuildMipChain(const uint8_t* texels, uint32_t width, uint32_t height, std::vector<uint8_t>& out,
+    std::vector<VkDeviceSize>& mip_offsets);
@@ -0,0 +1,156 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Draw keys and radix sort
+
+#include "phvk_sort.h"
+
+#include "phvk_jobs.h"
+
+#include <algorithm>
+#include <cstring>
+
+// *** Draw Keys ***
+
+uint32_t DrawStateKey(uint32_t pipeline_id, uint32_t material_id, uint32_t geometry_page)
+{
+    return ((pipeline_id & 0xFu) << 28) | ((material_id & 0xFFFFFu) << 8) | (geometry_page & 0xFFu);
+}
+
+uint32_t QuantizeDepth(float view_depth)
+{
+    // Behind the camera (or NaN) sorts as nearest
+    if (!(view_depth > 0.f))
+    {
+        return 0;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &view_depth, sizeof(bits));
+    return bits;
+}
+
+
+// *** Radix Sort ***
+
+static constexpr uint32_t RADIX_BITS = 8;
+static constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+static constexpr uint32_t RADIX_PASSES = 64 / RADIX_BITS;
+static constexpr uint32_t MAX_SORT_CHUNKS = 16;
+
+void RadixSortDrawKeys(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch, JobSystem* jobs)
+{
+    const size_t count = entries.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    scratch.resize(count);
+
+    // Split into contiguous chunks, each with its own histogram (keeps the scatter stable)
+    uint32_t chunk_count = 1;
+    if (jobs && jobs->workerCount() > 0 && count >= PARALLEL_SORT_MIN_ENTRIES)
+    {
+        chunk_count = std::min(jobs->workerCount() + 1, MAX_SORT_CHUNKS);
+    }
+    const size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+
+    // Runs fn(chunk) for every chunk, on the workers if there is more than one
+    auto for_each_chunk = [&](auto&& fn)
+        {
+            if (chunk_count == 1)
+            {
+                fn(0u);
+                return;
+            }
+
+            JobCounter counter;
+            for (uint32_t c = 0; c < chunk_count; c++)
+            {
+                jobs->schedule([&fn, c]() { fn(c); }, &counter);
+            }
+            jobs->wait(counter);
+        };
+
+    uint32_t histograms[MAX_SORT_CHUNKS][RADIX_SIZE];
+    DrawSortEntry* src = entries.data();
+    DrawSortEntry* dst = scratch.data();
+
+    for (uint32_t pass = 0; pass < RADIX_PASSES; pass++)
+    {
+        const uint32_t shift = pass * RADIX_BITS;
+
+        // *** Histogram ***
+        for_each_chunk([&](uint32_t c)
+            {
+                uint32_t* histogram = histograms[c];
+                memset(histogram, 0, sizeof(uint32_t) * RADIX_SIZE);
+
+                size_t first = c * chunk_size;
+                size_t last = std::min(first + chunk_size, count);
+                for (size_t i = first; i < last; i++)
+                {
+                    histogram[(src[i].key >> shift) & (RADIX_SIZE - 1)]++;
+                }
+            });
+
+        // Skip the pass if every key has the same digit
+        bool uniform = false;
+        for (uint32_t d = 0; d < RADIX_SIZE; d++)
+        {
+            size_t total = 0;
+            for (uint32_t c = 0; c < chunk_count; c++)
+            {
+                total += histograms[c][d];
+            }
+            if (total == count)
+            {
+                uniform = true;
+                break;
+            }
+            if (total > 0)
+            {
+                break;
+            }
+        }
+        if (uniform)
+        {
+            continue;
+        }
+
+        // *** Offsets ***
+        // Digit-major, chunk-minor prefix sum: chunk c writes after the same digit of earlier chunks
+        uint32_t offset = 0;
+        for (uint32_t d = 0; d < RADIX_SIZE; d++)
+        {
+            for (uint32_t c = 0; c < chunk_count; c++)
+            {
+                uint32_t n = histograms[c][d];
+                histograms[c][d] = offset;
+                offset += n;
+            }
+        }
+
+        // *** Scatter ***
+        for_each_chunk([&](uint32_t c)
+            {
+                uint32_t* offsets = histograms[c];
+
+                size_t first = c * chunk_size;
+                size_t last = std::min(first + chunk_size, count);
+                for (size_t i = first; i < last; i++)
+                {
+                    dst[offsets[(src[i].key >> shift) & (RADIX_SIZE - 1)]++] = src[i];
+                }
+            });
+
+        std::swap(src, dst);
+    }
+
+    // Odd number of executed passes leaves the result in scratch
+    if (src != entries.data())
+    {
+        entries.swap(scratch);
+    }
+}
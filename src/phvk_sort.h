@@ -0,0 +1,49 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Draw keys and radix sort
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct JobSystem;
+
+// Sortable draw: 64-bit key and the surface index it orders
+struct DrawSortEntry
+{
+    uint64_t key;
+    uint32_t index;
+};
+
+// *** Draw Keys ***
+// State key (built with the RenderObject):
+//   [31:28] pipeline (pass and vertex format)  [27:8] material  [7:0] geometry page
+// Opaque key:       [63:32] state key  [31:0] depth (front to back)
+// Transparent key:  [63:32] depth (back to front)  [31:0] state key
+
+uint32_t DrawStateKey(uint32_t pipeline_id, uint32_t material_id, uint32_t geometry_page);
+
+// View depth quantized to 32 bits (IEEE bits of a non-negative float are ordered like the values)
+uint32_t QuantizeDepth(float view_depth);
+
+inline uint64_t OpaqueDrawKey(uint32_t state_key, float view_depth)
+{
+    return ((uint64_t)state_key << 32) | QuantizeDepth(view_depth);
+}
+
+inline uint64_t TransparentDrawKey(uint32_t state_key, float view_depth)
+{
+    return ((uint64_t)~QuantizeDepth(view_depth) << 32) | state_key;
+}
+
+// *** Radix Sort ***
+// Stable LSD sort by key (8-bit digits, passes where every key shares the digit are skipped)
+// Large inputs split the histogram and scatter work across the job system
+// scratch is resized as needed and can be kept between calls
+constexpr size_t PARALLEL_SORT_MIN_ENTRIES = 16384;
+
+void RadixSortDrawKeys(std::vector<DrawSortEntry>& entries, std::vector<DrawSortEntry>& scratch,
+    JobSystem* jobs = nullptr);
@@ -0,0 +1,386 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Texture mip streaming (mip tails resident, larger levels uploaded on demand under a VRAM budget)
+
+#include "phvk_streaming.h"
+
+#include "phvk_engine.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TextureStreamer::init(phVkEngine* engine)
+{
+    this->engine = engine;
+}
+
+void TextureStreamer::destroy()
+{
+    if (!engine)
+    {
+        return;
+    }
+
+    // Device is idle
+    for (RetiredImage& r : retired)
+    {
+        for (uint32_t slot : r.slots)
+        {
+            engine->bindless_registry.releaseTexture(slot);
+        }
+        engine->destroyImage(r.image);
+    }
+
+    for (StreamedTexture& texture : textures)
+    {
+        if (!texture.alive)
+        {
+            continue;
+        }
+        engine->destroyImage(texture.image);
+        if (texture.pending.image != VK_NULL_HANDLE)
+        {
+            engine->destroyImage(texture.pending);
+        }
+    }
+
+    retired.clear();
+    textures.clear();
+    free_handles.clear();
+    resident_bytes = 0;
+    texture_count = 0;
+    uploading_count = 0;
+    engine = nullptr;
+}
+
+uint32_t TextureStreamer::create(TextureSource source)
+{
+    uint32_t handle;
+    if (!free_handles.empty())
+    {
+        handle = free_handles.back();
+        free_handles.pop_back();
+    }
+    else
+    {
+        handle = (uint32_t)textures.size();
+        textures.emplace_back();
+    }
+
+    StreamedTexture& texture = textures[handle];
+    texture = StreamedTexture();
+    texture.source = std::move(source);
+    texture.alive = true;
+
+    // Tail: first level within TAIL_SIZE (the whole chain for small textures)
+    const uint32_t level_count = (uint32_t)texture.source.mip_offsets.size();
+    uint32_t tail = 0;
+    while (tail + 1 < level_count &&
+        std::max(texture.source.width >> tail, texture.source.height >> tail) > TAIL_SIZE)
+    {
+        tail++;
+    }
+
+    texture.tail_base = tail;
+    texture.desired_base = tail;
+    texture.resident_base = tail;
+    texture.image = createLevels(texture, tail);
+
+    resident_bytes += chainBytes(texture, tail);
+    texture_count++;
+
+    return handle;
+}
+
+void TextureStreamer::release(uint32_t handle)
+{
+    StreamedTexture& texture = textures[handle];
+    assert(texture.alive);
+
+    // Frames in flight (and a transition still uploading) may use either image
+    resident_bytes -= chainBytes(texture, texture.resident_base);
+    retire(texture.image, {}, {});
+
+    if (texture.pending.image != VK_NULL_HANDLE)
+    {
+        resident_bytes -= chainBytes(texture, texture.pending_base);
+        retire(texture.pending, {}, texture.pending_upload);
+    }
+
+    texture = StreamedTexture();
+    free_handles.push_back(handle);
+    texture_count--;
+}
+
+void TextureStreamer::request(uint32_t handle, float projected_size)
+{
+    StreamedTexture& texture = textures[handle];
+
+    // Level with about one texel per pixel across the surface
+    const float size = (float)std::max(texture.source.width, texture.source.height);
+    uint32_t base = texture.tail_base;
+    if (projected_size >= size)
+    {
+        base = 0;
+    }
+    else if (projected_size > 0.f)
+    {
+        base = std::min((uint32_t)std::log2(size / projected_size), texture.tail_base);
+    }
+
+    // Largest request of the frame wins
+    if (texture.last_requested != engine->frame_number)
+    {
+        texture.desired_base = base;
+        texture.last_requested = engine->frame_number;
+    }
+    else
+    {
+        texture.desired_base = std::min(texture.desired_base, base);
+    }
+}
+
+void TextureStreamer::update()
+{
+    const int frame = engine->frame_number;
+    UploadManager& uploads = engine->upload_manager;
+
+    // *** Retired Images ***
+    // Runs before the frame's fence wait: up to MAX_FRAME_OVERLAP frames may still be in flight,
+    // and an image still uploading only starts counting once its acquire has been recorded
+    std::erase_if(retired, [&](RetiredImage& r)
+        {
+            if (!uploads.isReady(r.upload))
+            {
+                r.frame = frame;
+                return false;
+            }
+            if (frame - r.frame <= (int)MAX_FRAME_OVERLAP)
+            {
+                return false;
+            }
+
+            for (uint32_t slot : r.slots)
+            {
+                engine->bindless_registry.releaseTexture(slot);
+            }
+            engine->destroyImage(r.image);
+            return true;
+        });
+
+    // *** Completed Transitions ***
+    uploading_count = 0;
+    for (StreamedTexture& texture : textures)
+    {
+        if (!texture.alive || texture.pending.image == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+        if (!uploads.isReady(texture.pending_upload))
+        {
+            uploading_count++;
+            continue;
+        }
+
+        // New slots for the new view, in-flight frames keep reading the old ones
+        std::vector<uint32_t> slots;
+        engine->bindless_registry.replaceView(texture.image.view, texture.pending.view, slots);
+
+        resident_bytes -= chainBytes(texture, texture.resident_base);
+        retire(texture.image, std::move(slots), {});
+
+        texture.image = texture.pending;
+        texture.resident_base = texture.pending_base;
+        texture.pending = {};
+    }
+
+    // *** Budget ***
+    // Planned: memory once every transition in flight has landed
+    VkDeviceSize planned = 0;
+    for (StreamedTexture& texture : textures)
+    {
+        if (!texture.alive)
+        {
+            continue;
+        }
+        if (frame - texture.last_requested > UNUSED_FRAMES)
+        {
+            texture.desired_base = texture.tail_base;
+        }
+        planned += chainBytes(texture, texture.pending.image != VK_NULL_HANDLE ? texture.pending_base : texture.resident_base);
+    }
+
+    const VkDeviceSize budget = budgetBytes(planned);
+    VkDeviceSize uploaded = 0;
+    candidates.clear();
+
+    if (planned > budget)
+    {
+        // *** Evict ***
+        // Textures holding more than they need first, then least recently used (never below the tail)
+        for (uint32_t i = 0; i < textures.size(); i++)
+        {
+            const StreamedTexture& texture = textures[i];
+            if (texture.alive && texture.pending.image == VK_NULL_HANDLE && texture.resident_base < texture.tail_base)
+            {
+                candidates.push_back(i);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+            {
+                const StreamedTexture& ta = textures[a];
+                const StreamedTexture& tb = textures[b];
+                const bool excess_a = ta.resident_base < ta.desired_base;
+                const bool excess_b = tb.resident_base < tb.desired_base;
+                if (excess_a != excess_b)
+                {
+                    return excess_a;
+                }
+                return ta.last_requested < tb.last_requested;
+            });
+
+        for (uint32_t handle : candidates)
+        {
+            if (planned <= budget || uploaded >= max_upload_per_frame)
+            {
+                break;
+            }
+
+            // Straight down to the desired level if it has more, one level otherwise
+            StreamedTexture& texture = textures[handle];
+            const uint32_t base = std::max(texture.desired_base, texture.resident_base + 1);
+
+            planned -= chainBytes(texture, texture.resident_base) - chainBytes(texture, base);
+            uploaded += chainBytes(texture, base);
+            beginTransition(texture, base);
+        }
+    }
+    else
+    {
+        // *** Stream In ***
+        // Largest gap first, then most recently used
+        for (uint32_t i = 0; i < textures.size(); i++)
+        {
+            const StreamedTexture& texture = textures[i];
+            if (texture.alive && texture.pending.image == VK_NULL_HANDLE && texture.desired_base < texture.resident_base)
+            {
+                candidates.push_back(i);
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+            {
+                const StreamedTexture& ta = textures[a];
+                const StreamedTexture& tb = textures[b];
+                const uint32_t gap_a = ta.resident_base - ta.desired_base;
+                const uint32_t gap_b = tb.resident_base - tb.desired_base;
+                if (gap_a != gap_b)
+                {
+                    return gap_a > gap_b;
+                }
+                return ta.last_requested > tb.last_requested;
+            });
+
+        for (uint32_t handle : candidates)
+        {
+            if (uploaded >= max_upload_per_frame)
+            {
+                break;
+            }
+
+            StreamedTexture& texture = textures[handle];
+            const VkDeviceSize growth = chainBytes(texture, texture.desired_base) - chainBytes(texture, texture.resident_base);
+            if (planned + growth > budget)
+            {
+                continue;
+            }
+
+            planned += growth;
+            uploaded += chainBytes(texture, texture.desired_base);
+            beginTransition(texture, texture.desired_base);
+        }
+    }
+
+    // Submit this frame's transitions as one batch
+    if (uploaded > 0)
+    {
+        UploadHandle batch = uploads.flush();
+        for (StreamedTexture& texture : textures)
+        {
+            if (texture.alive && texture.pending.image != VK_NULL_HANDLE && texture.pending_upload.value == 0)
+            {
+                texture.pending_upload = batch;
+            }
+        }
+    }
+}
+
+VkDeviceSize TextureStreamer::chainBytes(const StreamedTexture& texture, uint32_t base) const
+{
+    return texture.source.texels.size() - texture.source.mip_offsets[base];
+}
+
+AllocatedImage TextureStreamer::createLevels(const StreamedTexture& texture, uint32_t base)
+{
+    const TextureSource& source = texture.source;
+
+    // Offsets rebased to the new mip 0 (still 16-byte aligned)
+    const VkDeviceSize start = source.mip_offsets[base];
+    std::vector<VkDeviceSize> mip_offsets(source.mip_offsets.begin() + base, source.mip_offsets.end());
+    for (VkDeviceSize& offset : mip_offsets)
+    {
+        offset -= start;
+    }
+
+    VkExtent3D extent { std::max(source.width >> base, 1u), std::max(source.height >> base, 1u), 1 };
+
+    return engine->createImage(source.texels.data() + start, source.texels.size() - start, extent,
+        source.format, VK_IMAGE_USAGE_SAMPLED_BIT, mip_offsets);
+}
+
+void TextureStreamer::beginTransition(StreamedTexture& texture, uint32_t base)
+{
+    texture.pending = createLevels(texture, base);
+    texture.pending_base = base;
+    texture.pending_upload = {};    // Set once the batch is flushed
+
+    resident_bytes += chainBytes(texture, base);
+    uploading_count++;
+}
+
+void TextureStreamer::retire(const AllocatedImage& image, std::vector<uint32_t> slots, UploadHandle upload)
+{
+    retired.push_back({ image, std::move(slots), upload, engine->frame_number });
+}
+
+VkDeviceSize TextureStreamer::budgetBytes(VkDeviceSize planned) const
+{
+    VkDeviceSize budget = (VkDeviceSize)std::max(budget_mb, 0) * 1024 * 1024;
+
+    // Everything else on the device counts too: close to a device-local heap's budget
+    // (usage above 90%), the streamer gives back the excess
+    const VkPhysicalDeviceMemoryProperties* memory_properties;
+    vmaGetMemoryProperties(engine->allocator, &memory_properties);
+
+    VmaBudget heap_budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(engine->allocator, heap_budgets);
+
+    for (uint32_t i = 0; i < memory_properties->memoryHeapCount; i++)
+    {
+        if (!(memory_properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+        {
+            continue;
+        }
+
+        const VkDeviceSize limit = heap_budgets[i].budget / 10 * 9;
+        if (heap_budgets[i].usage > limit)
+        {
+            const VkDeviceSize excess = heap_budgets[i].usage - limit;
+            budget = std::min(budget, planned - std::min(planned, excess));
+        }
+    }
+
+    return budget;
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Texture mip streaming (mip tails resident, larger levels uploaded on demand under a VRAM budget)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <memory>
+#include <span>
+#include <vector>
+
+class phVkEngine;
+
+// CPU copy of a texture's mip chain, packed from mip 0 (every level 16-byte aligned)
+// owner keeps texels alive while the texture can stream (decoded chain or the mapped scene cache)
+struct TextureSource
+{
+    VkFormat format { VK_FORMAT_R8G8B8A8_UNORM };
+    uint32_t width { 0 };
+    uint32_t height { 0 };
+    std::vector<VkDeviceSize> mip_offsets;
+    std::span<const uint8_t> texels;
+    std::shared_ptr<const void> owner;
+};
+
+// Textures start with only their mip tail resident (levels up to TAIL_SIZE texels). Each frame
+// the engine requests the level its surfaces need from their projected size, then update():
+//   - swaps in images whose upload has landed (bindless slots re-pointed, old image retired)
+//   - drops levels, unused / least recently used textures first, while over budget
+//   - uploads the chain for the textures furthest from their desired level
+// Every level change uploads a new image with levels [base, count) from the CPU copy through
+// the upload manager (transfer queue), the old image is destroyed once no frame can use it.
+// Needs bindless materials: descriptors reference the view, the registry rewrites them in place.
+// Not thread-safe, textures are created by FinalizeGLTF on the main thread
+class TextureStreamer
+{
+public:
+    static constexpr uint32_t TAIL_SIZE = 128;          // Largest always-resident level (max dimension)
+    static constexpr uint32_t INVALID_HANDLE = UINT32_MAX;
+    static constexpr int UNUSED_FRAMES = 60;            // Not requested for this long: only the tail is wanted
+
+    int budget_mb { 512 };                              // Streamed texture memory (resident + uploading)
+    VkDeviceSize max_upload_per_frame { 16 * 1024 * 1024 };
+
+    void init(phVkEngine* engine);
+    void destroy();
+
+    bool isEnabled() const { return engine != nullptr; }
+
+    // Creates the texture with its mip tail (upload queued, covered by the next flush)
+    uint32_t create(TextureSource source);
+    void release(uint32_t handle);
+
+    // Current image (changes when a level transition completes)
+    const AllocatedImage& image(uint32_t handle) const { return textures[handle].image; }
+
+    // Surface using the texture covers projected_size pixels on screen (this frame)
+    void request(uint32_t handle, float projected_size);
+
+    // Once per frame, before the draw lists are recorded
+    void update();
+
+    // Stats
+    VkDeviceSize residentBytes() const { return resident_bytes; }
+    uint32_t textureCount() const { return texture_count; }
+    uint32_t uploadingCount() const { return uploading_count; }
+
+private:
+    struct StreamedTexture
+    {
+        TextureSource source;
+        AllocatedImage image {};
+        uint32_t resident_base { 0 };       // Image holds levels [resident_base, level count)
+        uint32_t tail_base { 0 };
+        uint32_t desired_base { 0 };
+        int last_requested { -1 };          // Frame number
+
+        AllocatedImage pending {};          // Next image (VK_NULL_HANDLE if none)
+        uint32_t pending_base { 0 };
+        UploadHandle pending_upload;
+
+        bool alive { false };
+    };
+
+    // Image (and the bindless slots that pointed at it) kept until no frame can reference it
+    struct RetiredImage
+    {
+        AllocatedImage image;
+        std::vector<uint32_t> slots;
+        UploadHandle upload;                // Must be ready (acquire recorded) before the frame count starts
+        int frame;
+    };
+
+    // Bytes of levels [base, count)
+    VkDeviceSize chainBytes(const StreamedTexture& texture, uint32_t base) const;
+
+    // Image with levels [base, count), upload queued
+    AllocatedImage createLevels(const StreamedTexture& texture, uint32_t base);
+
+    void beginTransition(StreamedTexture& texture, uint32_t base);
+    void retire(const AllocatedImage& image, std::vector<uint32_t> slots, UploadHandle upload);
+
+    // Budget in bytes, lowered while a device-local heap is close to VMA's budget
+    VkDeviceSize budgetBytes(VkDeviceSize planned) const;
+
+    phVkEngine* engine { nullptr };
+
+    std::vector<StreamedTexture> textures;
+    std::vector<uint32_t> free_handles;
+    std::vector<RetiredImage> retired;
+    std::vector<uint32_t> candidates;       // Scratch
+
+    VkDeviceSize resident_bytes { 0 };
+    uint32_t texture_count { 0 };
+    uint32_t uploading_count { 0 };
+};
@@ -45,6 +45,13 @@ struct AllocatedBuffer
     VmaAllocationInfo info;
 };
 
+// Pending GPU upload (see UploadManager)
+// Resources are usable on the graphics queue once the upload manager reports the handle ready
+struct UploadHandle
+{
+    uint64_t value { 0 };   // Transfer timeline value, 0 = nothing pending
+};
+
 enum class MaterialPass : uint8_t 
 {
     main_color,
@@ -52,17 +59,59 @@ enum class MaterialPass : uint8_t
     other
 };
 
+// Vertex layouts available for mesh geometry (selected per asset at load time)
+enum class VertexFormat : uint8_t
+{
+    standard,   // Vertex (48 bytes)
+    packed      // PackedVertex (16 bytes)
+};
+
 struct MaterialPipeline 
 {
     VkPipeline pipeline;
     VkPipelineLayout layout;
+    VkPipeline indirect_pipeline { VK_NULL_HANDLE };   // GPU-driven variant (same layout)
+
+    // PackedVertex variants (same layout, null if the shaders are unavailable)
+    VkPipeline packed_pipeline { VK_NULL_HANDLE };
+    VkPipeline packed_indirect_pipeline { VK_NULL_HANDLE };
+
+    // Instanced CPU-path variants (same layout, null if the shaders are unavailable)
+    VkPipeline instanced_pipeline { VK_NULL_HANDLE };
+    VkPipeline packed_instanced_pipeline { VK_NULL_HANDLE };
+
+    VkPipeline get(VertexFormat format, bool indirect) const
+    {
+        if (format == VertexFormat::packed)
+            return indirect ? packed_indirect_pipeline : packed_pipeline;
+        return indirect ? indirect_pipeline : pipeline;
+    }
+
+    VkPipeline getInstanced(VertexFormat format) const
+    {
+        return format == VertexFormat::packed ? packed_instanced_pipeline : instanced_pipeline;
+    }
+
+    // Task / mesh shader variants (opaque only, null without VK_EXT_mesh_shader)
+    // Own layout: same sets, push constants visible to the task and mesh stages
+    VkPipeline meshlet_pipeline { VK_NULL_HANDLE };
+    VkPipeline packed_meshlet_pipeline { VK_NULL_HANDLE };
+    VkPipelineLayout meshlet_layout { VK_NULL_HANDLE };
+
+    VkPipeline getMeshlet(VertexFormat format) const
+    {
+        return format == VertexFormat::packed ? packed_meshlet_pipeline : meshlet_pipeline;
+    }
 };
 
 struct MaterialInstance 
 {
     MaterialPipeline* pipeline;
-    VkDescriptorSet material_set;
+    VkDescriptorSet material_set;   // Shared global set in bindless mode
     MaterialPass pass_type;
+    uint32_t material_index { 0 };  // Slot in the bindless material buffer
+    uint32_t sort_id { 0 };         // Stable ID for draw keys (pointer order isn't deterministic)
+    uint32_t streamed_texture { UINT32_MAX };   // TextureStreamer handle of the color texture, if streamed
 };
 
 struct Vertex 
@@ -76,6 +125,17 @@ struct Vertex
     Vec4f color;
 };
 
+// Compact vertex (16 bytes), decoded by packed_vertex.glsl
+// Position is quantized relative to the owning surface's Bounds (origin +/- extents)
+struct PackedVertex
+{
+    uint16_t position[3];   // unorm16 across the bounds AABB
+    int8_t normal[2];       // Octahedral-encoded unit normal (snorm8)
+    uint16_t uv[2];         // Half floats
+    uint32_t color;         // RGBA8 unorm
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must match packed_vertex.glsl");
+
 struct GPUSceneData 
 {
     Mat4f view;
@@ -86,12 +146,28 @@ struct GPUSceneData
     Vec4f sunlight_color;
 };
 
+// Vertex / index ranges suballocated from the engine's GeometryPool
+struct GeometryAllocation
+{
+    uint32_t page { 0 };            // Pool page (one vertex + one index buffer per page)
+    uint32_t vertex_offset { 0 };   // Bytes into the page's vertex buffer
+    uint32_t vertex_size { 0 };     // Bytes
+    uint32_t first_index { 0 };     // Elements into the page's index buffer
+    uint32_t index_count { 0 };
+};
+
 // Holds the resources needed for a mesh
 struct GPUMeshBuffers 
 {
-    AllocatedBuffer index_buffer;
-    AllocatedBuffer vertex_buffer;
-    VkDeviceAddress vertex_buffer_address;
+    GeometryAllocation geometry;
+    VkDeviceAddress vertex_buffer_address;  // Address of the mesh's first vertex (indices are mesh-local)
+    VertexFormat vertex_format { VertexFormat::standard };
+    UploadHandle upload;
+
+    // Meshlets (mesh shading only, see phvk_meshlet.h), GPUMeshlet[] followed by their data words
+    AllocatedBuffer meshlet_buffer {};
+    VkDeviceAddress meshlet_address { 0 };          // 0 if the mesh has no meshlets
+    VkDeviceAddress meshlet_data_address { 0 };
 };
 
 // Push constants for our mesh object draws
@@ -102,8 +178,50 @@ struct GPUDrawPushConstants
     VkDeviceAddress vertex_buffer_address;  // Buffer address
 };
 
+// Push constants for packed-vertex and bindless draws (mesh_packed.vert, mesh_bindless.vert, ...)
+struct GPUPackedDrawPushConstants 
+{
+    Mat4f world_matrix;                     // Transform matrix
+    VkDeviceAddress vertex_buffer_address;  // Buffer address (Vertex[] or PackedVertex[])
+    uint32_t material_index;                // Bindless material buffer slot
+    uint32_t pad;
+    Vec4f bounds_origin;                    // Dequantization: origin + (q * 2 - 1) * extents
+    Vec4f bounds_extents;
+};
+
+// Push constants for instanced draws (mesh_instanced.vert, mesh_packed_instanced.vert, ...)
+struct GPUInstancedDrawPushConstants
+{
+    VkDeviceAddress instance_buffer_address;    // GPUInstanceData[], indexed by gl_InstanceIndex
+    VkDeviceAddress vertex_buffer_address;      // Buffer address (Vertex[] or PackedVertex[])
+    uint32_t material_index;                    // Bindless material buffer slot
+    uint32_t pad[3];
+    Vec4f bounds_origin;                        // Dequantization (packed meshes)
+    Vec4f bounds_extents;
+};
+
+// Push constants for meshlet draws (meshlet.task, meshlet*.mesh), 128 bytes
+struct GPUMeshletDrawPushConstants
+{
+    Mat4f world_matrix;                         // Transform matrix
+    VkDeviceAddress vertex_buffer_address;      // Buffer address (Vertex[] or PackedVertex[])
+    VkDeviceAddress meshlet_address;            // First GPUMeshlet of the surface
+    VkDeviceAddress meshlet_data_address;       // Meshlet vertex indices / triangles
+    uint32_t meshlet_count;
+    uint32_t material_index;                    // Bindless material buffer slot
+    Vec4f bounds_origin;                        // Dequantization (packed meshes)
+    Vec4f bounds_extents;
+};
+
+// Per-instance data in the frame's upload buffer (instance_data.glsl)
+struct GPUInstanceData
+{
+    Mat4f transform;
+};
+
 // Base class for a renderable dynamic object
 struct DrawContext;     // Forward declaration
+struct FlatSceneGraph;
 class IRenderable 
 {
     virtual void draw(const Mat4f& top_matrix, DrawContext& ctx) = 0;
@@ -121,6 +239,14 @@ struct Node : public IRenderable
     Mat4f local_transform;
     Mat4f world_transform;
 
+    // Owning flattened graph (set once the scene graph is built), see FlatSceneGraph
+    FlatSceneGraph* graph { nullptr };
+    uint32_t graph_index { 0 };
+
+    // Sets local_transform and flags the subtree dirty in the owning graph
+    // (nodes without a graph need refreshTransform() afterwards)
+    void setLocalTransform(const Mat4f& m);
+
     void refreshTransform(const Mat4f& parent_matrix)
     {
         world_transform = parent_matrix * local_transform;
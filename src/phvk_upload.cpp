@@ -0,0 +1,436 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Asynchronous GPU uploads (transfer queue, staging ring, timeline semaphore)
+
+#include "phvk_upload.h"
+
+#include "phvk_engine.h"
+#include "phvk_images.h"
+#include "phvk_initializers.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Staging offsets are kept 16-byte aligned (covers texel block and copy offset requirements)
+constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+void UploadManager::init(phVkEngine* engine, VkQueue transfer_queue, uint32_t transfer_family, VkDeviceSize staging_size)
+{
+    this->engine = engine;
+    device = engine->device;
+    graphics_family = engine->graphics_queue_family;
+
+    queue = transfer_queue;
+    queue_family = transfer_family;
+    dedicated_queue = (queue_family != graphics_family);
+
+    // Command pool on the transfer family, buffers are recycled individually
+    VkCommandPoolCreateInfo pool_info = vkinit::command_pool_create_info(queue_family,
+        VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    VK_CHECK(vkCreateCommandPool(device, &pool_info, nullptr, &command_pool));
+
+    // Timeline semaphore, value N is signaled once batch N has finished
+    VkSemaphoreTypeCreateInfo type_info { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO };
+    type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    type_info.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphore_info = vkinit::semaphore_create_info();
+    semaphore_info.pNext = &type_info;
+    VK_CHECK(vkCreateSemaphore(device, &semaphore_info, nullptr, &timeline));
+
+    // Persistently mapped staging ring
+    this->staging_size = (staging_size + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+    staging = engine->createBuffer(this->staging_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+
+    fmt::println("Upload queue family {} ({})", queue_family, dedicated_queue ? "dedicated" : "shared with graphics");
+}
+
+void UploadManager::destroy()
+{
+    // Device must be idle
+    for (Batch& batch : in_flight)
+    {
+        for (AllocatedBuffer& temp : batch.temp_staging)
+            engine->destroyBuffer(temp);
+    }
+    in_flight.clear();
+
+    for (AllocatedBuffer& temp : recording.temp_staging)
+        engine->destroyBuffer(temp);
+    recording = Batch();
+
+    // Destroying the pool frees all command buffers allocated from it
+    vkDestroyCommandPool(device, command_pool, nullptr);
+    free_commands.clear();
+
+    vkDestroySemaphore(device, timeline, nullptr);
+    engine->destroyBuffer(staging);
+}
+
+UploadHandle UploadManager::uploadBuffer(VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size,
+    VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access)
+{
+    std::scoped_lock lock(mutex);
+
+    VkBuffer src_buffer;
+    VkDeviceSize src_offset;
+    stageData(data, size, src_buffer, src_offset);
+
+    VkCommandBuffer cmd = beginRecording();
+
+    VkBufferCopy copy {};
+    copy.srcOffset = src_offset;
+    copy.dstOffset = dst_offset;
+    copy.size = size;
+
+    vkCmdCopyBuffer(cmd, src_buffer, dst, 1, &copy);
+
+    recording.wait_stages |= dst_stages;
+
+    if (dedicated_queue)
+    {
+        // Release ownership to the graphics family, the matching acquire is recorded by recordAcquires()
+        // (on a shared queue the timeline semaphore wait alone makes the copy visible)
+        VkBufferMemoryBarrier2 release { .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2 };
+        release.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        release.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+        release.dstAccessMask = VK_ACCESS_2_NONE;
+        release.srcQueueFamilyIndex = queue_family;
+        release.dstQueueFamilyIndex = graphics_family;
+        release.buffer = dst;
+        release.offset = dst_offset;
+        release.size = size;
+
+        VkDependencyInfo dep_info { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep_info.bufferMemoryBarrierCount = 1;
+        dep_info.pBufferMemoryBarriers = &release;
+        vkCmdPipelineBarrier2(cmd, &dep_info);
+
+        // Source stages match the timeline wait so the acquire chains with it
+        VkBufferMemoryBarrier2 acquire = release;
+        acquire.srcStageMask = dst_stages;
+        acquire.srcAccessMask = VK_ACCESS_2_NONE;
+        acquire.dstStageMask = dst_stages;
+        acquire.dstAccessMask = dst_access;
+        recording.buffer_acquires.push_back(acquire);
+    }
+
+    bytes_uploaded += size;
+
+    // The recording batch is signaled with next_value when submitted
+    return UploadHandle { next_value };
+}
+
+UploadHandle UploadManager::uploadImage(const AllocatedImage& image, const void* data, VkDeviceSize size, bool mipmapped,
+    std::span<const VkDeviceSize> mip_offsets)
+{
+    std::scoped_lock lock(mutex);
+
+    // Stored mips are copied as they are, nothing left to generate
+    if (!mip_offsets.empty())
+        mipmapped = false;
+
+    VkBuffer src_buffer;
+    VkDeviceSize src_offset;
+    stageData(data, size, src_buffer, src_offset);
+
+    VkCommandBuffer cmd = beginRecording();
+
+    vkutil::transition_image(cmd, image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    // One region per stored mip (just mip 0 without offsets)
+    std::vector<VkBufferImageCopy> copy_regions(std::max<size_t>(mip_offsets.size(), 1));
+    for (uint32_t level = 0; level < (uint32_t)copy_regions.size(); level++)
+    {
+        VkBufferImageCopy& copy_region = copy_regions[level];
+        copy_region = {};
+        copy_region.bufferOffset = src_offset + (mip_offsets.empty() ? 0 : mip_offsets[level]);
+        copy_region.bufferRowLength = 0;
+        copy_region.bufferImageHeight = 0;
+
+        copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy_region.imageSubresource.mipLevel = level;
+        copy_region.imageSubresource.baseArrayLayer = 0;
+        copy_region.imageSubresource.layerCount = 1;
+        copy_region.imageExtent = { std::max(image.extent.width >> level, 1u), 
+            std::max(image.extent.height >> level, 1u), 1 };
+    }
+
+    vkCmdCopyBufferToImage(cmd, src_buffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 
+        (uint32_t)copy_regions.size(), copy_regions.data());
+
+    VkExtent2D extent { image.extent.width, image.extent.height };
+
+    // First graphics use: sampled by fragment shaders, or the mip blits after a transfer-only copy
+    bool blit_on_graphics = dedicated_queue && mipmapped;
+    VkPipelineStageFlags2 dst_stages = blit_on_graphics ?
+        (VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT) : VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    recording.wait_stages |= dst_stages;
+
+    if (!dedicated_queue)
+    {
+        // Graphics-capable queue: finish the image in place
+        if (mipmapped)
+            vkutil::generate_mipmaps(cmd, image.image, extent);
+        else
+            vkutil::transition_image(cmd, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+    else
+    {
+        // Transfer-only queue cannot blit, so mipmapped images stay in TRANSFER_DST and
+        // have their mips generated on graphics after the acquire
+        // The layout transition happens between the release and acquire (both must match)
+        VkImageMemoryBarrier2 release { .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+        release.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+        release.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        release.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+        release.dstAccessMask = VK_ACCESS_2_NONE;
+        release.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        release.newLayout = mipmapped ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        release.srcQueueFamilyIndex = queue_family;
+        release.dstQueueFamilyIndex = graphics_family;
+        release.image = image.image;
+        release.subresourceRange = vkinit::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT);
+
+        VkDependencyInfo dep_info { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep_info.imageMemoryBarrierCount = 1;
+        dep_info.pImageMemoryBarriers = &release;
+        vkCmdPipelineBarrier2(cmd, &dep_info);
+
+        VkImageMemoryBarrier2 acquire = release;
+        acquire.srcStageMask = dst_stages;
+        acquire.srcAccessMask = VK_ACCESS_2_NONE;
+        acquire.dstStageMask = dst_stages;
+        acquire.dstAccessMask = mipmapped ?
+            (VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT) : VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        recording.image_acquires.push_back(acquire);
+
+        if (mipmapped)
+            recording.mipmaps.push_back({ image.image, extent });
+    }
+
+    bytes_uploaded += size;
+
+    return UploadHandle { next_value };
+}
+
+UploadHandle UploadManager::flush()
+{
+    std::scoped_lock lock(mutex);
+    return submitRecording();
+}
+
+bool UploadManager::isComplete(UploadHandle handle)
+{
+    uint64_t value;
+    VK_CHECK(vkGetSemaphoreCounterValue(device, timeline, &value));
+    return value >= handle.value;
+}
+
+void UploadManager::wait(UploadHandle handle)
+{
+    std::scoped_lock lock(mutex);
+
+    if (handle.value > submitted_value)
+        submitRecording();
+
+    waitValue(handle.value);
+    reclaim(handle.value);
+}
+
+uint64_t UploadManager::recordAcquires(VkCommandBuffer cmd)
+{
+    std::scoped_lock lock(mutex);
+
+    uint64_t completed;
+    VK_CHECK(vkGetSemaphoreCounterValue(device, timeline, &completed));
+
+    reclaim(completed);
+
+    // Gather barriers from every completed batch into one dependency
+    std::vector<VkBufferMemoryBarrier2> buffer_barriers;
+    std::vector<VkImageMemoryBarrier2> image_barriers;
+    std::vector<PendingMipmaps> mipmaps;
+    uint64_t wait_value = 0;
+    wait_stages = VK_PIPELINE_STAGE_2_NONE;
+
+    while (!in_flight.empty() && in_flight.front().value <= completed)
+    {
+        Batch& batch = in_flight.front();
+
+        buffer_barriers.insert(buffer_barriers.end(), batch.buffer_acquires.begin(), batch.buffer_acquires.end());
+        image_barriers.insert(image_barriers.end(), batch.image_acquires.begin(), batch.image_acquires.end());
+        mipmaps.insert(mipmaps.end(), batch.mipmaps.begin(), batch.mipmaps.end());
+        wait_stages |= batch.wait_stages;
+
+        wait_value = batch.value;
+        in_flight.pop_front();
+    }
+
+    if (!buffer_barriers.empty() || !image_barriers.empty())
+    {
+        VkDependencyInfo dep_info { .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO };
+        dep_info.bufferMemoryBarrierCount = (uint32_t)buffer_barriers.size();
+        dep_info.pBufferMemoryBarriers = buffer_barriers.data();
+        dep_info.imageMemoryBarrierCount = (uint32_t)image_barriers.size();
+        dep_info.pImageMemoryBarriers = image_barriers.data();
+        vkCmdPipelineBarrier2(cmd, &dep_info);
+    }
+
+    for (PendingMipmaps& m : mipmaps)
+    {
+        vkutil::generate_mipmaps(cmd, m.image, m.extent);
+    }
+
+    if (wait_value != 0)
+        acquired_value = wait_value;
+
+    return wait_value;
+}
+
+VkCommandBuffer UploadManager::beginRecording()
+{
+    if (recording.cmd != VK_NULL_HANDLE)
+        return recording.cmd;
+
+    if (!free_commands.empty())
+    {
+        recording.cmd = free_commands.back();
+        free_commands.pop_back();
+        VK_CHECK(vkResetCommandBuffer(recording.cmd, 0));
+    }
+    else
+    {
+        VkCommandBufferAllocateInfo alloc_info = vkinit::command_buffer_allocate_info(command_pool, 1);
+        VK_CHECK(vkAllocateCommandBuffers(device, &alloc_info, &recording.cmd));
+    }
+
+    VkCommandBufferBeginInfo begin_info =
+        vkinit::command_buffer_begin_info(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+    VK_CHECK(vkBeginCommandBuffer(recording.cmd, &begin_info));
+
+    return recording.cmd;
+}
+
+UploadHandle UploadManager::submitRecording()
+{
+    if (recording.cmd == VK_NULL_HANDLE)
+        return UploadHandle { submitted_value };
+
+    VK_CHECK(vkEndCommandBuffer(recording.cmd));
+
+    recording.value = next_value++;
+    recording.staging_end = write_pos;
+
+    VkCommandBufferSubmitInfo cmd_info = vkinit::command_buffer_submit_info(recording.cmd);
+    VkSemaphoreSubmitInfo signal_info = vkinit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, timeline);
+    signal_info.value = recording.value;
+
+    VkSubmitInfo2 submit = vkinit::submit_info(&cmd_info, &signal_info, nullptr);
+
+    {
+        std::scoped_lock queue_lock(queue_mutex);
+        VK_CHECK(vkQueueSubmit2(queue, 1, &submit, VK_NULL_HANDLE));
+    }
+
+    submitted_value = recording.value;
+    batches_submitted++;
+
+    in_flight.push_back(std::move(recording));
+    recording = Batch();
+
+    return UploadHandle { submitted_value };
+}
+
+bool UploadManager::stageData(const void* data, VkDeviceSize size, VkBuffer& src_buffer, VkDeviceSize& src_offset)
+{
+    if (size > staging_size)
+    {
+        // Larger than the whole ring: one-off staging buffer, freed with the batch
+        AllocatedBuffer temp = engine->createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+        memcpy(temp.info.pMappedData, data, size);
+
+        src_buffer = temp.buffer;
+        src_offset = 0;
+        recording.temp_staging.push_back(temp);
+        return false;
+    }
+
+    while (true)
+    {
+        uint64_t pos = (write_pos + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+        VkDeviceSize offset = pos % staging_size;
+
+        // Don't split an allocation across the end of the ring
+        if (offset + size > staging_size)
+        {
+            pos += staging_size - offset;
+            offset = 0;
+        }
+
+        if (pos + size - read_pos <= staging_size)
+        {
+            write_pos = pos + size;
+
+            memcpy((char*)staging.info.pMappedData + offset, data, size);
+            src_buffer = staging.buffer;
+            src_offset = offset;
+            return true;
+        }
+
+        // Ring is full: submit our own pending copies, then wait for the oldest batch to free space
+        submitRecording();
+
+        auto oldest = std::find_if(in_flight.begin(), in_flight.end(),
+            [](const Batch& b) { return b.cmd != VK_NULL_HANDLE; });
+
+        if (oldest == in_flight.end())
+        {
+            // Nothing in flight holds staging space: restart the ring at pos (wrap already applied),
+            // otherwise the skipped tail still counts against an allocation that doesn't fit after it
+            read_pos = pos;
+            write_pos = pos;
+            continue;
+        }
+
+        uint64_t value = oldest->value;
+        waitValue(value);
+        reclaim(value);
+    }
+}
+
+void UploadManager::reclaim(uint64_t completed_value)
+{
+    // Free staging space and command buffers of finished batches
+    // (batches stay in flight until their acquires have been recorded)
+    for (Batch& batch : in_flight)
+    {
+        if (batch.value > completed_value)
+            break;
+
+        if (batch.cmd == VK_NULL_HANDLE)
+            continue;
+
+        read_pos = std::max(read_pos, batch.staging_end);
+
+        free_commands.push_back(batch.cmd);
+        batch.cmd = VK_NULL_HANDLE;
+
+        for (AllocatedBuffer& temp : batch.temp_staging)
+            engine->destroyBuffer(temp);
+        batch.temp_staging.clear();
+    }
+}
+
+void UploadManager::waitValue(uint64_t value)
+{
+    VkSemaphoreWaitInfo wait_info { .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO };
+    wait_info.semaphoreCount = 1;
+    wait_info.pSemaphores = &timeline;
+    wait_info.pValues = &value;
+
+    VK_CHECK(vkWaitSemaphores(device, &wait_info, UINT64_MAX));
+}
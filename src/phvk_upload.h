@@ -0,0 +1,123 @@
+// Copyright (c) 2025, Cory Douthat
+//
+// Acid Graphics Engine - Vulkan (Ver 1.3-1.4)
+// Asynchronous GPU uploads (transfer queue, staging ring, timeline semaphore)
+
+#pragma once
+
+#include "phvk_types.h"
+
+#include <mutex>
+
+class phVkEngine;
+
+// Batches buffer/image copies from a persistently mapped staging ring into a single
+// submission on the transfer queue (dedicated family when the device has one).
+// Completion is tracked with a timeline semaphore; each batch signals the next value.
+//
+// Lifetime of an upload:
+//   uploadBuffer()/uploadImage()  - data is copied into staging, copy recorded (returns handle)
+//   flush()                        - pending copies submitted (engine calls this every frame)
+//   recordAcquires()               - once the batch lands, queue ownership is acquired on the
+//                                    graphics command buffer (and mips generated)
+//   isReady()                      - true from the following frame on
+//
+// Thread-safe (recording is guarded by a mutex), so loader threads may upload directly
+struct UploadManager
+{
+    VkQueue queue { VK_NULL_HANDLE };
+    uint32_t queue_family { 0 };
+    bool dedicated_queue { false };         // True if the transfer family differs from graphics
+
+    VkSemaphore timeline { VK_NULL_HANDLE };
+
+    // Guards vkQueueSubmit/vkQueuePresent when the transfer queue is shared with graphics
+    std::mutex queue_mutex;
+
+    void init(phVkEngine* engine, VkQueue transfer_queue, uint32_t transfer_family, VkDeviceSize staging_size);
+    void destroy();
+
+    // Copy data into dst at dst_offset
+    // dst_stages/dst_access describe the first graphics use (for the ownership acquire)
+    UploadHandle uploadBuffer(VkBuffer dst, VkDeviceSize dst_offset, const void* data, VkDeviceSize size,
+        VkPipelineStageFlags2 dst_stages, VkAccessFlags2 dst_access);
+
+    // Copy tightly packed texel data into mip 0 of an image created in UNDEFINED layout
+    // The image ends up in SHADER_READ_ONLY_OPTIMAL (remaining mips generated if mipmapped)
+    // mip_offsets: pre-built mips in data (byte offset of each level), copied instead of generated
+    UploadHandle uploadImage(const AllocatedImage& image, const void* data, VkDeviceSize size, bool mipmapped,
+        std::span<const VkDeviceSize> mip_offsets = {});
+
+    // Submit pending copies, returns the handle of the submitted batch (or the last one)
+    UploadHandle flush();
+
+    // GPU has finished the copy (resources may still need their acquire)
+    bool isComplete(UploadHandle handle);
+
+    // Acquire has been recorded on the graphics queue, resources are safe to use
+    bool isReady(UploadHandle handle) const { return handle.value <= acquired_value; }
+
+    // Block until the copy has finished on the GPU (flushes if needed)
+    void wait(UploadHandle handle);
+
+    // Record ownership acquires (and mip generation) for every completed batch
+    // Returns the timeline value the graphics submit must wait on (0 = no wait)
+    uint64_t recordAcquires(VkCommandBuffer cmd);
+
+    // Pipeline stages waiting on the timeline (first graphics use of the last acquired batches)
+    VkPipelineStageFlags2 waitStages() const { return wait_stages; }
+
+    // Stats
+    uint32_t batches_submitted { 0 };
+    VkDeviceSize bytes_uploaded { 0 };
+
+private:
+    struct PendingMipmaps
+    {
+        VkImage image;
+        VkExtent2D extent;
+    };
+
+    struct Batch
+    {
+        VkCommandBuffer cmd { VK_NULL_HANDLE };
+        uint64_t value { 0 };               // Timeline value signaled on completion
+        uint64_t staging_end { 0 };         // Ring position released on completion
+        std::vector<AllocatedBuffer> temp_staging;  // Uploads larger than the ring
+
+        // Acquire side of the queue ownership transfers (recorded on graphics)
+        std::vector<VkBufferMemoryBarrier2> buffer_acquires;
+        std::vector<VkImageMemoryBarrier2> image_acquires;
+        std::vector<PendingMipmaps> mipmaps;
+        VkPipelineStageFlags2 wait_stages { VK_PIPELINE_STAGE_2_NONE };    // Consuming stages
+    };
+
+    phVkEngine* engine { nullptr };
+    VkDevice device { VK_NULL_HANDLE };
+    uint32_t graphics_family { 0 };
+
+    VkCommandPool command_pool { VK_NULL_HANDLE };
+    std::vector<VkCommandBuffer> free_commands;
+
+    // Staging ring, positions are monotonic (offset = position % staging_size)
+    AllocatedBuffer staging;
+    VkDeviceSize staging_size { 0 };
+    uint64_t write_pos { 0 };
+    uint64_t read_pos { 0 };
+
+    Batch recording;                        // Batch currently being recorded (cmd == null if empty)
+    std::deque<Batch> in_flight;            // Submitted, in timeline order
+    uint64_t next_value { 1 };
+    uint64_t submitted_value { 0 };
+    uint64_t acquired_value { 0 };
+    VkPipelineStageFlags2 wait_stages { VK_PIPELINE_STAGE_2_NONE };
+
+    std::mutex mutex;
+
+    // Callers must hold mutex
+    VkCommandBuffer beginRecording();
+    UploadHandle submitRecording();
+    bool stageData(const void* data, VkDeviceSize size, VkBuffer& src_buffer, VkDeviceSize& src_offset);
+    void reclaim(uint64_t completed_value);
+    void waitValue(uint64_t value);
+};